@@ -0,0 +1,412 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+
+#include "finch/core/memory.h"
+#include "finch/platform/cpu.h"
+#include "finch/render/kernels.h"
+#include "finch/render/raster.h"
+#include "finch/utils/string.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define MAX_RESULTS 64
+
+static BenchScene* scenes[] = {
+    &bench_scene_minimal_gradient,
+    &bench_scene_sandbox_shader,
+    &bench_scene_logging,
+    &bench_scene_logging_file,
+    &bench_scene_formatting,
+    &bench_scene_present,
+    &bench_scene_fill,
+    &bench_scene_blit,
+    &bench_scene_swizzle,
+    &bench_scene_string_length,
+    &bench_scene_upscale_nearest,
+    &bench_scene_upscale_bilinear,
+    &bench_scene_text_overlay,
+    &bench_scene_audio_mix,
+    &bench_scene_asset_files,
+    &bench_scene_asset_pack,
+    &bench_scene_array,
+    &bench_scene_array_arena,
+    &bench_scene_array_naive,
+    &bench_scene_hash_map,
+    &bench_scene_hash_map_naive,
+    &bench_scene_pool,
+    &bench_scene_pool_naive,
+    &bench_scene_ecs_update_aos,
+    &bench_scene_ecs_update,
+    &bench_scene_ecs_update_parallel,
+    &bench_scene_dashboard_full,
+    &bench_scene_dashboard_layers,
+    &bench_scene_capture_raw,
+    &bench_scene_capture_delta,
+    &bench_scene_capture_qoi,
+    &bench_scene_capture_y4m,
+    &bench_scene_qoi_decode,
+    &bench_scene_qoi_decode_parallel,
+    &bench_scene_qoi_encode,
+    &bench_scene_stream_async,
+    &bench_scene_stream_blocking,
+    &bench_scene_raster_spheres,
+    &bench_scene_raster_spheres_parallel,
+    &bench_scene_raster_fill,
+    &bench_scene_raster_fill_front_to_back,
+    &bench_scene_post_box_blur,
+    &bench_scene_post_box_blur_naive,
+    &bench_scene_post_gaussian_blur,
+    &bench_scene_post_gaussian_blur_parallel,
+    &bench_scene_post_color_grade,
+};
+
+typedef struct _BenchResult {
+    char name[64];
+    b32  skipped;
+    f64  ns_per_frame;
+    f64  ns_per_frame_ci95;
+    f64  ns_per_frame_min;
+    f64  ns_per_frame_median;
+    f64  pixels_per_second;
+    f64  syscalls_per_frame;
+    f64  allocations_per_frame; // Engine, and external when counted
+} BenchResult;
+
+typedef struct _BenchOptions {
+    u32   frames;
+    u32   warmup;
+    const char* scene;
+    const char* json_path;
+    const char* compare_path;
+    f64   threshold_percent;
+} BenchOptions;
+
+static u64 now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+// Read and write family syscalls made by the process so far, as counted
+// by the kernel in /proc/self/io. Reading the file costs one read itself.
+static u64 syscall_count(void)
+{
+    int fd = open("/proc/self/io", O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    char buf[512];
+    ssize_t length = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (length <= 0) {
+        return 0;
+    }
+    buf[length] = '\0';
+
+    u64 syscr = 0, syscw = 0;
+    char* line = strstr(buf, "syscr:");
+    if (line) syscr = strtoull(line + 6, NULL, 10);
+    line = strstr(buf, "syscw:");
+    if (line) syscw = strtoull(line + 6, NULL, 10);
+    return syscr + syscw;
+}
+
+// Allocations through the engine allocator, plus those outside of it when
+// tools/alloc_count is preloaded
+static u64 allocation_count(void)
+{
+    FcMemoryStats stats;
+    fc_memory_get_stats(&stats);
+    return stats.allocations + stats.external_allocations;
+}
+
+static int compare_f64(const void* a, const void* b)
+{
+    f64 x = *(const f64*)a, y = *(const f64*)b;
+    return (x > y) - (x < y);
+}
+
+static void run_scene(BenchScene* scene, BenchOptions* options, BenchResult* result)
+{
+    ApplicationState application_state = {0};
+    application_state.name = "Bench";
+    application_state.width_px  = BENCH_WIDTH_PX;
+    application_state.height_px = BENCH_HEIGHT_PX;
+    application_state.pixel_format = FC_PIXEL_FORMAT_BGRA8;
+    application_state.pixelbuffer = (u32*)FC_ALLOC_ZEROED(
+        (u64)BENCH_WIDTH_PX * BENCH_HEIGHT_PX * sizeof(u32), "bench pixelbuffer");
+
+    snprintf(result->name, sizeof(result->name), "%s", scene->name);
+    f64* samples = (f64*)malloc((u64)options->frames * sizeof(f64));
+    if (samples == NULL || application_state.pixelbuffer == NULL) {
+        fprintf(stderr, "Could not allocate %u frames of scene '%s'\n", options->frames, scene->name);
+        result->skipped = true;
+        free(samples);
+        FC_FREE(application_state.pixelbuffer);
+        return;
+    }
+    if (scene->setup && !scene->setup(&application_state)) {
+        result->skipped = true;
+        free(samples);
+        FC_FREE(application_state.pixelbuffer);
+        return;
+    }
+
+    const f64 delta_time = 1.0 / 60.0;
+    for (u32 i = 0; i < options->warmup; ++i) {
+        scene->frame(&application_state, delta_time);
+    }
+
+    u64 pixels = 0;
+    u64 allocations_before = allocation_count();
+    u64 syscalls_before = syscall_count();
+    for (u32 i = 0; i < options->frames; ++i) {
+        u64 start = now_ns();
+        pixels += scene->frame(&application_state, delta_time);
+        samples[i] = (f64)(now_ns() - start);
+    }
+    u64 syscalls_after = syscall_count();
+    u64 allocations_after = allocation_count();
+
+    if (scene->teardown) {
+        scene->teardown(&application_state);
+    }
+    FC_FREE(application_state.pixelbuffer);
+
+    f64 sum = 0.0;
+    for (u32 i = 0; i < options->frames; ++i) {
+        sum += samples[i];
+    }
+    f64 mean = sum / options->frames;
+    f64 variance = 0.0;
+    for (u32 i = 0; i < options->frames; ++i) {
+        variance += (samples[i] - mean) * (samples[i] - mean);
+    }
+    variance /= options->frames > 1 ? options->frames - 1 : 1;
+    qsort(samples, options->frames, sizeof(f64), compare_f64);
+
+    result->ns_per_frame        = mean;
+    result->ns_per_frame_ci95   = 1.96 * sqrt(variance / options->frames);
+    result->ns_per_frame_min    = samples[0];
+    result->ns_per_frame_median = samples[options->frames / 2];
+    result->pixels_per_second   = pixels > 0 ? (f64)pixels / (sum * 1e-9) : 0.0;
+    result->syscalls_per_frame  =
+        (f64)(syscalls_after - syscalls_before - 1) / options->frames;
+    result->allocations_per_frame =
+        (f64)(allocations_after - allocations_before) / options->frames;
+
+    free(samples);
+}
+
+static void print_result(BenchResult* result)
+{
+    if (result->skipped) {
+        printf("%-20s skipped\n", result->name);
+        return;
+    }
+    printf("%-20s %12.0f ns/frame +- %-10.0f (min %.0f, median %.0f)  "
+           "%8.2f Mpixels/s  %6.2f syscalls/frame  %6.2f allocs/frame\n",
+           result->name, result->ns_per_frame, result->ns_per_frame_ci95,
+           result->ns_per_frame_min, result->ns_per_frame_median,
+           result->pixels_per_second * 1e-6, result->syscalls_per_frame,
+           result->allocations_per_frame);
+}
+
+static b32 write_json(const char* path, BenchOptions* options,
+                      BenchResult* results, u32 result_count)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Could not open '%s' for writing\n", path);
+        return false;
+    }
+
+    // One scene per line, which is what read_json expects
+    fprintf(file, "{\n  \"frames\": %u,\n  \"warmup\": %u,\n  \"scenes\": [\n",
+            options->frames, options->warmup);
+    for (u32 i = 0; i < result_count; ++i) {
+        BenchResult* r = &results[i];
+        fprintf(file, "    {\"name\": \"%s\", \"skipped\": %s, "
+                "\"ns_per_frame\": %.1f, \"ns_per_frame_ci95\": %.1f, "
+                "\"ns_per_frame_min\": %.1f, \"ns_per_frame_median\": %.1f, "
+                "\"pixels_per_second\": %.1f, \"syscalls_per_frame\": %.3f, "
+                "\"allocations_per_frame\": %.3f}%s\n",
+                r->name, r->skipped ? "true" : "false",
+                r->ns_per_frame, r->ns_per_frame_ci95,
+                r->ns_per_frame_min, r->ns_per_frame_median,
+                r->pixels_per_second, r->syscalls_per_frame, r->allocations_per_frame,
+                i + 1 < result_count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+    return true;
+}
+
+static f64 json_number(const char* line, const char* key)
+{
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    const char* value = strstr(line, pattern);
+    return value ? strtod(value + strlen(pattern), NULL) : 0.0;
+}
+
+static u32 read_json(const char* path, BenchResult* results, u32 max_results)
+{
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Could not open baseline '%s'\n", path);
+        return 0;
+    }
+
+    u32 count = 0;
+    char line[1024];
+    while (count < max_results && fgets(line, sizeof(line), file)) {
+        const char* name = strstr(line, "\"name\": \"");
+        if (name == NULL) {
+            continue;
+        }
+        name += strlen("\"name\": \"");
+
+        BenchResult* r = &results[count++];
+        *r = (BenchResult){0};
+        u32 length = 0;
+        while (name[length] && name[length] != '"' && length < sizeof(r->name) - 1) {
+            r->name[length] = name[length];
+            length += 1;
+        }
+        r->skipped            = strstr(line, "\"skipped\": true") != NULL;
+        r->ns_per_frame       = json_number(line, "ns_per_frame");
+        r->ns_per_frame_ci95  = json_number(line, "ns_per_frame_ci95");
+        r->pixels_per_second  = json_number(line, "pixels_per_second");
+        r->syscalls_per_frame = json_number(line, "syscalls_per_frame");
+        r->allocations_per_frame = json_number(line, "allocations_per_frame");
+    }
+    fclose(file);
+    return count;
+}
+
+// A scene regresses when it is slower than the baseline by more than the
+// threshold and the confidence intervals of the two runs do not overlap
+static u32 compare_results(BenchOptions* options, BenchResult* results, u32 result_count)
+{
+    BenchResult baseline[MAX_RESULTS];
+    u32 baseline_count = read_json(options->compare_path, baseline, MAX_RESULTS);
+
+    u32 regressions = 0;
+    printf("\nComparison against %s (threshold %.1f%%):\n",
+           options->compare_path, options->threshold_percent);
+    for (u32 i = 0; i < result_count; ++i) {
+        BenchResult* current = &results[i];
+        BenchResult* base = NULL;
+        for (u32 j = 0; j < baseline_count; ++j) {
+            if (strcmp(baseline[j].name, current->name) == 0) {
+                base = &baseline[j];
+            }
+        }
+        if (current->skipped || base == NULL || base->skipped) {
+            printf("%-20s no comparison\n", current->name);
+            continue;
+        }
+
+        f64 change = (current->ns_per_frame - base->ns_per_frame) / base->ns_per_frame * 100.0;
+        f64 gap = fabs(current->ns_per_frame - base->ns_per_frame)
+            - current->ns_per_frame_ci95 - base->ns_per_frame_ci95;
+        const char* verdict = "ok";
+        if (gap > 0.0 && change > options->threshold_percent) {
+            verdict = "REGRESSION";
+            regressions += 1;
+        } else if (gap > 0.0 && change < -options->threshold_percent) {
+            verdict = "improved";
+        }
+        printf("%-20s %12.0f -> %-12.0f ns/frame %+7.2f%%  "
+               "%6.2f -> %-6.2f syscalls/frame  %s\n",
+               current->name, base->ns_per_frame, current->ns_per_frame, change,
+               base->syscalls_per_frame, current->syscalls_per_frame, verdict);
+    }
+    return regressions;
+}
+
+static void print_usage(const char* program)
+{
+    printf("Usage: %s [options]\n"
+           "  --frames <n>          Measured frames per scene (default 200)\n"
+           "  --warmup <n>          Unmeasured warmup frames (default 20)\n"
+           "  --scene <name>        Only run the given scene\n"
+           "  --json <path>         Write results as JSON\n"
+           "  --compare <path>      Compare against a JSON baseline\n"
+           "  --threshold <pct>     Regression threshold (default 5)\n",
+           program);
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options = {
+        .frames = 200,
+        .warmup = 20,
+        .threshold_percent = 5.0
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        b32 has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--frames") == 0 && has_value) {
+            options.frames = (u32)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && has_value) {
+            options.warmup = (u32)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scene") == 0 && has_value) {
+            options.scene = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && has_value) {
+            options.json_path = argv[++i];
+        } else if (strcmp(argv[i], "--compare") == 0 && has_value) {
+            options.compare_path = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && has_value) {
+            options.threshold_percent = atof(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (options.frames < 2) {
+        options.frames = 2;
+    }
+
+    platform_cpu_init();
+    fc_render_select_kernels(platform_get_cpu_features());
+    fc_raster_select_kernels(platform_get_cpu_features());
+    string_select_kernels(platform_get_cpu_features());
+    printf("Kernels: fill=%s copy=%s swizzle=%s scale=%s blend=%s post=%s raster=%s\n",
+           fc_render_kernels.fill_u32_variant, fc_render_kernels.copy_u32_variant,
+           fc_render_kernels.swizzle_u32_variant, fc_render_kernels.scale_variant,
+           fc_render_kernels.blend_variant, fc_render_kernels.post_variant,
+           fc_raster_kernels.block_variant);
+
+    BenchResult results[MAX_RESULTS];
+    u32 result_count = 0;
+    for (u32 i = 0; i < sizeof(scenes) / sizeof(scenes[0]); ++i) {
+        if (options.scene && strcmp(options.scene, scenes[i]->name) != 0) {
+            continue;
+        }
+        BenchResult* result = &results[result_count++];
+        *result = (BenchResult){0};
+        run_scene(scenes[i], &options, result);
+        print_result(result);
+        fflush(stdout);
+    }
+
+    if (options.json_path && !write_json(options.json_path, &options,
+                                         results, result_count)) {
+        return EXIT_FAILURE;
+    }
+    if (options.compare_path &&
+        compare_results(&options, results, result_count) > 0) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,67 @@
+#ifndef FINCH_BENCH_BENCH_H
+#define FINCH_BENCH_BENCH_H
+
+#include "finch/core/core.h"
+#include "finch/application/application.h"
+
+#define BENCH_WIDTH_PX  1280
+#define BENCH_HEIGHT_PX 720
+
+// A fixed workload that is run once per frame. `setup` may return false to
+// skip the scene (e.g. when no display is available), and `frame` returns
+// the number of pixels it produced, or 0 if pixels are not meaningful.
+typedef struct _BenchScene {
+    const char* name;
+    b32  (*setup)(ApplicationState*);
+    u64  (*frame)(ApplicationState*, f64 delta_time);
+    void (*teardown)(ApplicationState*);
+} BenchScene;
+
+extern BenchScene bench_scene_minimal_gradient;
+extern BenchScene bench_scene_sandbox_shader;
+extern BenchScene bench_scene_logging;
+extern BenchScene bench_scene_logging_file;
+extern BenchScene bench_scene_formatting;
+extern BenchScene bench_scene_present;
+extern BenchScene bench_scene_fill;
+extern BenchScene bench_scene_blit;
+extern BenchScene bench_scene_swizzle;
+extern BenchScene bench_scene_string_length;
+extern BenchScene bench_scene_upscale_nearest;
+extern BenchScene bench_scene_upscale_bilinear;
+extern BenchScene bench_scene_text_overlay;
+extern BenchScene bench_scene_audio_mix;
+extern BenchScene bench_scene_asset_files;
+extern BenchScene bench_scene_asset_pack;
+extern BenchScene bench_scene_array;
+extern BenchScene bench_scene_array_arena;
+extern BenchScene bench_scene_array_naive;
+extern BenchScene bench_scene_hash_map;
+extern BenchScene bench_scene_hash_map_naive;
+extern BenchScene bench_scene_pool;
+extern BenchScene bench_scene_pool_naive;
+extern BenchScene bench_scene_ecs_update_aos;
+extern BenchScene bench_scene_ecs_update;
+extern BenchScene bench_scene_ecs_update_parallel;
+extern BenchScene bench_scene_dashboard_full;
+extern BenchScene bench_scene_dashboard_layers;
+extern BenchScene bench_scene_capture_raw;
+extern BenchScene bench_scene_capture_delta;
+extern BenchScene bench_scene_capture_qoi;
+extern BenchScene bench_scene_capture_y4m;
+extern BenchScene bench_scene_qoi_decode;
+extern BenchScene bench_scene_qoi_decode_parallel;
+extern BenchScene bench_scene_qoi_encode;
+extern BenchScene bench_scene_stream_async;
+extern BenchScene bench_scene_stream_blocking;
+extern BenchScene bench_scene_raster_spheres;
+extern BenchScene bench_scene_raster_spheres_parallel;
+extern BenchScene bench_scene_raster_fill;
+extern BenchScene bench_scene_raster_fill_front_to_back;
+extern BenchScene bench_scene_post_box_blur;
+extern BenchScene bench_scene_post_box_blur_naive;
+extern BenchScene bench_scene_post_gaussian_blur;
+extern BenchScene bench_scene_post_gaussian_blur_parallel;
+extern BenchScene bench_scene_post_color_grade;
+
+#endif // FINCH_BENCH_BENCH_H
@@ -0,0 +1,227 @@
+#include "bench.h"
+
+#include "finch/core/memory.h"
+#include "finch/log/log.h"
+#include "finch/platform/platform.h"
+#include "finch/utils/string.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+//
+// Gradient from examples/minimal
+//
+
+static u64 minimal_gradient_frame(ApplicationState* app_state, f64 delta_time)
+{
+    (void)delta_time;
+
+    FcPixelFormat format = app_state->pixel_format;
+    for (u32 y = 0; y < app_state->height_px; ++y) {
+        for (u32 x = 0; x < app_state->width_px; ++x) {
+            u32* pixel = app_state->pixelbuffer + (x + y * app_state->width_px);
+            
+            *pixel = FC_PACK_PIXEL(format, y, x, 0xFF, 0xFF);
+        }
+    }
+    return (u64)app_state->width_px * app_state->height_px;
+}
+
+BenchScene bench_scene_minimal_gradient = {
+    .name  = "minimal_gradient",
+    .frame = minimal_gradient_frame
+};
+
+//
+// sinf shader from examples/sandbox
+//
+
+static f32 sandbox_time_elapsed_seconds;
+
+static b32 sandbox_shader_setup(ApplicationState* application_state)
+{
+    (void)application_state;
+    sandbox_time_elapsed_seconds = 0.0f;
+    return true;
+}
+
+static u64 sandbox_shader_frame(ApplicationState* application_state, f64 dt)
+{
+    FcPixelFormat format = application_state->pixel_format;
+    for (u32 j = 0; j < application_state->height_px; ++j) {
+        for (u32 i = 0; i < application_state->width_px; ++i) {
+            f32 u = i / (f32)application_state->width_px;
+            f32 v = j / (f32)application_state->height_px;
+
+            Color col = {0};
+            col.r = sinf(u * v * sandbox_time_elapsed_seconds) * 255.0f;
+            col.b = (u8)i;
+            col.g = (u8)j;
+            col.a = 0xFFu;
+
+            application_state->pixelbuffer[i + j * application_state->width_px] =
+                FC_PACK_COLOR(format, col);
+        }
+    }
+    sandbox_time_elapsed_seconds += dt;
+    return (u64)application_state->width_px * application_state->height_px;
+}
+
+BenchScene bench_scene_sandbox_shader = {
+    .name  = "sandbox_shader",
+    .setup = sandbox_shader_setup,
+    .frame = sandbox_shader_frame
+};
+
+//
+// Logging-heavy loop, with stdout redirected to /dev/null
+//
+
+#define LOG_LINES_PER_FRAME 100
+
+static int saved_stdout = -1;
+
+static b32 logging_setup(ApplicationState* application_state)
+{
+    (void)application_state;
+
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd < 0) {
+        return false;
+    }
+    saved_stdout = dup(STDOUT_FILENO);
+    dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+    return true;
+}
+
+static u64 logging_frame(ApplicationState* application_state, f64 dt)
+{
+    for (u32 i = 0; i < LOG_LINES_PER_FRAME; ++i) {
+        FC_INFO("dx: %d, dy: %d, dt: %f",
+                (s32)i, -(s32)i, dt);
+    }
+    (void)application_state;
+    return 0;
+}
+
+static void logging_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    fc_log_flush();
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+}
+
+BenchScene bench_scene_logging = {
+    .name     = "logging",
+    .setup    = logging_setup,
+    .frame    = logging_frame,
+    .teardown = logging_teardown
+};
+
+//
+// Logging-heavy loop into a rotated file sink instead of stdout
+//
+
+#define LOG_FILE_PATH "/tmp/finch_bench.log"
+
+static b32 logging_file_setup(ApplicationState* application_state)
+{
+    (void)application_state;
+
+    FcLogSinkConfig config = {
+        .type          = FC_LOG_SINK_FILE,
+        .path          = LOG_FILE_PATH,
+        .max_file_size = 4 * 1024 * 1024,
+        .max_files     = 2
+    };
+    fc_log_remove_sinks();
+    return fc_log_add_sink(&config);
+}
+
+static void logging_file_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    fc_log_remove_sinks();
+
+    FcLogSinkConfig config = { .type = FC_LOG_SINK_STDOUT };
+    fc_log_add_sink(&config);
+
+    platform_delete_file(LOG_FILE_PATH);
+    platform_delete_file(LOG_FILE_PATH ".1");
+    platform_delete_file(LOG_FILE_PATH ".2");
+}
+
+BenchScene bench_scene_logging_file = {
+    .name     = "logging_file",
+    .setup    = logging_file_setup,
+    .frame    = logging_frame,
+    .teardown = logging_file_teardown
+};
+
+//
+// Formatting-heavy loop
+//
+
+#define FORMATS_PER_FRAME 1000
+
+static u64 formatting_frame(ApplicationState* application_state, f64 dt)
+{
+    char buf[256];
+    u32 total = 0;
+    for (u32 i = 0; i < FORMATS_PER_FRAME; ++i) {
+        total += string_format(buf, sizeof(buf),
+                               "frame %u: %s at (%d, %d) took %f ms [%x]",
+                               i, application_state->name, (s32)i, -(s32)i,
+                               dt * 1000.0, i);
+    }
+    // Keep the result observable so the loop is not optimized away
+    application_state->pixelbuffer[0] = total;
+    return 0;
+}
+
+BenchScene bench_scene_formatting = {
+    .name  = "formatting",
+    .frame = formatting_frame
+};
+
+//
+// Present path: event polling and putting the pixelbuffer on screen
+//
+
+static b32 present_setup(ApplicationState* application_state)
+{
+    if (getenv("DISPLAY") == NULL) {
+        return false;
+    }
+    // The platform layer allocates its own pixelbuffer
+    FC_FREE(application_state->pixelbuffer);
+    application_state->pixelbuffer = NULL;
+    platform_init(application_state);
+    return true;
+}
+
+static u64 present_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    platform_poll_events(application_state);
+    platform_put_pixelbuffer_on_screen(application_state);
+    return (u64)application_state->width_px * application_state->height_px;
+}
+
+static void present_teardown(ApplicationState* application_state)
+{
+    // The platform layer owns and frees the pixelbuffer once initialized
+    platform_deinit(application_state);
+    application_state->pixelbuffer = NULL;
+}
+
+BenchScene bench_scene_present = {
+    .name     = "present",
+    .setup    = present_setup,
+    .frame    = present_frame,
+    .teardown = present_teardown
+};
@@ -0,0 +1,129 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+
+#include "finch/asset/image.h"
+#include "finch/asset/pack.h"
+#include "finch/render/kernels.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+// Startup cost of getting sprites ready to draw: reading and converting
+// one file per sprite, against mapping a pack of pre-converted sprites.
+// Every frame loads all sprites from scratch and blits them once. Files
+// come from the page cache after the first frame in both cases.
+
+#define ASSET_DIRECTORY  "bench_assets"
+#define ASSET_PACK       ASSET_DIRECTORY "/sprites.pack"
+#define SPRITE_COUNT     64
+#define SPRITE_SIZE      64
+
+static char sprite_names[SPRITE_COUNT][32];
+static char sprite_paths[SPRITE_COUNT][64];
+
+static b32 write_sprite(const char* path, u32 seed)
+{
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    fprintf(file, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n",
+            SPRITE_SIZE, SPRITE_SIZE);
+    for (u32 y = 0; y < SPRITE_SIZE; ++y) {
+        for (u32 x = 0; x < SPRITE_SIZE; ++x) {
+            u8 pixel[4] = { (u8)(x * 4 + seed), (u8)(y * 4), (u8)(seed * 16), 0xFF };
+            fwrite(pixel, 1, sizeof(pixel), file);
+        }
+    }
+    return fclose(file) == 0;
+}
+
+static b32 assets_setup(ApplicationState* application_state)
+{
+    mkdir(ASSET_DIRECTORY, 0755);
+
+    FcPackWriter writer;
+    if (!fc_pack_writer_begin(&writer, ASSET_PACK, &application_state->pixel_format)) {
+        return false;
+    }
+    for (u32 i = 0; i < SPRITE_COUNT; ++i) {
+        snprintf(sprite_names[i], sizeof(sprite_names[i]), "sprite_%02u.pam", i);
+        snprintf(sprite_paths[i], sizeof(sprite_paths[i]), ASSET_DIRECTORY "/%s", sprite_names[i]);
+
+        FcImage image;
+        if (!write_sprite(sprite_paths[i], i) ||
+            !fc_image_load_netpbm(&image, sprite_paths[i], &application_state->pixel_format)) {
+            fc_pack_writer_finish(&writer);
+            return false;
+        }
+        fc_pack_writer_add_image(&writer, sprite_names[i], &image);
+        fc_image_free(&image);
+    }
+    return fc_pack_writer_finish(&writer);
+}
+
+static void assets_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    for (u32 i = 0; i < SPRITE_COUNT; ++i) {
+        remove(sprite_paths[i]);
+    }
+    remove(ASSET_PACK);
+    remove(ASSET_DIRECTORY);
+}
+
+static void blit_sprite(ApplicationState* application_state, u32 index,
+                        const u32* pixels, u32 stride)
+{
+    u32 columns = application_state->width_px / SPRITE_SIZE;
+    u32 x = (index % columns) * SPRITE_SIZE;
+    u32 y = (index / columns) * SPRITE_SIZE;
+    fc_blit_u32(application_state->pixelbuffer + (u64)y * application_state->width_px + x,
+                application_state->width_px, pixels, stride, SPRITE_SIZE, SPRITE_SIZE);
+}
+
+static u64 files_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    for (u32 i = 0; i < SPRITE_COUNT; ++i) {
+        FcImage image;
+        if (fc_image_load_netpbm(&image, sprite_paths[i], &application_state->pixel_format)) {
+            blit_sprite(application_state, i, image.pixels, image.width);
+            fc_image_free(&image);
+        }
+    }
+    return (u64)SPRITE_COUNT * SPRITE_SIZE * SPRITE_SIZE;
+}
+
+static u64 pack_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    FcPack pack;
+    if (!fc_pack_open(&pack, ASSET_PACK)) {
+        return 0;
+    }
+    for (u32 i = 0; i < SPRITE_COUNT; ++i) {
+        FcPackImage image;
+        if (fc_pack_get_image(&pack, sprite_names[i], &image)) {
+            blit_sprite(application_state, i, image.pixels, image.stride);
+        }
+    }
+    fc_pack_close(&pack);
+    return (u64)SPRITE_COUNT * SPRITE_SIZE * SPRITE_SIZE;
+}
+
+BenchScene bench_scene_asset_files = {
+    .name     = "asset_files",
+    .setup    = assets_setup,
+    .frame    = files_frame,
+    .teardown = assets_teardown
+};
+
+BenchScene bench_scene_asset_pack = {
+    .name     = "asset_pack",
+    .setup    = assets_setup,
+    .frame    = pack_frame,
+    .teardown = assets_teardown
+};
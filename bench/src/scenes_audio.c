@@ -0,0 +1,67 @@
+#include "bench.h"
+
+#include "finch/audio/audio.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// Mixes FC_AUDIO_MAX_VOICES looping voices at different pitches, so that
+// every voice is resampled, for the length of one 60fps frame
+
+#define TONE_FRAMES 4800
+
+static FcAudio* audio;
+static f32      tone_samples[2][TONE_FRAMES * 2];
+static FcSound  tones[2];
+static f32*     mix_output;
+
+static b32 audio_setup(ApplicationState* application_state)
+{
+    (void)application_state;
+
+    for (u32 i = 0; i < TONE_FRAMES; ++i) {
+        f32 phase = 2.0f * 3.14159265f * 440.0f * i / 48000.0f;
+        tone_samples[0][i]         = sinf(phase);
+        tone_samples[1][2 * i]     = sinf(phase);
+        tone_samples[1][2 * i + 1] = cosf(phase);
+    }
+    tones[0] = (FcSound){ tone_samples[0], TONE_FRAMES, 1, 48000 };
+    tones[1] = (FcSound){ tone_samples[1], TONE_FRAMES, 2, 44100 };
+
+    audio = (FcAudio*)malloc(sizeof(FcAudio));
+    FcAudioConfig config = { .sink = FC_AUDIO_SINK_NONE };
+    if (!fc_audio_init(audio, &config)) {
+        free(audio);
+        return false;
+    }
+    mix_output = (f32*)malloc(800 * FC_AUDIO_CHANNELS * sizeof(f32));
+
+    for (u32 i = 0; i < FC_AUDIO_MAX_VOICES; ++i) {
+        FcVoiceId voice = fc_audio_play(audio, &tones[i % 2], 0.1f, (i % 5) * 0.5f - 1.0f, true);
+        fc_audio_set_pitch(audio, voice, 0.5f + i * 0.03f);
+    }
+    return true;
+}
+
+static u64 audio_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)application_state;
+    (void)delta_time;
+    fc_audio_mix(audio, mix_output, 800);
+    return 0;
+}
+
+static void audio_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    fc_audio_deinit(audio);
+    free(audio);
+    free(mix_output);
+}
+
+BenchScene bench_scene_audio_mix = {
+    .name     = "audio_mix",
+    .setup    = audio_setup,
+    .frame    = audio_frame,
+    .teardown = audio_teardown
+};
@@ -0,0 +1,117 @@
+#include "bench.h"
+
+#include "finch/core/capture.h"
+#include "finch/render/kernels.h"
+
+#include <stdio.h>
+
+// Cost of capturing to the main loop, which only copies each frame into a
+// free buffer, for every format. A box moves over a static gradient so
+// delta frames have something to skip. Teardown reports the rate the
+// writer thread sustained and the frames it could not keep up with.
+
+#define CAPTURE_PATH     "bench_capture"
+#define CAPTURE_BOX_SIZE 128
+
+static FcCapture capture;
+static u64       capture_frame_index;
+
+static b32 capture_setup(ApplicationState* application_state, FcCaptureFormat format,
+                         FcCaptureCompression compression)
+{
+    u32 width = application_state->width_px, height = application_state->height_px;
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; ++x) {
+            application_state->pixelbuffer[(u64)y * width + x] =
+                0xFF000000 | ((x * 255 / width) << 16) | ((y * 255 / height) << 8);
+        }
+    }
+    capture_frame_index = 0;
+
+    FcCaptureConfig config = {
+        .path         = CAPTURE_PATH,
+        .format       = format,
+        .compression  = compression,
+        .width        = width,
+        .height       = height,
+        .pixel_format = application_state->pixel_format
+    };
+    return fc_capture_start(&capture, &config);
+}
+
+static void capture_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    fc_capture_stop(&capture);
+
+    FcCaptureStats stats;
+    fc_capture_get_stats(&capture, &stats);
+    f64 megabytes = (f64)stats.bytes_written / (1024.0 * 1024.0);
+    printf("    writer: %.1f MB in %.3fs (%.0f MB/s), %u written, %u dropped\n",
+           megabytes, stats.write_seconds,
+           stats.write_seconds > 0.0 ? megabytes / stats.write_seconds : 0.0,
+           (u32)stats.frames_written, (u32)stats.frames_dropped);
+    remove(CAPTURE_PATH);
+}
+
+static u64 capture_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    u32 width = application_state->width_px, height = application_state->height_px;
+    u32 x = (u32)(capture_frame_index * 7) % (width - CAPTURE_BOX_SIZE);
+    u32 y = (u32)(capture_frame_index * 3) % (height - CAPTURE_BOX_SIZE);
+    fc_fill_rect_u32(application_state->pixelbuffer, width, x, y,
+                     CAPTURE_BOX_SIZE, CAPTURE_BOX_SIZE, 0xFFFFFFFF - (u32)capture_frame_index);
+    capture_frame_index += 1;
+
+    fc_capture_frame(&capture, application_state->pixelbuffer, width, height);
+    return (u64)width * height;
+}
+
+static b32 capture_raw_setup(ApplicationState* application_state)
+{
+    return capture_setup(application_state, FC_CAPTURE_FORMAT_RAW, FC_CAPTURE_COMPRESSION_NONE);
+}
+
+static b32 capture_delta_setup(ApplicationState* application_state)
+{
+    return capture_setup(application_state, FC_CAPTURE_FORMAT_RAW, FC_CAPTURE_COMPRESSION_DELTA);
+}
+
+static b32 capture_qoi_setup(ApplicationState* application_state)
+{
+    return capture_setup(application_state, FC_CAPTURE_FORMAT_RAW, FC_CAPTURE_COMPRESSION_QOI);
+}
+
+static b32 capture_y4m_setup(ApplicationState* application_state)
+{
+    return capture_setup(application_state, FC_CAPTURE_FORMAT_Y4M, FC_CAPTURE_COMPRESSION_NONE);
+}
+
+BenchScene bench_scene_capture_raw = {
+    .name     = "capture_raw",
+    .setup    = capture_raw_setup,
+    .frame    = capture_frame,
+    .teardown = capture_teardown
+};
+
+BenchScene bench_scene_capture_delta = {
+    .name     = "capture_delta",
+    .setup    = capture_delta_setup,
+    .frame    = capture_frame,
+    .teardown = capture_teardown
+};
+
+BenchScene bench_scene_capture_qoi = {
+    .name     = "capture_qoi",
+    .setup    = capture_qoi_setup,
+    .frame    = capture_frame,
+    .teardown = capture_teardown
+};
+
+BenchScene bench_scene_capture_y4m = {
+    .name     = "capture_y4m",
+    .setup    = capture_y4m_setup,
+    .frame    = capture_frame,
+    .teardown = capture_teardown
+};
@@ -0,0 +1,276 @@
+#include "bench.h"
+
+#include "finch/core/arena.h"
+#include "finch/utils/array.h"
+#include "finch/utils/hash_map.h"
+#include "finch/utils/pool.h"
+
+#include <stdlib.h>
+
+// The engine containers against what apps write without them: an array
+// that reallocs on every push, lookups by linear search and objects from
+// malloc. Each pair does the same work per frame.
+
+#define PUSH_COUNT   65536
+#define KEY_COUNT    1024
+#define LOOKUP_COUNT 16384
+#define OBJECT_COUNT 4096
+
+typedef struct _BenchObject {
+    f32 position[2];
+    f32 velocity[2];
+    u32 id;
+} BenchObject;
+
+typedef struct _BenchEntry {
+    u64 key;
+    u32 value;
+} BenchEntry;
+
+static volatile u64 bench_sink;
+
+static u64 key_at(u32 i)
+{
+    return (u64)i * 0x9E3779B97F4A7C15ull;
+}
+
+//
+// Dynamic array, grown from empty every frame
+//
+
+static u64 array_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)application_state;
+    (void)delta_time;
+    FcArray array;
+    FC_ARRAY_INIT(&array, u32, NULL);
+    for (u32 i = 0; i < PUSH_COUNT; ++i) {
+        *FC_ARRAY_PUSH(&array, u32) = i;
+    }
+    bench_sink = FC_ARRAY_LAST(&array, u32);
+    fc_array_free(&array);
+    return 0;
+}
+
+BenchScene bench_scene_array = {
+    .name  = "container_array",
+    .frame = array_frame
+};
+
+static u8* arena_memory;
+static FcArena arena;
+
+static b32 arena_setup(ApplicationState* application_state)
+{
+    (void)application_state;
+    u64 size = (u64)PUSH_COUNT * sizeof(u32) * 2;
+    arena_memory = (u8*)malloc(size);
+    fc_arena_init(&arena, arena_memory, size);
+    return arena_memory != NULL;
+}
+
+static void arena_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    free(arena_memory);
+}
+
+static u64 array_arena_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)application_state;
+    (void)delta_time;
+    FcAllocator allocator = fc_arena_allocator(&arena);
+    FcArray array;
+    FC_ARRAY_INIT(&array, u32, &allocator);
+    for (u32 i = 0; i < PUSH_COUNT; ++i) {
+        *FC_ARRAY_PUSH(&array, u32) = i;
+    }
+    bench_sink = FC_ARRAY_LAST(&array, u32);
+    fc_arena_reset(&arena);
+    return 0;
+}
+
+BenchScene bench_scene_array_arena = {
+    .name     = "container_array_arena",
+    .setup    = arena_setup,
+    .frame    = array_arena_frame,
+    .teardown = arena_teardown
+};
+
+static u64 array_naive_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)application_state;
+    (void)delta_time;
+    u32* data = NULL;
+    for (u32 i = 0; i < PUSH_COUNT; ++i) {
+        data = (u32*)realloc(data, (i + 1) * sizeof(u32));
+        data[i] = i;
+    }
+    bench_sink = data[PUSH_COUNT - 1];
+    free(data);
+    return 0;
+}
+
+BenchScene bench_scene_array_naive = {
+    .name  = "container_array_naive",
+    .frame = array_naive_frame
+};
+
+//
+// Hash map lookups of keys that are present, and as many that are not
+//
+
+static FcHashMap map;
+static BenchEntry entries[KEY_COUNT];
+
+static b32 map_setup(ApplicationState* application_state)
+{
+    (void)application_state;
+    FC_HASH_MAP_INIT(&map, u64, u32, NULL);
+    for (u32 i = 0; i < KEY_COUNT; ++i) {
+        u32* value = FC_HASH_MAP_INSERT(&map, u64, u32, key_at(i), NULL);
+        if (value == NULL) {
+            return false;
+        }
+        *value = i;
+        entries[i] = (BenchEntry){ .key = key_at(i), .value = i };
+    }
+    return true;
+}
+
+static void map_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    fc_hash_map_free(&map);
+}
+
+static u64 map_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)application_state;
+    (void)delta_time;
+    u64 sum = 0;
+    for (u32 i = 0; i < LOOKUP_COUNT; ++i) {
+        u32* value = FC_HASH_MAP_FIND(&map, u64, u32, key_at((i * 7) % (KEY_COUNT * 2)));
+        sum += value != NULL ? *value : 1;
+    }
+    bench_sink = sum;
+    return 0;
+}
+
+BenchScene bench_scene_hash_map = {
+    .name     = "container_hash_map",
+    .setup    = map_setup,
+    .frame    = map_frame,
+    .teardown = map_teardown
+};
+
+static u64 map_naive_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)application_state;
+    (void)delta_time;
+    u64 sum = 0;
+    for (u32 i = 0; i < LOOKUP_COUNT; ++i) {
+        u64 key = key_at((i * 7) % (KEY_COUNT * 2));
+        u32 value = 1;
+        for (u32 j = 0; j < KEY_COUNT; ++j) {
+            if (entries[j].key == key) {
+                value = entries[j].value;
+                break;
+            }
+        }
+        sum += value;
+    }
+    bench_sink = sum;
+    return 0;
+}
+
+BenchScene bench_scene_hash_map_naive = {
+    .name     = "container_hash_map_naive",
+    .setup    = map_setup,
+    .frame    = map_naive_frame,
+    .teardown = map_teardown
+};
+
+//
+// Objects created and destroyed in a churn, touched through their handles
+//
+
+static FcPool pool;
+static FcPoolHandle handles[OBJECT_COUNT];
+static BenchObject* objects[OBJECT_COUNT];
+
+static b32 pool_setup(ApplicationState* application_state)
+{
+    (void)application_state;
+    return FC_POOL_INIT(&pool, BenchObject, OBJECT_COUNT, NULL);
+}
+
+static void pool_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    fc_pool_free(&pool);
+}
+
+static u64 pool_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)application_state;
+    (void)delta_time;
+    for (u32 i = 0; i < OBJECT_COUNT; ++i) {
+        handles[i] = fc_pool_acquire(&pool);
+        *FC_POOL_GET(&pool, BenchObject, handles[i]) = (BenchObject){ .id = i };
+    }
+    // Every other object dies and is replaced, then all are updated
+    for (u32 i = 0; i < OBJECT_COUNT; i += 2) {
+        fc_pool_release(&pool, handles[i]);
+        handles[i] = fc_pool_acquire(&pool);
+        *FC_POOL_GET(&pool, BenchObject, handles[i]) = (BenchObject){ .id = i };
+    }
+    u64 sum = 0;
+    for (u32 i = 0; i < OBJECT_COUNT; ++i) {
+        BenchObject* object = FC_POOL_GET(&pool, BenchObject, handles[i]);
+        object->position[0] += object->velocity[0];
+        sum += object->id;
+    }
+    for (u32 i = 0; i < OBJECT_COUNT; ++i) {
+        fc_pool_release(&pool, handles[i]);
+    }
+    bench_sink = sum;
+    return 0;
+}
+
+BenchScene bench_scene_pool = {
+    .name     = "container_pool",
+    .setup    = pool_setup,
+    .frame    = pool_frame,
+    .teardown = pool_teardown
+};
+
+static u64 pool_naive_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)application_state;
+    (void)delta_time;
+    for (u32 i = 0; i < OBJECT_COUNT; ++i) {
+        objects[i] = (BenchObject*)malloc(sizeof(BenchObject));
+        *objects[i] = (BenchObject){ .id = i };
+    }
+    for (u32 i = 0; i < OBJECT_COUNT; i += 2) {
+        free(objects[i]);
+        objects[i] = (BenchObject*)malloc(sizeof(BenchObject));
+        *objects[i] = (BenchObject){ .id = i };
+    }
+    u64 sum = 0;
+    for (u32 i = 0; i < OBJECT_COUNT; ++i) {
+        objects[i]->position[0] += objects[i]->velocity[0];
+        sum += objects[i]->id;
+    }
+    for (u32 i = 0; i < OBJECT_COUNT; ++i) {
+        free(objects[i]);
+    }
+    bench_sink = sum;
+    return 0;
+}
+
+BenchScene bench_scene_pool_naive = {
+    .name  = "container_pool_naive",
+    .frame = pool_naive_frame
+};
@@ -0,0 +1,155 @@
+#include "bench.h"
+
+#include "finch/ecs/ecs.h"
+
+#include <stdlib.h>
+
+// Moving 100,000 objects, stored as an array of structs the way a game
+// keeps them at first, against the component store updated on one thread
+// and on the worker threads (FINCH_WORKER_THREADS picks how many).
+
+#define ENTITY_COUNT 100000
+#define BATCH_SIZE   4096
+
+typedef struct _BenchGameObject {
+    f32  position[2];
+    f32  velocity[2];
+    f32  rotation;
+    f32  scale;
+    u32  color;
+    u32  sprite;
+    s32  health;
+    u32  flags;
+    char name[40];
+} BenchGameObject;
+
+static BenchGameObject* game_objects;
+
+static b32 aos_setup(ApplicationState* application_state)
+{
+    (void)application_state;
+    game_objects = (BenchGameObject*)calloc(ENTITY_COUNT, sizeof(BenchGameObject));
+    if (game_objects == NULL) {
+        return false;
+    }
+    for (u32 i = 0; i < ENTITY_COUNT; ++i) {
+        game_objects[i].velocity[0] = (f32)(i % 17) - 8.0f;
+        game_objects[i].velocity[1] = (f32)(i % 13) - 6.0f;
+        game_objects[i].health = 100;
+    }
+    return true;
+}
+
+static void aos_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    free(game_objects);
+}
+
+static u64 aos_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)application_state;
+    f32 dt = (f32)delta_time;
+    for (u32 i = 0; i < ENTITY_COUNT; ++i) {
+        game_objects[i].position[0] += game_objects[i].velocity[0] * dt;
+        game_objects[i].position[1] += game_objects[i].velocity[1] * dt;
+    }
+    return 0;
+}
+
+BenchScene bench_scene_ecs_update_aos = {
+    .name     = "ecs_update_aos",
+    .setup    = aos_setup,
+    .frame    = aos_frame,
+    .teardown = aos_teardown
+};
+
+static FcWorld world;
+static FcGroup movement;
+
+static b32 ecs_setup(ApplicationState* application_state)
+{
+    (void)application_state;
+    if (!fc_world_init(&world, ENTITY_COUNT, NULL)) {
+        return false;
+    }
+    FcComponent position = fc_world_register_component(&world, &(FcComponentDesc){
+        .name = "position", .field_count = 2, .field_sizes = { sizeof(f32), sizeof(f32) }
+    });
+    FcComponent velocity = fc_world_register_component(&world, &(FcComponentDesc){
+        .name = "velocity", .field_count = 2, .field_sizes = { sizeof(f32), sizeof(f32) }
+    });
+    // The rest of BenchGameObject, which the update does not touch
+    FcComponent sprite = fc_world_register_component(&world, &(FcComponentDesc){
+        .name = "sprite", .field_count = 4,
+        .field_sizes = { sizeof(f32), sizeof(f32), sizeof(u32), sizeof(u32) }
+    });
+    FcComponent state = fc_world_register_component(&world, &(FcComponentDesc){
+        .name = "state", .field_count = 3, .field_sizes = { sizeof(s32), sizeof(u32), 40 }
+    });
+    movement = fc_world_create_group(&world, (FcComponent[]){ position, velocity }, 2);
+    if (movement == FC_ECS_INVALID) {
+        return false;
+    }
+
+    for (u32 i = 0; i < ENTITY_COUNT; ++i) {
+        FcEntity entity = fc_entity_create(&world);
+        fc_entity_add(&world, entity, position);
+        fc_entity_add(&world, entity, velocity);
+        fc_entity_add(&world, entity, sprite);
+        fc_entity_add(&world, entity, state);
+        *FC_ENTITY_FIELD(&world, entity, velocity, 0, f32) = (f32)(i % 17) - 8.0f;
+        *FC_ENTITY_FIELD(&world, entity, velocity, 1, f32) = (f32)(i % 13) - 6.0f;
+        *FC_ENTITY_FIELD(&world, entity, state, 0, s32) = 100;
+    }
+    return true;
+}
+
+static void ecs_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    fc_world_free(&world);
+}
+
+static void move_system(FcEcsBatch* batch, void* data)
+{
+    f32 dt = *(f32*)data;
+    f32* x  = FC_BATCH_FIELD(batch, 0, 0, f32);
+    f32* y  = FC_BATCH_FIELD(batch, 0, 1, f32);
+    f32* vx = FC_BATCH_FIELD(batch, 1, 0, f32);
+    f32* vy = FC_BATCH_FIELD(batch, 1, 1, f32);
+    for (u32 i = 0; i < batch->count; ++i) {
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+    }
+}
+
+static u64 ecs_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)application_state;
+    f32 dt = (f32)delta_time;
+    fc_world_run(&world, movement, move_system, &dt, BATCH_SIZE, false);
+    return 0;
+}
+
+BenchScene bench_scene_ecs_update = {
+    .name     = "ecs_update",
+    .setup    = ecs_setup,
+    .frame    = ecs_frame,
+    .teardown = ecs_teardown
+};
+
+static u64 ecs_parallel_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)application_state;
+    f32 dt = (f32)delta_time;
+    fc_world_run(&world, movement, move_system, &dt, BATCH_SIZE, true);
+    return 0;
+}
+
+BenchScene bench_scene_ecs_update_parallel = {
+    .name     = "ecs_update_parallel",
+    .setup    = ecs_setup,
+    .frame    = ecs_parallel_frame,
+    .teardown = ecs_teardown
+};
@@ -0,0 +1,211 @@
+#include "bench.h"
+
+#include "finch/render/kernels.h"
+#include "finch/render/scale.h"
+#include "finch/render/text.h"
+#include "finch/utils/string.h"
+
+#include <stdlib.h>
+
+// Pick a kernel variant with FINCH_CPU_FEATURES to benchmark it
+
+static u32* source_pixels;
+
+static b32 source_setup(ApplicationState* application_state)
+{
+    u64 count = (u64)application_state->width_px * application_state->height_px;
+    source_pixels = (u32*)malloc(count * sizeof(u32));
+    for (u64 i = 0; i < count; ++i) {
+        source_pixels[i] = (u32)(i * 2654435761u);
+    }
+    return true;
+}
+
+static void source_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    free(source_pixels);
+}
+
+//
+// Fill
+//
+
+static u64 fill_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    u64 count = (u64)application_state->width_px * application_state->height_px;
+    fc_fill_u32(application_state->pixelbuffer, 0xFF203040, count);
+    return count;
+}
+
+BenchScene bench_scene_fill = {
+    .name  = "kernel_fill",
+    .frame = fill_frame
+};
+
+//
+// Blit of a full frame, row by row
+//
+
+static u64 blit_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    u32 width = application_state->width_px - 1;
+    fc_blit_u32(application_state->pixelbuffer + 1, application_state->width_px,
+                source_pixels, application_state->width_px,
+                width, application_state->height_px);
+    return (u64)width * application_state->height_px;
+}
+
+BenchScene bench_scene_blit = {
+    .name     = "kernel_blit",
+    .setup    = source_setup,
+    .frame    = blit_frame,
+    .teardown = source_teardown
+};
+
+//
+// RGBA <-> BGRA swizzle
+//
+
+static u64 swizzle_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    u64 count = (u64)application_state->width_px * application_state->height_px;
+    FcSwizzle swizzle = {{ 2, 1, 0, FC_SWIZZLE_ONE }};
+    fc_swizzle_u32(application_state->pixelbuffer, source_pixels, count, swizzle);
+    return count;
+}
+
+BenchScene bench_scene_swizzle = {
+    .name     = "kernel_swizzle",
+    .setup    = source_setup,
+    .frame    = swizzle_frame,
+    .teardown = source_teardown
+};
+
+//
+// String length over log-line sized strings
+//
+
+#define STRINGS_PER_FRAME 1000
+
+static char strings[STRINGS_PER_FRAME][160];
+
+static b32 string_length_setup(ApplicationState* application_state)
+{
+    (void)application_state;
+    for (u32 i = 0; i < STRINGS_PER_FRAME; ++i) {
+        u32 length = 16 + (i * 37) % 140;
+        for (u32 j = 0; j < length; ++j) {
+            strings[i][j] = 'a' + (j % 26);
+        }
+        strings[i][length] = '\0';
+    }
+    return true;
+}
+
+static u64 string_length_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    u32 total = 0;
+    for (u32 i = 0; i < STRINGS_PER_FRAME; ++i) {
+        // Odd offsets exercise the unaligned start
+        total += string_length_null_terminated(strings[i] + (i & 7));
+    }
+    application_state->pixelbuffer[0] = total;
+    return 0;
+}
+
+BenchScene bench_scene_string_length = {
+    .name  = "kernel_string_length",
+    .setup = string_length_setup,
+    .frame = string_length_frame
+};
+
+//
+// Upscale of a frame rendered at half the resolution in each dimension
+//
+
+static FcUpscaler upscaler;
+
+static void upscale_teardown(ApplicationState* application_state)
+{
+    source_teardown(application_state);
+    fc_upscaler_free(&upscaler);
+}
+
+static u64 upscale_frame(ApplicationState* application_state, FcRenderScaleFilter filter)
+{
+    fc_upscaler_run(&upscaler, filter,
+                    application_state->pixelbuffer, application_state->width_px,
+                    application_state->width_px, application_state->height_px,
+                    source_pixels,
+                    application_state->width_px / 2, application_state->height_px / 2);
+    return (u64)application_state->width_px * application_state->height_px;
+}
+
+static u64 upscale_nearest_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    return upscale_frame(application_state, FC_RENDER_SCALE_FILTER_NEAREST);
+}
+
+static u64 upscale_bilinear_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    return upscale_frame(application_state, FC_RENDER_SCALE_FILTER_BILINEAR);
+}
+
+BenchScene bench_scene_upscale_nearest = {
+    .name     = "upscale_nearest",
+    .setup    = source_setup,
+    .frame    = upscale_nearest_frame,
+    .teardown = upscale_teardown
+};
+
+BenchScene bench_scene_upscale_bilinear = {
+    .name     = "upscale_bilinear",
+    .setup    = source_setup,
+    .frame    = upscale_bilinear_frame,
+    .teardown = upscale_teardown
+};
+
+//
+// Text overlay: a few formatted lines of text blended over the frame
+//
+
+static FcFont overlay_font;
+
+static b32 text_setup(ApplicationState* application_state)
+{
+    (void)application_state;
+    fc_font_init_default(&overlay_font, 2);
+    return true;
+}
+
+static u64 text_frame(ApplicationState* application_state, f64 delta_time)
+{
+    for (u32 line = 0; line < 8; ++line) {
+        fc_text_draw_format(&overlay_font, application_state->pixelbuffer,
+                            application_state->width_px, application_state->height_px,
+                            8, 8 + line * overlay_font.glyph_height, 0xFFE0E0E0,
+                            "line %u: frame %f ms, %u x %u", line, delta_time * 1000.0,
+                            application_state->width_px, application_state->height_px);
+    }
+    return 0;
+}
+
+static void text_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    fc_font_free(&overlay_font);
+}
+
+BenchScene bench_scene_text_overlay = {
+    .name     = "text_overlay",
+    .setup    = text_setup,
+    .frame    = text_frame,
+    .teardown = text_teardown
+};
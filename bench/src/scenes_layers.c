@@ -0,0 +1,218 @@
+#include "bench.h"
+
+#include "finch/render/kernels.h"
+#include "finch/render/layer.h"
+#include "finch/render/text.h"
+
+// A mostly static dashboard: a shaded background, a grid of panels with
+// labels and a translucent status bar, where only a clock changes every
+// frame. Drawn from scratch every frame, and with retained layers where
+// only the clock is redrawn and composited.
+
+#define PANEL_COLUMNS 4
+#define PANEL_ROWS    3
+#define PANEL_MARGIN  24
+#define CLOCK_WIDTH   320
+#define CLOCK_HEIGHT  48
+#define STATUS_HEIGHT 40
+
+#define PANEL_MAX_WIDTH  512
+#define PANEL_MAX_HEIGHT 256
+
+static FcFont dashboard_font;
+static u64    dashboard_frame;
+
+// Scratch images of the from-scratch version
+static u32 panel_pixels[PANEL_MAX_WIDTH * PANEL_MAX_HEIGHT];
+static u32 status_pixels[BENCH_WIDTH_PX * STATUS_HEIGHT];
+static u32 clock_pixels[CLOCK_WIDTH * CLOCK_HEIGHT];
+
+static void draw_background(u32* pixels, u32 stride, u32 width, FcRect region)
+{
+    for (s32 y = region.y; y < region.y + region.height; ++y) {
+        u32* row = pixels + (u64)y * stride;
+        for (s32 x = region.x; x < region.x + region.width; ++x) {
+            u32 shade = (u32)((x * 64) / (s32)width + (y & 31));
+            row[x] = 0xFF000000 | (shade << 16) | (shade << 8) | (shade + 32);
+        }
+    }
+}
+
+static void panel_rect(u32 width, u32 height, u32 index, FcRect* rect)
+{
+    u32 panel_width = (width - PANEL_MARGIN * (PANEL_COLUMNS + 1)) / PANEL_COLUMNS;
+    u32 panel_height = (height - STATUS_HEIGHT - PANEL_MARGIN * (PANEL_ROWS + 1)) / PANEL_ROWS;
+    u32 column = index % PANEL_COLUMNS, row = index / PANEL_COLUMNS;
+    *rect = (FcRect){
+        (s32)(PANEL_MARGIN + column * (panel_width + PANEL_MARGIN)),
+        (s32)(PANEL_MARGIN + row * (panel_height + PANEL_MARGIN)),
+        (s32)panel_width, (s32)panel_height
+    };
+}
+
+static void draw_panel(u32* pixels, u32 width, u32 height, u32 index)
+{
+    fc_fill_rect_u32(pixels, width, 0, 0, width, height, 0xFF303848);
+    fc_fill_rect_u32(pixels, width, 0, 0, width, 4, 0xFF60A0E0);
+    for (u32 line = 0; line < 6; ++line) {
+        fc_text_draw_format(&dashboard_font, pixels, width, height,
+                            12, 16 + (s32)(line * dashboard_font.glyph_height), 0xFFE0E0E0,
+                            "Sensor %u.%u  %u units", index, line, index * 37 + line * 11);
+    }
+}
+
+static void draw_status_bar(u32* pixels, u32 width, u32 height)
+{
+    fc_fill_u32(pixels, 0x80101010, (u64)width * height);
+    fc_text_draw(&dashboard_font, pixels, width, height, 12, 12, 0xFFFFFFFF,
+                 "All systems nominal");
+}
+
+static void draw_clock(u32* pixels, u32 width, u32 height)
+{
+    fc_fill_u32(pixels, 0xFF202020, (u64)width * height);
+    fc_text_draw_format(&dashboard_font, pixels, width, height, 12, 12, 0xFF80FF80,
+                        "Frame %u", (u32)dashboard_frame);
+}
+
+static b32 dashboard_setup(ApplicationState* application_state)
+{
+    (void)application_state;
+    fc_font_init_default(&dashboard_font, 2);
+    dashboard_frame = 0;
+    return true;
+}
+
+//
+// Everything redrawn every frame
+//
+
+static void dashboard_full_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    fc_font_free(&dashboard_font);
+}
+
+static u64 dashboard_full_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    u32* pixels = application_state->pixelbuffer;
+    u32 width = application_state->width_px, height = application_state->height_px;
+    dashboard_frame += 1;
+
+    draw_background(pixels, width, width, (FcRect){ 0, 0, (s32)width, (s32)height });
+    for (u32 i = 0; i < PANEL_COLUMNS * PANEL_ROWS; ++i) {
+        FcRect rect;
+        panel_rect(width, height, i, &rect);
+        u32 panel_width = (u32)rect.width < PANEL_MAX_WIDTH ? (u32)rect.width : PANEL_MAX_WIDTH;
+        u32 panel_height = (u32)rect.height < PANEL_MAX_HEIGHT ? (u32)rect.height : PANEL_MAX_HEIGHT;
+        draw_panel(panel_pixels, panel_width, panel_height, i);
+        fc_blit_u32(pixels + (u64)rect.y * width + rect.x, width, panel_pixels, panel_width,
+                    panel_width, panel_height);
+    }
+
+    draw_status_bar(status_pixels, width, STATUS_HEIGHT);
+    for (u32 y = 0; y < STATUS_HEIGHT; ++y) {
+        fc_blend_over_u32(pixels + (u64)(height - STATUS_HEIGHT + y) * width,
+                          status_pixels + (u64)y * width,
+                          application_state->pixel_format.alpha_shift, width);
+    }
+
+    draw_clock(clock_pixels, CLOCK_WIDTH, CLOCK_HEIGHT);
+    fc_blit_u32(pixels + (u64)(height - STATUS_HEIGHT - CLOCK_HEIGHT) * width + width - CLOCK_WIDTH,
+                width, clock_pixels, CLOCK_WIDTH, CLOCK_WIDTH, CLOCK_HEIGHT);
+    return (u64)width * height;
+}
+
+BenchScene bench_scene_dashboard_full = {
+    .name     = "layers_dashboard_full",
+    .setup    = dashboard_setup,
+    .frame    = dashboard_full_frame,
+    .teardown = dashboard_full_teardown
+};
+
+//
+// Retained layers
+//
+
+static FcCompositor compositor;
+static FcLayer*     clock_layer;
+
+static void background_layer_draw(FcLayer* layer, FcRect region, void* data)
+{
+    (void)data;
+    draw_background(layer->pixels, layer->width, layer->width, region);
+}
+
+static void panel_layer_draw(FcLayer* layer, FcRect region, void* data)
+{
+    (void)region;
+    draw_panel(layer->pixels, layer->width, layer->height, (u32)(u64)data);
+}
+
+static void status_layer_draw(FcLayer* layer, FcRect region, void* data)
+{
+    (void)region;
+    (void)data;
+    draw_status_bar(layer->pixels, layer->width, layer->height);
+}
+
+static void clock_layer_draw(FcLayer* layer, FcRect region, void* data)
+{
+    (void)region;
+    (void)data;
+    draw_clock(layer->pixels, layer->width, layer->height);
+}
+
+static b32 dashboard_layers_setup(ApplicationState* application_state)
+{
+    dashboard_setup(application_state);
+    u32 width = application_state->width_px, height = application_state->height_px;
+
+    fc_compositor_init(&compositor, &application_state->pixel_format, 0xFF000000);
+    fc_compositor_add_layer(&compositor, &(FcLayerDesc){
+        .width = width, .height = height, .draw = background_layer_draw
+    });
+    for (u32 i = 0; i < PANEL_COLUMNS * PANEL_ROWS; ++i) {
+        FcRect rect;
+        panel_rect(width, height, i, &rect);
+        fc_compositor_add_layer(&compositor, &(FcLayerDesc){
+            .x = rect.x, .y = rect.y,
+            .width = (u32)rect.width < PANEL_MAX_WIDTH ? (u32)rect.width : PANEL_MAX_WIDTH,
+            .height = (u32)rect.height < PANEL_MAX_HEIGHT ? (u32)rect.height : PANEL_MAX_HEIGHT,
+            .z = 1, .draw = panel_layer_draw, .data = (void*)(u64)i
+        });
+    }
+    fc_compositor_add_layer(&compositor, &(FcLayerDesc){
+        .y = (s32)(height - STATUS_HEIGHT), .width = width, .height = STATUS_HEIGHT,
+        .z = 2, .blend = FC_LAYER_BLEND_ALPHA, .draw = status_layer_draw
+    });
+    clock_layer = fc_compositor_add_layer(&compositor, &(FcLayerDesc){
+        .x = (s32)(width - CLOCK_WIDTH), .y = (s32)(height - STATUS_HEIGHT - CLOCK_HEIGHT),
+        .width = CLOCK_WIDTH, .height = CLOCK_HEIGHT, .z = 3, .draw = clock_layer_draw
+    });
+    return clock_layer != NULL;
+}
+
+static void dashboard_layers_teardown(ApplicationState* application_state)
+{
+    fc_compositor_free(&compositor);
+    dashboard_full_teardown(application_state);
+}
+
+static u64 dashboard_layers_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    dashboard_frame += 1;
+    fc_layer_invalidate(clock_layer, NULL);
+    fc_compositor_render(&compositor, application_state->pixelbuffer,
+                         application_state->width_px, application_state->height_px);
+    return compositor.pixels_composited;
+}
+
+BenchScene bench_scene_dashboard_layers = {
+    .name     = "layers_dashboard",
+    .setup    = dashboard_layers_setup,
+    .frame    = dashboard_layers_frame,
+    .teardown = dashboard_layers_teardown
+};
@@ -0,0 +1,199 @@
+#include "bench.h"
+
+#include "finch/core/memory.h"
+#include "finch/platform/platform.h"
+#include "finch/render/kernels.h"
+#include "finch/render/post.h"
+
+#include <stdio.h>
+
+// Post-processing of the whole pixelbuffer. The blur scenes run a box blur
+// and a Gaussian blur, whose cost per pixel does not depend on the radius,
+// next to a box blur that sums every window directly; the grade scene runs
+// a tone curve and a 3D LUT fused over the same rows. The frame time of
+// the chain is reported at teardown.
+
+#define POST_BOX_RADIUS      16
+#define POST_GAUSSIAN_SIGMA  8.0f
+#define POST_COLOR_LUT_SIZE  33
+
+static FcPostChain post_chain;
+static FcToneLut   post_tone;
+static FcColorLut  post_grade;
+static u32*        post_naive_scratch;
+static u32*        post_naive_output;
+static f64         post_time_ms;
+static u32         post_runs;
+
+static void post_draw_pattern(ApplicationState* application_state)
+{
+    u32 width = application_state->width_px, height = application_state->height_px;
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; ++x) {
+            u8 check = ((x ^ y) & 32) ? 220 : 40;
+            application_state->pixelbuffer[y * width + x] =
+                FC_PACK_PIXEL(application_state->pixel_format, check, x * 255 / width,
+                              y * 255 / height, 255);
+        }
+    }
+}
+
+static void post_setup(ApplicationState* application_state, b32 parallel)
+{
+    fc_post_chain_init(&post_chain, parallel);
+    post_draw_pattern(application_state);
+    post_time_ms = 0.0;
+    post_runs = 0;
+}
+
+static void post_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    printf("    post: %.3f ms per run\n", post_runs > 0 ? post_time_ms / post_runs : 0.0);
+    fc_post_chain_free(&post_chain);
+    fc_color_lut_free(&post_grade);
+    FC_FREE(post_naive_scratch);
+    FC_FREE(post_naive_output);
+    post_naive_scratch = NULL;
+    post_naive_output = NULL;
+}
+
+static u64 post_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    fc_post_chain_run(&post_chain, application_state->pixelbuffer, application_state->width_px,
+                      application_state->height_px, application_state->width_px,
+                      &application_state->pixel_format);
+    post_time_ms += post_chain.last_run_ms;
+    post_runs++;
+    return (u64)application_state->width_px * application_state->height_px;
+}
+
+static b32 post_box_blur_setup(ApplicationState* application_state)
+{
+    post_setup(application_state, false);
+    fc_post_chain_add_box_blur(&post_chain, POST_BOX_RADIUS);
+    return true;
+}
+
+static b32 post_gaussian_blur_setup(ApplicationState* application_state)
+{
+    post_setup(application_state, false);
+    fc_post_chain_add_gaussian_blur(&post_chain, POST_GAUSSIAN_SIGMA);
+    return true;
+}
+
+static b32 post_gaussian_blur_parallel_setup(ApplicationState* application_state)
+{
+    post_setup(application_state, true);
+    fc_post_chain_add_gaussian_blur(&post_chain, POST_GAUSSIAN_SIGMA);
+    return true;
+}
+
+static b32 post_color_grade_setup(ApplicationState* application_state)
+{
+    if (!fc_color_lut_init(&post_grade, POST_COLOR_LUT_SIZE)) {
+        return false;
+    }
+    // Warm highlights and cool shadows
+    for (u32 b = 0; b < POST_COLOR_LUT_SIZE; ++b) {
+        for (u32 g = 0; g < POST_COLOR_LUT_SIZE; ++g) {
+            for (u32 r = 0; r < POST_COLOR_LUT_SIZE; ++r) {
+                f32 red = (f32)r / (POST_COLOR_LUT_SIZE - 1);
+                f32 green = (f32)g / (POST_COLOR_LUT_SIZE - 1);
+                f32 blue = (f32)b / (POST_COLOR_LUT_SIZE - 1);
+                f32 luma = 0.3f * red + 0.59f * green + 0.11f * blue;
+                fc_color_lut_set(&post_grade, r, g, b, red + 0.1f * luma, green,
+                                 blue + 0.1f * (1.0f - luma));
+            }
+        }
+    }
+    fc_tone_lut_init(&post_tone, 1.1f, 1.2f, 2.2f);
+    post_setup(application_state, false);
+    fc_post_chain_add_tone(&post_chain, &post_tone);
+    fc_post_chain_add_color_grade(&post_chain, &post_grade);
+    return true;
+}
+
+static b32 post_box_blur_naive_setup(ApplicationState* application_state)
+{
+    post_setup(application_state, false);
+    u64 size = (u64)application_state->width_px * application_state->height_px * sizeof(u32);
+    post_naive_scratch = (u32*)FC_ALLOC(size, "bench");
+    post_naive_output = (u32*)FC_ALLOC(size, "bench");
+    return post_naive_scratch != NULL && post_naive_output != NULL;
+}
+
+// Each pass sums the whole window of every pixel, for comparison. Like the
+// chain it leaves the pixelbuffer as drawn and writes a separate output.
+static u64 post_box_blur_naive_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    f64 start_time = platform_get_epoch_time();
+    u32 width = application_state->width_px, height = application_state->height_px;
+    const u32* pixels = application_state->pixelbuffer;
+    u32* scratch = post_naive_scratch;
+    u32 scale = 65536 / (2 * POST_BOX_RADIUS + 1);
+    for (u32 pass = 0; pass < 2; ++pass) {
+        const u32* src = pass == 0 ? pixels : scratch;
+        u32* dest = pass == 0 ? scratch : post_naive_output;
+        for (u32 y = 0; y < height; ++y) {
+            for (u32 x = 0; x < width; ++x) {
+                u32 sums[4] = {0};
+                for (s32 k = -POST_BOX_RADIUS; k <= POST_BOX_RADIUS; ++k) {
+                    s32 sx = pass == 0 ? (s32)x + k : (s32)x;
+                    s32 sy = pass == 0 ? (s32)y : (s32)y + k;
+                    sx = sx < 0 ? 0 : sx >= (s32)width ? (s32)width - 1 : sx;
+                    sy = sy < 0 ? 0 : sy >= (s32)height ? (s32)height - 1 : sy;
+                    u32 pixel = src[(u64)sy * width + sx];
+                    for (u32 c = 0; c < 4; ++c) {
+                        sums[c] += (pixel >> (c * 8)) & 0xFF;
+                    }
+                }
+                u32 result = 0;
+                for (u32 c = 0; c < 4; ++c) {
+                    result |= ((sums[c] * scale + 32768) >> 16) << (c * 8);
+                }
+                dest[(u64)y * width + x] = result;
+            }
+        }
+    }
+    post_time_ms += (platform_get_epoch_time() - start_time) * 1000.0;
+    post_runs++;
+    return (u64)width * height;
+}
+
+BenchScene bench_scene_post_box_blur = {
+    .name     = "post_box_blur",
+    .setup    = post_box_blur_setup,
+    .frame    = post_frame,
+    .teardown = post_teardown
+};
+
+BenchScene bench_scene_post_box_blur_naive = {
+    .name     = "post_box_blur_naive",
+    .setup    = post_box_blur_naive_setup,
+    .frame    = post_box_blur_naive_frame,
+    .teardown = post_teardown
+};
+
+BenchScene bench_scene_post_gaussian_blur = {
+    .name     = "post_gaussian_blur",
+    .setup    = post_gaussian_blur_setup,
+    .frame    = post_frame,
+    .teardown = post_teardown
+};
+
+BenchScene bench_scene_post_gaussian_blur_parallel = {
+    .name     = "post_gaussian_blur_parallel",
+    .setup    = post_gaussian_blur_parallel_setup,
+    .frame    = post_frame,
+    .teardown = post_teardown
+};
+
+BenchScene bench_scene_post_color_grade = {
+    .name     = "post_color_grade",
+    .setup    = post_color_grade_setup,
+    .frame    = post_frame,
+    .teardown = post_teardown
+};
@@ -0,0 +1,163 @@
+#include "bench.h"
+
+#include "finch/asset/image.h"
+#include "finch/core/memory.h"
+
+#include <math.h>
+#include <stdio.h>
+
+// QOI decoding straight into the pixelbuffer, one image of a small corpus
+// per frame: sprites on a transparent background, a flat interface with
+// gradients and a photo-like image with smooth shading and grain. The
+// parallel scene decodes a stripe per job, and the encode scene compresses
+// the pixelbuffer as a screenshot or capture would. Setup reports the
+// compression ratio, and decoded MB/s is four times the reported pixels/s.
+
+#define QOI_CORPUS_SIZE 3
+
+static u8* qoi_corpus[QOI_CORPUS_SIZE];
+static u8* qoi_encoded;
+static u64 qoi_encoded_capacity;
+static u64 qoi_corpus_sizes[QOI_CORPUS_SIZE];
+static u32 qoi_frame_index;
+
+static u32 qoi_random(u32* state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static u32 qoi_corpus_pixel(u32 image, u32 x, u32 y, u32* state)
+{
+    switch (image) {
+        case 0: {
+            // 48 px sprites with a few colours, every other cell empty
+            u32 cell = (x / 48) * 31 + (y / 48) * 17;
+            u32 dx = x % 48, dy = y % 48;
+            if ((cell & 1) || (dx - 24) * (dx - 24) + (dy - 24) * (dy - 24) > 400) {
+                return 0;
+            }
+            return 0xFF000000 | ((cell * 40) & 0xFF) << 16 | ((dy * 5) & 0xF0) << 8 | (cell & 0xC0);
+        }
+        case 1: {
+            // Panels with a vertical gradient and text-like specks
+            b32 panel = (x / 160 + y / 120) & 1;
+            u32 shade = panel ? 0x30 + y % 120 / 4 : 0x20;
+            b32 text = panel && y % 120 > 20 && y % 120 < 100 && x % 160 > 16 &&
+                       x % 160 < 144 && (qoi_random(state) & 7) == 0;
+            return text ? 0xFFF0F0F0 : 0xFF000000 | shade << 16 | shade << 8 | (shade + 0x10);
+        }
+        default: {
+            f32 light = 0.5f + 0.25f * sinf((f32)x * 0.011f) + 0.25f * cosf((f32)y * 0.017f);
+            u32 grain = qoi_random(state) % 6;
+            u32 r = (u32)(light * 200.0f) + grain;
+            u32 g = (u32)(light * 160.0f) + grain;
+            u32 b = (u32)(light * 120.0f) + grain;
+            return 0xFF000000 | r << 16 | g << 8 | b;
+        }
+    }
+}
+
+static b32 qoi_setup(ApplicationState* application_state)
+{
+    u32 width = application_state->width_px, height = application_state->height_px;
+    u64 raw_size = (u64)width * height * sizeof(u32);
+    u32* pixels = (u32*)FC_ALLOC(raw_size, "bench");
+    u64 encoded_total = 0;
+    u32 state = 1;
+
+    FcPixelFormat format = FC_PIXEL_FORMAT_BGRA8;
+    for (u32 i = 0; i < QOI_CORPUS_SIZE; ++i) {
+        for (u32 y = 0; y < height; ++y) {
+            for (u32 x = 0; x < width; ++x) {
+                pixels[(u64)y * width + x] = qoi_corpus_pixel(i, x, y, &state);
+            }
+        }
+        u64 capacity = fc_image_qoi_max_size(width, height, FC_QOI_STRIPE_ROWS);
+        qoi_corpus[i] = (u8*)FC_ALLOC(capacity, "bench");
+        qoi_corpus_sizes[i] = fc_image_encode_qoi(qoi_corpus[i], capacity, pixels, width, height,
+                                                  width, &format, true, FC_QOI_STRIPE_ROWS);
+        encoded_total += qoi_corpus_sizes[i];
+    }
+    FC_FREE(pixels);
+    qoi_encoded_capacity = fc_image_qoi_max_size(width, height, FC_QOI_STRIPE_ROWS);
+    qoi_encoded = (u8*)FC_ALLOC(qoi_encoded_capacity, "bench");
+
+    printf("    corpus: %u images, %.1f MB raw, %.1f MB as QOI (%.1f%%)\n",
+           QOI_CORPUS_SIZE, (f64)(raw_size * QOI_CORPUS_SIZE) / (1024.0 * 1024.0),
+           (f64)encoded_total / (1024.0 * 1024.0),
+           100.0 * (f64)encoded_total / (f64)(raw_size * QOI_CORPUS_SIZE));
+    qoi_frame_index = 0;
+    return true;
+}
+
+static void qoi_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    for (u32 i = 0; i < QOI_CORPUS_SIZE; ++i) {
+        FC_FREE(qoi_corpus[i]);
+    }
+    FC_FREE(qoi_encoded);
+}
+
+static u64 qoi_decode(ApplicationState* application_state, b32 parallel)
+{
+    u32 image = qoi_frame_index++ % QOI_CORPUS_SIZE;
+    if (!fc_image_decode_qoi(qoi_corpus[image], qoi_corpus_sizes[image],
+                             application_state->pixelbuffer, application_state->width_px,
+                             &application_state->pixel_format, parallel)) {
+        return 0;
+    }
+    return (u64)application_state->width_px * application_state->height_px;
+}
+
+static u64 qoi_decode_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    return qoi_decode(application_state, false);
+}
+
+static u64 qoi_decode_parallel_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    return qoi_decode(application_state, true);
+}
+
+static b32 qoi_encode_setup(ApplicationState* application_state)
+{
+    // Encodes the photo-like image, the slowest to compress
+    qoi_setup(application_state);
+    qoi_frame_index = QOI_CORPUS_SIZE - 1;
+    return qoi_decode(application_state, false) > 0;
+}
+
+static u64 qoi_encode_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    u32 width = application_state->width_px, height = application_state->height_px;
+    fc_image_encode_qoi(qoi_encoded, qoi_encoded_capacity, application_state->pixelbuffer,
+                        width, height, width, &application_state->pixel_format, false,
+                        FC_QOI_STRIPE_ROWS);
+    return (u64)width * height;
+}
+
+BenchScene bench_scene_qoi_decode = {
+    .name     = "qoi_decode",
+    .setup    = qoi_setup,
+    .frame    = qoi_decode_frame,
+    .teardown = qoi_teardown
+};
+
+BenchScene bench_scene_qoi_decode_parallel = {
+    .name     = "qoi_decode_parallel",
+    .setup    = qoi_setup,
+    .frame    = qoi_decode_parallel_frame,
+    .teardown = qoi_teardown
+};
+
+BenchScene bench_scene_qoi_encode = {
+    .name     = "qoi_encode",
+    .setup    = qoi_encode_setup,
+    .frame    = qoi_encode_frame,
+    .teardown = qoi_teardown
+};
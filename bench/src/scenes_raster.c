@@ -0,0 +1,250 @@
+#include "bench.h"
+
+#include "finch/core/memory.h"
+#include "finch/platform/platform.h"
+#include "finch/render/kernels.h"
+#include "finch/render/raster.h"
+
+#include <math.h>
+#include <stdio.h>
+
+// 3D rasterization into the pixelbuffer. The sphere scenes turn a grid of
+// lit spheres, many triangles of a few pixels each, and report triangles/s
+// at teardown; the parallel one rasterizes a tile per job. The fill scenes
+// draw large textured quads over the whole screen, back to front so every
+// layer is written, and front to back so the farthest depth kept per block
+// rejects most of them; their pixels/s is the fill rate.
+
+#define RASTER_SPHERE_RINGS    16
+#define RASTER_SPHERE_SEGMENTS 32
+#define RASTER_SPHERE_COLUMNS  8
+#define RASTER_SPHERE_ROWS     5
+#define RASTER_FILL_LAYERS     8
+#define RASTER_TEXTURE_SIZE    64
+
+static FcRaster        raster;
+static FcRasterVertex* raster_vertices;
+static u32*            raster_indices;
+static u32             raster_vertex_count;
+static u32             raster_index_count;
+static u32*            raster_texels;
+static FcRasterTexture raster_texture;
+static f64             raster_time;
+static u64             raster_triangles;
+static u32             raster_frame_index;
+
+static b32 raster_setup(ApplicationState* application_state, u32 vertex_count, u32 index_count)
+{
+    (void)application_state;
+    fc_raster_init(&raster, FC_RASTER_DEPTH_32);
+    raster_vertices = (FcRasterVertex*)FC_ALLOC(vertex_count * sizeof(FcRasterVertex), "bench");
+    raster_indices = (u32*)FC_ALLOC(index_count * sizeof(u32), "bench");
+    raster_texels = (u32*)FC_ALLOC(RASTER_TEXTURE_SIZE * RASTER_TEXTURE_SIZE * sizeof(u32), "bench");
+    if (raster_vertices == NULL || raster_indices == NULL || raster_texels == NULL) {
+        FC_FREE(raster_vertices);
+        FC_FREE(raster_indices);
+        FC_FREE(raster_texels);
+        return false;
+    }
+    for (u32 y = 0; y < RASTER_TEXTURE_SIZE; ++y) {
+        for (u32 x = 0; x < RASTER_TEXTURE_SIZE; ++x) {
+            raster_texels[y * RASTER_TEXTURE_SIZE + x] = ((x ^ y) & 8) ? 0xFFE0E0E0 : 0xFF4060A0;
+        }
+    }
+    raster_texture = (FcRasterTexture){ raster_texels, RASTER_TEXTURE_SIZE, RASTER_TEXTURE_SIZE };
+    raster_vertex_count = vertex_count;
+    raster_index_count = index_count;
+    raster_time = 0.0;
+    raster_triangles = 0;
+    raster_frame_index = 0;
+    return true;
+}
+
+static void raster_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    printf("    raster: %.2f Mtriangles/s, last frame %llu triangles set up, "
+           "%llu blocks rasterized, %llu rejected by depth\n",
+           raster_time > 0.0 ? (f64)raster_triangles / raster_time / 1e6 : 0.0,
+           (unsigned long long)raster.stats.triangles_binned,
+           (unsigned long long)raster.stats.blocks_rasterized,
+           (unsigned long long)raster.stats.blocks_rejected);
+    fc_raster_free(&raster);
+    FC_FREE(raster_vertices);
+    FC_FREE(raster_indices);
+    FC_FREE(raster_texels);
+}
+
+static b32 raster_begin(ApplicationState* application_state)
+{
+    fc_fill_rect_u32(application_state->pixelbuffer, application_state->width_px, 0, 0,
+                     application_state->width_px, application_state->height_px, 0xFF101018);
+    if (!fc_raster_begin(&raster, application_state->pixelbuffer, application_state->width_px,
+                         application_state->height_px, application_state->width_px,
+                         &application_state->pixel_format)) {
+        return false;
+    }
+    fc_raster_clear_depth(&raster);
+    return true;
+}
+
+static b32 raster_spheres_setup(ApplicationState* application_state)
+{
+    u32 vertex_count = (RASTER_SPHERE_RINGS + 1) * (RASTER_SPHERE_SEGMENTS + 1);
+    u32 index_count = RASTER_SPHERE_RINGS * RASTER_SPHERE_SEGMENTS * 6;
+    if (!raster_setup(application_state, vertex_count, index_count)) {
+        return false;
+    }
+
+    // Unit sphere, lit from the upper left into its vertex colors
+    FcRasterVertex* vertex = raster_vertices;
+    for (u32 ring = 0; ring <= RASTER_SPHERE_RINGS; ++ring) {
+        f32 theta = 3.14159265f * (f32)ring / RASTER_SPHERE_RINGS;
+        for (u32 segment = 0; segment <= RASTER_SPHERE_SEGMENTS; ++segment) {
+            f32 phi = 6.28318531f * (f32)segment / RASTER_SPHERE_SEGMENTS;
+            f32 x = sinf(theta) * cosf(phi), y = cosf(theta), z = -sinf(theta) * sinf(phi);
+            f32 light = 0.25f + 0.75f * fmaxf(0.0f, -0.5f * x + 0.6f * y + 0.6f * z);
+            *vertex++ = (FcRasterVertex){
+                .position = { x, y, z },
+                .color    = { light, light * 0.9f, light * 0.8f },
+                .uv       = { (f32)segment / RASTER_SPHERE_SEGMENTS * 4.0f,
+                              (f32)ring / RASTER_SPHERE_RINGS * 2.0f },
+            };
+        }
+    }
+    u32* index = raster_indices;
+    for (u32 ring = 0; ring < RASTER_SPHERE_RINGS; ++ring) {
+        for (u32 segment = 0; segment < RASTER_SPHERE_SEGMENTS; ++segment) {
+            u32 a = ring * (RASTER_SPHERE_SEGMENTS + 1) + segment;
+            u32 b = a + RASTER_SPHERE_SEGMENTS + 1;
+            *index++ = a; *index++ = b; *index++ = a + 1;
+            *index++ = a + 1; *index++ = b; *index++ = b + 1;
+        }
+    }
+    return true;
+}
+
+static u64 raster_spheres(ApplicationState* application_state, b32 parallel)
+{
+    if (!raster_begin(application_state)) {
+        return 0;
+    }
+    f64 start_time = platform_get_epoch_time();
+    f32 aspect = (f32)application_state->width_px / (f32)application_state->height_px;
+    FcMat4 projection = fc_mat4_perspective(0.9f, aspect, 0.5f, 100.0f);
+    f32 angle = (f32)raster_frame_index++ * 0.02f;
+    for (u32 row = 0; row < RASTER_SPHERE_ROWS; ++row) {
+        for (u32 column = 0; column < RASTER_SPHERE_COLUMNS; ++column) {
+            FcMat4 translation = fc_mat4_translation(
+                ((f32)column - (RASTER_SPHERE_COLUMNS - 1) * 0.5f) * 2.2f,
+                ((f32)row - (RASTER_SPHERE_ROWS - 1) * 0.5f) * 2.2f, -13.0f);
+            FcMat4 rotation = fc_mat4_rotation_y(angle + (f32)(row * RASTER_SPHERE_COLUMNS + column));
+            FcMat4 model = fc_mat4_multiply(&translation, &rotation);
+            FcMat4 transform = fc_mat4_multiply(&projection, &model);
+            fc_raster_draw(&raster, &transform, raster_vertices, raster_vertex_count,
+                           raster_indices, raster_index_count, (row + column) & 1 ? &raster_texture : NULL);
+        }
+    }
+    fc_raster_end(&raster, parallel);
+    raster_time += platform_get_epoch_time() - start_time;
+    raster_triangles += raster.stats.triangles_submitted;
+    return (u64)application_state->width_px * application_state->height_px;
+}
+
+static u64 raster_spheres_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    return raster_spheres(application_state, false);
+}
+
+static u64 raster_spheres_parallel_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    return raster_spheres(application_state, true);
+}
+
+static b32 raster_fill_setup(ApplicationState* application_state)
+{
+    if (!raster_setup(application_state, 4, 6)) {
+        return false;
+    }
+    // A quad a little larger than the view at a depth of one
+    static const f32 corners[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+    for (u32 i = 0; i < 4; ++i) {
+        raster_vertices[i] = (FcRasterVertex){
+            .position = { corners[i][0] * 1.2f, corners[i][1] * 0.8f, 0.0f },
+            .color    = { 1.0f, 1.0f, 1.0f },
+            .uv       = { corners[i][0] * 4.0f, corners[i][1] * 3.0f },
+        };
+    }
+    static const u32 indices[6] = { 0, 1, 2, 0, 2, 3 };
+    for (u32 i = 0; i < 6; ++i) {
+        raster_indices[i] = indices[i];
+    }
+    return true;
+}
+
+static u64 raster_fill(ApplicationState* application_state, b32 front_to_back)
+{
+    if (!raster_begin(application_state)) {
+        return 0;
+    }
+    f64 start_time = platform_get_epoch_time();
+    f32 aspect = (f32)application_state->width_px / (f32)application_state->height_px;
+    FcMat4 projection = fc_mat4_perspective(1.0f, aspect, 0.5f, 100.0f);
+    for (u32 i = 0; i < RASTER_FILL_LAYERS; ++i) {
+        u32 layer = front_to_back ? i : RASTER_FILL_LAYERS - 1 - i;
+        f32 distance = 1.0f + 0.05f * (f32)layer;
+        FcMat4 translation = fc_mat4_translation(0.0f, 0.0f, -distance);
+        FcMat4 scale = fc_mat4_identity();
+        scale.m[0] = scale.m[5] = distance;
+        FcMat4 model = fc_mat4_multiply(&translation, &scale);
+        FcMat4 transform = fc_mat4_multiply(&projection, &model);
+        fc_raster_draw(&raster, &transform, raster_vertices, raster_vertex_count,
+                       raster_indices, raster_index_count, &raster_texture);
+    }
+    fc_raster_end(&raster, false);
+    raster_time += platform_get_epoch_time() - start_time;
+    raster_triangles += raster.stats.triangles_submitted;
+    return raster.stats.pixels_written;
+}
+
+static u64 raster_fill_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    return raster_fill(application_state, false);
+}
+
+static u64 raster_fill_front_to_back_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    return raster_fill(application_state, true);
+}
+
+BenchScene bench_scene_raster_spheres = {
+    .name     = "raster_spheres",
+    .setup    = raster_spheres_setup,
+    .frame    = raster_spheres_frame,
+    .teardown = raster_teardown
+};
+
+BenchScene bench_scene_raster_spheres_parallel = {
+    .name     = "raster_spheres_parallel",
+    .setup    = raster_spheres_setup,
+    .frame    = raster_spheres_parallel_frame,
+    .teardown = raster_teardown
+};
+
+BenchScene bench_scene_raster_fill = {
+    .name     = "raster_fill",
+    .setup    = raster_fill_setup,
+    .frame    = raster_fill_frame,
+    .teardown = raster_teardown
+};
+
+BenchScene bench_scene_raster_fill_front_to_back = {
+    .name     = "raster_fill_front_to_back",
+    .setup    = raster_fill_setup,
+    .frame    = raster_fill_front_to_back_frame,
+    .teardown = raster_teardown
+};
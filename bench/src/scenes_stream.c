@@ -0,0 +1,145 @@
+#include "bench.h"
+
+#include "finch/core/memory.h"
+#include "finch/core/stream.h"
+#include "finch/platform/platform.h"
+#include "finch/render/kernels.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Reading a large file while drawing: streamed reads keep a few megabytes
+// in flight and only collect completions each frame, against reading the
+// same amount per frame on the main thread. Teardown reports the rate the
+// stream sustained and its slowest update. The file is read from the page
+// cache after it was written, so this measures the cost to the frame
+// rather than the disk.
+
+#define STREAM_PATH       "bench_stream"
+#define STREAM_FILE_SIZE  (128ull << 20)
+#define STREAM_READ_SIZE  (4ull << 20)
+#define STREAM_READ_COUNT 4
+
+static u8* stream_buffers;
+static u64 stream_next_offset;
+static f64 stream_start_time;
+
+static b32 stream_write_file(void)
+{
+    FILE* file = fopen(STREAM_PATH, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    u32* block = (u32*)FC_ALLOC(STREAM_READ_SIZE, "bench");
+    for (u64 offset = 0; offset < STREAM_FILE_SIZE; offset += STREAM_READ_SIZE) {
+        for (u32 i = 0; i < STREAM_READ_SIZE / sizeof(u32); ++i) {
+            block[i] = (u32)(offset / sizeof(u32)) + i;
+        }
+        fwrite(block, 1, STREAM_READ_SIZE, file);
+    }
+    FC_FREE(block);
+    return fclose(file) == 0;
+}
+
+static void stream_read_done(FcStreamRead read, FcStreamStatus status, void* data);
+
+static void stream_queue_read(u32 slot)
+{
+    fc_stream_read(STREAM_PATH, stream_next_offset, STREAM_READ_SIZE,
+                   stream_buffers + slot * STREAM_READ_SIZE, 0,
+                   stream_read_done, (void*)(uintptr_t)slot);
+    stream_next_offset = (stream_next_offset + STREAM_READ_SIZE) % STREAM_FILE_SIZE;
+}
+
+static void stream_read_done(FcStreamRead read, FcStreamStatus status, void* data)
+{
+    (void)read;
+    if (status == FC_STREAM_STATUS_DONE) {
+        stream_queue_read((u32)(uintptr_t)data);
+    }
+}
+
+static b32 stream_setup(ApplicationState* application_state)
+{
+    (void)application_state;
+    stream_buffers = (u8*)FC_ALLOC(STREAM_READ_COUNT * STREAM_READ_SIZE, "bench");
+    if (stream_buffers == NULL || !stream_write_file()) {
+        FC_FREE(stream_buffers);
+        return false;
+    }
+    stream_next_offset = 0;
+    stream_start_time = platform_get_epoch_time();
+    return true;
+}
+
+static void stream_teardown(ApplicationState* application_state)
+{
+    (void)application_state;
+    remove(STREAM_PATH);
+    FC_FREE(stream_buffers);
+}
+
+static u64 stream_draw(ApplicationState* application_state)
+{
+    fc_fill_rect_u32(application_state->pixelbuffer, application_state->width_px, 0, 0,
+                     application_state->width_px, application_state->height_px, 0xFF202020);
+    return (u64)application_state->width_px * application_state->height_px;
+}
+
+static b32 stream_async_setup(ApplicationState* application_state)
+{
+    if (!stream_setup(application_state) || !fc_stream_init(0)) {
+        return false;
+    }
+    for (u32 slot = 0; slot < STREAM_READ_COUNT; ++slot) {
+        stream_queue_read(slot);
+    }
+    return true;
+}
+
+static void stream_async_teardown(ApplicationState* application_state)
+{
+    FcStreamStats stats;
+    fc_stream_get_stats(&stats);
+    fc_stream_deinit();
+    f64 seconds = platform_get_epoch_time() - stream_start_time;
+    f64 megabytes = (f64)stats.bytes_read / (1024.0 * 1024.0);
+    printf("    stream: %.1f MB in %.3fs (%.0f MB/s), slowest update %.3fms\n",
+           megabytes, seconds, seconds > 0.0 ? megabytes / seconds : 0.0, stats.max_update_ms);
+    stream_teardown(application_state);
+}
+
+static u64 stream_async_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    fc_stream_update();
+    return stream_draw(application_state);
+}
+
+static u64 stream_blocking_frame(ApplicationState* application_state, f64 delta_time)
+{
+    (void)delta_time;
+    // What one frame's share of the streamed reads costs when read in place
+    FILE* file = fopen(STREAM_PATH, "rb");
+    if (file != NULL) {
+        fseek(file, (long)stream_next_offset, SEEK_SET);
+        fread(stream_buffers, 1, STREAM_READ_SIZE, file);
+        fclose(file);
+    }
+    stream_next_offset = (stream_next_offset + STREAM_READ_SIZE) % STREAM_FILE_SIZE;
+    return stream_draw(application_state);
+}
+
+BenchScene bench_scene_stream_async = {
+    .name     = "stream_async",
+    .setup    = stream_async_setup,
+    .frame    = stream_async_frame,
+    .teardown = stream_async_teardown
+};
+
+BenchScene bench_scene_stream_blocking = {
+    .name     = "stream_blocking",
+    .setup    = stream_setup,
+    .frame    = stream_blocking_frame,
+    .teardown = stream_teardown
+};
@@ -15,6 +15,14 @@ BIN="minimal_app"
 
 RUN_TREE_PATH="run_tree/"
 
+# Build the application as a shared object that is hot-reloaded by the
+# finch host executable whenever it is rebuilt
+if test "$1" == '--hot-reload'; then
+    HOT_RELOAD=1
+    CFLAGS="$CFLAGS -fpic"
+    shift
+fi
+
 SRC=$(find $SRC_PATH -name '*.c' | sort -k 1nr | cut -f2-)
 OBJ=$(echo $SRC | sed "s|\.c|\.o|g" | sed "s|$SRC_PATH|$BUILD_PATH|g")
 
@@ -76,12 +84,31 @@ link_program()
     $CC $CFLAGS $INCLUDE_PATH -o $BIN_PATH/$BIN $OBJ $LIBS
 }
 
+link_module()
+{
+    # Link application module
+    echo -e "${BOLD}${MAGENTA}Linking:${NORMAL} $OBJ -> $BIN_PATH/lib$BIN.so"
+    $CC $CFLAGS $INCLUDE_PATH -shared -o $BIN_PATH/lib$BIN.so $OBJ $LIBS
+}
+
+copy_to_run_tree()
+{
+    # Copy through a temporary file and rename, so that a running instance
+    # keeps its mapping of the old file and never sees a partial one
+    echo -e "${BOLD}${YELLOW}Copying:${NORMAL} $1 -> $RUN_TREE_PATH/$2"
+    cp $1 $RUN_TREE_PATH/$2.tmp
+    mv -f $RUN_TREE_PATH/$2.tmp $RUN_TREE_PATH/$2
+}
+
 make_run_tree()
 {
-    echo -e "${BOLD}${YELLOW}Copying:${NORMAL} $BIN_PATH/$BIN -> $RUN_TREE_PATH/$BIN"
-    cp $BIN_PATH/$BIN $RUN_TREE_PATH/$BIN
-    echo -e "${BOLD}${YELLOW}Copying:${NORMAL} ../../build/bin/libfinch.so -> $RUN_TREE_PATH/libfinch.so"
-    cp ../../build/bin/libfinch.so $RUN_TREE_PATH/libfinch.so
+    if test -n "$HOT_RELOAD"; then
+        copy_to_run_tree ../../build/bin/finch finch
+        copy_to_run_tree $BIN_PATH/lib$BIN.so lib$BIN.so
+    else
+        copy_to_run_tree $BIN_PATH/$BIN $BIN
+    fi
+    copy_to_run_tree ../../build/bin/libfinch.so libfinch.so
 }
 
 #
@@ -111,8 +138,13 @@ echo -e "${STANDOUT}${BOLD}${BLUE}COMPILING SOURCES${NORMAL}"
 compile_sources | sed "s|^|    |g"
 echo ""
 
-echo -e "${STANDOUT}${BOLD}${MAGENTA}LINKING PROGRAM${NORMAL}"
-link_program | sed "s|^|    |g"
+if test -n "$HOT_RELOAD"; then
+    echo -e "${STANDOUT}${BOLD}${MAGENTA}LINKING MODULE${NORMAL}"
+    link_module | sed "s|^|    |g"
+else
+    echo -e "${STANDOUT}${BOLD}${MAGENTA}LINKING PROGRAM${NORMAL}"
+    link_program | sed "s|^|    |g"
+fi
 echo ""
 
 echo -e "${STANDOUT}${BOLD}${YELLOW}MAKING RUN TREE${NORMAL}"
@@ -121,6 +153,10 @@ make_run_tree | sed "s|^|    |g"
 if test "$1" == '--run'; then
     pushd run_tree > /dev/null
     echo -e "Running $BIN..."
-    ./$BIN
+    if test -n "$HOT_RELOAD"; then
+        FINCH_APPLICATION_MODULE=./lib$BIN.so ./finch
+    else
+        ./$BIN
+    fi
     popd > /dev/null
 fi
@@ -15,15 +15,23 @@ void fc_application_update(ApplicationState* app_state, f64 delta_time)
 {
     (void)delta_time; // Unused variable - suppresses warning
 
+    // The gradient only changes with the size of the pixelbuffer, so the
+    // application idles until the window is resized
+    static u32 drawn_width = 0, drawn_height = 0;
+    if (app_state->width_px == drawn_width && app_state->height_px == drawn_height) {
+        app_state->skip_redraw = true;
+        return;
+    }
+    drawn_width  = app_state->width_px;
+    drawn_height = app_state->height_px;
+
     // Rendering
+    FcPixelFormat format = app_state->pixel_format;
     for (u32 y = 0; y < app_state->height_px; ++y) {
         for (u32 x = 0; x < app_state->width_px; ++x) {
             u32* pixel = app_state->pixelbuffer + (x + y * app_state->width_px);
             
-            *((u8*)pixel + 0) = (u8)0xFF;
-            *((u8*)pixel + 1) = (u8)x;
-            *((u8*)pixel + 2) = (u8)y;
-            *((u8*)pixel + 3) = (u8)0xFF; // Alpha (Unused)
+            *pixel = FC_PACK_PIXEL(format, y, x, 0xFF, 0xFF);
         }
     }
 }
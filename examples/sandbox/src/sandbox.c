@@ -3,15 +3,29 @@
 #include "finch/log/log.h"
 #include "finch/utils/string.h"
 #include "finch/platform/platform.h"
+#include "finch/audio/audio.h"
+#include "finch/render/kernels.h"
+#include "finch/render/post.h"
+#include "finch/render/text.h"
 
 #include <math.h>
-#include <stdlib.h>
 
 typedef struct _ApplicationData {
     f32 time_elapsed_seconds;
     f32 horizontal_offset;
     f32 vertical_offset;
     f32 velocity;
+
+    FcAudio audio;
+    FcSound click;
+
+    FcFont font;
+    f64    average_frame_ms;
+
+    // Contrast curve on every frame, and a blur toggled with B
+    FcPostChain   post_chain;
+    FcToneLut     tone;
+    FcPostFilter* blur;
 } ApplicationData;
 
 static ApplicationData* app_data;
@@ -21,6 +35,17 @@ static void handle_game_events(ApplicationState* application_state)
     while (application_state->unhandled_events) {
         FcEvent e = application_state->events[--application_state->unhandled_events];
         switch (e.type) {                
+            case FC_EVENT_TYPE_BUTTON_PRESSED: {
+                if (e.button == FC_BUTTON_LEFT) {
+                    f32 pan = e.mouse_x / (f32)application_state->width_px * 2.0f - 1.0f;
+                    fc_audio_play(&app_data->audio, &app_data->click, 0.5f, pan, false);
+                }
+            } break;
+            case FC_EVENT_TYPE_KEY_PRESSED: {
+                if (e.key == FC_KEY_B) {
+                    app_data->blur->enabled = !app_data->blur->enabled;
+                }
+            } break;
             case FC_EVENT_TYPE_WHEEL_SCROLLED: {
                 if (e.scroll_wheel_vertical_direction != 0) {
                     app_data->vertical_offset -= app_data->velocity * e.scroll_wheel_vertical_direction;
@@ -38,26 +63,84 @@ static void handle_game_events(ApplicationState* application_state)
     }
 }
 
-static u32 format_color(Color col)
+static void draw_overlay(ApplicationState* application_state, f64 dt)
 {
-    return (u32)(col.a << 24 |
-                 col.r << 16 |
-                 col.g << 8  |
-                 col.b << 0);
+    app_data->average_frame_ms = app_data->average_frame_ms * 0.95 + dt * 1000.0 * 0.05;
+
+    FcAudioStats audio_stats;
+    fc_audio_get_stats(&app_data->audio, &audio_stats);
+    const FcLatencyStats* latency = &application_state->frame_stats.latency;
+    const FcPresentStats* present = &application_state->frame_stats.present;
+
+    // Dark box behind the text, clamped to the pixelbuffer
+    FcFont* font = &app_data->font;
+    u32 box_width  = font->glyph_width * 36 + 8;
+    u32 box_height = font->glyph_height * 6 + 8;
+    box_width  = box_width  < application_state->width_px  ? box_width  : application_state->width_px;
+    box_height = box_height < application_state->height_px ? box_height : application_state->height_px;
+
+    FcPixelFormat format = application_state->pixel_format;
+    fc_fill_rect_u32(application_state->pixelbuffer, application_state->width_px,
+                     0, 0, box_width, box_height, FC_PACK_PIXEL(format, 0x10, 0x10, 0x10, 0xFF));
+    fc_text_draw_format(font, application_state->pixelbuffer,
+                        application_state->width_px, application_state->height_px,
+                        4, 4, FC_PACK_PIXEL(format, 0xE0, 0xE0, 0xE0, 0xFF),
+                        "frame %f ms\nrender %ux%u\naudio %f ms, %u underruns\n"
+                        "input p50 %f p99 %f ms\n"
+                        "present %f ms, %u missed\n"
+                        "post %f ms",
+                        app_data->average_frame_ms,
+                        application_state->width_px, application_state->height_px,
+                        audio_stats.average_mix_ms, (u32)audio_stats.underruns,
+                        fc_histogram_percentile(&latency->total, 50.0),
+                        fc_histogram_percentile(&latency->total, 99.0),
+                        present->last_complete_ms, (u32)present->missed,
+                        app_data->post_chain.last_run_ms);
 }
 
 void fc_application_init(ApplicationState* application_state)
 {
-    app_data = (ApplicationData*)malloc(sizeof(ApplicationData));
+    // Kept in engine-owned memory so that it survives hot-reloads
+    app_data = FC_ARENA_PUSH_STRUCT(&application_state->memory, ApplicationData);
     app_data->time_elapsed_seconds = 0.0f;
     app_data->horizontal_offset = 0.0f;
     app_data->vertical_offset = 0.0f;
     app_data->velocity = 0.0f;
+
+    // Short decaying tone played on clicks, panned to the mouse position
+    u32 click_frames = 4800;
+    f32* click_samples = FC_ARENA_PUSH_ARRAY(&application_state->memory, f32, click_frames);
+    for (u32 i = 0; i < click_frames; ++i) {
+        f32 t = i / 48000.0f;
+        click_samples[i] = sinf(2.0f * 3.14159265f * 660.0f * t) * expf(-t * 40.0f);
+    }
+    app_data->click = (FcSound){ click_samples, click_frames, 1, 48000 };
+
+    FcAudioConfig audio_config = { .sink = FC_AUDIO_SINK_DEVICE };
+    fc_audio_init(&app_data->audio, &audio_config);
+
+    fc_font_init_default(&app_data->font, 2);
+
+    fc_tone_lut_init(&app_data->tone, 1.0f, 1.15f, 1.0f);
+    fc_post_chain_init(&app_data->post_chain, true);
+    fc_post_chain_add_tone(&app_data->post_chain, &app_data->tone);
+    app_data->blur = fc_post_chain_add_gaussian_blur(&app_data->post_chain, 4.0f);
+    app_data->blur->enabled = false;
+    application_state->post_chain = &app_data->post_chain;
     
     application_state->name = "Sandbox";
     application_state->width_px = 1280;
     application_state->height_px = 720;
 
+    // Render at a lower resolution when frames take longer than 60fps allows
+    application_state->render_scale = (FcRenderScale){
+        .mode            = FC_RENDER_SCALE_DYNAMIC,
+        .filter          = FC_RENDER_SCALE_FILTER_BILINEAR,
+        .min_factor      = 0.5f,
+        .max_factor      = 1.0f,
+        .frame_budget_ms = 1000.0 / 60.0
+    };
+
     FC_TRACE("This is a trace!");
     FC_INFO("This is info!");
     FC_WARN("This is a warning!");
@@ -66,6 +149,9 @@ void fc_application_init(ApplicationState* application_state)
 
 void fc_application_update(ApplicationState* application_state, f64 dt)
 {   
+    // Static data is lost when the module is reloaded
+    app_data = (ApplicationData*)application_state->memory.base;
+
     handle_game_events(application_state);
     
     InputState* input_state = &application_state->input_state;
@@ -84,12 +170,13 @@ void fc_application_update(ApplicationState* application_state, f64 dt)
         app_data->horizontal_offset -= app_data->velocity * dt;
     }
     if (input_state->button_is_down[FC_BUTTON_LEFT]) {
-        FC_INFO("dx: %d, dy: %d", input_state->mouse_dx, input_state->mouse_dy);
+        FC_INFO_PER_SECOND(10, "dx: %d, dy: %d", input_state->mouse_dx, input_state->mouse_dy);
         app_data->horizontal_offset += input_state->mouse_dx;
         app_data->vertical_offset   += input_state->mouse_dy;
     }
     
-    // Rendering
+    // Rendering, packing pixels straight into the native format
+    FcPixelFormat format = application_state->pixel_format;
     for (u32 j = 0; j < application_state->height_px; ++j) {
         for (u32 i = 0; i < application_state->width_px; ++i) {
             f32 u = i / (f32)application_state->width_px;
@@ -102,16 +189,20 @@ void fc_application_update(ApplicationState* application_state, f64 dt)
             col.g = (u8)j - app_data->vertical_offset;
             col.a = 0xFFu;
 
-            application_state->pixelbuffer[i + j * application_state->width_px] = format_color(col);
+            application_state->pixelbuffer[i + j * application_state->width_px] =
+                FC_PACK_COLOR(format, col);
         }
     }
     
+    draw_overlay(application_state, dt);
+    
     app_data->time_elapsed_seconds += dt;
 }
 
 void fc_application_deinit(ApplicationState* application_state)
 {
-    (void)application_state;
-
-    free(app_data);
+    app_data = (ApplicationData*)application_state->memory.base;
+    fc_audio_deinit(&app_data->audio);
+    fc_font_free(&app_data->font);
+    fc_post_chain_free(&app_data->post_chain);
 }
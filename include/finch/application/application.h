@@ -2,9 +2,15 @@
 #define FINCH_APPLICATION_APPLICATION_H
 
 #include "finch/core/events.h"
+#include "finch/core/arena.h"
+#include "finch/core/stats.h"
 
 #define MAX_EVENTS 1024
 
+// Size of the engine-owned application memory. It is reserved up front and
+// only backed by physical pages once touched.
+#define FC_APPLICATION_MEMORY_SIZE (64ull * 1024 * 1024)
+
 typedef union _Color {
     u32 packed;
     struct {
@@ -12,6 +18,77 @@ typedef union _Color {
     };
 } Color;
 
+// Layout of a pixel. Pixelbuffer formats are 32 bits per pixel with 8-bit
+// channels, so the shifts are all that is needed to pack a pixel. The
+// masks, size and depth also describe native formats that differ from
+// that (e.g. 16-bit visuals), which are converted to at present.
+typedef struct _FcPixelFormat {
+    u8  red_shift, green_shift, blue_shift, alpha_shift;
+    u32 red_mask, green_mask, blue_mask, alpha_mask;
+    u8  bits_per_pixel;
+    u8  depth;
+} FcPixelFormat;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define FC_PIXEL_BYTE_SHIFT(BYTE) ((BYTE) * 8)
+#else
+#define FC_PIXEL_BYTE_SHIFT(BYTE) (24 - (BYTE) * 8)
+#endif
+
+// 32-bit format given the index in memory of each channel's byte
+#define FC_PIXEL_FORMAT_32(R, G, B, A) ((FcPixelFormat){                \
+            .red_shift   = FC_PIXEL_BYTE_SHIFT(R),                      \
+            .green_shift = FC_PIXEL_BYTE_SHIFT(G),                      \
+            .blue_shift  = FC_PIXEL_BYTE_SHIFT(B),                      \
+            .alpha_shift = FC_PIXEL_BYTE_SHIFT(A),                      \
+            .red_mask    = 0xFFu << FC_PIXEL_BYTE_SHIFT(R),             \
+            .green_mask  = 0xFFu << FC_PIXEL_BYTE_SHIFT(G),             \
+            .blue_mask   = 0xFFu << FC_PIXEL_BYTE_SHIFT(B),             \
+            .alpha_mask  = 0xFFu << FC_PIXEL_BYTE_SHIFT(A),             \
+            .bits_per_pixel = 32,                                       \
+            .depth          = 32 })
+
+// Named by channel order in memory. RGBA8 is the layout of Color.
+#define FC_PIXEL_FORMAT_BGRA8 FC_PIXEL_FORMAT_32(2, 1, 0, 3)
+#define FC_PIXEL_FORMAT_RGBA8 FC_PIXEL_FORMAT_32(0, 1, 2, 3)
+
+#define FC_PACK_PIXEL(FORMAT, R, G, B, A)               \
+    (((u32)(u8)(R) << (FORMAT).red_shift)   |           \
+     ((u32)(u8)(G) << (FORMAT).green_shift) |           \
+     ((u32)(u8)(B) << (FORMAT).blue_shift)  |           \
+     ((u32)(u8)(A) << (FORMAT).alpha_shift))
+
+#define FC_PACK_COLOR(FORMAT, COLOR)                                    \
+    FC_PACK_PIXEL(FORMAT, (COLOR).r, (COLOR).g, (COLOR).b, (COLOR).a)
+
+typedef enum _FcRenderScaleMode {
+    FC_RENDER_SCALE_NONE = 0, // Pixelbuffer is the size of the window
+    FC_RENDER_SCALE_FIXED,    // Fixed width_px x height_px
+    FC_RENDER_SCALE_FACTOR,   // Window size times factor
+    FC_RENDER_SCALE_DYNAMIC   // Factor adjusted to keep within frame_budget_ms
+} FcRenderScaleMode;
+
+typedef enum _FcRenderScaleFilter {
+    FC_RENDER_SCALE_FILTER_NEAREST = 0,
+    FC_RENDER_SCALE_FILTER_BILINEAR
+} FcRenderScaleFilter;
+
+// Resolution the application renders at, independent of the window size.
+// The pixelbuffer is upscaled to the window at present.
+typedef struct _FcRenderScale {
+    FcRenderScaleMode   mode;
+    FcRenderScaleFilter filter;
+    b32 integer_scaling; // Largest whole multiple that fits, centered
+
+    u32 width_px, height_px;     // FC_RENDER_SCALE_FIXED
+    f32 factor;                  // FC_RENDER_SCALE_FACTOR and current dynamic factor
+    f32 min_factor, max_factor;  // FC_RENDER_SCALE_DYNAMIC
+    f64 frame_budget_ms;         // FC_RENDER_SCALE_DYNAMIC
+
+    f64 average_frame_ms;
+    u32 frames_since_change;
+} FcRenderScale;
+
 typedef struct _InputState {
     b32 button_is_down[FC_BUTTON_COUNT];
     b32 key_is_down[FC_KEY_COUNT];
@@ -21,14 +98,45 @@ typedef struct _InputState {
 
 typedef struct _ApplicationState {
     char* name;
-    u32  width_px;
-    u32  height_px;
+    u32  width_px;  // Size of the pixelbuffer, which is only the size of
+    u32  height_px; // the window when render_scale is not used
     int  running; 
     u32* pixelbuffer;
 
+    // Format of the pixelbuffer. If left zeroed by fc_application_init the
+    // platform sets it to the native format, so pixels go to the screen as
+    // they are. Any other format is converted at every present.
+    FcPixelFormat pixel_format;
+    FcPixelFormat native_pixel_format; // Set by the platform
+
+    FcRenderScale render_scale;
+
+    // Set by fc_application_update when the pixelbuffer has not changed.
+    // The frame is then not presented and the main loop blocks until input
+    // arrives, or at most wakeup_seconds when it is above 0. Both are reset
+    // before every update.
+    b32 skip_redraw;
+    f64 wakeup_seconds;
+    // Set by the platform when the window lost its contents, such as on
+    // expose. The next frame is then presented, through the post chain,
+    // even if the update skips the redraw.
+    b32 present_requested;
+
+    // Filters the pixelbuffer into a frame of its own after every update
+    // that redraws, which is presented instead; see finch/render/post.h.
+    // Kept in memory below so it survives hot reloading.
+    struct _FcPostChain* post_chain;
+
     InputState input_state;
     FcEvent events[MAX_EVENTS];
     u32 unhandled_events;
+
+    // Timings and input latency of the previous frame, see stats.h
+    FcFrameStats frame_stats;
+
+    // Owned by the engine and preserved when the application module is
+    // hot-reloaded. Starts out zeroed.
+    FcArena memory;
 } ApplicationState;
 
 // Implemented by application
@@ -0,0 +1,48 @@
+#ifndef FINCH_ASSET_IMAGE_H
+#define FINCH_ASSET_IMAGE_H
+
+#include "finch/core/core.h"
+#include "finch/application/application.h"
+
+// Decoded 32-bit image, rows are tightly packed
+typedef struct _FcImage {
+    u32* pixels;
+    u32  width, height;
+    FcPixelFormat format;
+} FcImage;
+
+// Loads a binary PPM (P6) or PAM (P7, RGB or RGB_ALPHA) with 8-bit
+// channels and converts it to `format`
+b32  fc_image_load_netpbm(FcImage* image, const char* path, const FcPixelFormat* format);
+void fc_image_free(FcImage* image);
+
+// QOI, a lossless format that decodes in a single pass with no entropy
+// coding. Files may end with an index of stripes of rows after the QOI end
+// marker, which other decoders ignore. Every stripe starts from a reset
+// decoder state, so stripes decode independently and in parallel.
+#define FC_QOI_HEADER_SIZE  14
+#define FC_QOI_END_SIZE     8
+#define FC_QOI_INDEX_MAGIC  0x58495146u // "FQIX"
+#define FC_QOI_STRIPE_ROWS  64          // Default for saved images
+
+// Upper bound of fc_image_encode_qoi's output
+u64  fc_image_qoi_max_size(u32 width, u32 height, u32 stripe_rows);
+// Encodes `height` rows of `stride` pixels in `format` and returns the
+// size, or 0 when it does not fit in `capacity`. Alpha is stored only with
+// `keep_alpha`, otherwise pixels are opaque. `stripe_rows` of 0 writes no
+// stripe index.
+u64  fc_image_encode_qoi(u8* dest, u64 capacity, const u32* pixels, u32 width, u32 height,
+                         u32 stride, const FcPixelFormat* format, b32 keep_alpha,
+                         u32 stripe_rows);
+b32  fc_image_qoi_size(const u8* data, u64 size, u32* width, u32* height);
+// Decodes straight into rows of `stride` pixels in `format`, such as a
+// region of the pixelbuffer. With `parallel`, indexed files are decoded
+// a stripe per job on the worker threads of finch/core/jobs.h.
+b32  fc_image_decode_qoi(const u8* data, u64 size, u32* dest, u32 stride,
+                         const FcPixelFormat* format, b32 parallel);
+b32  fc_image_load_qoi(FcImage* image, const char* path, const FcPixelFormat* format);
+// For screenshots: writes the pixels opaque, with a stripe index
+b32  fc_image_save_qoi(const char* path, const u32* pixels, u32 width, u32 height,
+                       u32 stride, const FcPixelFormat* format);
+
+#endif // FINCH_ASSET_IMAGE_H
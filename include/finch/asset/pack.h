@@ -0,0 +1,95 @@
+#ifndef FINCH_ASSET_PACK_H
+#define FINCH_ASSET_PACK_H
+
+#include "finch/core/core.h"
+#include "finch/application/application.h"
+#include "finch/asset/image.h"
+
+#include <stdio.h>
+
+#define FC_PACK_MAGIC     0x4B415046u // "FPAK"
+#define FC_PACK_VERSION   1
+#define FC_PACK_ALIGNMENT 64          // Of every payload
+
+// Pack file layout, in the byte order of the machine that built it:
+// header, payloads, names, then the entry index sorted by name hash.
+// Image payloads are stored in the pack's pixel format so they can be used
+// straight from the mapping.
+typedef struct _FcPackHeader {
+    u32 magic;
+    u32 version;
+    u32 entry_count;
+    u8  pixel_shifts[4]; // Red, green, blue and alpha shift of image pixels
+    u64 file_size;
+    u64 names_offset;
+    u64 index_offset;
+} FcPackHeader;
+
+typedef enum _FcPackEntryType {
+    FC_PACK_ENTRY_BLOB = 0,
+    FC_PACK_ENTRY_IMAGE
+} FcPackEntryType;
+
+typedef struct _FcPackEntry {
+    u64 name_hash;
+    u64 offset;
+    u64 size;
+    u32 name_offset; // Relative to names_offset, names are not terminated
+    u32 name_length;
+    u32 type;
+    u32 width, height; // Images only
+    u32 stride;        // Pixels per row, images only
+} FcPackEntry;
+
+typedef struct _FcPack {
+    const u8* data;
+    u64 size;
+    const FcPackHeader* header;
+    const FcPackEntry*  entries;
+    const char*         names;
+    FcPixelFormat pixel_format;
+} FcPack;
+
+// Pixels point into the mapping and stay valid until the pack is closed
+typedef struct _FcPackImage {
+    const u32* pixels;
+    u32 width, height;
+    u32 stride;
+} FcPackImage;
+
+// Maps the pack read-only and validates its index. Nothing is copied, pages
+// are read on first use (or are already in the page cache).
+b32  fc_pack_open(FcPack* pack, const char* path);
+void fc_pack_close(FcPack* pack);
+
+const FcPackEntry* fc_pack_find(const FcPack* pack, const char* name);
+
+// False if the entry is missing or is not an image. Pixels are in
+// pack->pixel_format, which the caller checks against its pixelbuffer's.
+b32 fc_pack_get_image(const FcPack* pack, const char* name, FcPackImage* image);
+const void* fc_pack_get_blob(const FcPack* pack, const char* name, u64* size);
+
+// Builds a pack by streaming payloads to the file as they are added
+typedef struct _FcPackWriter {
+    FILE* file;
+    FcPixelFormat pixel_format;
+    FcPackEntry* entries;
+    u32   entry_count;
+    u32   entry_capacity;
+    char* names;
+    u32   names_size;
+    u32   names_capacity;
+    u64   offset;
+    b32   failed;
+} FcPackWriter;
+
+b32  fc_pack_writer_begin(FcPackWriter* writer, const char* path, const FcPixelFormat* format);
+// The image is converted to the pack's pixel format if needed
+void fc_pack_writer_add_image(FcPackWriter* writer, const char* name, const FcImage* image);
+void fc_pack_writer_add_blob(FcPackWriter* writer, const char* name, const void* data, u64 size);
+// Writes the names and index, false if any write failed or a name repeats
+b32  fc_pack_writer_finish(FcPackWriter* writer);
+
+u64 fc_pack_hash_name(const char* name, u32 length);
+
+#endif // FINCH_ASSET_PACK_H
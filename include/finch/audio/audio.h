@@ -0,0 +1,134 @@
+#ifndef FINCH_AUDIO_AUDIO_H
+#define FINCH_AUDIO_AUDIO_H
+
+#include "finch/core/core.h"
+
+#include <stdatomic.h>
+
+#define FC_AUDIO_MAX_VOICES          64
+#define FC_AUDIO_COMMAND_QUEUE_SIZE  256 // Power of two
+#define FC_AUDIO_CHANNELS            2   // Output is interleaved stereo f32
+
+// Interleaved f32 samples with one or two channels. Sounds are not copied,
+// so they must outlive every voice playing them.
+typedef struct _FcSound {
+    const f32* samples;
+    u32 frame_count;
+    u32 channels;
+    u32 sample_rate;
+} FcSound;
+
+// Identifies a playing voice, 0 is never a valid voice
+typedef u32 FcVoiceId;
+
+typedef enum _FcAudioSinkType {
+    FC_AUDIO_SINK_DEVICE = 0, // ALSA, falls back to the null sink
+    FC_AUDIO_SINK_FILE,       // WAV file at file_path, paced in real time
+    FC_AUDIO_SINK_NULL,       // Discards the output, paced in real time
+    FC_AUDIO_SINK_NONE        // No mixer thread, call fc_audio_mix directly
+} FcAudioSinkType;
+
+// FINCH_AUDIO_SINK ("device", "file", "null" or "none") and FINCH_AUDIO_FILE
+// override the sink chosen by the application
+typedef struct _FcAudioConfig {
+    FcAudioSinkType sink;
+    const char*     file_path;
+    u32 sample_rate;       // Defaults to 48000
+    u32 frames_per_buffer; // Defaults to 256
+} FcAudioConfig;
+
+typedef enum _FcAudioCommandType {
+    FC_AUDIO_COMMAND_PLAY = 0,
+    FC_AUDIO_COMMAND_STOP,
+    FC_AUDIO_COMMAND_STOP_ALL,
+    FC_AUDIO_COMMAND_SET_VOLUME,
+    FC_AUDIO_COMMAND_SET_PAN,
+    FC_AUDIO_COMMAND_SET_PITCH
+} FcAudioCommandType;
+
+typedef struct _FcAudioCommand {
+    FcAudioCommandType type;
+    FcVoiceId      voice;
+    const FcSound* sound;
+    f32 volume;
+    f32 pan;   // -1 (left) to 1 (right)
+    f32 pitch; // Playback rate, 1 is the sound's own rate
+    b32 loop;
+} FcAudioCommand;
+
+// Single producer, single consumer ring buffer from the application thread
+// to the mixer thread
+typedef struct _FcAudioCommandQueue {
+    FcAudioCommand commands[FC_AUDIO_COMMAND_QUEUE_SIZE];
+    _Atomic u32 head; // Written by the application thread
+    _Atomic u32 tail; // Written by the mixer thread
+} FcAudioCommandQueue;
+
+typedef struct _FcAudioVoice {
+    FcVoiceId      id; // 0 when the voice is free
+    const FcSound* sound;
+    u64 position;      // Frames, 32.32 fixed point
+    u64 step;          // Frames per output frame, 32.32 fixed point
+    f32 volume, pan, pitch;
+    f32 gain_left, gain_right; // Ramped towards the volume and pan per buffer
+    b32 loop;
+    b32 stopping;      // Fades out over one buffer, then frees the voice
+} FcAudioVoice;
+
+typedef struct _FcAudioStats {
+    u64 buffers_mixed;
+    u64 underruns;
+    u64 commands_dropped; // Queue was full
+    u64 voices_dropped;   // No free voice for a play command
+    u32 active_voices;
+    f64 buffer_ms;        // Duration of one buffer
+    f64 last_mix_ms;      // Mixer thread CPU time per buffer
+    f64 average_mix_ms;
+    f64 max_mix_ms;
+} FcAudioStats;
+
+typedef struct _FcAudio {
+    FcAudioConfig config;
+
+    FcAudioCommandQueue queue;
+    FcVoiceId next_voice_id; // Application thread only
+
+    // Mixer thread only
+    FcAudioVoice voices[FC_AUDIO_MAX_VOICES];
+    f32* mix_buffer;
+    f32* scratch;
+
+    void* sink;
+    void* thread;
+    _Atomic b32 running;
+
+    _Atomic u64 buffers_mixed;
+    _Atomic u64 underruns;
+    _Atomic u64 commands_dropped;
+    _Atomic u64 voices_dropped;
+    _Atomic u32 active_voices;
+    _Atomic u64 last_mix_ns;
+    _Atomic u64 total_mix_ns;
+    _Atomic u64 max_mix_ns;
+} FcAudio;
+
+// Starts the mixer thread and opens the sink. The audio functions below
+// must all be called from the same (application) thread; they never block.
+b32  fc_audio_init(FcAudio* audio, const FcAudioConfig* config);
+void fc_audio_deinit(FcAudio* audio);
+
+FcVoiceId fc_audio_play(FcAudio* audio, const FcSound* sound, f32 volume, f32 pan, b32 loop);
+void fc_audio_stop(FcAudio* audio, FcVoiceId voice);
+void fc_audio_stop_all(FcAudio* audio);
+void fc_audio_set_volume(FcAudio* audio, FcVoiceId voice, f32 volume);
+void fc_audio_set_pan(FcAudio* audio, FcVoiceId voice, f32 pan);
+void fc_audio_set_pitch(FcAudio* audio, FcVoiceId voice, f32 pitch);
+
+// Applies queued commands and mixes the next `frame_count` frames into
+// `output`. Called by the mixer thread, or by the application when the
+// sink is FC_AUDIO_SINK_NONE. Does not lock or allocate.
+void fc_audio_mix(FcAudio* audio, f32* output, u32 frame_count);
+
+void fc_audio_get_stats(FcAudio* audio, FcAudioStats* stats);
+
+#endif // FINCH_AUDIO_AUDIO_H
@@ -0,0 +1,31 @@
+#ifndef FINCH_AUDIO_KERNELS_H
+#define FINCH_AUDIO_KERNELS_H
+
+#include "finch/core/core.h"
+
+// Resamples `count` frames starting at the 32.32 fixed point `position`
+// into interleaved stereo with linear interpolation. Mono is duplicated to
+// both channels. Frames index and index + 1 are read for every output
+// frame, so the caller keeps both within the sound.
+typedef void (*FcResampleFn)(f32* dest, const f32* samples, u32 channels,
+                             u64 position, u64 step, u32 count);
+
+// Adds interleaved stereo `src` to `dest`, with the gain of frame i being
+// gain + i * gain_step for each channel
+typedef void (*FcMixStereoFn)(f32* dest, const f32* src, u32 count,
+                              f32 gain_left, f32 gain_right,
+                              f32 gain_step_left, f32 gain_step_right);
+
+typedef struct _FcAudioKernels {
+    FcResampleFn  resample;
+    FcMixStereoFn mix_stereo;
+
+    const char* resample_variant;
+    const char* mix_stereo_variant;
+} FcAudioKernels;
+
+extern FcAudioKernels fc_audio_kernels;
+
+void fc_audio_select_kernels(u32 cpu_features);
+
+#endif // FINCH_AUDIO_KERNELS_H
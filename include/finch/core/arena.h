@@ -0,0 +1,28 @@
+#ifndef FINCH_CORE_ARENA_H
+#define FINCH_CORE_ARENA_H
+
+#include "finch/core/core.h"
+#include "finch/core/memory.h"
+
+// Linear allocator over a caller-provided block of memory. Memory is
+// handed out by bumping an offset and released all at once by resetting.
+typedef struct _FcArena {
+    u8* base;
+    u64 size;
+    u64 used;
+} FcArena;
+
+void  fc_arena_init(FcArena* arena, void* base, u64 size);
+void* fc_arena_push(FcArena* arena, u64 size, u64 alignment);
+void  fc_arena_reset(FcArena* arena);
+
+// Allocates from the arena; frees are ignored, so a container growing in an
+// arena leaves its old blocks behind until the arena is reset
+FcAllocator fc_arena_allocator(FcArena* arena);
+
+#define FC_ARENA_PUSH_STRUCT(ARENA, TYPE)                               \
+    ((TYPE*)fc_arena_push((ARENA), sizeof(TYPE), _Alignof(TYPE)))
+#define FC_ARENA_PUSH_ARRAY(ARENA, TYPE, COUNT)                         \
+    ((TYPE*)fc_arena_push((ARENA), sizeof(TYPE) * (COUNT), _Alignof(TYPE)))
+
+#endif // FINCH_CORE_ARENA_H
@@ -0,0 +1,119 @@
+#ifndef FINCH_CORE_CAPTURE_H
+#define FINCH_CORE_CAPTURE_H
+
+#include "finch/core/core.h"
+#include "finch/application/application.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+// Records presented frames to disk without stalling the main loop: frames
+// are copied into one of a few preallocated buffers and written by a
+// writer thread. When the writer falls behind and no buffer is free, the
+// frame is dropped and counted instead of waiting.
+#define FC_CAPTURE_MAX_BUFFERS 32
+#define FC_CAPTURE_MAGIC       0x50414346 // "FCAP"
+#define FC_CAPTURE_VERSION     1
+
+typedef enum _FcCaptureFormat {
+    FC_CAPTURE_FORMAT_RAW = 0, // FCAP frames in the pixelbuffer's format
+    FC_CAPTURE_FORMAT_Y4M      // YUV 4:2:0, which ffmpeg and mpv read
+} FcCaptureFormat;
+
+typedef enum _FcCaptureCompression {
+    FC_CAPTURE_COMPRESSION_NONE = 0,
+    // Runs of pixels unchanged since the previous frame are skipped. Frames
+    // that would not get smaller are stored as they are. RAW only.
+    FC_CAPTURE_COMPRESSION_DELTA,
+    // Each frame as a QOI image with a stripe index (finch/asset/image.h),
+    // or as it is when that would not be smaller. RAW only.
+    FC_CAPTURE_COMPRESSION_QOI
+} FcCaptureCompression;
+
+// An FCAP file is a FcCaptureHeader followed by a FcCaptureFrameHeader and
+// `size` bytes per frame. A delta frame is a sequence of runs: a u32 count
+// of pixels to keep from the previous frame, a u32 count of pixels that
+// follow, then those pixels. A QOI frame is a complete QOI file.
+typedef struct _FcCaptureHeader {
+    u32 magic;
+    u32 version;
+    u32 width;
+    u32 height;
+    u8  red_shift, green_shift, blue_shift, alpha_shift;
+    u32 compression;
+} FcCaptureHeader;
+
+typedef enum _FcCaptureEncoding {
+    FC_CAPTURE_ENCODING_PIXELS = 0,
+    FC_CAPTURE_ENCODING_DELTA,
+    FC_CAPTURE_ENCODING_QOI
+} FcCaptureEncoding;
+
+typedef struct _FcCaptureFrameHeader {
+    u32 encoding;
+    u32 size;
+    f64 time; // Seconds since the capture started
+} FcCaptureFrameHeader;
+
+typedef struct _FcCaptureConfig {
+    const char* path;
+    FcCaptureFormat      format;
+    FcCaptureCompression compression;
+    u32 width, height;      // Frames of any other size are dropped
+    FcPixelFormat pixel_format;
+    u32 buffer_count;       // 0 for 4
+    u32 frames_per_second;  // Of the Y4M header; 0 for 60
+} FcCaptureConfig;
+
+typedef struct _FcCaptureStats {
+    u64 frames_captured;    // Handed to the writer
+    u64 frames_dropped;
+    u64 frames_written;
+    u64 bytes_written;
+    f64 write_seconds;      // Time the writer spent encoding and writing
+} FcCaptureStats;
+
+typedef struct _FcCaptureBuffer {
+    u32* pixels;
+    f64  time;
+} FcCaptureBuffer;
+
+typedef struct _FcCapture {
+    FcCaptureConfig config;
+    FILE* file;
+    void* thread;
+    void* frames_queued;    // Posted for every captured frame and at stop
+    f64   start_time;
+
+    // Buffers from tail to head are queued for the writer, the others free
+    FcCaptureBuffer buffers[FC_CAPTURE_MAX_BUFFERS];
+    _Atomic u32 head;       // Written by the main thread
+    _Atomic u32 tail;       // Written by the writer thread
+    _Atomic b32 running;
+
+    // Writer thread only
+    u32* previous;          // Last written frame, for delta frames
+    u8*  encoded;           // Delta or QOI frame, or Y4M planes
+
+    _Atomic u64 frames_captured;
+    _Atomic u64 frames_dropped;
+    _Atomic u64 frames_written;
+    _Atomic u64 bytes_written;
+    _Atomic u64 write_ns;
+} FcCapture;
+
+b32  fc_capture_start(FcCapture* capture, const FcCaptureConfig* config);
+// Queues a copy of the frame for writing, or drops it. Never blocks.
+b32  fc_capture_frame(FcCapture* capture, const u32* pixels, u32 width, u32 height);
+// Writes the frames still queued and closes the file
+void fc_capture_stop(FcCapture* capture);
+b32  fc_capture_is_running(const FcCapture* capture);
+void fc_capture_get_stats(FcCapture* capture, FcCaptureStats* stats);
+
+// Started by the main loop when FINCH_CAPTURE=<path> is set. Paths ending
+// in .y4m are written as Y4M, anything else as FCAP, delta compressed with
+// FINCH_CAPTURE_DELTA=1 or QOI compressed with FINCH_CAPTURE_QOI=1.
+// FINCH_CAPTURE_BUFFERS sets the number of buffers.
+void fc_capture_init_from_env(FcCapture* capture, const ApplicationState* application_state);
+
+#endif // FINCH_CORE_CAPTURE_H
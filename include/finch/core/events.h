@@ -8,6 +8,7 @@ typedef enum _FcEventType {
     FC_EVENT_TYPE_BUTTON_PRESSED, FC_EVENT_TYPE_BUTTON_RELEASED,
     FC_EVENT_TYPE_KEY_PRESSED, FC_EVENT_TYPE_KEY_RELEASED,
     FC_EVENT_TYPE_WHEEL_SCROLLED, FC_EVENT_TYPE_MOUSE_MOVED,
+    FC_EVENT_TYPE_WINDOW_RESIZED,
 
     FC_EVENT_TYPE_COUNT
 } FcEventType;
@@ -106,6 +107,12 @@ typedef struct _FcEvent {
     u32 mouse_x, mouse_y;
     s8 scroll_wheel_vertical_direction;
     s8 scroll_wheel_horizontal_direction;
+
+    // Input events only. The server time is in milliseconds on the server's
+    // clock and wraps, the arrival time is platform_get_epoch_time() when
+    // the engine read the event.
+    u32 server_time_ms;
+    f64 arrival_time;
 } FcEvent;
 
 #endif // FINCH_CORE_EVENTS_H
@@ -0,0 +1,21 @@
+#ifndef FINCH_CORE_JOBS_H
+#define FINCH_CORE_JOBS_H
+
+#include "finch/core/core.h"
+
+// Processes the items [begin, end) of a parallel loop
+typedef void (*FcJobRangeFn)(void* data, u32 begin, u32 end);
+
+// Starts the worker threads. 0 picks one per CPU besides the calling
+// thread, or FINCH_WORKER_THREADS when set; with no workers every loop runs
+// on the caller. Done on the first parallel loop if not called before.
+b32  fc_jobs_init(u32 worker_count);
+void fc_jobs_deinit(void);
+u32  fc_jobs_get_worker_count(void);
+
+// Splits `count` items into ranges of `batch_size` that the workers and the
+// calling thread take in turn, and returns once all have been processed.
+// Meant to be called from the main thread, one loop at a time.
+void fc_jobs_parallel_for(u32 count, u32 batch_size, FcJobRangeFn fn, void* data);
+
+#endif // FINCH_CORE_JOBS_H
@@ -0,0 +1,104 @@
+#ifndef FINCH_CORE_MEMORY_H
+#define FINCH_CORE_MEMORY_H
+
+#include "finch/core/core.h"
+
+#include <stdatomic.h>
+
+// Heap allocations of the engine go through these, so that they can be
+// counted per frame. Every block carries a small header with its size and
+// call site; with FINCH_MEMORY_TRACKING=1 the count, bytes and tag of each
+// call site are also kept, see fc_memory_report.
+#define FC_ALLOC(SIZE, TAG)                                             \
+    fc_memory_alloc((SIZE), 0, false, (TAG), __FILE__, __LINE__)
+#define FC_ALLOC_ZEROED(SIZE, TAG)                                      \
+    fc_memory_alloc((SIZE), 0, true, (TAG), __FILE__, __LINE__)
+#define FC_ALLOC_ALIGNED(SIZE, ALIGNMENT, TAG)                          \
+    fc_memory_alloc((SIZE), (ALIGNMENT), false, (TAG), __FILE__, __LINE__)
+#define FC_REALLOC(MEMORY, SIZE, TAG)                                   \
+    fc_memory_realloc((MEMORY), (SIZE), (TAG), __FILE__, __LINE__)
+#define FC_FREE(MEMORY) fc_memory_free(MEMORY)
+
+// Alignment 0 is the alignment of malloc. Returns NULL on failure.
+void* fc_memory_alloc(u64 size, u64 alignment, b32 zeroed,
+                      const char* tag, const char* file, u32 line);
+// Blocks allocated with an alignment cannot be reallocated
+void* fc_memory_realloc(void* memory, u64 size,
+                        const char* tag, const char* file, u32 line);
+void  fc_memory_free(void* memory); // Accepts NULL
+
+// Where containers get their memory from. `alloc` is given the call site
+// of FC_ALLOCATOR_ALLOC. `free` is given the size that was allocated, and
+// may do nothing, as with arenas.
+typedef struct _FcAllocator {
+    void* (*alloc)(void* context, u64 size, u64 alignment,
+                   const char* tag, const char* file, u32 line);
+    void  (*free)(void* context, void* memory, u64 size);
+    void* context;
+} FcAllocator;
+
+// fc_memory_alloc and FC_FREE, attributed to the caller's tag and call site
+FcAllocator fc_heap_allocator(void);
+
+#define FC_ALLOCATOR_ALLOC(ALLOCATOR, SIZE, ALIGNMENT, TAG)             \
+    ((ALLOCATOR)->alloc((ALLOCATOR)->context, (SIZE), (ALIGNMENT), (TAG), \
+                        __FILE__, __LINE__))
+#define FC_ALLOCATOR_FREE(ALLOCATOR, MEMORY, SIZE)                      \
+    ((ALLOCATOR)->free((ALLOCATOR)->context, (MEMORY), (SIZE)))
+
+// Parts of a frame that allocations are attributed to, in frame order
+typedef enum _FcMemoryPhase {
+    FC_MEMORY_PHASE_EVENTS = 0,
+    FC_MEMORY_PHASE_UPDATE,
+    FC_MEMORY_PHASE_PRESENT,
+    FC_MEMORY_PHASE_OTHER,   // Stats, logging and idling
+    FC_MEMORY_PHASE_COUNT
+} FcMemoryPhase;
+
+typedef struct _FcMemoryStats {
+    u64 allocations;         // Engine allocations since startup
+    u64 frees;
+    u64 live_bytes;
+    u64 peak_bytes;
+
+    // Allocations made outside the engine allocator (libc, Xlib, ...),
+    // only counted when libfinch_alloc_count.so is preloaded
+    b32 external_counted;
+    u64 external_allocations;
+
+    // Of the last completed frame, engine and external together
+    u32 frame_allocations[FC_MEMORY_PHASE_COUNT];
+    u64 frame_bytes[FC_MEMORY_PHASE_COUNT]; // Engine allocations only
+    u64 frames;
+    u64 frames_with_allocations;
+} FcMemoryStats;
+
+// Counters exported by tools/alloc_count, which interposes malloc and
+// friends. Every call is counted, the engine's own included.
+typedef struct _FcExternalAllocCounters {
+    _Atomic u64 allocations;
+    _Atomic u64 frees;
+    _Atomic u64 bytes;
+} FcExternalAllocCounters;
+
+#define FC_EXTERNAL_ALLOC_COUNTERS_SYMBOL "fc_external_alloc_counters"
+
+// Called by the main loop: the phase lasts until the next phase begins or
+// the frame ends
+void fc_memory_begin_phase(FcMemoryPhase phase);
+void fc_memory_end_frame(void);
+
+// Makes every frame that allocates an error once `after_frames` frames have
+// passed, logging the call sites of the frame before aborting. Also set by
+// FINCH_MEMORY_ASSERT=<frames>. 0 disarms.
+void fc_memory_assert_steady_state(u64 after_frames);
+// Exempts the current frame from the assertion, e.g. when it resizes
+void fc_memory_allow_frame(void);
+
+void fc_memory_get_stats(FcMemoryStats* stats);
+
+// Logs the totals and every call site with its tag, allocation count and
+// live bytes. Does nothing without tracking; the engine reports at exit.
+void fc_memory_report(void);
+
+#endif // FINCH_CORE_MEMORY_H
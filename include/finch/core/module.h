@@ -0,0 +1,38 @@
+#ifndef FINCH_CORE_MODULE_H
+#define FINCH_CORE_MODULE_H
+
+#include "finch/core/core.h"
+#include "finch/application/application.h"
+
+// Seconds between checks of the module file for changes
+#define FC_MODULE_RELOAD_CHECK_INTERVAL 0.25
+
+typedef void (*FcApplicationInitFn)(ApplicationState*);
+typedef void (*FcApplicationUpdateFn)(ApplicationState*, f64);
+typedef void (*FcApplicationDeinitFn)(ApplicationState*);
+
+// The application entry points, either bound to the ones linked into the
+// executable or loaded from a shared object that is re-loaded whenever
+// the file on disk changes. Anything the application wants to keep across
+// reloads must live in ApplicationState (e.g. its memory arena), since
+// the module's static data is lost when it is unloaded.
+typedef struct _FcApplicationModule {
+    FcApplicationInitFn   init;
+    FcApplicationUpdateFn update;
+    FcApplicationDeinitFn deinit;
+
+    const char* path;   // NULL when statically linked
+    void*       handle;
+    s64         last_write_time;
+    f64         time_since_check;
+
+    u32 reload_count;
+    f64 last_reload_ms;
+    f64 total_reload_ms;
+} FcApplicationModule;
+
+b32  fc_module_load(FcApplicationModule* module, const char* path);
+b32  fc_module_reload_if_changed(FcApplicationModule* module, f64 delta_time);
+void fc_module_unload(FcApplicationModule* module);
+
+#endif // FINCH_CORE_MODULE_H
@@ -0,0 +1,60 @@
+#ifndef FINCH_CORE_REPLAY_H
+#define FINCH_CORE_REPLAY_H
+
+#include "finch/core/core.h"
+#include "finch/application/application.h"
+
+#include <stdio.h>
+
+#define FC_REPLAY_MAGIC   0x50524346u // "FCRP"
+#define FC_REPLAY_VERSION 1
+
+typedef enum _FcReplayMode {
+    FC_REPLAY_MODE_OFF = 0,
+    FC_REPLAY_MODE_RECORD,
+    FC_REPLAY_MODE_PLAYBACK
+} FcReplayMode;
+
+// Records the per-frame input of a session (events, input state and delta
+// time) to a compact binary file, or plays such a file back in place of
+// live input. Configured from the environment:
+//
+//   FINCH_RECORD=<path>          Record the session to <path>
+//   FINCH_REPLAY=<path>          Play back a recording from <path>
+//   FINCH_REPLAY_DT=<seconds>    Use a fixed delta time instead of the
+//                                recorded one
+//   FINCH_REPLAY_FAST=1          Do not pace frames to the recorded time,
+//                                run as fast as possible
+//   FINCH_REPLAY_TIMINGS=<path>  Write per-frame timings as CSV
+//
+// At the end of playback a summary of the frame timings and a checksum of
+// the final pixelbuffer are logged, so runs can be compared across builds.
+typedef struct _FcReplay {
+    FcReplayMode mode;
+    FILE* file;
+    FILE* timings;
+
+    f64 fixed_delta_time;
+    b32 as_fast_as_possible;
+
+    u32 frame_count;
+    u32 width_px, height_px;
+    InputState previous_input_state;
+    f64 frame_start_time;
+
+    f64 total_update_ms, max_update_ms;
+    f64 total_present_ms, max_present_ms;
+    b32 size_mismatch_reported;
+} FcReplay;
+
+void fc_replay_init(FcReplay* replay, ApplicationState* application_state);
+void fc_replay_record_frame(FcReplay* replay, ApplicationState* application_state,
+                            f64 delta_time);
+b32  fc_replay_playback_frame(FcReplay* replay, ApplicationState* application_state,
+                              f64* delta_time);
+void fc_replay_frame_timings(FcReplay* replay, f64 update_ms, f64 present_ms);
+void fc_replay_deinit(FcReplay* replay, ApplicationState* application_state);
+
+u64 fc_pixelbuffer_checksum(ApplicationState* application_state);
+
+#endif // FINCH_CORE_REPLAY_H
@@ -0,0 +1,79 @@
+#ifndef FINCH_CORE_STATS_H
+#define FINCH_CORE_STATS_H
+
+#include "finch/core/core.h"
+#include "finch/core/events.h"
+
+// Four buckets per doubling from 1 us, so about 1 second at the top. Values
+// above fall into the last bucket.
+#define FC_HISTOGRAM_BUCKETS 80
+
+typedef struct _FcHistogram {
+    u64 counts[FC_HISTOGRAM_BUCKETS];
+    u64 count;
+    f64 total_ms;
+    f64 max_ms;
+} FcHistogram;
+
+void fc_histogram_add(FcHistogram* histogram, f64 ms);
+// Upper bound of the bucket holding the percentile (0 to 100), in ms
+f64  fc_histogram_percentile(const FcHistogram* histogram, f64 percentile);
+
+// Latency of input events from the moment the engine read them until the
+// frame that consumed them was on the screen, split into:
+//   queue:   waiting for the next update
+//   update:  the update that consumed the event
+//   present: putting that frame on the screen, up to the server having
+//            processed it
+// Delivery is the time from the server generating the event until it was
+// read, only recorded when the server clock is the local monotonic clock
+// (as with Xorg).
+typedef struct _FcLatencyStats {
+    FcHistogram delivery;
+    FcHistogram queue;
+    FcHistogram update;
+    FcHistogram present;
+    FcHistogram total;
+} FcLatencyStats;
+
+// Feedback from the platform about presents reaching the screen. Only the
+// X Present path measures completion, the XPutImage path counts presents.
+typedef struct _FcPresentStats {
+    b32 vsync;          // Presents complete at vblank
+    u64 presented;
+    u64 completed;
+    u64 flips;          // Completed by swapping in the buffer
+    u64 copies;         // Completed by copying the buffer
+    u64 skipped;        // Replaced by a later present before being shown
+    u64 missed;         // Completed after the vblank they targeted
+    f64 refresh_ms;     // Measured interval between vblanks
+    f64 last_complete_ms; // From the present request until it completed
+    f64 max_complete_ms;
+    f64 last_wait_ms;   // Blocked in the last present until a buffer was free
+} FcPresentStats;
+
+// Filled in by the engine after every frame, so an update sees the stats
+// of the previous frame
+typedef struct _FcFrameStats {
+    u64 frame_index;
+    b32 presented;
+    f64 update_ms;
+    f64 present_ms;
+
+    // Input events consumed by the frame and the worst of their latencies.
+    // Events of frames that were not presented are not measured.
+    u32 input_events;
+    f64 max_queue_ms;
+    f64 max_latency_ms;
+
+    FcLatencyStats latency; // Since startup
+    FcPresentStats present;
+} FcFrameStats;
+
+b32  fc_event_is_input(const FcEvent* event);
+
+void fc_frame_stats_record(FcFrameStats* stats, const FcEvent* events, u32 event_count,
+                           f64 update_start_time, f64 present_start_time,
+                           f64 present_end_time, b32 presented);
+
+#endif // FINCH_CORE_STATS_H
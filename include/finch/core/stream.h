@@ -0,0 +1,72 @@
+#ifndef FINCH_CORE_STREAM_H
+#define FINCH_CORE_STREAM_H
+
+#include "finch/core/core.h"
+#include "finch/utils/pool.h"
+
+// Asynchronous file reads into memory the caller provides, for streaming
+// data without blocking a frame on read(). Reads are split into chunks and
+// only a few chunks are kept in flight, taken from the highest priority
+// read first, so a large read does not hold up a more urgent one behind it.
+// The main loop calls fc_stream_update once per frame, where finished reads
+// are reported. On Linux reads go through io_uring, or a few threads
+// running pread where it is unavailable or FINCH_IO_URING=0.
+#define FC_STREAM_MAX_READS     1024
+#define FC_STREAM_CHUNK_SIZE    (1u << 20)
+// Longest the main loop sleeps while reads are queued
+#define FC_STREAM_POLL_INTERVAL 0.002
+
+typedef FcPoolHandle FcStreamRead;
+
+typedef enum _FcStreamStatus {
+    FC_STREAM_STATUS_NONE = 0,  // Unknown or already reported
+    FC_STREAM_STATUS_PENDING,
+    FC_STREAM_STATUS_DONE,
+    FC_STREAM_STATUS_FAILED,
+    FC_STREAM_STATUS_CANCELED
+} FcStreamStatus;
+
+// Called from fc_stream_update once the read finished and no chunk of it is
+// in flight, so its memory may be reused
+typedef void (*FcStreamDoneFn)(FcStreamRead read, FcStreamStatus status, void* data);
+
+typedef struct _FcStreamStats {
+    u64 reads_done;
+    u64 reads_failed;
+    u64 reads_canceled;
+    u64 bytes_read;
+    u32 chunks_in_flight;
+    u32 reads_queued;       // Waiting for or having chunks in flight
+    f64 last_update_ms;     // Time fc_stream_update took
+    f64 max_update_ms;
+} FcStreamStats;
+
+// A completed chunk as the platform reports it: bytes read or -errno
+typedef struct _FcStreamCompletion {
+    u64 tag;
+    s64 result;
+} FcStreamCompletion;
+
+// 0 keeps FINCH_STREAM_IN_FLIGHT chunks in flight, or 8. Done on the first
+// read if not called before.
+b32  fc_stream_init(u32 chunks_in_flight);
+// Cancels every read and waits for the chunks in flight
+void fc_stream_deinit(void);
+
+// Reads `size` bytes at `offset` of the file into `dest`, which must stay
+// valid until the read was reported. Higher priorities go first, equal ones
+// in the order they were queued. Returns the zero handle if the file cannot
+// be opened, is too short or too many reads are queued.
+FcStreamRead fc_stream_read(const char* path, u64 offset, u64 size, void* dest,
+                            s32 priority, FcStreamDoneFn done, void* data);
+// Chunks not yet in flight are dropped and the others canceled if they did
+// not start. The read is reported as canceled once none is in flight.
+b32  fc_stream_cancel(FcStreamRead read);
+b32  fc_stream_set_priority(FcStreamRead read, s32 priority);
+FcStreamStatus fc_stream_get_status(FcStreamRead read);
+
+// Reports finished reads and puts more chunks in flight. Never blocks.
+void fc_stream_update(void);
+void fc_stream_get_stats(FcStreamStats* stats);
+
+#endif // FINCH_CORE_STREAM_H
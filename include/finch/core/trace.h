@@ -0,0 +1,25 @@
+#ifndef FINCH_CORE_TRACE_H
+#define FINCH_CORE_TRACE_H
+
+#include "finch/core/core.h"
+#include "finch/core/events.h"
+#include "finch/core/stats.h"
+
+#include <stdio.h>
+
+// FINCH_TRACE=<path> writes the session as a trace in the Chrome trace
+// event format, which chrome://tracing and Perfetto open: the update and
+// present of every frame, and every measured input event as a span from
+// its arrival until its frame was on the screen.
+typedef struct _FcTrace {
+    FILE* file;
+    f64   start_time;
+} FcTrace;
+
+void fc_trace_init(FcTrace* trace);
+void fc_trace_frame(FcTrace* trace, const FcFrameStats* stats,
+                    const FcEvent* events, u32 event_count,
+                    f64 update_start_time, f64 present_end_time);
+void fc_trace_deinit(FcTrace* trace);
+
+#endif // FINCH_CORE_TRACE_H
@@ -0,0 +1,115 @@
+#ifndef FINCH_ECS_ECS_H
+#define FINCH_ECS_ECS_H
+
+#include "finch/core/core.h"
+#include "finch/core/memory.h"
+
+// Entities are ids that components are attached to. Each component type is
+// stored as a sparse set: a dense array of the entities that have it, one
+// dense array per field of the component (structure of arrays), and a
+// sparse array from entity to dense index. Groups keep the entities that
+// have all of a set of components at the front of each set, in the same
+// order, so that systems run over plain contiguous arrays.
+#define FC_ECS_MAX_COMPONENTS       64
+#define FC_ECS_MAX_FIELDS           8
+#define FC_ECS_MAX_GROUPS           16
+#define FC_ECS_MAX_GROUP_COMPONENTS 8
+#define FC_ECS_INVALID              UINT32_MAX
+
+// Stays valid until the entity is destroyed; the generation tells a
+// destroyed entity apart from a later one reusing its index
+typedef struct _FcEntity {
+    u32 index;
+    u32 generation;
+} FcEntity;
+
+typedef u32 FcComponent;
+typedef u32 FcGroup;
+
+typedef struct _FcComponentDesc {
+    const char* name;
+    u32 field_count;
+    u32 field_sizes[FC_ECS_MAX_FIELDS];
+    u32 capacity; // Entities that can have it at once, 0 for all
+} FcComponentDesc;
+
+typedef struct _FcComponentSet {
+    FcComponentDesc desc;
+    u32* sparse;   // Entity index to dense index, FC_ECS_INVALID if absent
+    u32* entities; // Dense index to entity index
+    u8*  fields[FC_ECS_MAX_FIELDS];
+    u32  count;
+    FcGroup group; // Owning group or FC_ECS_INVALID
+} FcComponentSet;
+
+typedef struct _FcEcsGroup {
+    FcComponent components[FC_ECS_MAX_GROUP_COMPONENTS];
+    u32 component_count;
+    u32 count;     // Entities with all components, at the front of each set
+} FcEcsGroup;
+
+typedef struct _FcWorld {
+    u32* generations;  // Odd while alive
+    u32* next_free;
+    u32  free_head;
+    u32  capacity;
+    u32  count;
+    FcComponentSet components[FC_ECS_MAX_COMPONENTS];
+    u32  component_count;
+    FcEcsGroup groups[FC_ECS_MAX_GROUPS];
+    u32  group_count;
+    FcAllocator allocator;
+} FcWorld;
+
+// A contiguous run of a group's entities. fields[c][f] points at the first
+// element of field f of the group's component c for this run.
+typedef struct _FcEcsBatch {
+    u32 count;
+    u32 offset;          // Index of the first entity within the group
+    const u32* entities; // Entity indices
+    void* fields[FC_ECS_MAX_GROUP_COMPONENTS][FC_ECS_MAX_FIELDS];
+} FcEcsBatch;
+
+typedef void (*FcSystemFn)(FcEcsBatch* batch, void* data);
+
+// Everything is allocated up front for `max_entities`, so that entities
+// and components are added and removed without allocating. A NULL
+// allocator is the heap.
+b32  fc_world_init(FcWorld* world, u32 max_entities, const FcAllocator* allocator);
+void fc_world_free(FcWorld* world);
+
+// Returns FC_ECS_INVALID on failure
+FcComponent fc_world_register_component(FcWorld* world, const FcComponentDesc* desc);
+// Components can belong to one group each. Existing entities are sorted in.
+FcGroup fc_world_create_group(FcWorld* world, const FcComponent* components, u32 count);
+
+// Returns an entity with generation 0 when the world is full
+FcEntity fc_entity_create(FcWorld* world);
+b32  fc_entity_destroy(FcWorld* world, FcEntity entity); // Removes its components
+b32  fc_entity_is_alive(const FcWorld* world, FcEntity entity);
+
+// The fields of an added component are zeroed. Adding a component the
+// entity already has does nothing.
+b32  fc_entity_add(FcWorld* world, FcEntity entity, FcComponent component);
+b32  fc_entity_remove(FcWorld* world, FcEntity entity, FcComponent component);
+b32  fc_entity_has(const FcWorld* world, FcEntity entity, FcComponent component);
+// Pointer to one field of an entity's component, NULL if it has none. Moves
+// when components are added or removed.
+void* fc_entity_get_field(const FcWorld* world, FcEntity entity,
+                          FcComponent component, u32 field);
+
+u32  fc_group_count(const FcWorld* world, FcGroup group);
+
+// Calls `system` on runs of up to `batch_size` entities of the group (0 for
+// one run). With `parallel` the runs are spread over the worker threads of
+// finch/core/jobs.h, so the system must not touch other runs or add or
+// remove components.
+void fc_world_run(FcWorld* world, FcGroup group, FcSystemFn system, void* data,
+                  u32 batch_size, b32 parallel);
+
+#define FC_ENTITY_FIELD(WORLD, ENTITY, COMPONENT, FIELD, TYPE)          \
+    ((TYPE*)fc_entity_get_field((WORLD), (ENTITY), (COMPONENT), (FIELD)))
+#define FC_BATCH_FIELD(BATCH, COMPONENT_SLOT, FIELD, TYPE)              \
+    ((TYPE*)(BATCH)->fields[COMPONENT_SLOT][FIELD])
+
+#endif // FINCH_ECS_ECS_H
@@ -4,10 +4,15 @@
 #define FINCH_LOG_LOG_H
 
 typedef enum _FcTerminalColor {
-    FC_TERM_COLOR_WHITE,
+    FC_TERM_COLOR_WHITE, // The terminal's normal color
     FC_TERM_COLOR_GREEN,
     FC_TERM_COLOR_ORANGE,
-    FC_TERM_COLOR_RED
+    FC_TERM_COLOR_RED,
+    FC_TERM_COLOR_BLACK,
+    FC_TERM_COLOR_BLUE,
+    FC_TERM_COLOR_PURPLE,
+    FC_TERM_COLOR_CYAN,
+    FC_TERM_COLOR_LIGHT_GRAY
 } FcTerminalColor;
 
 typedef enum _FcLogLevel {
@@ -18,9 +23,72 @@ typedef enum _FcLogLevel {
     FC_LOG_LEVEL_ERROR
 } FcLogLevel;
 
+#define FC_LOG_MAX_SINKS 8
+
+typedef enum _FcLogSinkType {
+    FC_LOG_SINK_STDOUT = 0,
+    FC_LOG_SINK_FILE
+} FcLogSinkType;
+
+typedef enum _FcLogSyncPolicy {
+    FC_LOG_SYNC_NONE = 0, // Written back by the page cache
+    FC_LOG_SYNC_DATA,     // fdatasync after every flush
+    FC_LOG_SYNC_DIRECT    // O_DIRECT, bypassing the page cache
+} FcLogSyncPolicy;
+
+// Zeroed fields take the defaults in brackets. Lines are buffered and
+// written when the buffer is full, when the oldest buffered line is
+// flush_interval seconds old, after an ERROR, and at exit.
+typedef struct _FcLogSinkConfig {
+    FcLogSinkType type;
+    FcLogLevel    min_level;      // [all levels]
+    const char*   pattern;        // See src/log/README.md [FC_LOG_DEFAULT_PATTERN]
+    u32 buffer_size;              // [64 KiB]
+    f64 flush_interval;           // Negative writes every line [1 s, or every
+                                  // line for stdout on a terminal]
+
+    // File sinks. The file is appended to, and once it would exceed
+    // max_file_size it is renamed to path.1 (path.1 to path.2 and so on)
+    // and a new one is started.
+    const char*     path;
+    u64             max_file_size; // [no rotation]
+    u32             max_files;     // Rotated files kept [4]
+    FcLogSyncPolicy sync;
+} FcLogSinkConfig;
+
+// The logger starts out with a stdout sink, plus a file sink when
+// FINCH_LOG_FILE is set, both using FINCH_LOG_PATTERN if set. Colors are
+// only written to terminals. Fails for invalid patterns.
+b32  fc_log_add_sink(const FcLogSinkConfig* config);
+void fc_log_remove_sinks(void); // Flushes and removes every sink
+void fc_log_flush(void);
+void fc_log_update(void);       // Flushes sinks past their interval, every frame
+
 void fc_logger_log(char* name, FcLogLevel level,
                    char* file, u32 line, char* msg);
 
+// Identical consecutive lines from the same call site are written once,
+// followed by a "repeated N times" line when a different line is logged,
+// on flush, or a second after the first repeat. On by default.
+void fc_log_set_suppress_repeats(b32 suppress);
+
+// State of one rate limited call site, see FC_LOG_EVERY_N and
+// FC_LOG_PER_SECOND. Call sites are not synchronized, so lines from
+// several threads through one site are limited approximately.
+typedef struct _FcLogRateLimit {
+    f64 tokens;
+    f64 last_time;
+    u32 calls;
+    u32 suppressed; // Since the last written line
+} FcLogRateLimit;
+
+// Token bucket refilled at `per_second`, holding up to a second's worth
+b32  fc_log_rate_allow(FcLogRateLimit* limit, f64 per_second);
+
+// Logs like fc_logger_log, noting how many lines the limit suppressed
+void fc_logger_log_limited(char* name, FcLogLevel level, char* file, u32 line,
+                           char* msg, FcLogRateLimit* limit);
+
 #define FC_LOG(NAME, LEVEL, ...) {                                \
         char LOGBUF[1024];                                        \
         string_format(LOGBUF, sizeof(LOGBUF), __VA_ARGS__);       \
@@ -28,6 +96,31 @@ void fc_logger_log(char* name, FcLogLevel level,
                       __FILE__, __LINE__, LOGBUF);                \
     }
 
+// Writes the first of every N lines through this call site. Suppressed
+// lines are not formatted.
+#define FC_LOG_EVERY_N(NAME, LEVEL, N, ...) {                              \
+        static FcLogRateLimit LOGLIMIT;                                    \
+        if (LOGLIMIT.calls++ % (N) == 0) {                                 \
+            char LOGBUF[1024];                                             \
+            string_format(LOGBUF, sizeof(LOGBUF), __VA_ARGS__);            \
+            fc_logger_log_limited(NAME, LEVEL, __FILE__, __LINE__,         \
+                                  LOGBUF, &LOGLIMIT);                      \
+        } else {                                                           \
+            LOGLIMIT.suppressed += 1;                                      \
+        }                                                                  \
+    }
+
+// Writes at most PER_SECOND lines per second through this call site
+#define FC_LOG_PER_SECOND(NAME, LEVEL, PER_SECOND, ...) {                  \
+        static FcLogRateLimit LOGLIMIT;                                    \
+        if (fc_log_rate_allow(&LOGLIMIT, PER_SECOND)) {                    \
+            char LOGBUF[1024];                                             \
+            string_format(LOGBUF, sizeof(LOGBUF), __VA_ARGS__);            \
+            fc_logger_log_limited(NAME, LEVEL, __FILE__, __LINE__,         \
+                                  LOGBUF, &LOGLIMIT);                      \
+        }                                                                  \
+    }
+
 #define FC_ENGINE_TRACE(...)  FC_LOG("FINCH", FC_LOG_LEVEL_TRACE, __VA_ARGS__)
 #define FC_ENGINE_INFO(...)   FC_LOG("FINCH", FC_LOG_LEVEL_INFO, __VA_ARGS__)
 #define FC_ENGINE_WARN(...)   FC_LOG("FINCH", FC_LOG_LEVEL_WARN, __VA_ARGS__)
@@ -38,4 +131,16 @@ void fc_logger_log(char* name, FcLogLevel level,
 #define FC_WARN(...)   FC_LOG("APPLICATION", FC_LOG_LEVEL_WARN, __VA_ARGS__)
 #define FC_ERROR(...)  FC_LOG("APPLICATION", FC_LOG_LEVEL_ERROR, __VA_ARGS__)
 
+#define FC_ENGINE_WARN_PER_SECOND(N, ...)  FC_LOG_PER_SECOND("FINCH", FC_LOG_LEVEL_WARN, N, __VA_ARGS__)
+
+#define FC_TRACE_EVERY_N(N, ...)  FC_LOG_EVERY_N("APPLICATION", FC_LOG_LEVEL_TRACE, N, __VA_ARGS__)
+#define FC_INFO_EVERY_N(N, ...)   FC_LOG_EVERY_N("APPLICATION", FC_LOG_LEVEL_INFO, N, __VA_ARGS__)
+#define FC_WARN_EVERY_N(N, ...)   FC_LOG_EVERY_N("APPLICATION", FC_LOG_LEVEL_WARN, N, __VA_ARGS__)
+#define FC_ERROR_EVERY_N(N, ...)  FC_LOG_EVERY_N("APPLICATION", FC_LOG_LEVEL_ERROR, N, __VA_ARGS__)
+
+#define FC_TRACE_PER_SECOND(N, ...)  FC_LOG_PER_SECOND("APPLICATION", FC_LOG_LEVEL_TRACE, N, __VA_ARGS__)
+#define FC_INFO_PER_SECOND(N, ...)   FC_LOG_PER_SECOND("APPLICATION", FC_LOG_LEVEL_INFO, N, __VA_ARGS__)
+#define FC_WARN_PER_SECOND(N, ...)   FC_LOG_PER_SECOND("APPLICATION", FC_LOG_LEVEL_WARN, N, __VA_ARGS__)
+#define FC_ERROR_PER_SECOND(N, ...)  FC_LOG_PER_SECOND("APPLICATION", FC_LOG_LEVEL_ERROR, N, __VA_ARGS__)
+
 #endif // FINCH_LOG_LOG_H
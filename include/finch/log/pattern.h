@@ -0,0 +1,63 @@
+#ifndef FINCH_LOG_PATTERN_H
+#define FINCH_LOG_PATTERN_H
+
+#include "finch/core/core.h"
+#include "finch/log/log.h"
+
+#define FC_LOG_PATTERN_MAX_OPS   32
+#define FC_LOG_PATTERN_MAX_TEXT  256
+#define FC_LOG_PATTERN_MAX_TIMES 4
+
+// Level color, time, file and line, logger name, level and message
+#define FC_LOG_DEFAULT_PATTERN "%CL%TT (%Fn:%Fl) %Gn (%Gl) %Gm%Cn"
+
+typedef enum _FcLogOpType {
+    FC_LOG_OP_LITERAL = 0,
+    FC_LOG_OP_TIME,
+    FC_LOG_OP_LEVEL,
+    FC_LOG_OP_LEVEL_COLOR,
+    FC_LOG_OP_COLOR,
+    FC_LOG_OP_MESSAGE,
+    FC_LOG_OP_NAME,
+    FC_LOG_OP_FILE,
+    FC_LOG_OP_LINE
+} FcLogOpType;
+
+typedef struct _FcLogOp {
+    FcLogOpType type;
+    u16 offset; // Literal text, or the time field
+    u16 length;
+    FcTerminalColor color;
+} FcLogOp;
+
+// A run of %T specifiers and the text between them, formatted with one
+// strftime call whenever the second changes
+typedef struct _FcLogTimeField {
+    char format[64];
+    char text[128];
+    u32  length;
+    s64  second;
+} FcLogTimeField;
+
+typedef struct _FcLogPattern {
+    FcLogOp        ops[FC_LOG_PATTERN_MAX_OPS];
+    u32            op_count;
+    char           text[FC_LOG_PATTERN_MAX_TEXT];
+    u32            text_used;
+    FcLogTimeField times[FC_LOG_PATTERN_MAX_TIMES];
+    u32            time_count;
+} FcLogPattern;
+
+// Compiles a pattern in the format of src/log/README.md into a list of
+// ops. Color specifiers are dropped unless `colors` is set. Returns false
+// for unknown specifiers and patterns too long to compile.
+b32 fc_log_pattern_compile(FcLogPattern* pattern, const char* source, b32 colors);
+
+// Renders one record followed by a newline, truncated to `max_size` - 1
+// bytes. `second` is the wall clock time of the record in seconds since
+// the epoch. Returns the length.
+u32 fc_log_pattern_render(FcLogPattern* pattern, char* dest, u32 max_size, s64 second,
+                          const char* name, FcLogLevel level,
+                          const char* file, u32 line, const char* msg);
+
+#endif // FINCH_LOG_PATTERN_H
@@ -0,0 +1,25 @@
+#ifndef FINCH_PLATFORM_CPU_H
+#define FINCH_PLATFORM_CPU_H
+
+#include "finch/core/core.h"
+
+typedef enum _FcCpuFeature {
+    FC_CPU_FEATURE_SSE2   = 1 << 0,
+    FC_CPU_FEATURE_SSE41  = 1 << 1,
+    FC_CPU_FEATURE_AVX2   = 1 << 2,
+    FC_CPU_FEATURE_AVX512 = 1 << 3, // AVX-512 F and BW
+    FC_CPU_FEATURE_BMI2   = 1 << 4,
+
+    FC_CPU_FEATURE_COUNT  = 5
+} FcCpuFeature;
+
+// Detects the features of the host CPU (and whether the OS saves the
+// registers they need). The detected set can be narrowed for testing and
+// benchmarking with FINCH_CPU_FEATURES, a comma-separated list of feature
+// names ("sse2,sse4.1,avx2,avx512,bmi2"), or "none" for generic code only.
+// Features the host does not support are never enabled.
+void platform_cpu_init(void);
+u32  platform_get_cpu_features(void);
+const char* platform_get_cpu_feature_name(FcCpuFeature feature);
+
+#endif // FINCH_PLATFORM_CPU_H
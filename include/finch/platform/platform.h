@@ -3,20 +3,71 @@
 
 #include "finch/application/application.h"
 #include "finch/log/log.h"
+#include "finch/audio/audio.h"
+#include "finch/core/stream.h"
 
 // Implemented in platform layer
 void platform_init(ApplicationState*);
 void platform_deinit(ApplicationState*);
 void platform_poll_events(ApplicationState*);
+b32 platform_wait_for_events(f64 timeout_seconds); // Negative waits indefinitely
 void platform_put_pixelbuffer_on_screen(ApplicationState*);
+void platform_sync_present(void); // Blocks until the last present was processed
+void platform_get_present_stats(FcPresentStats*);
+void platform_update_render_scale(ApplicationState*);
 f64 platform_get_epoch_time();
+f64 platform_get_coarse_time(void); // Same clock, a few ms resolution but cheaper
+void platform_sleep(f64 seconds);
 WindowAttributes* platform_get_window_attributes();
 void platform_set_window_title(const char*);
 void platform_write_to_stdout(char*);
+void platform_write_bytes_to_stdout(const char* data, u64 size);
 void platform_write_to_stderr(char*);
 b32 platform_terminal_supports_colors();
 b32 platform_stdout_is_terminal();
 b32 platform_stderr_is_terminal();
 void platform_set_terminal_color(FcTerminalColor);
+const char* platform_get_terminal_color_code(FcTerminalColor); // Escape sequence
+void* platform_allocate_memory(u64 size);
+void platform_free_memory(void*, u64 size);
+void* platform_load_library(const char* path);
+void* platform_get_library_symbol(void* library, const char* name);
+void platform_unload_library(void* library);
+s64 platform_get_file_write_time(const char* path);
+b32 platform_copy_file(const char* source, const char* destination);
+b32 platform_delete_file(const char* path);
+b32 platform_rename_file(const char* source, const char* destination); // Replaces destination
+const void* platform_map_file(const char* path, u64* size); // Read-only, NULL on failure
+void platform_unmap_file(const void* data, u64 size);
+void* platform_create_thread(void (*proc)(void*), void* data);
+void platform_join_thread(void* thread);
+f64 platform_get_thread_cpu_time(void);
+u32 platform_get_cpu_count(void); // Online logical CPUs, at least 1
+void* platform_create_semaphore(u32 initial_count);
+void platform_semaphore_wait(void* semaphore);
+void platform_semaphore_post(void* semaphore, u32 count);
+void platform_destroy_semaphore(void* semaphore);
+s32 platform_file_open_read(const char* path, u64* size); // Negative on failure
+void platform_file_close(s32 file);
+// Asynchronous reads for finch/core/stream.h. At most queue_depth reads are
+// outstanding until polled; reads are handed to the system by submit and
+// complete in any order. Cancel completes the reads with the tag that did
+// not start yet with -ECANCELED, and close waits for those in flight.
+void* platform_file_reader_open(u32 queue_depth);
+b32 platform_file_reader_read(void* reader, s32 file, void* dest, u64 size, u64 offset, u64 tag); // False when full
+void platform_file_reader_submit(void* reader);
+u32 platform_file_reader_poll(void* reader, FcStreamCompletion* completions, u32 max_count);
+void platform_file_reader_cancel(void* reader, u64 tag);
+void platform_file_reader_close(void* reader);
+void* platform_audio_open(const FcAudioConfig*);
+b32 platform_audio_write(void* sink, const f32* frames, u32 frame_count); // False on underrun
+void platform_audio_close(void* sink);
+// Log files are opened for appending. Direct I/O bypasses the page cache
+// where the file system supports it.
+void* platform_log_file_open(const char* path, b32 direct_io);
+u64 platform_log_file_size(void* file);
+b32 platform_log_file_write(void* file, const void* data, u64 size);
+void platform_log_file_sync(void* file);
+void platform_log_file_close(void* file);
 
 #endif // FINCH_PLATFORM_PLATFORM_H
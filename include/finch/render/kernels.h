@@ -0,0 +1,131 @@
+#ifndef FINCH_RENDER_KERNELS_H
+#define FINCH_RENDER_KERNELS_H
+
+#include "finch/core/core.h"
+#include "finch/application/application.h"
+
+// Byte swizzle applied to every 32-bit pixel: byte i of the destination
+// pixel is byte index[i] of the source pixel, or zero / 0xFF for the
+// special indices below.
+#define FC_SWIZZLE_ZERO 0x80
+#define FC_SWIZZLE_ONE  0x81
+
+typedef struct _FcSwizzle {
+    u8 index[4];
+} FcSwizzle;
+
+typedef void (*FcFillU32Fn)(u32* dest, u32 value, u64 count);
+typedef void (*FcCopyU32Fn)(u32* dest, const u32* src, u64 count);
+typedef void (*FcSwizzleU32Fn)(u32* dest, const u32* src, u64 count, FcSwizzle swizzle);
+
+// Row kernels used for scaling. x_table holds a source index per
+// destination pixel for nearest sampling, and a 16.16 fixed point source
+// position for bilinear sampling (which reads one pixel past the index).
+// Lerp weights go from 0 (all a) to 256 (all b).
+typedef void (*FcScaleRowNearestFn)(u32* dest, const u32* src, const u32* x_table, u32 count);
+typedef void (*FcScaleRowBilinearFn)(u32* dest, const u32* src, const u32* x_table, u32 count);
+typedef void (*FcLerpU32Fn)(u32* dest, const u32* a, const u32* b, u32 weight, u64 count);
+
+// Blends a solid color over dest with an 8-bit coverage mask, where 255 is
+// fully covered. Used to draw glyphs.
+typedef void (*FcBlendMaskU32Fn)(u32* dest, const u8* mask, u32 color, u64 count);
+// Blends src over dest by the alpha byte of each src pixel, at bit
+// `alpha_shift`. Runs of transparent and opaque pixels are skipped and
+// copied. Used to composite layers.
+typedef void (*FcBlendOverU32Fn)(u32* dest, const u32* src, u32 alpha_shift, u64 count);
+
+// Box blur passes over all four bytes of each pixel, used by
+// finch/render/post.h. A window sum is scaled back by `scale`, 65536 divided
+// by the window size. The row kernel slides a window of 2 * radius + 1
+// pixels along each of `rows` rows of src, repeating their edge pixels. The
+// column kernel takes one row of a vertical pass: it writes the sums of each
+// pixel's column window, four per pixel, then slides them by adding one row
+// and removing another.
+typedef void (*FcBlurRowsU32Fn)(u32* dest, u32 dest_stride, const u32* src, u32 src_stride,
+                                u32 rows, u32 count, u32 radius, u32 scale);
+typedef void (*FcBlurColumnU32Fn)(u32* dest, u32* sums, const u32* add, const u32* sub,
+                                  u32 count, u32 scale);
+
+// Lookup tables applied to every pixel. A 1D LUT holds 256 entries for each
+// byte of the pixel, already shifted into place, which are or-ed together.
+// A 3D LUT interpolates a lattice of size^3 pixels trilinearly; for each
+// channel value, its axis table holds the lattice offset times 512 plus
+// the weight (0 to 256) of the next lattice point. Bytes of alpha_mask are
+// kept from the source pixel.
+typedef struct _FcLut3dTables {
+    const u32* lattice;
+    const u32* axes[3];     // Red, green and blue
+    u8  shifts[3];
+    u32 size;
+    u32 alpha_mask;
+} FcLut3dTables;
+
+typedef void (*FcLut1dU32Fn)(u32* dest, const u32* src, u64 count, const u32* tables);
+typedef void (*FcLut3dU32Fn)(u32* dest, const u32* src, u64 count, const FcLut3dTables* tables);
+
+// Pixel kernels, selected for the host CPU by fc_render_select_kernels().
+// Until then the generic variants are used.
+typedef struct _FcRenderKernels {
+    FcFillU32Fn    fill_u32;
+    FcCopyU32Fn    copy_u32;
+    FcSwizzleU32Fn swizzle_u32;
+
+    FcScaleRowNearestFn  scale_row_nearest;
+    FcScaleRowBilinearFn scale_row_bilinear;
+    FcLerpU32Fn          lerp_u32;
+
+    FcBlendMaskU32Fn blend_mask_u32;
+    FcBlendOverU32Fn blend_over_u32;
+
+    FcBlurRowsU32Fn   blur_rows_u32;
+    FcBlurColumnU32Fn blur_column_u32;
+    FcLut1dU32Fn      lut_1d_u32;
+    FcLut3dU32Fn      lut_3d_u32;
+
+    const char* fill_u32_variant;
+    const char* copy_u32_variant;
+    const char* swizzle_u32_variant;
+    const char* scale_variant;
+    const char* blend_variant;
+    const char* post_variant;
+} FcRenderKernels;
+
+extern FcRenderKernels fc_render_kernels;
+
+void fc_render_select_kernels(u32 cpu_features);
+
+static inline void fc_fill_u32(u32* dest, u32 value, u64 count)
+{
+    fc_render_kernels.fill_u32(dest, value, count);
+}
+
+static inline void fc_copy_u32(u32* dest, const u32* src, u64 count)
+{
+    fc_render_kernels.copy_u32(dest, src, count);
+}
+
+static inline void fc_swizzle_u32(u32* dest, const u32* src, u64 count,
+                                  FcSwizzle swizzle)
+{
+    fc_render_kernels.swizzle_u32(dest, src, count, swizzle);
+}
+
+static inline void fc_blend_over_u32(u32* dest, const u32* src, u32 alpha_shift, u64 count)
+{
+    fc_render_kernels.blend_over_u32(dest, src, alpha_shift, count);
+}
+
+// Pixel format conversion. Swizzles only convert between 32-bit formats,
+// anything else takes the (scalar) mask conversion.
+b32       fc_pixel_formats_equal(const FcPixelFormat* a, const FcPixelFormat* b);
+FcSwizzle fc_pixel_format_swizzle(const FcPixelFormat* from, const FcPixelFormat* to);
+void      fc_convert_u32_to_u16(u16* dest, const u32* src, u64 count,
+                                const FcPixelFormat* from, const FcPixelFormat* to,
+                                b32 swap_bytes);
+
+void fc_fill_rect_u32(u32* dest, u32 dest_stride,
+                      u32 x, u32 y, u32 width, u32 height, u32 value);
+void fc_blit_u32(u32* dest, u32 dest_stride,
+                 const u32* src, u32 src_stride, u32 width, u32 height);
+
+#endif // FINCH_RENDER_KERNELS_H
@@ -0,0 +1,93 @@
+#ifndef FINCH_RENDER_LAYER_H
+#define FINCH_RENDER_LAYER_H
+
+#include "finch/core/core.h"
+#include "finch/application/application.h"
+
+#include <stddef.h>
+
+// Retained layers composited into the pixelbuffer. Each layer keeps its own
+// pixels and is only redrawn where it was invalidated; the compositor then
+// only rebuilds the parts of the pixelbuffer that changed, so a frame in
+// which nothing changed costs nothing and can skip presenting.
+#define FC_COMPOSITOR_MAX_LAYERS 32
+#define FC_COMPOSITOR_MAX_DAMAGE 16
+
+typedef struct _FcRect {
+    s32 x, y;
+    s32 width, height;
+} FcRect;
+
+typedef enum _FcLayerBlend {
+    FC_LAYER_BLEND_OPAQUE = 0, // Covers what is below
+    FC_LAYER_BLEND_ALPHA       // Blended by the alpha channel of its pixels
+} FcLayerBlend;
+
+typedef struct _FcLayer FcLayer;
+
+// Redraws `region` of the layer, in layer coordinates. Drawing outside of
+// it is allowed but wasted.
+typedef void (*FcLayerDrawFn)(FcLayer* layer, FcRect region, void* data);
+
+struct _FcLayer {
+    u32* pixels;      // width * height, in the pixelbuffer's format
+    u32  width, height;
+    s32  x, y;        // Position in the pixelbuffer
+    s32  z;           // Higher is on top; equal z keeps the order of adding
+    FcLayerBlend  blend;
+    b32  visible;
+    FcLayerDrawFn draw;
+    void* data;
+
+    b32    in_use;
+    b32    dirty;
+    FcRect dirty_region;
+};
+
+typedef struct _FcLayerDesc {
+    s32 x, y;
+    u32 width, height;
+    s32 z;
+    FcLayerBlend  blend;
+    FcLayerDrawFn draw;
+    void* data;
+} FcLayerDesc;
+
+typedef struct _FcCompositor {
+    FcLayer  layers[FC_COMPOSITOR_MAX_LAYERS];
+    FcLayer* order[FC_COMPOSITOR_MAX_LAYERS]; // Bottom to top
+    u32      layer_count;
+
+    FcRect damage[FC_COMPOSITOR_MAX_DAMAGE];  // Pixelbuffer regions to rebuild
+    u32    damage_count;
+
+    u32 width, height;  // Of the pixelbuffer last rendered to
+    u32 alpha_shift;
+    u32 clear_color;    // Where no opaque layer covers the pixelbuffer
+    b32 composite_all;  // Rebuild the whole pixelbuffer whenever anything changed
+
+    // Of the last render
+    u32 layers_drawn;
+    u64 pixels_composited;
+} FcCompositor;
+
+void fc_compositor_init(FcCompositor* compositor, const FcPixelFormat* format, u32 clear_color);
+void fc_compositor_free(FcCompositor* compositor);
+
+// The layer starts out invalidated. Returns NULL when out of layers or memory.
+FcLayer* fc_compositor_add_layer(FcCompositor* compositor, const FcLayerDesc* desc);
+void fc_compositor_remove_layer(FcCompositor* compositor, FcLayer* layer);
+void fc_compositor_move_layer(FcCompositor* compositor, FcLayer* layer, s32 x, s32 y);
+void fc_compositor_set_layer_visible(FcCompositor* compositor, FcLayer* layer, b32 visible);
+
+// Marks a region of the layer for redrawing, NULL for all of it
+void fc_layer_invalidate(FcLayer* layer, const FcRect* region);
+// Marks a region of the pixelbuffer for rebuilding, NULL for all of it
+void fc_compositor_damage(FcCompositor* compositor, const FcRect* region);
+
+// Redraws invalidated layers and rebuilds the damaged parts of `pixels`,
+// which must hold what the last render left there. A new size rebuilds
+// everything. Returns false if no pixel changed.
+b32 fc_compositor_render(FcCompositor* compositor, u32* pixels, u32 width, u32 height);
+
+#endif // FINCH_RENDER_LAYER_H
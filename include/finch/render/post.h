@@ -0,0 +1,104 @@
+#ifndef FINCH_RENDER_POST_H
+#define FINCH_RENDER_POST_H
+
+#include "finch/core/core.h"
+#include "finch/application/application.h"
+
+// Post-processing of the pixelbuffer by a chain of filters, which the main
+// loop runs between fc_application_update and presenting when
+// ApplicationState.post_chain is set. The filtered frame goes into a buffer
+// of the chain, which is presented and captured instead of the
+// pixelbuffer, so the application's pixels are never changed. Blurs slide a window along rows and
+// then columns, so their cost per pixel does not grow with the radius.
+// Colour filters look pixels up in tables built when their settings or the
+// pixel format change, and consecutive ones are applied to a band of rows
+// while it is in cache. Every pass is split across the worker threads of
+// finch/core/jobs.h when the chain is parallel.
+#define FC_POST_MAX_FILTERS     16
+#define FC_POST_MAX_BLUR_RADIUS 127 // Keeps scaled window sums within a level of the mean
+#define FC_POST_BAND_ROWS       16  // Rows per job of row passes
+#define FC_POST_STRIP_WIDTH     64  // Columns per job of column passes
+#define FC_COLOR_LUT_MAX_SIZE   129
+
+typedef enum _FcPostFilterType {
+    FC_POST_FILTER_BOX_BLUR = 0,
+    FC_POST_FILTER_GAUSSIAN_BLUR,   // Approximated by three box blurs
+    FC_POST_FILTER_TONE,            // Per-channel curves
+    FC_POST_FILTER_COLOR_GRADE      // 3D colour LUT
+} FcPostFilterType;
+
+// Curves from 8-bit input to 8-bit output for red, green and blue. Set
+// dirty after editing the curves by hand.
+typedef struct _FcToneLut {
+    u8  curves[3][256];
+    b32 dirty;
+    FcPixelFormat format;   // Of the tables
+    u32 tables[4 * 256];
+} FcToneLut;
+
+// Output colours on a lattice of size^3 input colours, red varying fastest
+// as in .cube files. Input between lattice points is interpolated.
+typedef struct _FcColorLut {
+    u32 size;
+    u8* colors;             // RGB of every lattice point
+    b32 dirty;
+    FcPixelFormat format;   // Of the tables
+    u32* lattice;
+    u32 axes[3][256];
+} FcColorLut;
+
+typedef struct _FcPostFilter {
+    FcPostFilterType type;
+    b32 enabled;
+    u32 radius;             // Box blur
+    f32 sigma;              // Gaussian blur, in pixels
+    FcToneLut*  tone;
+    FcColorLut* color;
+} FcPostFilter;
+
+typedef struct _FcPostChain {
+    FcPostFilter filters[FC_POST_MAX_FILTERS];
+    u32 filter_count;
+    b32 parallel;
+
+    // Filtered frame, the ping-pong buffer of blurs and the window sums of
+    // column passes, allocated for the size of the pixels the chain runs on
+    u32* output;
+    u32* scratch;
+    u32* column_sums;
+    u32  width, height;
+
+    f64 last_run_ms;
+} FcPostChain;
+
+void fc_post_chain_init(FcPostChain* chain, b32 parallel);
+void fc_post_chain_free(FcPostChain* chain);
+
+// Each returns the added filter, which stays in place and may be changed
+// or disabled between runs, or NULL when the chain is full. LUTs must stay
+// valid while the chain uses them.
+FcPostFilter* fc_post_chain_add_box_blur(FcPostChain* chain, u32 radius);
+FcPostFilter* fc_post_chain_add_gaussian_blur(FcPostChain* chain, f32 sigma);
+FcPostFilter* fc_post_chain_add_tone(FcPostChain* chain, FcToneLut* lut);
+FcPostFilter* fc_post_chain_add_color_grade(FcPostChain* chain, FcColorLut* lut);
+
+// Applies the enabled filters in order to the pixels, which are only read,
+// and returns the result: width x height pixels in chain->output, valid
+// until the next run. Returns NULL if the buffers could not be allocated.
+const u32* fc_post_chain_run(FcPostChain* chain, const u32* pixels, u32 width, u32 height,
+                             u32 stride, const FcPixelFormat* format);
+
+// Scales by exposure, then stretches around mid grey by contrast, then
+// raises to 1 / gamma; 1, 1, 1 is the identity
+void fc_tone_lut_init(FcToneLut* lut, f32 exposure, f32 contrast, f32 gamma);
+
+// Starts out as the identity. Returns false if size is outside 2 to
+// FC_COLOR_LUT_MAX_SIZE or allocating fails.
+b32  fc_color_lut_init(FcColorLut* lut, u32 size);
+void fc_color_lut_set(FcColorLut* lut, u32 r, u32 g, u32 b, f32 red, f32 green, f32 blue);
+// Initializes the LUT from a .cube file, which must hold a 3D LUT with
+// the default domain of 0 to 1
+b32  fc_color_lut_load_cube(FcColorLut* lut, const char* path);
+void fc_color_lut_free(FcColorLut* lut);
+
+#endif // FINCH_RENDER_POST_H
@@ -0,0 +1,168 @@
+#ifndef FINCH_RENDER_RASTER_H
+#define FINCH_RENDER_RASTER_H
+
+#include "finch/core/core.h"
+#include "finch/application/application.h"
+#include "finch/utils/array.h"
+
+// Software 3D rasterizer drawing depth-tested triangles into the
+// pixelbuffer. Draw calls transform, clip and set up their triangles and
+// sort them into bins of screen tiles; fc_raster_end then rasterizes every
+// tile on its own, on the worker threads of finch/core/jobs.h if asked.
+// Tiles are walked in blocks of 8x8 pixels: blocks outside an edge are
+// skipped, and blocks the triangle is entirely behind are rejected against
+// the farthest depth stored per block before any pixel is touched.
+#define FC_RASTER_TILE_SIZE     64
+#define FC_RASTER_BLOCK_SIZE    8
+#define FC_RASTER_SUBPIXEL_BITS 4
+#define FC_RASTER_MAX_SIZE      8192 // Width and height
+
+typedef enum _FcRasterDepthFormat {
+    FC_RASTER_DEPTH_16 = 0, // Unsigned normalized
+    FC_RASTER_DEPTH_32      // Float
+} FcRasterDepthFormat;
+
+// Column major, as the matrices transform column vectors
+typedef struct _FcMat4 {
+    f32 m[16];
+} FcMat4;
+
+FcMat4 fc_mat4_identity(void);
+FcMat4 fc_mat4_multiply(const FcMat4* a, const FcMat4* b);
+// Right handed, looking down -z, with depths from -1 to 1
+FcMat4 fc_mat4_perspective(f32 fov_y_radians, f32 aspect, f32 near, f32 far);
+FcMat4 fc_mat4_translation(f32 x, f32 y, f32 z);
+FcMat4 fc_mat4_rotation_x(f32 radians);
+FcMat4 fc_mat4_rotation_y(f32 radians);
+
+typedef struct _FcRasterVertex {
+    f32 position[3];
+    f32 color[3];   // 0 to 1, multiplied with the texture if there is one
+    f32 uv[2];      // Texture coordinates, repeating
+} FcRasterVertex;
+
+// Pixels in the target's format. Width and height are powers of two.
+typedef struct _FcRasterTexture {
+    const u32* pixels;
+    u32 width, height;
+} FcRasterTexture;
+
+// Interpolated values of a triangle, planes over pixel coordinates
+typedef enum _FcRasterPlane {
+    FC_RASTER_PLANE_Z = 0,  // Depth from 0 to 1
+    FC_RASTER_PLANE_INV_W,
+    FC_RASTER_PLANE_RED,    // Attributes are divided by w, for perspective
+    FC_RASTER_PLANE_GREEN,
+    FC_RASTER_PLANE_BLUE,
+    FC_RASTER_PLANE_U,
+    FC_RASTER_PLANE_V,
+    FC_RASTER_PLANE_COUNT
+} FcRasterPlane;
+
+// Set up once per triangle. Edge functions a * x + b * y + c are over
+// positions in fixed point with FC_RASTER_SUBPIXEL_BITS fractional bits and
+// are positive inside. Planes give value + dx * x + dy * y, with x and y
+// relative to the origin.
+typedef struct _FcRasterTriangle {
+    s32 edge_a[3], edge_b[3];
+    s64 edge_c[3];
+    s32 min_x, min_y, max_x, max_y;  // Pixel bounds, inclusive
+    f32 origin_x, origin_y;
+    f32 planes[FC_RASTER_PLANE_COUNT][3];
+    f32 z_min;
+    const FcRasterTexture* texture;
+} FcRasterTriangle;
+
+typedef struct _FcRasterBin {
+    FcArray triangles;      // u32 indices, in the order they were drawn
+    u64 blocks_rasterized;
+    u64 blocks_rejected;
+    u64 pixels_written;
+} FcRasterBin;
+
+// An 8x8 block of pixels a triangle covers at least partly. Edges whose
+// bit is set in partial_edges cross the block and hold their value at its
+// first pixel; the others cover all of it.
+typedef struct _FcRasterBlock {
+    const FcRasterTriangle* triangle;
+    u32* pixels;
+    void* depth;
+    u32 pixel_stride, depth_stride;
+    s32 x, y;
+    s32 edges[3];
+    u32 partial_edges;
+    u32 columns, rows;      // Inside the target
+    FcRasterDepthFormat depth_format;
+    u8 red_shift, green_shift, blue_shift, alpha_shift;
+} FcRasterBlock;
+
+// Depth tests, shades and writes the pixels of a block, returning how many
+// were written. If any were, stores the farthest depth of the block.
+typedef u32 (*FcRasterBlockFn)(const FcRasterBlock* block, u32* block_depth);
+
+typedef struct _FcRasterStats {
+    u64 triangles_submitted;
+    u64 triangles_culled;       // Back facing, outside the view or too small
+    u64 triangles_clipped;      // Crossing a clip plane
+    u64 triangles_binned;       // Set up and sorted into tiles
+    u64 blocks_rasterized;
+    u64 blocks_rejected;        // By the farthest depth of the block
+    u64 pixels_written;
+} FcRasterStats;
+
+typedef struct _FcRaster {
+    FcRasterDepthFormat depth_format;
+    b32 cull_back_faces;        // Counter clockwise triangles face the viewer
+
+    // Target of the current frame
+    u32* pixels;
+    u32  width, height, stride;
+    FcPixelFormat pixel_format;
+
+    // Padded to whole blocks; block_depth holds the farthest depth of each
+    // block, in the same encoding as the depth buffer
+    void* depth;
+    u32*  block_depth;
+    u32   depth_stride;         // Pixels per row
+    u32   blocks_x, blocks_y;
+    u32   allocated_width, allocated_height;
+
+    FcRasterBin* bins;
+    u32 tiles_x, tiles_y;
+    FcArray triangles;          // FcRasterTriangle
+    FcArray active_tiles;       // u32 indices of the bins with triangles
+    FcArray clip_vertices;      // Scratch of each draw
+
+    FcRasterStats stats;        // Of the frame since fc_raster_begin
+} FcRaster;
+
+void fc_raster_init(FcRaster* raster, FcRasterDepthFormat depth_format);
+void fc_raster_free(FcRaster* raster);
+
+// Starts a frame drawing into `pixels`, which stays unchanged where nothing
+// is drawn. The depth buffer is kept from the previous frame unless
+// cleared; it is reallocated when the size changed. Returns false if that
+// fails or the size is over FC_RASTER_MAX_SIZE.
+b32  fc_raster_begin(FcRaster* raster, u32* pixels, u32 width, u32 height, u32 stride,
+                     const FcPixelFormat* format);
+void fc_raster_clear_depth(FcRaster* raster);
+// Triangles of three indices each. The texture, which may be NULL, must
+// stay valid until fc_raster_end.
+void fc_raster_draw(FcRaster* raster, const FcMat4* transform,
+                    const FcRasterVertex* vertices, u32 vertex_count,
+                    const u32* indices, u32 index_count, const FcRasterTexture* texture);
+// Rasterizes everything drawn since fc_raster_begin
+void fc_raster_end(FcRaster* raster, b32 parallel);
+
+// Block kernel, selected for the host CPU by fc_raster_select_kernels().
+// Until then the generic variant is used.
+typedef struct _FcRasterKernels {
+    FcRasterBlockFn block;
+    const char* block_variant;
+} FcRasterKernels;
+
+extern FcRasterKernels fc_raster_kernels;
+
+void fc_raster_select_kernels(u32 cpu_features);
+
+#endif // FINCH_RENDER_RASTER_H
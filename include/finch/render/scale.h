@@ -0,0 +1,42 @@
+#ifndef FINCH_RENDER_SCALE_H
+#define FINCH_RENDER_SCALE_H
+
+#include "finch/core/core.h"
+#include "finch/application/application.h"
+
+// Frames between adjustments of the dynamic render scale
+#define FC_RENDER_SCALE_SETTLE_FRAMES 30
+
+// Pixelbuffer size for a window of the given size
+void fc_render_scale_resolve(FcRenderScale* render_scale,
+                             u32 window_width, u32 window_height,
+                             u32* width, u32* height);
+
+// Feeds the time of the last frame to the dynamic render scale. Returns
+// true when the factor changed and the pixelbuffer must be resized.
+b32 fc_render_scale_update(FcRenderScale* render_scale, f64 frame_ms);
+
+// Area of the window the pixelbuffer is scaled to
+void fc_render_scale_destination(FcRenderScale* render_scale,
+                                 u32 width, u32 height,
+                                 u32 window_width, u32 window_height,
+                                 u32* x, u32* y, u32* dest_width, u32* dest_height);
+
+// Scales a source image to a destination rectangle with the dispatched row
+// kernels. The lookup tables are rebuilt only when the sizes change.
+typedef struct _FcUpscaler {
+    u32 src_width, src_height;
+    u32 dest_width, dest_height;
+    FcRenderScaleFilter filter;
+
+    u32* x_table;
+    u32* y_table;
+    u32* rows;      // Bilinear scratch: one filtered row (+1 pixel)
+} FcUpscaler;
+
+void fc_upscaler_run(FcUpscaler* upscaler, FcRenderScaleFilter filter,
+                     u32* dest, u32 dest_stride, u32 dest_width, u32 dest_height,
+                     const u32* src, u32 src_width, u32 src_height);
+void fc_upscaler_free(FcUpscaler* upscaler);
+
+#endif // FINCH_RENDER_SCALE_H
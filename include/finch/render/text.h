@@ -0,0 +1,43 @@
+#ifndef FINCH_RENDER_TEXT_H
+#define FINCH_RENDER_TEXT_H
+
+#include "finch/core/core.h"
+
+#include <stdarg.h>
+
+// Monospaced bitmap font baked into a coverage atlas, glyph after glyph,
+// each glyph_width * glyph_height bytes
+typedef struct _FcFont {
+    u32 glyph_width;  // Cell size in pixels, including spacing
+    u32 glyph_height;
+    u32 first_char;
+    u32 glyph_count;
+    u8* atlas;
+} FcFont;
+
+// Embedded ASCII font, 5x7 with descenders in 6x9 cells, enlarged by a
+// whole `scale`, or not enlarged if the atlas would be too large
+void fc_font_init_default(FcFont* font, u32 scale);
+
+// Loads a PC Screen Font (PSF1 or PSF2), such as the Linux console fonts.
+// Fails on glyphs over 256 pixels wide or high, or an atlas over 64 MB.
+b32  fc_font_load_psf(FcFont* font, const char* path, u32 scale);
+
+void fc_font_free(FcFont* font);
+
+// Draws text into a pixelbuffer of the given size with `color` in the
+// pixelbuffer's format, clipped to its edges. '\n' starts a new line.
+// Returns the width of the widest line.
+u32 fc_text_draw(const FcFont* font, u32* pixels, u32 width, u32 height,
+                 s32 x, s32 y, u32 color, const char* text);
+
+// Formats like string_format into a buffer on the stack and draws the
+// result. Output past 1024 characters is truncated.
+u32 fc_text_draw_format(const FcFont* font, u32* pixels, u32 width, u32 height,
+                        s32 x, s32 y, u32 color, const char* fmt, ...);
+u32 fc_text_draw_format_v(const FcFont* font, u32* pixels, u32 width, u32 height,
+                          s32 x, s32 y, u32 color, const char* fmt, va_list args);
+
+void fc_text_measure(const FcFont* font, const char* text, u32* width, u32* height);
+
+#endif // FINCH_RENDER_TEXT_H
@@ -0,0 +1,50 @@
+#ifndef FINCH_UTILS_ARRAY_H
+#define FINCH_UTILS_ARRAY_H
+
+#include "finch/core/core.h"
+#include "finch/core/memory.h"
+
+#include <stddef.h>
+
+// Growable array of fixed-size elements, stored contiguously. Grows by
+// doubling; pointers into it are invalidated by anything that grows it.
+typedef struct _FcArray {
+    u8* data;
+    u32 count;
+    u32 capacity;
+    u32 element_size;
+    u32 element_alignment;
+    FcAllocator allocator;
+} FcArray;
+
+// A NULL allocator is the heap. Nothing is allocated until the first push.
+void  fc_array_init(FcArray* array, u32 element_size, u32 element_alignment,
+                    const FcAllocator* allocator);
+void  fc_array_free(FcArray* array);
+
+b32   fc_array_reserve(FcArray* array, u32 capacity);
+b32   fc_array_resize(FcArray* array, u32 count); // New elements are zeroed
+void  fc_array_pop(FcArray* array);
+// Moves the last element into the hole, so order is not kept
+void  fc_array_remove_swap(FcArray* array, u32 index);
+void  fc_array_remove_ordered(FcArray* array, u32 index);
+void  fc_array_clear(FcArray* array);
+
+// Returns the new, uninitialized last element, or NULL if growing failed
+static inline void* fc_array_push(FcArray* array)
+{
+    if (array->count == array->capacity &&
+        !fc_array_reserve(array, array->capacity != 0 ? array->capacity * 2 : 16)) {
+        return NULL;
+    }
+    return array->data + (u64)array->count++ * array->element_size;
+}
+
+#define FC_ARRAY_INIT(ARRAY, TYPE, ALLOCATOR)                           \
+    fc_array_init((ARRAY), sizeof(TYPE), _Alignof(TYPE), (ALLOCATOR))
+#define FC_ARRAY_DATA(ARRAY, TYPE) ((TYPE*)(ARRAY)->data)
+#define FC_ARRAY_AT(ARRAY, TYPE, INDEX) (((TYPE*)(ARRAY)->data)[INDEX])
+#define FC_ARRAY_PUSH(ARRAY, TYPE) ((TYPE*)fc_array_push(ARRAY))
+#define FC_ARRAY_LAST(ARRAY, TYPE) (((TYPE*)(ARRAY)->data)[(ARRAY)->count - 1])
+
+#endif // FINCH_UTILS_ARRAY_H
@@ -0,0 +1,62 @@
+#ifndef FINCH_UTILS_HASH_MAP_H
+#define FINCH_UTILS_HASH_MAP_H
+
+#include "finch/core/core.h"
+#include "finch/core/memory.h"
+
+// Open addressing hash map laid out like a SwissTable: one control byte per
+// slot holding 7 bits of the hash, probed 16 at a time (with SSE2 where
+// available). Keys and values are fixed-size and stored together in one
+// array, so a hit touches one control group and one slot. Inserting may
+// move every entry; pointers into the map last until the next insert.
+#define FC_HASH_MAP_GROUP_WIDTH 16
+
+typedef u64 (*FcHashFn)(const void* key, u32 size);
+typedef b32 (*FcKeyEqualFn)(const void* a, const void* b, u32 size);
+
+typedef struct _FcHashMap {
+    u8* control;
+    u8* slots;
+    u32 capacity;    // Slots, a power of two and a multiple of the group width
+    u32 count;
+    u32 growth_left; // Inserts into empty slots before the next rehash
+    u32 key_size;
+    u32 value_offset;
+    u32 value_size;
+    u32 slot_size;
+    // Bytewise when NULL; set after init for keys like strings
+    FcHashFn     hash;
+    FcKeyEqualFn equal;
+    FcAllocator  allocator;
+} FcHashMap;
+
+// A NULL allocator is the heap. Values are aligned to at most 8 bytes.
+// Nothing is allocated until the first insert.
+void  fc_hash_map_init(FcHashMap* map, u32 key_size, u32 value_size,
+                       const FcAllocator* allocator);
+void  fc_hash_map_free(FcHashMap* map);
+
+b32   fc_hash_map_reserve(FcHashMap* map, u32 count);
+// Returns the value of `key`, or NULL
+void* fc_hash_map_find(const FcHashMap* map, const void* key);
+// Returns the value of `key`, adding the key with an uninitialized value
+// if it is new (`existed` may be NULL). NULL if growing failed.
+void* fc_hash_map_insert(FcHashMap* map, const void* key, b32* existed);
+b32   fc_hash_map_remove(FcHashMap* map, const void* key);
+void  fc_hash_map_clear(FcHashMap* map);
+
+// Visits every entry in no particular order; start with `iterator` at 0
+b32   fc_hash_map_next(const FcHashMap* map, u32* iterator, void** key, void** value);
+
+u64   fc_hash_bytes(const void* data, u64 size);
+
+#define FC_HASH_MAP_INIT(MAP, KEY_TYPE, VALUE_TYPE, ALLOCATOR)          \
+    fc_hash_map_init((MAP), sizeof(KEY_TYPE), sizeof(VALUE_TYPE), (ALLOCATOR))
+#define FC_HASH_MAP_FIND(MAP, KEY_TYPE, VALUE_TYPE, KEY)                \
+    ((VALUE_TYPE*)fc_hash_map_find((MAP), &(KEY_TYPE){KEY}))
+#define FC_HASH_MAP_INSERT(MAP, KEY_TYPE, VALUE_TYPE, KEY, EXISTED)     \
+    ((VALUE_TYPE*)fc_hash_map_insert((MAP), &(KEY_TYPE){KEY}, (EXISTED)))
+#define FC_HASH_MAP_REMOVE(MAP, KEY_TYPE, KEY)                          \
+    fc_hash_map_remove((MAP), &(KEY_TYPE){KEY})
+
+#endif // FINCH_UTILS_HASH_MAP_H
@@ -0,0 +1,99 @@
+#ifndef FINCH_UTILS_POOL_H
+#define FINCH_UTILS_POOL_H
+
+#include "finch/core/core.h"
+#include "finch/core/memory.h"
+
+#include <string.h>
+
+// Refers to an object in a pool. The generation tells a released and
+// reused slot apart from the object the handle was made for; the zero
+// handle is never valid.
+typedef struct _FcPoolHandle {
+    u32 index;
+    u32 generation;
+} FcPoolHandle;
+
+// Fixed number of equally sized blocks, allocated once. Free blocks form a
+// list threaded through the blocks themselves, so acquiring and releasing
+// are O(1) and never allocate.
+typedef struct _FcPool {
+    u8*  blocks;
+    u32* generations; // Odd while the block is in use
+    u32  block_size;
+    u32  capacity;
+    u32  count;
+    u32  free_head;
+    FcAllocator allocator;
+} FcPool;
+
+#define FC_POOL_END UINT32_MAX // free_head of a full pool
+
+// A NULL allocator is the heap. Blocks are aligned to 16 bytes.
+b32   fc_pool_init(FcPool* pool, u32 block_size, u32 capacity, const FcAllocator* allocator);
+void  fc_pool_free(FcPool* pool);
+// Releases every block, invalidating all handles
+void  fc_pool_clear(FcPool* pool);
+
+static inline b32 fc_pool_handle_is_valid(FcPoolHandle handle)
+{
+    return handle.generation != 0;
+}
+
+static inline u8* fc_pool_block_at(const FcPool* pool, u32 index)
+{
+    return pool->blocks + (u64)index * pool->block_size;
+}
+
+// Returns the zero handle when the pool is full. The block is
+// uninitialized; see fc_pool_acquire_zeroed.
+static inline FcPoolHandle fc_pool_acquire(FcPool* pool)
+{
+    u32 index = pool->free_head;
+    if (index == FC_POOL_END) {
+        return (FcPoolHandle){0};
+    }
+    // Free blocks start with the index of the next free block
+    memcpy(&pool->free_head, fc_pool_block_at(pool, index), sizeof(pool->free_head));
+    pool->count += 1;
+    return (FcPoolHandle){ .index = index, .generation = ++pool->generations[index] };
+}
+
+static inline FcPoolHandle fc_pool_acquire_zeroed(FcPool* pool)
+{
+    FcPoolHandle handle = fc_pool_acquire(pool);
+    if (fc_pool_handle_is_valid(handle)) {
+        memset(fc_pool_block_at(pool, handle.index), 0, pool->block_size);
+    }
+    return handle;
+}
+
+// Returns NULL for stale and zero handles
+static inline void* fc_pool_get(const FcPool* pool, FcPoolHandle handle)
+{
+    if (handle.index >= pool->capacity ||
+        pool->generations[handle.index] != handle.generation ||
+        (handle.generation & 1) == 0) {
+        return NULL;
+    }
+    return fc_pool_block_at(pool, handle.index);
+}
+
+// Returns false for stale and zero handles
+static inline b32 fc_pool_release(FcPool* pool, FcPoolHandle handle)
+{
+    if (fc_pool_get(pool, handle) == NULL) {
+        return false;
+    }
+    pool->generations[handle.index] += 1;
+    memcpy(fc_pool_block_at(pool, handle.index), &pool->free_head, sizeof(pool->free_head));
+    pool->free_head = handle.index;
+    pool->count -= 1;
+    return true;
+}
+
+#define FC_POOL_INIT(POOL, TYPE, CAPACITY, ALLOCATOR)                   \
+    fc_pool_init((POOL), sizeof(TYPE), (CAPACITY), (ALLOCATOR))
+#define FC_POOL_GET(POOL, TYPE, HANDLE) ((TYPE*)fc_pool_get((POOL), (HANDLE)))
+
+#endif // FINCH_UTILS_POOL_H
@@ -0,0 +1,51 @@
+#ifndef FINCH_UTILS_SMALL_STRING_H
+#define FINCH_UTILS_SMALL_STRING_H
+
+#include "finch/core/core.h"
+#include "finch/core/memory.h"
+
+#include <stdarg.h>
+
+// Strings up to this length are stored inside the struct itself, which
+// covers most names, tags and keys without touching the allocator
+#define FC_SMALL_STRING_INLINE_CAPACITY 23
+
+typedef struct _FcSmallString {
+    union {
+        char inline_chars[FC_SMALL_STRING_INLINE_CAPACITY + 1];
+        struct {
+            char* data;
+            u32   capacity; // Excluding the terminator
+        } heap;
+    };
+    u32 length;
+    b32 on_heap;
+    const FcAllocator* allocator; // NULL is the heap; must outlive the string
+} FcSmallString;
+
+void fc_small_string_init(FcSmallString* string, const FcAllocator* allocator);
+void fc_small_string_free(FcSmallString* string);
+
+// These return false, leaving the string as it was, if growing failed
+b32  fc_small_string_set(FcSmallString* string, const char* str);
+b32  fc_small_string_set_n(FcSmallString* string, const char* str, u32 length);
+b32  fc_small_string_append(FcSmallString* string, const char* str);
+b32  fc_small_string_append_n(FcSmallString* string, const char* str, u32 length);
+// Formats like string_format; output past 1024 characters is truncated
+b32  fc_small_string_format(FcSmallString* string, const char* fmt, ...);
+b32  fc_small_string_format_v(FcSmallString* string, const char* fmt, va_list args);
+void fc_small_string_clear(FcSmallString* string);
+
+b32  fc_small_string_equals(const FcSmallString* a, const FcSmallString* b);
+b32  fc_small_string_equals_cstr(const FcSmallString* string, const char* str);
+
+// For hash maps keyed by FcSmallString, see FcHashMap.hash and .equal
+u64  fc_small_string_hash_key(const void* key, u32 size);
+b32  fc_small_string_key_equal(const void* a, const void* b, u32 size);
+
+static inline const char* fc_small_string_cstr(const FcSmallString* string)
+{
+    return string->on_heap ? string->heap.data : string->inline_chars;
+}
+
+#endif // FINCH_UTILS_SMALL_STRING_H
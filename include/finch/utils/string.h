@@ -14,5 +14,9 @@ char* string_copy(char* dest, char* src);
 char* f64_to_string_null_terminated(f64 number, char* buf, u32 buf_size,
                                     u32 num_decimals);
 u32   string_format(char* dest, u32 max_size, const char* fmt, ...);
+u32   string_format_v(char* dest, u32 max_size, const char* fmt, va_list args);
+
+// Picks the string kernels for the host CPU, see platform_cpu_init()
+void  string_select_kernels(u32 cpu_features);
 
 #endif // FINCH_UTILS_STRING_H
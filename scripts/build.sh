@@ -4,10 +4,18 @@ source scripts/color_support.sh
 
 CC=gcc
 CFLAGS="-Wall -Wextra -std=c11 -O0 -ggdb"
+if test "$1" == '--release'; then
+    CFLAGS="-Wall -Wextra -std=c11 -O2 -ggdb"
+fi
 
 INCLUDE_PATH="-I include/"
 SOURCE_PATH="src/"
-LIBS="$(pkg-config --cflags --libs x11) -lm -ldl"
+LIBS="$(pkg-config --cflags --libs x11 xext) -lm -ldl -lpthread"
+# FINCH_PLATFORM=xcb builds the XCB window backend instead of the Xlib one
+if test "$FINCH_PLATFORM" == 'xcb'; then
+    CFLAGS="$CFLAGS -DFINCH_PLATFORM_XCB"
+    LIBS="$(pkg-config --cflags --libs xcb) -lm -ldl -lpthread"
+fi
 
 BUILD_PATH="build/"
 BIN_PATH=$BUILD_PATH"/bin/"
@@ -70,6 +78,14 @@ link_library()
     $CC $CFLAGS -shared -o $BIN_PATH/$LIB_NAME -Wl,--whole-archive $MODULE_LIBS -Wl,--no-whole-archive $LIBS
 }
 
+link_host()
+{
+    # Executable with no application linked in, used to run applications
+    # built as shared objects (see FINCH_APPLICATION_MODULE)
+    echo -e "${BOLD}${MAGENTA}Linking:${NORMAL} $BIN_PATH/lib$BIN.so -> $BIN_PATH/$BIN"
+    $CC $CFLAGS -o $BIN_PATH/$BIN -L $BIN_PATH -l$BIN -Wl,-rpath,'$ORIGIN'
+}
+
 if test "$1" == '--clean'; then
     clean
     exit 0
@@ -90,3 +106,7 @@ echo ""
 echo -e "${STANDOUT}${BOLD}${MAGENTA}LINKING LIBRARY${NORMAL}"
 link_library | sed "s|^|    |g"
 echo ""
+
+echo -e "${STANDOUT}${BOLD}${MAGENTA}LINKING HOST${NORMAL}"
+link_host | sed "s|^|    |g"
+echo ""
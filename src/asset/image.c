@@ -0,0 +1,177 @@
+#include "finch/asset/image.h"
+#include "finch/core/memory.h"
+#include "finch/render/kernels.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct _NetpbmReader {
+    const u8* data;
+    u64 size;
+    u64 at;
+} NetpbmReader;
+
+static void netpbm_skip_space(NetpbmReader* reader)
+{
+    while (reader->at < reader->size) {
+        u8 c = reader->data[reader->at];
+        if (c == '#') {
+            while (reader->at < reader->size && reader->data[reader->at] != '\n') {
+                reader->at++;
+            }
+        } else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            reader->at++;
+        } else {
+            break;
+        }
+    }
+}
+
+// Next whitespace separated token, not terminated
+static u32 netpbm_token(NetpbmReader* reader, const char** token)
+{
+    netpbm_skip_space(reader);
+    u64 start = reader->at;
+    while (reader->at < reader->size) {
+        u8 c = reader->data[reader->at];
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            break;
+        }
+        reader->at++;
+    }
+    *token = (const char*)reader->data + start;
+    return (u32)(reader->at - start);
+}
+
+static b32 netpbm_token_is(const char* token, u32 length, const char* expected)
+{
+    return strlen(expected) == length && memcmp(token, expected, length) == 0;
+}
+
+static b32 netpbm_number(NetpbmReader* reader, u32* value)
+{
+    const char* token;
+    u32 length = netpbm_token(reader, &token);
+    if (length == 0 || length > 9) {
+        return false;
+    }
+    *value = 0;
+    for (u32 i = 0; i < length; ++i) {
+        if (token[i] < '0' || token[i] > '9') {
+            return false;
+        }
+        *value = *value * 10 + (token[i] - '0');
+    }
+    return true;
+}
+
+static b32 netpbm_parse_header(NetpbmReader* reader, u32* width, u32* height,
+                               u32* depth, u32* max_value)
+{
+    const char* token;
+    u32 length = netpbm_token(reader, &token);
+
+    if (netpbm_token_is(token, length, "P6")) {
+        *depth = 3;
+        if (!netpbm_number(reader, width) || !netpbm_number(reader, height) ||
+            !netpbm_number(reader, max_value)) {
+            return false;
+        }
+    } else if (netpbm_token_is(token, length, "P7")) {
+        *width = *height = *depth = *max_value = 0;
+        for (;;) {
+            length = netpbm_token(reader, &token);
+            if (length == 0) {
+                return false;
+            }
+            if (netpbm_token_is(token, length, "ENDHDR")) {
+                break;
+            }
+            if (netpbm_token_is(token, length, "WIDTH")) {
+                if (!netpbm_number(reader, width)) return false;
+            } else if (netpbm_token_is(token, length, "HEIGHT")) {
+                if (!netpbm_number(reader, height)) return false;
+            } else if (netpbm_token_is(token, length, "DEPTH")) {
+                if (!netpbm_number(reader, depth)) return false;
+            } else if (netpbm_token_is(token, length, "MAXVAL")) {
+                if (!netpbm_number(reader, max_value)) return false;
+            } else if (netpbm_token_is(token, length, "TUPLTYPE")) {
+                netpbm_token(reader, &token);
+            } else {
+                return false;
+            }
+        }
+    } else {
+        return false;
+    }
+
+    // A single whitespace character separates the header from the pixels
+    if (reader->at >= reader->size) {
+        return false;
+    }
+    reader->at++;
+    return true;
+}
+
+b32 fc_image_load_netpbm(FcImage* image, const char* path, const FcPixelFormat* format)
+{
+    memset(image, 0, sizeof(FcImage));
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        FC_ENGINE_ERROR("Could not open image `%s`", (char*)path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    u8* data = (u8*)FC_ALLOC(file_size > 0 ? file_size : 1, "image file");
+    b32 read = file_size > 0 && fread(data, 1, file_size, file) == (size_t)file_size;
+    fclose(file);
+
+    NetpbmReader reader = { .data = data, .size = read ? (u64)file_size : 0 };
+    u32 width, height, depth, max_value;
+    if (!read || !netpbm_parse_header(&reader, &width, &height, &depth, &max_value) ||
+        width == 0 || height == 0 || (depth != 3 && depth != 4) || max_value != 255 ||
+        reader.size - reader.at < (u64)width * height * depth) {
+        FC_ENGINE_ERROR("Unsupported or truncated image `%s`", (char*)path);
+        FC_FREE(data);
+        return false;
+    }
+
+    u64 count = (u64)width * height;
+    image->pixels = (u32*)FC_ALLOC(count * sizeof(u32), "image");
+    image->width  = width;
+    image->height = height;
+    image->format = *format;
+
+    // Expand to RGBA8 bytes, then swizzle in place to the requested format
+    const u8* src = data + reader.at;
+    u8* dest = (u8*)image->pixels;
+    for (u64 i = 0; i < count; ++i) {
+        dest[0] = src[0];
+        dest[1] = src[1];
+        dest[2] = src[2];
+        dest[3] = depth == 4 ? src[3] : 0xFF;
+        src  += depth;
+        dest += 4;
+    }
+    FC_FREE(data);
+
+    FcPixelFormat rgba = FC_PIXEL_FORMAT_RGBA8;
+    if (!fc_pixel_formats_equal(&rgba, format)) {
+        fc_swizzle_u32(image->pixels, image->pixels, count,
+                       fc_pixel_format_swizzle(&rgba, format));
+    }
+    return true;
+}
+
+void fc_image_free(FcImage* image)
+{
+    FC_FREE(image->pixels);
+    memset(image, 0, sizeof(FcImage));
+}
@@ -0,0 +1,321 @@
+#include "finch/asset/pack.h"
+#include "finch/core/memory.h"
+#include "finch/render/kernels.h"
+#include "finch/platform/platform.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// FNV-1a
+u64 fc_pack_hash_name(const char* name, u32 length)
+{
+    u64 hash = 0xCBF29CE484222325ull;
+    for (u32 i = 0; i < length; ++i) {
+        hash ^= (u8)name[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+static FcPixelFormat pixel_format_from_shifts(const u8 shifts[4])
+{
+    return (FcPixelFormat){
+        .red_shift   = shifts[0],
+        .green_shift = shifts[1],
+        .blue_shift  = shifts[2],
+        .alpha_shift = shifts[3],
+        .red_mask    = 0xFFu << shifts[0],
+        .green_mask  = 0xFFu << shifts[1],
+        .blue_mask   = 0xFFu << shifts[2],
+        .alpha_mask  = 0xFFu << shifts[3],
+        .bits_per_pixel = 32,
+        .depth          = 32
+    };
+}
+
+static b32 pack_validate(FcPack* pack)
+{
+    const FcPackHeader* header = pack->header;
+    if (header->magic != FC_PACK_MAGIC ||
+        header->version != FC_PACK_VERSION || header->file_size != pack->size) {
+        return false;
+    }
+    if (header->index_offset % 8 != 0 || header->index_offset > pack->size ||
+        (pack->size - header->index_offset) / sizeof(FcPackEntry) < header->entry_count ||
+        header->names_offset > header->index_offset) {
+        return false;
+    }
+    pack->entries = (const FcPackEntry*)(pack->data + header->index_offset);
+    pack->names   = (const char*)(pack->data + header->names_offset);
+
+    u64 names_size = header->index_offset - header->names_offset;
+    for (u32 i = 0; i < header->entry_count; ++i) {
+        const FcPackEntry* entry = &pack->entries[i];
+        if (entry->offset > pack->size || entry->size > pack->size - entry->offset ||
+            (u64)entry->name_offset + entry->name_length > names_size) {
+            return false;
+        }
+        if (i > 0 && entry->name_hash < pack->entries[i - 1].name_hash) {
+            return false;
+        }
+        if (entry->type == FC_PACK_ENTRY_IMAGE &&
+            (entry->offset % sizeof(u32) != 0 || entry->width > entry->stride ||
+             entry->size != (u64)entry->stride * entry->height * sizeof(u32))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+b32 fc_pack_open(FcPack* pack, const char* path)
+{
+    memset(pack, 0, sizeof(FcPack));
+
+    pack->data = (const u8*)platform_map_file(path, &pack->size);
+    if (pack->data == NULL) {
+        FC_ENGINE_ERROR("Could not map pack `%s`", (char*)path);
+        return false;
+    }
+
+    pack->header = (const FcPackHeader*)pack->data;
+    if (pack->size < sizeof(FcPackHeader) || !pack_validate(pack)) {
+        FC_ENGINE_ERROR("`%s` is not a valid pack", (char*)path);
+        fc_pack_close(pack);
+        return false;
+    }
+
+    pack->pixel_format = pixel_format_from_shifts(pack->header->pixel_shifts);
+    return true;
+}
+
+void fc_pack_close(FcPack* pack)
+{
+    if (pack->data != NULL) {
+        platform_unmap_file(pack->data, pack->size);
+    }
+    memset(pack, 0, sizeof(FcPack));
+}
+
+const FcPackEntry* fc_pack_find(const FcPack* pack, const char* name)
+{
+    u32 length = (u32)strlen(name);
+    u64 hash   = fc_pack_hash_name(name, length);
+
+    // First entry with a hash not below the name's, then every collision
+    u32 low = 0, high = pack->header->entry_count;
+    while (low < high) {
+        u32 middle = low + (high - low) / 2;
+        if (pack->entries[middle].name_hash < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    for (u32 i = low; i < pack->header->entry_count && pack->entries[i].name_hash == hash; ++i) {
+        const FcPackEntry* entry = &pack->entries[i];
+        if (entry->name_length == length &&
+            memcmp(pack->names + entry->name_offset, name, length) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+b32 fc_pack_get_image(const FcPack* pack, const char* name, FcPackImage* image)
+{
+    const FcPackEntry* entry = fc_pack_find(pack, name);
+    if (entry == NULL || entry->type != FC_PACK_ENTRY_IMAGE) {
+        return false;
+    }
+    image->pixels = (const u32*)(pack->data + entry->offset);
+    image->width  = entry->width;
+    image->height = entry->height;
+    image->stride = entry->stride;
+    return true;
+}
+
+const void* fc_pack_get_blob(const FcPack* pack, const char* name, u64* size)
+{
+    const FcPackEntry* entry = fc_pack_find(pack, name);
+    if (entry == NULL) {
+        return NULL;
+    }
+    *size = entry->size;
+    return pack->data + entry->offset;
+}
+
+//
+// Writer
+//
+
+static void writer_write(FcPackWriter* writer, const void* data, u64 size)
+{
+    if (size > 0 && fwrite(data, 1, size, writer->file) != size) {
+        writer->failed = true;
+    }
+    writer->offset += size;
+}
+
+static void writer_align(FcPackWriter* writer, u64 alignment)
+{
+    static const u8 zeros[FC_PACK_ALIGNMENT] = {0};
+    u64 padding = (alignment - writer->offset % alignment) % alignment;
+    writer_write(writer, zeros, padding);
+}
+
+// Returns NULL, failing the pack, if the index cannot grow
+static FcPackEntry* writer_push_entry(FcPackWriter* writer, const char* name, u32 type)
+{
+    if (writer->entry_count == writer->entry_capacity) {
+        u32 capacity = writer->entry_capacity ? writer->entry_capacity * 2 : 64;
+        FcPackEntry* entries = (FcPackEntry*)FC_REALLOC(writer->entries,
+                                                        capacity * sizeof(FcPackEntry),
+                                                        "pack writer");
+        if (entries == NULL) {
+            FC_ENGINE_ERROR("Could not grow the pack index to %u entries", capacity);
+            writer->failed = true;
+            return NULL;
+        }
+        writer->entries = entries;
+        writer->entry_capacity = capacity;
+    }
+
+    u32 length = (u32)strlen(name);
+    if (writer->names_size + length > writer->names_capacity) {
+        u32 capacity = (writer->names_size + length) * 2;
+        char* names = (char*)FC_REALLOC(writer->names, capacity, "pack writer");
+        if (names == NULL) {
+            FC_ENGINE_ERROR("Could not grow the pack names to %u bytes", capacity);
+            writer->failed = true;
+            return NULL;
+        }
+        writer->names = names;
+        writer->names_capacity = capacity;
+    }
+    memcpy(writer->names + writer->names_size, name, length);
+
+    writer_align(writer, FC_PACK_ALIGNMENT);
+
+    FcPackEntry* entry = &writer->entries[writer->entry_count++];
+    memset(entry, 0, sizeof(FcPackEntry));
+    entry->name_hash   = fc_pack_hash_name(name, length);
+    entry->name_offset = writer->names_size;
+    entry->name_length = length;
+    entry->type        = type;
+    entry->offset      = writer->offset;
+    writer->names_size += length;
+    return entry;
+}
+
+b32 fc_pack_writer_begin(FcPackWriter* writer, const char* path, const FcPixelFormat* format)
+{
+    memset(writer, 0, sizeof(FcPackWriter));
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL) {
+        FC_ENGINE_ERROR("Could not create pack `%s`", (char*)path);
+        return false;
+    }
+    writer->pixel_format = *format;
+
+    // Written for real once the index is known
+    FcPackHeader header = {0};
+    writer_write(writer, &header, sizeof(header));
+    return true;
+}
+
+void fc_pack_writer_add_image(FcPackWriter* writer, const char* name, const FcImage* image)
+{
+    FcPackEntry* entry = writer_push_entry(writer, name, FC_PACK_ENTRY_IMAGE);
+    if (entry == NULL) {
+        return;
+    }
+    entry->width  = image->width;
+    entry->height = image->height;
+    entry->stride = image->width;
+    entry->size   = (u64)image->width * image->height * sizeof(u32);
+
+    if (fc_pixel_formats_equal(&image->format, &writer->pixel_format)) {
+        writer_write(writer, image->pixels, entry->size);
+        return;
+    }
+
+    FcSwizzle swizzle = fc_pixel_format_swizzle(&image->format, &writer->pixel_format);
+    u32* row = (u32*)FC_ALLOC(image->width * sizeof(u32), "pack writer");
+    for (u32 y = 0; y < image->height; ++y) {
+        fc_swizzle_u32(row, image->pixels + (u64)y * image->width, image->width, swizzle);
+        writer_write(writer, row, image->width * sizeof(u32));
+    }
+    FC_FREE(row);
+}
+
+void fc_pack_writer_add_blob(FcPackWriter* writer, const char* name, const void* data, u64 size)
+{
+    FcPackEntry* entry = writer_push_entry(writer, name, FC_PACK_ENTRY_BLOB);
+    if (entry == NULL) {
+        return;
+    }
+    entry->size = size;
+    writer_write(writer, data, size);
+}
+
+static int compare_entries(const void* a, const void* b)
+{
+    u64 hash_a = ((const FcPackEntry*)a)->name_hash;
+    u64 hash_b = ((const FcPackEntry*)b)->name_hash;
+    return hash_a < hash_b ? -1 : hash_a > hash_b ? 1 : 0;
+}
+
+b32 fc_pack_writer_finish(FcPackWriter* writer)
+{
+    qsort(writer->entries, writer->entry_count, sizeof(FcPackEntry), compare_entries);
+
+    for (u32 i = 1; i < writer->entry_count; ++i) {
+        for (u32 j = i; j-- > 0 && writer->entries[j].name_hash == writer->entries[i].name_hash;) {
+            const FcPackEntry* a = &writer->entries[i];
+            const FcPackEntry* b = &writer->entries[j];
+            if (a->name_length == b->name_length &&
+                memcmp(writer->names + a->name_offset, writer->names + b->name_offset,
+                       a->name_length) == 0) {
+                char name[256];
+                u32 length = a->name_length < sizeof(name) - 1 ? a->name_length : sizeof(name) - 1;
+                memcpy(name, writer->names + a->name_offset, length);
+                name[length] = '\0';
+                FC_ENGINE_ERROR("Pack entry `%s` was added twice", name);
+                writer->failed = true;
+            }
+        }
+    }
+
+    FcPackHeader header = {
+        .magic       = FC_PACK_MAGIC,
+        .version     = FC_PACK_VERSION,
+        .entry_count = writer->entry_count,
+        .pixel_shifts = {
+            writer->pixel_format.red_shift,  writer->pixel_format.green_shift,
+            writer->pixel_format.blue_shift, writer->pixel_format.alpha_shift
+        }
+    };
+
+    header.names_offset = writer->offset;
+    writer_write(writer, writer->names, writer->names_size);
+    writer_align(writer, 8);
+    header.index_offset = writer->offset;
+    writer_write(writer, writer->entries, (u64)writer->entry_count * sizeof(FcPackEntry));
+    header.file_size = writer->offset;
+
+    if (fseek(writer->file, 0, SEEK_SET) != 0 ||
+        fwrite(&header, 1, sizeof(header), writer->file) != sizeof(header)) {
+        writer->failed = true;
+    }
+    if (fclose(writer->file) != 0) {
+        writer->failed = true;
+    }
+
+    b32 success = !writer->failed;
+    FC_FREE(writer->entries);
+    FC_FREE(writer->names);
+    memset(writer, 0, sizeof(FcPackWriter));
+    return success;
+}
@@ -0,0 +1,464 @@
+#include "finch/asset/image.h"
+#include "finch/core/jobs.h"
+#include "finch/core/memory.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF  0x40
+#define QOI_OP_LUMA  0x80
+#define QOI_OP_RUN   0xC0
+#define QOI_OP_RGB   0xFE
+#define QOI_OP_RGBA  0xFF
+#define QOI_MASK_2   0xC0
+
+#define QOI_MAX_PIXELS    400000000u
+#define QOI_MAX_OP_SIZE   5
+#define QOI_INDEX_TRAILER 12 // Stripe rows, stripe count and magic after the offsets
+
+// Pixels are handled as RGBA bytes in a u32, red in the lowest byte
+#define QOI_R(PX) ((PX) & 0xFF)
+#define QOI_G(PX) (((PX) >> 8) & 0xFF)
+#define QOI_B(PX) (((PX) >> 16) & 0xFF)
+#define QOI_A(PX) ((PX) >> 24)
+#define QOI_HASH(PX) ((QOI_R(PX) * 3 + QOI_G(PX) * 5 + QOI_B(PX) * 7 + QOI_A(PX) * 11) & 63)
+#define QOI_OPAQUE_BLACK 0xFF000000u
+
+static const u8 qoi_end_marker[FC_QOI_END_SIZE] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+static inline u32 read_u32_be(const u8* p)
+{
+    return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | p[3];
+}
+
+static inline void write_u32_be(u8* p, u32 value)
+{
+    p[0] = (u8)(value >> 24);
+    p[1] = (u8)(value >> 16);
+    p[2] = (u8)(value >> 8);
+    p[3] = (u8)value;
+}
+
+// The stripe index is not part of QOI and uses the engine's byte order
+static inline u32 read_u32_le(const u8* p)
+{
+    return p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+static inline void write_u32_le(u8* p, u32 value)
+{
+    p[0] = (u8)value;
+    p[1] = (u8)(value >> 8);
+    p[2] = (u8)(value >> 16);
+    p[3] = (u8)(value >> 24);
+}
+
+static u32 stripe_count(u32 height, u32 stripe_rows)
+{
+    return stripe_rows != 0 ? (height + stripe_rows - 1) / stripe_rows : 1;
+}
+
+//
+// Encoding
+//
+
+u64 fc_image_qoi_max_size(u32 width, u32 height, u32 stripe_rows)
+{
+    u64 index_size = stripe_rows != 0
+        ? (u64)stripe_count(height, stripe_rows) * sizeof(u32) + QOI_INDEX_TRAILER
+        : 0;
+    // A run ending before a pixel costs one byte more
+    return FC_QOI_HEADER_SIZE + (u64)width * height * QOI_MAX_OP_SIZE + height +
+           FC_QOI_END_SIZE + index_size;
+}
+
+typedef struct _QoiEncoder {
+    u32 index[64];
+    u64 used_slots;     // Only slots written in this stripe may be referred to
+    u32 previous;
+    u32 run;
+} QoiEncoder;
+
+static inline u8* encode_pixel(QoiEncoder* encoder, u8* out, u32 px)
+{
+    if (px == encoder->previous) {
+        encoder->run += 1;
+        if (encoder->run == 62) {
+            *out++ = QOI_OP_RUN | (encoder->run - 1);
+            encoder->run = 0;
+        }
+        return out;
+    }
+    if (encoder->run > 0) {
+        *out++ = QOI_OP_RUN | (encoder->run - 1);
+        encoder->run = 0;
+    }
+
+    u32 slot = QOI_HASH(px);
+    u32 previous = encoder->previous;
+    encoder->previous = px;
+    if ((encoder->used_slots >> slot & 1) && encoder->index[slot] == px) {
+        *out++ = QOI_OP_INDEX | (u8)slot;
+        return out;
+    }
+    encoder->index[slot] = px;
+    encoder->used_slots |= 1ull << slot;
+
+    if (QOI_A(px) != QOI_A(previous)) {
+        out[0] = QOI_OP_RGBA;
+        write_u32_le(out + 1, px);
+        return out + 5;
+    }
+    s8 dr = (s8)(QOI_R(px) - QOI_R(previous));
+    s8 dg = (s8)(QOI_G(px) - QOI_G(previous));
+    s8 db = (s8)(QOI_B(px) - QOI_B(previous));
+    s8 dr_dg = (s8)(dr - dg);
+    s8 db_dg = (s8)(db - dg);
+    if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+        *out++ = QOI_OP_DIFF | (u8)((dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+    } else if (dr_dg >= -8 && dr_dg <= 7 && dg >= -32 && dg <= 31 && db_dg >= -8 && db_dg <= 7) {
+        *out++ = QOI_OP_LUMA | (u8)(dg + 32);
+        *out++ = (u8)((dr_dg + 8) << 4 | (db_dg + 8));
+    } else {
+        out[0] = QOI_OP_RGB;
+        out[1] = (u8)QOI_R(px);
+        out[2] = (u8)QOI_G(px);
+        out[3] = (u8)QOI_B(px);
+        out += 4;
+    }
+    return out;
+}
+
+u64 fc_image_encode_qoi(u8* dest, u64 capacity, const u32* pixels, u32 width, u32 height,
+                        u32 stride, const FcPixelFormat* format, b32 keep_alpha,
+                        u32 stripe_rows)
+{
+    if (width == 0 || height == 0 || (u64)width * height > QOI_MAX_PIXELS) {
+        return 0;
+    }
+    u32 stripes = stripe_count(height, stripe_rows);
+    u64 trailer_size = FC_QOI_END_SIZE +
+        (stripe_rows != 0 ? (u64)stripes * sizeof(u32) + QOI_INDEX_TRAILER : 0);
+    if (capacity < FC_QOI_HEADER_SIZE + trailer_size) {
+        return 0;
+    }
+    u64 chunks_capacity = capacity - trailer_size;
+    u64 row_size = (u64)width * QOI_MAX_OP_SIZE + 1;
+
+    memcpy(dest, "qoif", 4);
+    write_u32_be(dest + 4, width);
+    write_u32_be(dest + 8, height);
+    dest[12] = keep_alpha ? 4 : 3;
+    dest[13] = 0; // sRGB with linear alpha
+    u8* out = dest + FC_QOI_HEADER_SIZE;
+
+    // Stripe offsets are collected in the room kept for them at the end of
+    // `dest` and moved behind the end marker once known
+    u8* offsets = dest + capacity - (u64)stripes * sizeof(u32);
+    u32 alpha_mask = keep_alpha ? 0 : QOI_OPAQUE_BLACK;
+    u8 rs = format->red_shift, gs = format->green_shift;
+    u8 bs = format->blue_shift, as = format->alpha_shift;
+
+    QoiEncoder encoder = { .previous = QOI_OPAQUE_BLACK };
+    for (u32 y = 0; y < height; ++y) {
+        if ((u64)(out - dest) + row_size > chunks_capacity) {
+            return 0;
+        }
+        b32 stripe_start = stripe_rows != 0 && y % stripe_rows == 0;
+        if (stripe_start) {
+            if (encoder.run > 0) {
+                *out++ = QOI_OP_RUN | (encoder.run - 1);
+            }
+            write_u32_le(offsets + y / stripe_rows * sizeof(u32), (u32)(out - dest));
+            encoder = (QoiEncoder){ .previous = QOI_OPAQUE_BLACK };
+        }
+
+        const u32* row = pixels + (u64)y * stride;
+        u32 x = 0;
+        if (stripe_start && y > 0) {
+            // Decoders reading every stripe still hold the previous pixel,
+            // so the first pixel refers to nothing
+            u32 v = row[0];
+            u32 px = ((v >> rs) & 0xFF) | ((v >> gs) & 0xFF) << 8 | ((v >> bs) & 0xFF) << 16 |
+                     (((v >> as) & 0xFF) << 24 | alpha_mask);
+            out[0] = QOI_OP_RGBA;
+            write_u32_le(out + 1, px);
+            out += 5;
+            encoder.index[QOI_HASH(px)] = px;
+            encoder.used_slots |= 1ull << QOI_HASH(px);
+            encoder.previous = px;
+            x = 1;
+        }
+        for (; x < width; ++x) {
+            u32 v = row[x];
+            u32 px = ((v >> rs) & 0xFF) | ((v >> gs) & 0xFF) << 8 | ((v >> bs) & 0xFF) << 16 |
+                     (((v >> as) & 0xFF) << 24 | alpha_mask);
+            out = encode_pixel(&encoder, out, px);
+        }
+    }
+    if (encoder.run > 0) {
+        *out++ = QOI_OP_RUN | (encoder.run - 1);
+    }
+    memcpy(out, qoi_end_marker, FC_QOI_END_SIZE);
+    out += FC_QOI_END_SIZE;
+
+    if (stripe_rows != 0) {
+        memmove(out, offsets, (u64)stripes * sizeof(u32));
+        out += (u64)stripes * sizeof(u32);
+        write_u32_le(out, stripe_rows);
+        write_u32_le(out + 4, stripes);
+        write_u32_le(out + 8, FC_QOI_INDEX_MAGIC);
+        out += QOI_INDEX_TRAILER;
+    }
+    return (u64)(out - dest);
+}
+
+//
+// Decoding
+//
+
+typedef struct _QoiFile {
+    u32 width, height;
+    u64 chunks_end;         // Where the end marker starts
+    u32 stripe_rows;        // 0 without a valid stripe index
+    u32 stripe_count;
+    const u8* offsets;
+} QoiFile;
+
+static b32 qoi_parse(const u8* data, u64 size, QoiFile* file)
+{
+    if (size < FC_QOI_HEADER_SIZE + FC_QOI_END_SIZE || memcmp(data, "qoif", 4) != 0) {
+        return false;
+    }
+    *file = (QoiFile){
+        .width = read_u32_be(data + 4),
+        .height = read_u32_be(data + 8),
+        .chunks_end = size - FC_QOI_END_SIZE
+    };
+    if (file->width == 0 || file->height == 0 ||
+        (u64)file->width * file->height > QOI_MAX_PIXELS ||
+        (data[12] != 3 && data[12] != 4) || data[13] > 1) {
+        return false;
+    }
+
+    if (size < FC_QOI_HEADER_SIZE + FC_QOI_END_SIZE + QOI_INDEX_TRAILER ||
+        read_u32_le(data + size - 4) != FC_QOI_INDEX_MAGIC) {
+        return true;
+    }
+    // An index that does not add up is ignored, the chunks may still be fine
+    u32 rows = read_u32_le(data + size - 12);
+    u32 count = read_u32_le(data + size - 8);
+    u64 index_size = (u64)count * sizeof(u32) + QOI_INDEX_TRAILER;
+    if (rows == 0 || count != stripe_count(file->height, rows) ||
+        size < FC_QOI_HEADER_SIZE + FC_QOI_END_SIZE + index_size) {
+        return true;
+    }
+    u64 chunks_end = size - index_size - FC_QOI_END_SIZE;
+    const u8* offsets = data + chunks_end + FC_QOI_END_SIZE;
+    u32 previous = FC_QOI_HEADER_SIZE;
+    for (u32 i = 0; i < count; ++i) {
+        u32 offset = read_u32_le(offsets + i * sizeof(u32));
+        if (offset < previous || offset > chunks_end || (i == 0 && offset != FC_QOI_HEADER_SIZE)) {
+            return true;
+        }
+        previous = offset;
+    }
+    file->chunks_end = chunks_end;
+    file->stripe_rows = rows;
+    file->stripe_count = count;
+    file->offsets = offsets;
+    return true;
+}
+
+// Decodes `row_count` rows from `at` with a reset decoder state
+static b32 decode_rows(const u8* data, u64 at, u64 end, u32* dest, u32 stride, u32 width,
+                       u32 row_count, const FcPixelFormat* format)
+{
+    u32 index[64] = {0};
+    u32 px = QOI_OPAQUE_BLACK;
+    u32 run = 0;
+    u8 rs = format->red_shift, gs = format->green_shift;
+    u8 bs = format->blue_shift, as = format->alpha_shift;
+    u32 out = (u32)0xFF << as;
+
+    for (u32 y = 0; y < row_count; ++y) {
+        u32* row = dest + (u64)y * stride;
+        u32 x = 0;
+        while (x < width) {
+            if (run > 0) {
+                u32 fill = run < width - x ? run : width - x;
+                for (u32 i = 0; i < fill; ++i) {
+                    row[x + i] = out;
+                }
+                x += fill;
+                run -= fill;
+                continue;
+            }
+            // Every op fits in front of the end marker, so one check suffices
+            if (at >= end) {
+                return false;
+            }
+            u8 op = data[at++];
+            if (op < QOI_OP_RUN) {
+                // INDEX, DIFF and LUMA alternate unpredictably in photos, so
+                // all are computed and one selected with masks, which the
+                // compiler does not turn back into branches
+                u32 luma = (u32)0 - (op >> 7);
+                u32 indexed = (u32)0 - (op < QOI_OP_DIFF);
+                u32 second = data[at];
+                u32 luma_dg = (u32)(op & 0x3F) - 32;
+                u32 dr = ((luma_dg - 8 + (second >> 4)) & luma) | ((((u32)op >> 4 & 3) - 2) & ~luma);
+                u32 dg = (luma_dg & luma) | ((((u32)op >> 2 & 3) - 2) & ~luma);
+                u32 db = ((luma_dg - 8 + (second & 0x0F)) & luma) | ((((u32)op & 3) - 2) & ~luma);
+                at += luma & 1;
+                u32 moved = (px & 0xFF000000) | ((QOI_R(px) + dr) & 0xFF) |
+                            ((QOI_G(px) + dg) & 0xFF) << 8 | ((QOI_B(px) + db) & 0xFF) << 16;
+                px = (index[op & 0x3F] & indexed) | (moved & ~indexed);
+            } else if (op == QOI_OP_RGB) {
+                px = (px & 0xFF000000) | data[at] | (u32)data[at + 1] << 8 | (u32)data[at + 2] << 16;
+                at += 3;
+            } else if (op == QOI_OP_RGBA) {
+                px = read_u32_le(data + at);
+                at += 4;
+            } else {
+                // The pixel repeats, and encoders never refer to the slot
+                // a run at the very start would fill
+                run = (op & 0x3F) + 1;
+                continue;
+            }
+            index[QOI_HASH(px)] = px;
+            out = QOI_R(px) << rs | QOI_G(px) << gs | QOI_B(px) << bs | QOI_A(px) << as;
+            row[x++] = out;
+        }
+    }
+    return true;
+}
+
+b32 fc_image_qoi_size(const u8* data, u64 size, u32* width, u32* height)
+{
+    QoiFile file;
+    if (!qoi_parse(data, size, &file)) {
+        return false;
+    }
+    *width = file.width;
+    *height = file.height;
+    return true;
+}
+
+typedef struct _QoiStripeJob {
+    const u8* data;
+    const QoiFile* file;
+    u32* dest;
+    u32  stride;
+    const FcPixelFormat* format;
+    _Atomic b32 failed;
+} QoiStripeJob;
+
+static void decode_stripes(void* data, u32 begin, u32 end)
+{
+    QoiStripeJob* job = (QoiStripeJob*)data;
+    const QoiFile* file = job->file;
+    for (u32 i = begin; i < end; ++i) {
+        u32 first_row = i * file->stripe_rows;
+        u32 rows = file->height - first_row < file->stripe_rows
+            ? file->height - first_row : file->stripe_rows;
+        u64 at = read_u32_le(file->offsets + i * sizeof(u32));
+        u64 stripe_end = i + 1 < file->stripe_count
+            ? read_u32_le(file->offsets + (i + 1) * sizeof(u32))
+            : file->chunks_end;
+        if (!decode_rows(job->data, at, stripe_end, job->dest + (u64)first_row * job->stride,
+                         job->stride, file->width, rows, job->format)) {
+            atomic_store_explicit(&job->failed, true, memory_order_relaxed);
+        }
+    }
+}
+
+b32 fc_image_decode_qoi(const u8* data, u64 size, u32* dest, u32 stride,
+                        const FcPixelFormat* format, b32 parallel)
+{
+    QoiFile file;
+    if (!qoi_parse(data, size, &file)) {
+        return false;
+    }
+    if (!parallel || file.stripe_count < 2) {
+        return decode_rows(data, FC_QOI_HEADER_SIZE, file.chunks_end, dest, stride,
+                           file.width, file.height, format);
+    }
+
+    QoiStripeJob job = {
+        .data   = data,
+        .file   = &file,
+        .dest   = dest,
+        .stride = stride,
+        .format = format
+    };
+    fc_jobs_parallel_for(file.stripe_count, 1, decode_stripes, &job);
+    return !atomic_load(&job.failed);
+}
+
+b32 fc_image_load_qoi(FcImage* image, const char* path, const FcPixelFormat* format)
+{
+    memset(image, 0, sizeof(FcImage));
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        FC_ENGINE_ERROR("Could not open image `%s`", (char*)path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    u8* data = (u8*)FC_ALLOC(file_size > 0 ? file_size : 1, "image file");
+    b32 read = file_size > 0 && fread(data, 1, file_size, file) == (size_t)file_size;
+    fclose(file);
+
+    u32 width, height;
+    if (!read || !fc_image_qoi_size(data, (u64)file_size, &width, &height)) {
+        FC_ENGINE_ERROR("Unsupported or truncated image `%s`", (char*)path);
+        FC_FREE(data);
+        return false;
+    }
+    image->pixels = (u32*)FC_ALLOC((u64)width * height * sizeof(u32), "image");
+    image->width  = width;
+    image->height = height;
+    image->format = *format;
+
+    // Workers are used when something already started them
+    b32 parallel = fc_jobs_get_worker_count() > 0;
+    b32 decoded = fc_image_decode_qoi(data, (u64)file_size, image->pixels, width, format, parallel);
+    FC_FREE(data);
+    if (!decoded) {
+        FC_ENGINE_ERROR("Unsupported or truncated image `%s`", (char*)path);
+        fc_image_free(image);
+        return false;
+    }
+    return true;
+}
+
+b32 fc_image_save_qoi(const char* path, const u32* pixels, u32 width, u32 height,
+                      u32 stride, const FcPixelFormat* format)
+{
+    u64 capacity = fc_image_qoi_max_size(width, height, FC_QOI_STRIPE_ROWS);
+    u8* encoded = (u8*)FC_ALLOC(capacity, "qoi_encoded");
+    u64 size = encoded != NULL
+        ? fc_image_encode_qoi(encoded, capacity, pixels, width, height, stride, format,
+                              false, FC_QOI_STRIPE_ROWS)
+        : 0;
+    FILE* file = size > 0 ? fopen(path, "wb") : NULL;
+    b32 written = file != NULL && fwrite(encoded, 1, size, file) == size;
+    if (file != NULL) {
+        written = fclose(file) == 0 && written;
+    }
+    FC_FREE(encoded);
+    if (!written) {
+        FC_ENGINE_ERROR("Could not save image `%s`", (char*)path);
+        return false;
+    }
+    return true;
+}
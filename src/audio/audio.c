@@ -0,0 +1,417 @@
+#include "finch/audio/audio.h"
+#include "finch/core/memory.h"
+#include "finch/audio/kernels.h"
+#include "finch/platform/platform.h"
+#include "finch/platform/cpu.h"
+#include "finch/log/log.h"
+#include "finch/utils/string.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FIXED_ONE (1ull << 32)
+
+//
+// Command queue
+//
+
+static b32 queue_push(FcAudio* audio, const FcAudioCommand* command)
+{
+    FcAudioCommandQueue* queue = &audio->queue;
+    u32 head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    u32 tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head - tail == FC_AUDIO_COMMAND_QUEUE_SIZE) {
+        atomic_fetch_add_explicit(&audio->commands_dropped, 1, memory_order_relaxed);
+        return false;
+    }
+    queue->commands[head & (FC_AUDIO_COMMAND_QUEUE_SIZE - 1)] = *command;
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+static b32 queue_pop(FcAudioCommandQueue* queue, FcAudioCommand* command)
+{
+    u32 tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    u32 head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (tail == head) {
+        return false;
+    }
+    *command = queue->commands[tail & (FC_AUDIO_COMMAND_QUEUE_SIZE - 1)];
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+//
+// Voices
+//
+
+static u64 voice_step(const FcAudioVoice* voice, u32 output_rate)
+{
+    f64 ratio = (f64)voice->pitch * voice->sound->sample_rate / output_rate;
+    return ratio > 0.0 ? (u64)(ratio * (f64)FIXED_ONE) : 0;
+}
+
+// Constant power panning
+static void voice_target_gains(const FcAudioVoice* voice, f32* left, f32* right)
+{
+    if (voice->stopping) {
+        *left = *right = 0.0f;
+        return;
+    }
+    f32 pan = voice->pan < -1.0f ? -1.0f : voice->pan > 1.0f ? 1.0f : voice->pan;
+    f32 angle = (pan + 1.0f) * 0.25f * 3.14159265f;
+    *left  = voice->volume * cosf(angle);
+    *right = voice->volume * sinf(angle);
+}
+
+static FcAudioVoice* find_voice(FcAudio* audio, FcVoiceId id)
+{
+    for (u32 i = 0; i < FC_AUDIO_MAX_VOICES; ++i) {
+        if (audio->voices[i].id == id) {
+            return &audio->voices[i];
+        }
+    }
+    return NULL;
+}
+
+static void apply_command(FcAudio* audio, const FcAudioCommand* command)
+{
+    if (command->type == FC_AUDIO_COMMAND_PLAY) {
+        FcAudioVoice* voice = find_voice(audio, 0);
+        if (voice == NULL) {
+            atomic_fetch_add_explicit(&audio->voices_dropped, 1, memory_order_relaxed);
+            return;
+        }
+        *voice = (FcAudioVoice){
+            .id     = command->voice,
+            .sound  = command->sound,
+            .volume = command->volume,
+            .pan    = command->pan,
+            .pitch  = command->pitch,
+            .loop   = command->loop
+        };
+        voice->step = voice_step(voice, audio->config.sample_rate);
+        voice_target_gains(voice, &voice->gain_left, &voice->gain_right);
+        return;
+    }
+
+    if (command->type == FC_AUDIO_COMMAND_STOP_ALL) {
+        for (u32 i = 0; i < FC_AUDIO_MAX_VOICES; ++i) {
+            audio->voices[i].stopping = true;
+        }
+        return;
+    }
+
+    FcAudioVoice* voice = find_voice(audio, command->voice);
+    if (voice == NULL) {
+        // Already finished
+        return;
+    }
+    switch (command->type) {
+        case FC_AUDIO_COMMAND_STOP: {
+            voice->stopping = true;
+        } break;
+        case FC_AUDIO_COMMAND_SET_VOLUME: {
+            voice->volume = command->volume;
+        } break;
+        case FC_AUDIO_COMMAND_SET_PAN: {
+            voice->pan = command->pan;
+        } break;
+        case FC_AUDIO_COMMAND_SET_PITCH: {
+            voice->pitch = command->pitch;
+            voice->step = voice_step(voice, audio->config.sample_rate);
+        } break;
+        default: {}
+    }
+}
+
+// Resamples the frame at the end of the sound, which interpolates towards
+// the first frame when looping
+static void resample_last_frame(const FcAudioVoice* voice, f32* dest)
+{
+    const FcSound* sound = voice->sound;
+    u64 last = sound->frame_count - 1;
+    u64 next = voice->loop ? 0 : last;
+    f32 t = (f32)((u32)voice->position >> 8) * (1.0f / 16777216.0f);
+    for (u32 c = 0; c < 2; ++c) {
+        u32 channel = sound->channels == 1 ? 0 : c;
+        f32 a = sound->samples[last * sound->channels + channel];
+        f32 b = sound->samples[next * sound->channels + channel];
+        dest[c] = a + (b - a) * t;
+    }
+}
+
+static void mix_voice(FcAudio* audio, FcAudioVoice* voice, f32* output, u32 frame_count)
+{
+    const FcSound* sound = voice->sound;
+    u64 end   = (u64)sound->frame_count << 32;
+    u64 limit = (u64)(sound->frame_count - 1) << 32;
+
+    // Volume and pan changes are ramped over the buffer to avoid clicks
+    f32 target_left, target_right;
+    voice_target_gains(voice, &target_left, &target_right);
+    f32 step_left  = (target_left  - voice->gain_left)  / frame_count;
+    f32 step_right = (target_right - voice->gain_right) / frame_count;
+
+    b32 finished = false;
+    u32 done = 0;
+    while (done < frame_count && !finished) {
+        u32 remaining = frame_count - done;
+        u32 count = 0;
+
+        if (voice->position < limit) {
+            // Frames whose both source frames are inside the sound
+            u64 available = voice->step > 0
+                ? (limit - voice->position + voice->step - 1) / voice->step
+                : remaining;
+            count = available < remaining ? (u32)available : remaining;
+            fc_audio_kernels.resample(audio->scratch, sound->samples, sound->channels,
+                                      voice->position, voice->step, count);
+            voice->position += (u64)count * voice->step;
+        } else {
+            count = 1;
+            resample_last_frame(voice, audio->scratch);
+            voice->position += voice->step;
+        }
+
+        if (voice->position >= end) {
+            if (voice->loop) {
+                voice->position %= end;
+            } else {
+                finished = true;
+            }
+        }
+
+        fc_audio_kernels.mix_stereo(output + (u64)done * FC_AUDIO_CHANNELS, audio->scratch, count,
+                                    voice->gain_left  + done * step_left,
+                                    voice->gain_right + done * step_right,
+                                    step_left, step_right);
+        done += count;
+    }
+
+    voice->gain_left  = target_left;
+    voice->gain_right = target_right;
+    if (finished || voice->stopping) {
+        voice->id = 0;
+    }
+}
+
+void fc_audio_mix(FcAudio* audio, f32* output, u32 frame_count)
+{
+    f64 start_time = platform_get_thread_cpu_time();
+
+    FcAudioCommand command;
+    while (queue_pop(&audio->queue, &command)) {
+        apply_command(audio, &command);
+    }
+
+    memset(output, 0, (u64)frame_count * FC_AUDIO_CHANNELS * sizeof(f32));
+
+    u32 active_voices = 0;
+    while (frame_count > 0) {
+        // The scratch buffer holds one buffer's worth of frames
+        u32 count = frame_count < audio->config.frames_per_buffer
+            ? frame_count
+            : audio->config.frames_per_buffer;
+
+        active_voices = 0;
+        for (u32 i = 0; i < FC_AUDIO_MAX_VOICES; ++i) {
+            FcAudioVoice* voice = &audio->voices[i];
+            if (voice->id != 0) {
+                mix_voice(audio, voice, output, count);
+                active_voices += voice->id != 0;
+            }
+        }
+        output      += (u64)count * FC_AUDIO_CHANNELS;
+        frame_count -= count;
+    }
+
+    u64 mix_ns = (u64)((platform_get_thread_cpu_time() - start_time) * 1e9);
+    atomic_store_explicit(&audio->active_voices, active_voices, memory_order_relaxed);
+    atomic_store_explicit(&audio->last_mix_ns, mix_ns, memory_order_relaxed);
+    atomic_fetch_add_explicit(&audio->total_mix_ns, mix_ns, memory_order_relaxed);
+    if (mix_ns > atomic_load_explicit(&audio->max_mix_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&audio->max_mix_ns, mix_ns, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&audio->buffers_mixed, 1, memory_order_release);
+}
+
+//
+// Mixer thread
+//
+
+static void audio_thread(void* data)
+{
+    FcAudio* audio = (FcAudio*)data;
+    u32 frames = audio->config.frames_per_buffer;
+    while (atomic_load_explicit(&audio->running, memory_order_acquire)) {
+        fc_audio_mix(audio, audio->mix_buffer, frames);
+        if (!platform_audio_write(audio->sink, audio->mix_buffer, frames)) {
+            atomic_fetch_add_explicit(&audio->underruns, 1, memory_order_relaxed);
+        }
+    }
+}
+
+static FcAudioSinkType sink_from_environment(FcAudioSinkType sink)
+{
+    const char* name = getenv("FINCH_AUDIO_SINK");
+    if (name == NULL) {
+        return sink;
+    }
+    if (strcmp(name, "device") == 0) return FC_AUDIO_SINK_DEVICE;
+    if (strcmp(name, "file") == 0)   return FC_AUDIO_SINK_FILE;
+    if (strcmp(name, "null") == 0)   return FC_AUDIO_SINK_NULL;
+    if (strcmp(name, "none") == 0)   return FC_AUDIO_SINK_NONE;
+    FC_ENGINE_WARN("Unknown FINCH_AUDIO_SINK `%s`", name);
+    return sink;
+}
+
+b32 fc_audio_init(FcAudio* audio, const FcAudioConfig* config)
+{
+    memset(audio, 0, sizeof(FcAudio));
+    audio->config = *config;
+    audio->config.sink = sink_from_environment(config->sink);
+    if (getenv("FINCH_AUDIO_FILE") != NULL) {
+        audio->config.file_path = getenv("FINCH_AUDIO_FILE");
+    }
+    if (audio->config.sample_rate == 0) {
+        audio->config.sample_rate = 48000;
+    }
+    if (audio->config.frames_per_buffer == 0) {
+        audio->config.frames_per_buffer = 256;
+    }
+    audio->next_voice_id = 1;
+
+    fc_audio_select_kernels(platform_get_cpu_features());
+
+    u64 buffer_size = (u64)audio->config.frames_per_buffer * FC_AUDIO_CHANNELS * sizeof(f32);
+    audio->mix_buffer = (f32*)FC_ALLOC(buffer_size, "audio mix");
+    audio->scratch    = (f32*)FC_ALLOC(buffer_size, "audio mix");
+    if (audio->mix_buffer == NULL || audio->scratch == NULL) {
+        FC_ENGINE_ERROR("Could not allocate audio buffers of %u frames",
+                        audio->config.frames_per_buffer);
+        fc_audio_deinit(audio);
+        return false;
+    }
+
+    if (audio->config.sink == FC_AUDIO_SINK_NONE) {
+        return true;
+    }
+
+    audio->sink = platform_audio_open(&audio->config);
+    if (audio->sink == NULL) {
+        fc_audio_deinit(audio);
+        return false;
+    }
+
+    atomic_store(&audio->running, true);
+    audio->thread = platform_create_thread(audio_thread, audio);
+    if (audio->thread == NULL) {
+        fc_audio_deinit(audio);
+        return false;
+    }
+
+    FC_ENGINE_INFO("Audio: %u Hz, %u frames per buffer (%f ms)",
+                   audio->config.sample_rate, audio->config.frames_per_buffer,
+                   audio->config.frames_per_buffer * 1000.0 / audio->config.sample_rate);
+    return true;
+}
+
+void fc_audio_deinit(FcAudio* audio)
+{
+    if (audio->thread != NULL) {
+        atomic_store(&audio->running, false);
+        platform_join_thread(audio->thread);
+        audio->thread = NULL;
+
+        FcAudioStats stats;
+        fc_audio_get_stats(audio, &stats);
+        FC_ENGINE_INFO("Audio: %u buffers mixed, %u underruns, mix %f ms average, "
+                       "%f ms max of %f ms buffers",
+                       (u32)stats.buffers_mixed, (u32)stats.underruns,
+                       stats.average_mix_ms, stats.max_mix_ms, stats.buffer_ms);
+    }
+    if (audio->sink != NULL) {
+        platform_audio_close(audio->sink);
+        audio->sink = NULL;
+    }
+    FC_FREE(audio->mix_buffer);
+    FC_FREE(audio->scratch);
+    audio->mix_buffer = NULL;
+    audio->scratch    = NULL;
+}
+
+//
+// Commands
+//
+
+FcVoiceId fc_audio_play(FcAudio* audio, const FcSound* sound, f32 volume, f32 pan, b32 loop)
+{
+    if (sound == NULL || sound->frame_count == 0 ||
+        (sound->channels != 1 && sound->channels != 2)) {
+        return 0;
+    }
+
+    FcVoiceId voice = audio->next_voice_id++;
+    if (audio->next_voice_id == 0) {
+        audio->next_voice_id = 1;
+    }
+
+    FcAudioCommand command = {
+        .type   = FC_AUDIO_COMMAND_PLAY,
+        .voice  = voice,
+        .sound  = sound,
+        .volume = volume,
+        .pan    = pan,
+        .pitch  = 1.0f,
+        .loop   = loop
+    };
+    return queue_push(audio, &command) ? voice : 0;
+}
+
+void fc_audio_stop(FcAudio* audio, FcVoiceId voice)
+{
+    FcAudioCommand command = { .type = FC_AUDIO_COMMAND_STOP, .voice = voice };
+    queue_push(audio, &command);
+}
+
+void fc_audio_stop_all(FcAudio* audio)
+{
+    FcAudioCommand command = { .type = FC_AUDIO_COMMAND_STOP_ALL };
+    queue_push(audio, &command);
+}
+
+void fc_audio_set_volume(FcAudio* audio, FcVoiceId voice, f32 volume)
+{
+    FcAudioCommand command = { .type = FC_AUDIO_COMMAND_SET_VOLUME, .voice = voice, .volume = volume };
+    queue_push(audio, &command);
+}
+
+void fc_audio_set_pan(FcAudio* audio, FcVoiceId voice, f32 pan)
+{
+    FcAudioCommand command = { .type = FC_AUDIO_COMMAND_SET_PAN, .voice = voice, .pan = pan };
+    queue_push(audio, &command);
+}
+
+void fc_audio_set_pitch(FcAudio* audio, FcVoiceId voice, f32 pitch)
+{
+    FcAudioCommand command = { .type = FC_AUDIO_COMMAND_SET_PITCH, .voice = voice, .pitch = pitch };
+    queue_push(audio, &command);
+}
+
+void fc_audio_get_stats(FcAudio* audio, FcAudioStats* stats)
+{
+    u64 buffers_mixed = atomic_load_explicit(&audio->buffers_mixed, memory_order_acquire);
+    stats->buffers_mixed    = buffers_mixed;
+    stats->underruns        = atomic_load_explicit(&audio->underruns, memory_order_relaxed);
+    stats->commands_dropped = atomic_load_explicit(&audio->commands_dropped, memory_order_relaxed);
+    stats->voices_dropped   = atomic_load_explicit(&audio->voices_dropped, memory_order_relaxed);
+    stats->active_voices    = atomic_load_explicit(&audio->active_voices, memory_order_relaxed);
+    stats->buffer_ms   = audio->config.frames_per_buffer * 1000.0 / audio->config.sample_rate;
+    stats->last_mix_ms = atomic_load_explicit(&audio->last_mix_ns, memory_order_relaxed) * 1e-6;
+    stats->max_mix_ms  = atomic_load_explicit(&audio->max_mix_ns, memory_order_relaxed) * 1e-6;
+    stats->average_mix_ms = buffers_mixed > 0
+        ? atomic_load_explicit(&audio->total_mix_ns, memory_order_relaxed) * 1e-6 / buffers_mixed
+        : 0.0;
+}
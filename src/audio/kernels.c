@@ -0,0 +1,85 @@
+#include "finch/audio/kernels.h"
+#include "finch/platform/cpu.h"
+#include "finch/log/log.h"
+#include "finch/utils/string.h"
+
+//
+// Generic variants
+//
+
+static void resample_generic(f32* dest, const f32* samples, u32 channels,
+                             u64 position, u64 step, u32 count)
+{
+    for (u32 i = 0; i < count; ++i, position += step) {
+        u64 index = position >> 32;
+        f32 t = (f32)((u32)position >> 8) * (1.0f / 16777216.0f);
+        if (channels == 1) {
+            f32 a = samples[index], b = samples[index + 1];
+            dest[2 * i] = dest[2 * i + 1] = a + (b - a) * t;
+        } else {
+            for (u32 c = 0; c < 2; ++c) {
+                f32 a = samples[2 * index + c], b = samples[2 * index + 2 + c];
+                dest[2 * i + c] = a + (b - a) * t;
+            }
+        }
+    }
+}
+
+static void mix_stereo_generic(f32* dest, const f32* src, u32 count,
+                               f32 gain_left, f32 gain_right,
+                               f32 gain_step_left, f32 gain_step_right)
+{
+    for (u32 i = 0; i < count; ++i) {
+        dest[2 * i]     += src[2 * i]     * (gain_left  + (f32)i * gain_step_left);
+        dest[2 * i + 1] += src[2 * i + 1] * (gain_right + (f32)i * gain_step_right);
+    }
+}
+
+//
+// Dispatch
+//
+
+#if defined(__x86_64__) || defined(__i386__)
+void resample_avx2(f32* dest, const f32* samples, u32 channels, u64 position, u64 step, u32 count);
+void mix_stereo_sse2(f32* dest, const f32* src, u32 count, f32 gain_left, f32 gain_right,
+                     f32 gain_step_left, f32 gain_step_right);
+void mix_stereo_avx2(f32* dest, const f32* src, u32 count, f32 gain_left, f32 gain_right,
+                     f32 gain_step_left, f32 gain_step_right);
+#endif
+
+FcAudioKernels fc_audio_kernels = {
+    .resample   = resample_generic,
+    .mix_stereo = mix_stereo_generic,
+
+    .resample_variant   = "generic",
+    .mix_stereo_variant = "generic",
+};
+
+void fc_audio_select_kernels(u32 cpu_features)
+{
+    FcAudioKernels kernels = {
+        .resample   = resample_generic,
+        .mix_stereo = mix_stereo_generic,
+
+        .resample_variant   = "generic",
+        .mix_stereo_variant = "generic",
+    };
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (cpu_features & FC_CPU_FEATURE_SSE2) {
+        kernels.mix_stereo = mix_stereo_sse2;
+        kernels.mix_stereo_variant = "sse2";
+    }
+    if (cpu_features & FC_CPU_FEATURE_AVX2) {
+        kernels.resample   = resample_avx2;
+        kernels.mix_stereo = mix_stereo_avx2;
+        kernels.resample_variant = kernels.mix_stereo_variant = "avx2";
+    }
+#else
+    (void)cpu_features;
+#endif
+
+    fc_audio_kernels = kernels;
+    FC_ENGINE_TRACE("Audio kernels: resample=%s mix=%s",
+                    kernels.resample_variant, kernels.mix_stereo_variant);
+}
@@ -0,0 +1,116 @@
+#include "finch/audio/kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+//
+// Resampling
+//
+
+TARGET_AVX2 void resample_avx2(f32* dest, const f32* samples, u32 channels,
+                               u64 position, u64 step, u32 count)
+{
+    // Four output frames per iteration, with a 64-bit position per lane
+    __m256i positions = _mm256_set_epi64x((s64)(position + 3 * step), (s64)(position + 2 * step),
+                                          (s64)(position + step), (s64)position);
+    const __m256i advance   = _mm256_set1_epi64x((s64)(4 * step));
+    const __m256i low_lanes = _mm256_set_epi32(0, 0, 0, 0, 6, 4, 2, 0);
+    const __m128  scale     = _mm_set1_ps(1.0f / 16777216.0f);
+
+    u32 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i index = _mm256_srli_epi64(positions, 32);
+        __m128i fraction = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(
+            _mm256_srli_epi32(positions, 8), low_lanes));
+        __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(fraction), scale);
+
+        if (channels == 1) {
+            __m128 a = _mm256_i64gather_ps(samples, index, 4);
+            __m128 b = _mm256_i64gather_ps(samples + 1, index, 4);
+            __m128 s = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+            _mm_storeu_ps(dest + 2 * i,     _mm_unpacklo_ps(s, s));
+            _mm_storeu_ps(dest + 2 * i + 4, _mm_unpackhi_ps(s, s));
+        } else {
+            // Both channels of a frame gathered as one 64-bit element
+            __m256 a = _mm256_castpd_ps(_mm256_i64gather_pd((const double*)samples, index, 8));
+            __m256 b = _mm256_castpd_ps(_mm256_i64gather_pd((const double*)(samples + 2), index, 8));
+            __m256 t2 = _mm256_set_m128(_mm_unpackhi_ps(t, t), _mm_unpacklo_ps(t, t));
+            _mm256_storeu_ps(dest + 2 * i,
+                             _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), t2)));
+        }
+        positions = _mm256_add_epi64(positions, advance);
+    }
+
+    position += (u64)i * step;
+    for (; i < count; ++i, position += step) {
+        u64 index = position >> 32;
+        f32 t = (f32)((u32)position >> 8) * (1.0f / 16777216.0f);
+        if (channels == 1) {
+            f32 a = samples[index], b = samples[index + 1];
+            dest[2 * i] = dest[2 * i + 1] = a + (b - a) * t;
+        } else {
+            for (u32 c = 0; c < 2; ++c) {
+                f32 a = samples[2 * index + c], b = samples[2 * index + 2 + c];
+                dest[2 * i + c] = a + (b - a) * t;
+            }
+        }
+    }
+}
+
+//
+// Mixing
+//
+
+TARGET_SSE2 void mix_stereo_sse2(f32* dest, const f32* src, u32 count,
+                                 f32 gain_left, f32 gain_right,
+                                 f32 gain_step_left, f32 gain_step_right)
+{
+    // Two frames per iteration
+    const __m128 gain  = _mm_set_ps(gain_right, gain_left, gain_right, gain_left);
+    const __m128 slope = _mm_set_ps(gain_step_right, gain_step_left, gain_step_right, gain_step_left);
+    const __m128 two   = _mm_set1_ps(2.0f);
+    __m128 frame = _mm_set_ps(1.0f, 1.0f, 0.0f, 0.0f);
+
+    u32 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128 g = _mm_add_ps(gain, _mm_mul_ps(frame, slope));
+        __m128 d = _mm_loadu_ps(dest + 2 * i);
+        _mm_storeu_ps(dest + 2 * i, _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(src + 2 * i), g)));
+        frame = _mm_add_ps(frame, two);
+    }
+    for (; i < count; ++i) {
+        dest[2 * i]     += src[2 * i]     * (gain_left  + (f32)i * gain_step_left);
+        dest[2 * i + 1] += src[2 * i + 1] * (gain_right + (f32)i * gain_step_right);
+    }
+}
+
+TARGET_AVX2 void mix_stereo_avx2(f32* dest, const f32* src, u32 count,
+                                 f32 gain_left, f32 gain_right,
+                                 f32 gain_step_left, f32 gain_step_right)
+{
+    // Four frames per iteration
+    const __m256 gain  = _mm256_set_ps(gain_right, gain_left, gain_right, gain_left,
+                                       gain_right, gain_left, gain_right, gain_left);
+    const __m256 slope = _mm256_set_ps(gain_step_right, gain_step_left, gain_step_right, gain_step_left,
+                                       gain_step_right, gain_step_left, gain_step_right, gain_step_left);
+    const __m256 four  = _mm256_set1_ps(4.0f);
+    __m256 frame = _mm256_set_ps(3.0f, 3.0f, 2.0f, 2.0f, 1.0f, 1.0f, 0.0f, 0.0f);
+
+    u32 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256 g = _mm256_add_ps(gain, _mm256_mul_ps(frame, slope));
+        __m256 d = _mm256_loadu_ps(dest + 2 * i);
+        _mm256_storeu_ps(dest + 2 * i,
+                         _mm256_add_ps(d, _mm256_mul_ps(_mm256_loadu_ps(src + 2 * i), g)));
+        frame = _mm256_add_ps(frame, four);
+    }
+    mix_stereo_sse2(dest + 2 * i, src + 2 * i, count - i,
+                    gain_left + (f32)i * gain_step_left, gain_right + (f32)i * gain_step_right,
+                    gain_step_left, gain_step_right);
+}
+
+#endif
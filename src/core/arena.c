@@ -0,0 +1,54 @@
+#include "finch/core/arena.h"
+#include "finch/log/log.h"
+#include "finch/utils/string.h"
+
+#include <stddef.h>
+
+void fc_arena_init(FcArena* arena, void* base, u64 size)
+{
+    arena->base = (u8*)base;
+    arena->size = size;
+    arena->used = 0;
+}
+
+void* fc_arena_push(FcArena* arena, u64 size, u64 alignment)
+{
+    u64 address = (u64)(arena->base + arena->used);
+    u64 padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+
+    if (arena->used + padding + size > arena->size) {
+        FC_ENGINE_ERROR("Arena out of memory (requested %u bytes, %u of %u used)",
+                        (u32)size, (u32)arena->used, (u32)arena->size);
+        return NULL;
+    }
+
+    void* result = arena->base + arena->used + padding;
+    arena->used += padding + size;
+    return result;
+}
+
+void fc_arena_reset(FcArena* arena)
+{
+    arena->used = 0;
+}
+
+static void* arena_alloc(void* context, u64 size, u64 alignment,
+                         const char* tag, const char* file, u32 line)
+{
+    (void)tag;
+    (void)file;
+    (void)line;
+    return fc_arena_push((FcArena*)context, size, alignment != 0 ? alignment : 16);
+}
+
+static void arena_free(void* context, void* memory, u64 size)
+{
+    (void)context;
+    (void)memory;
+    (void)size;
+}
+
+FcAllocator fc_arena_allocator(FcArena* arena)
+{
+    return (FcAllocator){ .alloc = arena_alloc, .free = arena_free, .context = arena };
+}
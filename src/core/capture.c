@@ -0,0 +1,379 @@
+#include "finch/core/capture.h"
+#include "finch/asset/image.h"
+#include "finch/core/memory.h"
+#include "finch/render/kernels.h"
+#include "finch/platform/platform.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Frames are large, so the file buffer only needs to batch the headers
+#define CAPTURE_FILE_BUFFER_SIZE (1 << 20)
+
+static u64 frame_size(const FcCaptureConfig* config)
+{
+    return (u64)config->width * config->height * sizeof(u32);
+}
+
+static b32 write_bytes(FcCapture* capture, const void* data, u64 size)
+{
+    if (fwrite(data, 1, size, capture->file) != size) {
+        FC_ENGINE_WARN_PER_SECOND(1, "Failed to write capture frame");
+        return false;
+    }
+    atomic_fetch_add_explicit(&capture->bytes_written, size, memory_order_relaxed);
+    return true;
+}
+
+//
+// Delta frames
+//
+
+static inline b32 room_for(u64 used, u64 size, u64 capacity)
+{
+    return used + size <= capacity;
+}
+
+// Returns the encoded size, or 0 if it would not be smaller than the frame
+static u64 encode_delta(u8* dest, const u32* pixels, const u32* previous, u64 count)
+{
+    u64 capacity = count * sizeof(u32);
+    u64 used = 0;
+    u64 i = 0;
+    while (i < count) {
+        u64 start = i;
+        while (i < count && pixels[i] == previous[i]) {
+            i += 1;
+        }
+        u32 keep = (u32)(i - start);
+
+        // A literal run ends at two unchanged pixels in a row, as a single
+        // one costs less to repeat than to start a new run for
+        start = i;
+        while (i < count &&
+               !(pixels[i] == previous[i] && (i + 1 == count || pixels[i + 1] == previous[i + 1]))) {
+            i += 1;
+        }
+        u32 literal = (u32)(i - start);
+
+        u64 run_size = 2 * sizeof(u32) + (u64)literal * sizeof(u32);
+        if (!room_for(used, run_size, capacity - 1)) {
+            return 0;
+        }
+        memcpy(dest + used, &keep, sizeof(keep));
+        memcpy(dest + used + sizeof(u32), &literal, sizeof(literal));
+        memcpy(dest + used + 2 * sizeof(u32), pixels + start, (u64)literal * sizeof(u32));
+        used += run_size;
+    }
+    return used;
+}
+
+static void write_fcap_frame(FcCapture* capture, const FcCaptureBuffer* buffer)
+{
+    u64 count = (u64)capture->config.width * capture->config.height;
+    FcCaptureFrameHeader header = {
+        .encoding = FC_CAPTURE_ENCODING_PIXELS,
+        .size = (u32)(count * sizeof(u32)),
+        .time = buffer->time
+    };
+    const void* payload = buffer->pixels;
+
+    if (capture->config.compression == FC_CAPTURE_COMPRESSION_DELTA) {
+        u64 size = encode_delta(capture->encoded, buffer->pixels, capture->previous, count);
+        if (size > 0) {
+            header.encoding = FC_CAPTURE_ENCODING_DELTA;
+            header.size = (u32)size;
+            payload = capture->encoded;
+        }
+        fc_copy_u32(capture->previous, buffer->pixels, count);
+    } else if (capture->config.compression == FC_CAPTURE_COMPRESSION_QOI) {
+        u64 size = fc_image_encode_qoi(capture->encoded, count * sizeof(u32) - 1, buffer->pixels,
+                                       capture->config.width, capture->config.height,
+                                       capture->config.width, &capture->config.pixel_format,
+                                       capture->config.pixel_format.alpha_mask != 0,
+                                       FC_QOI_STRIPE_ROWS);
+        if (size > 0) {
+            header.encoding = FC_CAPTURE_ENCODING_QOI;
+            header.size = (u32)size;
+            payload = capture->encoded;
+        }
+    }
+
+    if (write_bytes(capture, &header, sizeof(header))) {
+        write_bytes(capture, payload, header.size);
+    }
+}
+
+//
+// Y4M
+//
+
+// Full range BT.601 (JFIF), declared by XCOLORRANGE=FULL in the header;
+// C420jpeg only declares the chroma siting
+static void write_y4m_frame(FcCapture* capture, const FcCaptureBuffer* buffer)
+{
+    u32 width = capture->config.width, height = capture->config.height;
+    u32 chroma_width = (width + 1) / 2, chroma_height = (height + 1) / 2;
+    const FcPixelFormat* format = &capture->config.pixel_format;
+    u8* luma = capture->encoded;
+    u8* cb = luma + (u64)width * height;
+    u8* cr = cb + (u64)chroma_width * chroma_height;
+
+    for (u32 y = 0; y < height; ++y) {
+        const u32* row = buffer->pixels + (u64)y * width;
+        u8* luma_row = luma + (u64)y * width;
+        for (u32 x = 0; x < width; ++x) {
+            s32 r = (row[x] >> format->red_shift) & 0xFF;
+            s32 g = (row[x] >> format->green_shift) & 0xFF;
+            s32 b = (row[x] >> format->blue_shift) & 0xFF;
+            luma_row[x] = (u8)((77 * r + 150 * g + 29 * b + 128) >> 8);
+        }
+    }
+
+    // Chroma of the average of each 2x2 block
+    for (u32 cy = 0; cy < chroma_height; ++cy) {
+        const u32* row0 = buffer->pixels + (u64)(cy * 2) * width;
+        const u32* row1 = cy * 2 + 1 < height ? row0 + width : row0;
+        for (u32 cx = 0; cx < chroma_width; ++cx) {
+            u32 x0 = cx * 2, x1 = x0 + 1 < width ? x0 + 1 : x0;
+            u32 block[4] = { row0[x0], row0[x1], row1[x0], row1[x1] };
+            s32 r = 0, g = 0, b = 0;
+            for (u32 i = 0; i < 4; ++i) {
+                r += (block[i] >> format->red_shift) & 0xFF;
+                g += (block[i] >> format->green_shift) & 0xFF;
+                b += (block[i] >> format->blue_shift) & 0xFF;
+            }
+            s32 u = ((-43 * r - 85 * g + 128 * b) >> 10) + 128;
+            s32 v = ((128 * r - 107 * g - 21 * b) >> 10) + 128;
+            cb[(u64)cy * chroma_width + cx] = (u8)(u < 0 ? 0 : u > 255 ? 255 : u);
+            cr[(u64)cy * chroma_width + cx] = (u8)(v < 0 ? 0 : v > 255 ? 255 : v);
+        }
+    }
+
+    static const char frame_marker[] = "FRAME\n";
+    if (write_bytes(capture, frame_marker, sizeof(frame_marker) - 1)) {
+        write_bytes(capture, capture->encoded,
+                    (u64)width * height + 2 * (u64)chroma_width * chroma_height);
+    }
+}
+
+//
+// Writer thread
+//
+
+static void writer_main(void* data)
+{
+    FcCapture* capture = (FcCapture*)data;
+    for (;;) {
+        platform_semaphore_wait(capture->frames_queued);
+        u32 tail = atomic_load_explicit(&capture->tail, memory_order_relaxed);
+        u32 head = atomic_load_explicit(&capture->head, memory_order_acquire);
+        if (tail == head) {
+            if (!atomic_load_explicit(&capture->running, memory_order_acquire)) {
+                return;
+            }
+            continue;
+        }
+
+        f64 start = platform_get_epoch_time();
+        const FcCaptureBuffer* buffer = &capture->buffers[tail % capture->config.buffer_count];
+        if (capture->config.format == FC_CAPTURE_FORMAT_Y4M) {
+            write_y4m_frame(capture, buffer);
+        } else {
+            write_fcap_frame(capture, buffer);
+        }
+        atomic_store_explicit(&capture->tail, tail + 1, memory_order_release);
+
+        atomic_fetch_add_explicit(&capture->frames_written, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&capture->write_ns,
+                                  (u64)((platform_get_epoch_time() - start) * 1000000000.0),
+                                  memory_order_relaxed);
+    }
+}
+
+static void free_buffers(FcCapture* capture)
+{
+    for (u32 i = 0; i < FC_CAPTURE_MAX_BUFFERS; ++i) {
+        FC_FREE(capture->buffers[i].pixels);
+        capture->buffers[i].pixels = NULL;
+    }
+    FC_FREE(capture->previous);
+    FC_FREE(capture->encoded);
+    capture->previous = NULL;
+    capture->encoded = NULL;
+}
+
+static b32 write_header(FcCapture* capture)
+{
+    const FcCaptureConfig* config = &capture->config;
+    if (config->format == FC_CAPTURE_FORMAT_Y4M) {
+        return fprintf(capture->file, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n",
+                       config->width, config->height, config->frames_per_second) > 0;
+    }
+    FcCaptureHeader header = {
+        .magic       = FC_CAPTURE_MAGIC,
+        .version     = FC_CAPTURE_VERSION,
+        .width       = config->width,
+        .height      = config->height,
+        .red_shift   = config->pixel_format.red_shift,
+        .green_shift = config->pixel_format.green_shift,
+        .blue_shift  = config->pixel_format.blue_shift,
+        .alpha_shift = config->pixel_format.alpha_shift,
+        .compression = config->compression
+    };
+    return fwrite(&header, 1, sizeof(header), capture->file) == sizeof(header);
+}
+
+b32 fc_capture_start(FcCapture* capture, const FcCaptureConfig* config)
+{
+    *capture = (FcCapture){ .config = *config };
+    FcCaptureConfig* own = &capture->config;
+    own->buffer_count = own->buffer_count != 0 ? own->buffer_count : 4;
+    own->buffer_count = own->buffer_count < FC_CAPTURE_MAX_BUFFERS
+        ? own->buffer_count : FC_CAPTURE_MAX_BUFFERS;
+    own->frames_per_second = own->frames_per_second != 0 ? own->frames_per_second : 60;
+    if (own->format == FC_CAPTURE_FORMAT_Y4M) {
+        own->compression = FC_CAPTURE_COMPRESSION_NONE;
+    }
+
+    // Everything is allocated up front, capturing a frame never allocates
+    u64 size = frame_size(own);
+    b32 allocated = true;
+    for (u32 i = 0; i < own->buffer_count; ++i) {
+        capture->buffers[i].pixels = (u32*)FC_ALLOC(size, "capture_buffer");
+        allocated = allocated && capture->buffers[i].pixels != NULL;
+    }
+    capture->encoded = (u8*)FC_ALLOC(size, "capture_encoded");
+    if (own->compression == FC_CAPTURE_COMPRESSION_DELTA) {
+        capture->previous = (u32*)FC_ALLOC_ZEROED(size, "capture_previous");
+        allocated = allocated && capture->previous != NULL;
+    }
+    if (!allocated || capture->encoded == NULL) {
+        FC_ENGINE_ERROR("Failed to allocate %u capture buffers", own->buffer_count);
+        free_buffers(capture);
+        return false;
+    }
+
+    capture->file = fopen(own->path, "wb");
+    if (capture->file == NULL) {
+        FC_ENGINE_ERROR("Could not open '%s' for capturing", (char*)own->path);
+        free_buffers(capture);
+        return false;
+    }
+    setvbuf(capture->file, NULL, _IOFBF, CAPTURE_FILE_BUFFER_SIZE);
+    if (!write_header(capture)) {
+        FC_ENGINE_ERROR("Could not write to '%s'", (char*)own->path);
+        fclose(capture->file);
+        free_buffers(capture);
+        return false;
+    }
+
+    capture->frames_queued = platform_create_semaphore(0);
+    atomic_store(&capture->running, true);
+    capture->thread = capture->frames_queued != NULL
+        ? platform_create_thread(writer_main, capture)
+        : NULL;
+    if (capture->thread == NULL) {
+        platform_destroy_semaphore(capture->frames_queued);
+        fclose(capture->file);
+        free_buffers(capture);
+        atomic_store(&capture->running, false);
+        return false;
+    }
+
+    capture->start_time = platform_get_epoch_time();
+    FC_ENGINE_INFO("Capturing %ux%u frames to '%s' with %u buffers",
+                   own->width, own->height, (char*)own->path, own->buffer_count);
+    return true;
+}
+
+b32 fc_capture_is_running(const FcCapture* capture)
+{
+    return atomic_load_explicit(&capture->running, memory_order_relaxed);
+}
+
+b32 fc_capture_frame(FcCapture* capture, const u32* pixels, u32 width, u32 height)
+{
+    if (!fc_capture_is_running(capture)) {
+        return false;
+    }
+    if (width != capture->config.width || height != capture->config.height) {
+        FC_ENGINE_WARN_PER_SECOND(1, "Dropping %ux%u frame, the capture is %ux%u",
+                                  width, height, capture->config.width, capture->config.height);
+        atomic_fetch_add_explicit(&capture->frames_dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    u32 head = atomic_load_explicit(&capture->head, memory_order_relaxed);
+    u32 tail = atomic_load_explicit(&capture->tail, memory_order_acquire);
+    if (head - tail == capture->config.buffer_count) {
+        atomic_fetch_add_explicit(&capture->frames_dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    FcCaptureBuffer* buffer = &capture->buffers[head % capture->config.buffer_count];
+    fc_copy_u32(buffer->pixels, pixels, (u64)width * height);
+    buffer->time = platform_get_epoch_time() - capture->start_time;
+    atomic_store_explicit(&capture->head, head + 1, memory_order_release);
+    atomic_fetch_add_explicit(&capture->frames_captured, 1, memory_order_relaxed);
+    platform_semaphore_post(capture->frames_queued, 1);
+    return true;
+}
+
+void fc_capture_stop(FcCapture* capture)
+{
+    if (!fc_capture_is_running(capture)) {
+        return;
+    }
+    atomic_store_explicit(&capture->running, false, memory_order_release);
+    platform_semaphore_post(capture->frames_queued, 1);
+    platform_join_thread(capture->thread);
+    platform_destroy_semaphore(capture->frames_queued);
+    fclose(capture->file);
+    free_buffers(capture);
+
+    FcCaptureStats stats;
+    fc_capture_get_stats(capture, &stats);
+    FC_ENGINE_INFO("Captured %u frames (%u dropped) to '%s', %u MB",
+                   (u32)stats.frames_written, (u32)stats.frames_dropped,
+                   (char*)capture->config.path, (u32)(stats.bytes_written >> 20));
+}
+
+void fc_capture_get_stats(FcCapture* capture, FcCaptureStats* stats)
+{
+    stats->frames_captured = atomic_load_explicit(&capture->frames_captured, memory_order_relaxed);
+    stats->frames_dropped  = atomic_load_explicit(&capture->frames_dropped, memory_order_relaxed);
+    stats->frames_written  = atomic_load_explicit(&capture->frames_written, memory_order_relaxed);
+    stats->bytes_written   = atomic_load_explicit(&capture->bytes_written, memory_order_relaxed);
+    stats->write_seconds   = atomic_load_explicit(&capture->write_ns, memory_order_relaxed) / 1000000000.0;
+}
+
+void fc_capture_init_from_env(FcCapture* capture, const ApplicationState* application_state)
+{
+    *capture = (FcCapture){0};
+    const char* path = getenv("FINCH_CAPTURE");
+    if (path == NULL) {
+        return;
+    }
+
+    u32 length = (u32)strlen(path);
+    b32 y4m = length >= 4 && strcmp(path + length - 4, ".y4m") == 0;
+    const char* delta = getenv("FINCH_CAPTURE_DELTA");
+    const char* qoi = getenv("FINCH_CAPTURE_QOI");
+    const char* buffers = getenv("FINCH_CAPTURE_BUFFERS");
+
+    FcCaptureConfig config = {
+        .path         = path,
+        .format       = y4m ? FC_CAPTURE_FORMAT_Y4M : FC_CAPTURE_FORMAT_RAW,
+        .compression  = delta != NULL && delta[0] == '1' ? FC_CAPTURE_COMPRESSION_DELTA
+            : qoi != NULL && qoi[0] == '1'               ? FC_CAPTURE_COMPRESSION_QOI
+            : FC_CAPTURE_COMPRESSION_NONE,
+        .width        = application_state->width_px,
+        .height       = application_state->height_px,
+        .pixel_format = application_state->pixel_format,
+        .buffer_count = buffers != NULL ? (u32)atoi(buffers) : 0
+    };
+    fc_capture_start(capture, &config);
+}
@@ -1,16 +1,58 @@
 #include "finch/core/core.h"
+#include "finch/core/capture.h"
+#include "finch/core/jobs.h"
+#include "finch/core/memory.h"
+#include "finch/core/module.h"
+#include "finch/core/replay.h"
+#include "finch/core/stream.h"
+#include "finch/core/trace.h"
 #include "finch/application/application.h"
 #include "finch/log/log.h"
 #include "finch/platform/platform.h"
+#include "finch/render/post.h"
+#include "finch/render/scale.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 
+static b32 frame_has_input(ApplicationState* application_state)
+{
+    for (u32 i = 0; i < application_state->unhandled_events; ++i) {
+        if (fc_event_is_input(&application_state->events[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
 int main(void)
 {
     ApplicationState application_state = {0};
-    fc_application_init(&application_state);
+
+    // Set FINCH_APPLICATION_MODULE to the path of an application built as a
+    // shared object to have it re-loaded whenever it is rebuilt
+    FcApplicationModule module;
+    if (!fc_module_load(&module, getenv("FINCH_APPLICATION_MODULE"))) {
+        return EXIT_FAILURE;
+    }
+
+    void* memory = platform_allocate_memory(FC_APPLICATION_MEMORY_SIZE);
+    if (memory == NULL) {
+        return EXIT_FAILURE;
+    }
+    fc_arena_init(&application_state.memory, memory, FC_APPLICATION_MEMORY_SIZE);
+
+    module.init(&application_state);
     platform_init(&application_state);
+
+    FcReplay replay;
+    fc_replay_init(&replay, &application_state);
+
+    FcTrace trace;
+    fc_trace_init(&trace);
+
+    FcCapture capture;
+    fc_capture_init_from_env(&capture, &application_state);
     
     f64 prev_time = platform_get_epoch_time();
 
@@ -20,26 +62,137 @@ int main(void)
     while (application_state.running) {
         f64 curr_time = platform_get_epoch_time();
         f64 delta_time = curr_time - prev_time;
+
+        fc_memory_begin_phase(FC_MEMORY_PHASE_EVENTS);
+        if (fc_module_reload_if_changed(&module, delta_time)) {
+            // Loading the module allocates
+            fc_memory_allow_frame();
+        }
         
         platform_poll_events(&application_state);
-        fc_application_update(&application_state, delta_time);
-        platform_put_pixelbuffer_on_screen(&application_state);
-
-        // Update fps in window title approx. every second
-        time_since_window_title_updated += delta_time;
-        if (time_since_window_title_updated > 1.0) {
-            char buf[1000];
-            sprintf(buf, "%s - %dfps",
-                    platform_get_window_attributes()->title, (u32)(1.0 / delta_time));
-            platform_set_window_title(buf);
-            time_since_window_title_updated = 0.0f;
+        if (replay.mode == FC_REPLAY_MODE_PLAYBACK) {
+            // Live input is replaced by the recorded input
+            if (!fc_replay_playback_frame(&replay, &application_state, &delta_time)) {
+                break;
+            }
+        } else if (replay.mode == FC_REPLAY_MODE_RECORD) {
+            fc_replay_record_frame(&replay, &application_state, delta_time);
+        }
+        fc_stream_update();
+
+        f64 update_start_time = platform_get_epoch_time();
+        application_state.skip_redraw = false;
+        application_state.wakeup_seconds = 0.0;
+        fc_memory_begin_phase(FC_MEMORY_PHASE_UPDATE);
+        module.update(&application_state, delta_time);
+        fc_memory_begin_phase(FC_MEMORY_PHASE_PRESENT);
+        f64 present_start_time = platform_get_epoch_time();
+        f64 present_work_ms = 0.0;
+        b32 present = !application_state.skip_redraw || application_state.present_requested;
+        application_state.present_requested = false;
+        if (present) {
+            // The filtered frame stands in for the pixelbuffer until it is
+            // captured, so regions the application does not redraw are not
+            // filtered again next frame
+            u32* pixelbuffer = application_state.pixelbuffer;
+            if (application_state.post_chain != NULL) {
+                const u32* filtered = fc_post_chain_run(application_state.post_chain, pixelbuffer,
+                                                        application_state.width_px,
+                                                        application_state.height_px,
+                                                        application_state.width_px,
+                                                        &application_state.pixel_format);
+                if (filtered != NULL) {
+                    application_state.pixelbuffer = (u32*)filtered;
+                }
+            }
+            platform_put_pixelbuffer_on_screen(&application_state);
+            // Conversion and upscaling cost frame time, waiting for vsync
+            // to free a buffer does not
+            FcPresentStats present_stats;
+            platform_get_present_stats(&present_stats);
+            present_work_ms = (platform_get_epoch_time() - present_start_time) * 1000.0 -
+                              present_stats.last_wait_ms;
+            // Input latency is measured up to the server having processed
+            // the frame, other frames are not waited for
+            if (frame_has_input(&application_state)) {
+                platform_sync_present();
+            }
+            fc_capture_frame(&capture, application_state.pixelbuffer,
+                             application_state.width_px, application_state.height_px);
+            application_state.pixelbuffer = pixelbuffer;
         }
+        f64 present_end_time = platform_get_epoch_time();
+        fc_memory_begin_phase(FC_MEMORY_PHASE_OTHER);
+        fc_frame_stats_record(&application_state.frame_stats,
+                              application_state.events, application_state.unhandled_events,
+                              update_start_time, present_start_time, present_end_time,
+                              present);
+        platform_get_present_stats(&application_state.frame_stats.present);
+        fc_trace_frame(&trace, &application_state.frame_stats,
+                       application_state.events, application_state.unhandled_events,
+                       update_start_time, present_end_time);
+        fc_replay_frame_timings(&replay,
+                                (present_start_time - update_start_time) * 1000.0,
+                                (present_end_time - present_start_time) * 1000.0);
+        fc_log_update();
+
+        if (application_state.skip_redraw) {
+            // Nothing changed, so block until input arrives or the requested
+            // wakeup. Playback supplies its own input and never waits.
+            f64 timeout = application_state.wakeup_seconds > 0.0
+                ? application_state.wakeup_seconds
+                : -1.0;
+            if (module.path != NULL &&
+                (timeout < 0.0 || timeout > FC_MODULE_RELOAD_CHECK_INTERVAL)) {
+                timeout = FC_MODULE_RELOAD_CHECK_INTERVAL;
+            }
+            FcStreamStats stream_stats;
+            fc_stream_get_stats(&stream_stats);
+            if (stream_stats.reads_queued > 0 &&
+                (timeout < 0.0 || timeout > FC_STREAM_POLL_INTERVAL)) {
+                // Reads are only reported from here
+                timeout = FC_STREAM_POLL_INTERVAL;
+            }
+            if (replay.mode != FC_REPLAY_MODE_PLAYBACK) {
+                // Buffered lines would otherwise wait for the next input
+                fc_log_flush();
+                platform_wait_for_events(timeout);
+            }
+        } else {
+            // Trade resolution for frame time when the render scale is dynamic
+            if (fc_render_scale_update(&application_state.render_scale,
+                                       (present_start_time - update_start_time) * 1000.0 +
+                                       present_work_ms)) {
+                platform_update_render_scale(&application_state);
+            }
 
+            // Update fps in window title approx. every second
+            time_since_window_title_updated += delta_time;
+            if (time_since_window_title_updated > 1.0) {
+                char buf[1000];
+                sprintf(buf, "%s - %dfps",
+                        platform_get_window_attributes()->title, (u32)(1.0 / delta_time));
+                platform_set_window_title(buf);
+                time_since_window_title_updated = 0.0f;
+            }
+        }
+
+        fc_memory_end_frame();
         prev_time = curr_time;
     }
 
+    fc_capture_stop(&capture);
+    fc_memory_report();
+    fc_trace_deinit(&trace);
+    fc_replay_deinit(&replay, &application_state);
     platform_deinit(&application_state);
-    fc_application_deinit(&application_state);
+    // Reads in flight may target memory the module frees
+    fc_stream_deinit();
+    module.deinit(&application_state);
+    fc_jobs_deinit();
+    fc_module_unload(&module);
+
+    platform_free_memory(memory, FC_APPLICATION_MEMORY_SIZE);
     
     return EXIT_SUCCESS;
 }
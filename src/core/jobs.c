@@ -0,0 +1,140 @@
+#include "finch/core/jobs.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+#include "finch/platform/platform.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define JOBS_MAX_WORKERS 64
+
+typedef struct _JobLoop {
+    FcJobRangeFn fn;
+    void*        data;
+    u32          count;
+    u32          batch_size;
+    _Atomic u32  next_batch;
+} JobLoop;
+
+static b32   initialized;
+static u32   worker_count;
+static void* workers[JOBS_MAX_WORKERS];
+static void* work_available;  // Posted once per worker for every loop
+static void* workers_done;    // Posted by the last worker to leave a loop
+static _Atomic u32  workers_busy;
+static _Atomic b32  shutting_down;
+static JobLoop loop;
+
+static void run_batches(void)
+{
+    u32 batch_count = (loop.count + loop.batch_size - 1) / loop.batch_size;
+    for (;;) {
+        u32 batch = atomic_fetch_add_explicit(&loop.next_batch, 1, memory_order_relaxed);
+        if (batch >= batch_count) {
+            return;
+        }
+        u32 begin = batch * loop.batch_size;
+        u32 end = begin + loop.batch_size < loop.count ? begin + loop.batch_size : loop.count;
+        loop.fn(loop.data, begin, end);
+    }
+}
+
+static void worker_main(void* data)
+{
+    (void)data;
+    for (;;) {
+        platform_semaphore_wait(work_available);
+        if (atomic_load_explicit(&shutting_down, memory_order_acquire)) {
+            return;
+        }
+        run_batches();
+        // The loop may not be replaced until every worker has left it
+        if (atomic_fetch_sub_explicit(&workers_busy, 1, memory_order_acq_rel) == 1) {
+            platform_semaphore_post(workers_done, 1);
+        }
+    }
+}
+
+b32 fc_jobs_init(u32 count)
+{
+    if (initialized) {
+        return true;
+    }
+    initialized = true;
+
+    if (count == 0) {
+        const char* env = getenv("FINCH_WORKER_THREADS");
+        count = env != NULL ? (u32)atoi(env) : platform_get_cpu_count() - 1;
+    }
+    count = count < JOBS_MAX_WORKERS ? count : JOBS_MAX_WORKERS;
+    if (count == 0) {
+        return true;
+    }
+
+    work_available = platform_create_semaphore(0);
+    workers_done = platform_create_semaphore(0);
+    if (work_available == NULL || workers_done == NULL) {
+        platform_destroy_semaphore(work_available);
+        platform_destroy_semaphore(workers_done);
+        return false;
+    }
+    for (u32 i = 0; i < count; ++i) {
+        workers[i] = platform_create_thread(worker_main, NULL);
+        if (workers[i] == NULL) {
+            break;
+        }
+        worker_count += 1;
+    }
+    FC_ENGINE_INFO("Started %u worker threads", worker_count);
+    return worker_count == count;
+}
+
+void fc_jobs_deinit(void)
+{
+    if (worker_count > 0) {
+        atomic_store_explicit(&shutting_down, true, memory_order_release);
+        platform_semaphore_post(work_available, worker_count);
+        for (u32 i = 0; i < worker_count; ++i) {
+            platform_join_thread(workers[i]);
+        }
+        platform_destroy_semaphore(work_available);
+        platform_destroy_semaphore(workers_done);
+    }
+    worker_count = 0;
+    atomic_store(&shutting_down, false);
+    initialized = false;
+}
+
+u32 fc_jobs_get_worker_count(void)
+{
+    return worker_count;
+}
+
+void fc_jobs_parallel_for(u32 count, u32 batch_size, FcJobRangeFn fn, void* data)
+{
+    if (count == 0) {
+        return;
+    }
+    if (!initialized) {
+        fc_jobs_init(0);
+    }
+    batch_size = batch_size != 0 ? batch_size : count;
+
+    loop.fn = fn;
+    loop.data = data;
+    loop.count = count;
+    loop.batch_size = batch_size;
+    atomic_store_explicit(&loop.next_batch, 0, memory_order_relaxed);
+
+    // The caller takes a batch too, so one batch wakes no one
+    u32 batch_count = (count + batch_size - 1) / batch_size;
+    u32 helpers = batch_count - 1 < worker_count ? batch_count - 1 : worker_count;
+    if (helpers > 0) {
+        atomic_store_explicit(&workers_busy, helpers, memory_order_release);
+        platform_semaphore_post(work_available, helpers);
+    }
+    run_batches();
+    if (helpers > 0) {
+        platform_semaphore_wait(workers_done);
+    }
+}
@@ -0,0 +1,402 @@
+#define _GNU_SOURCE
+
+#include "finch/core/memory.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+
+#define MEMORY_HEADER_SIZE     16
+#define MEMORY_MAX_SITES       512 // Power of two
+#define MEMORY_NO_SITE         0xFFFFFFFFu
+#define MEMORY_MAX_FRAME_SITES 64
+
+// Stored right before every block
+typedef struct _MemoryHeader {
+    u64 size;
+    u32 site;   // Index into sites, or MEMORY_NO_SITE
+    u32 offset; // From the start of the malloc block to the memory
+} MemoryHeader;
+
+typedef struct _MemorySite {
+    const char* file; // NULL when the slot is free
+    u32         line;
+    const char* tag;
+    u64 allocations;
+    u64 live_bytes;
+    u64 peak_bytes;
+    u32 frame_allocations;
+} MemorySite;
+
+static b32 initialized;
+static b32 tracking;
+
+static _Atomic u64 allocations;
+static _Atomic u64 frees;
+static _Atomic u64 bytes_allocated;
+static _Atomic u64 live_bytes;
+static _Atomic u64 peak_bytes;
+
+// Call sites, only with tracking
+static MemorySite  sites[MEMORY_MAX_SITES];
+static u32         frame_sites[MEMORY_MAX_FRAME_SITES];
+static u32         frame_site_count;
+static atomic_flag sites_lock = ATOMIC_FLAG_INIT;
+
+static FcExternalAllocCounters* external;
+
+// Frame accounting, main thread only
+static FcMemoryPhase phase;
+static u64 phase_start_allocations;
+static u64 phase_start_external;
+static u64 phase_start_bytes;
+static u32 current_allocations[FC_MEMORY_PHASE_COUNT];
+static u64 current_bytes[FC_MEMORY_PHASE_COUNT];
+static u32 last_allocations[FC_MEMORY_PHASE_COUNT];
+static u64 last_bytes[FC_MEMORY_PHASE_COUNT];
+static u64 frames;
+static u64 frames_with_allocations;
+static u64 assert_after_frames;
+static b32 frame_allowed;
+
+static const char* phase_names[] = {"events", "update", "present", "other"};
+
+static void memory_init(void)
+{
+    initialized = true;
+
+    char* value = getenv("FINCH_MEMORY_TRACKING");
+    tracking = value != NULL && value[0] == '1';
+
+    value = getenv("FINCH_MEMORY_ASSERT");
+    if (value != NULL) {
+        assert_after_frames = strtoull(value, NULL, 10);
+    }
+
+    external = (FcExternalAllocCounters*)dlsym(RTLD_DEFAULT, FC_EXTERNAL_ALLOC_COUNTERS_SYMBOL);
+}
+
+static u32 site_find(const char* file, u32 line, const char* tag)
+{
+    u64 hash = ((u64)(uintptr_t)file ^ ((u64)line << 32)) * 0x9E3779B97F4A7C15ull;
+    u32 index = (u32)(hash >> 40) & (MEMORY_MAX_SITES - 1);
+    for (u32 probe = 0; probe < MEMORY_MAX_SITES; ++probe) {
+        MemorySite* site = &sites[index];
+        if (site->file == NULL) {
+            site->file = file;
+            site->line = line;
+            site->tag  = tag;
+            return index;
+        }
+        if (site->file == file && site->line == line) {
+            return index;
+        }
+        index = (index + 1) & (MEMORY_MAX_SITES - 1);
+    }
+    return MEMORY_NO_SITE;
+}
+
+static u32 site_add(const char* file, u32 line, const char* tag, u64 size)
+{
+    while (atomic_flag_test_and_set_explicit(&sites_lock, memory_order_acquire)) {}
+    u32 index = site_find(file, line, tag);
+    if (index != MEMORY_NO_SITE) {
+        MemorySite* site = &sites[index];
+        site->allocations += 1;
+        site->live_bytes  += size;
+        if (site->live_bytes > site->peak_bytes) {
+            site->peak_bytes = site->live_bytes;
+        }
+        if (site->frame_allocations++ == 0 && frame_site_count < MEMORY_MAX_FRAME_SITES) {
+            frame_sites[frame_site_count++] = index;
+        }
+    }
+    atomic_flag_clear_explicit(&sites_lock, memory_order_release);
+    return index;
+}
+
+static void site_remove(u32 index, u64 size)
+{
+    if (index == MEMORY_NO_SITE) {
+        return;
+    }
+    while (atomic_flag_test_and_set_explicit(&sites_lock, memory_order_acquire)) {}
+    sites[index].live_bytes -= size;
+    atomic_flag_clear_explicit(&sites_lock, memory_order_release);
+}
+
+static void count_allocation(u64 size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&bytes_allocated, size, memory_order_relaxed);
+    u64 live = atomic_fetch_add_explicit(&live_bytes, size, memory_order_relaxed) + size;
+    u64 peak = atomic_load_explicit(&peak_bytes, memory_order_relaxed);
+    while (live > peak &&
+           !atomic_compare_exchange_weak_explicit(&peak_bytes, &peak, live,
+                                                  memory_order_relaxed, memory_order_relaxed)) {}
+}
+
+void* fc_memory_alloc(u64 size, u64 alignment, b32 zeroed,
+                      const char* tag, const char* file, u32 line)
+{
+    if (!initialized) {
+        memory_init();
+    }
+
+    // Aligned blocks are padded so that the header fits in front of the
+    // first aligned address
+    alignment = alignment > MEMORY_HEADER_SIZE ? alignment : MEMORY_HEADER_SIZE;
+    u64 padding = alignment == MEMORY_HEADER_SIZE ? MEMORY_HEADER_SIZE : alignment + MEMORY_HEADER_SIZE;
+    u8* block = zeroed
+        ? (u8*)calloc(1, size + padding)
+        : (u8*)malloc(size + padding);
+    if (block == NULL) {
+        return NULL;
+    }
+
+    u8* memory = (u8*)(((uintptr_t)block + MEMORY_HEADER_SIZE + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    MemoryHeader* header = (MemoryHeader*)(memory - MEMORY_HEADER_SIZE);
+    header->size   = size;
+    header->offset = (u32)(memory - block);
+    header->site   = tracking ? site_add(file, line, tag, size) : MEMORY_NO_SITE;
+
+    count_allocation(size);
+    return memory;
+}
+
+void* fc_memory_realloc(void* memory, u64 size,
+                        const char* tag, const char* file, u32 line)
+{
+    if (memory == NULL) {
+        return fc_memory_alloc(size, 0, false, tag, file, line);
+    }
+
+    MemoryHeader* header = (MemoryHeader*)((u8*)memory - MEMORY_HEADER_SIZE);
+    if (header->offset != MEMORY_HEADER_SIZE) {
+        FC_ENGINE_ERROR("Aligned blocks cannot be reallocated (%s:%u)", (char*)file, line);
+        return NULL;
+    }
+    u64 old_size = header->size;
+    u32 old_site = header->site;
+
+    u8* block = (u8*)realloc(header, size + MEMORY_HEADER_SIZE);
+    if (block == NULL) {
+        return NULL;
+    }
+    header = (MemoryHeader*)block;
+    header->size = size;
+
+    // Moves the block from its old call site to this one
+    site_remove(old_site, old_size);
+    header->site = tracking ? site_add(file, line, tag, size) : MEMORY_NO_SITE;
+    atomic_fetch_sub_explicit(&live_bytes, old_size, memory_order_relaxed);
+    atomic_fetch_add_explicit(&frees, 1, memory_order_relaxed);
+    count_allocation(size);
+    return block + MEMORY_HEADER_SIZE;
+}
+
+void fc_memory_free(void* memory)
+{
+    if (memory == NULL) {
+        return;
+    }
+    MemoryHeader* header = (MemoryHeader*)((u8*)memory - MEMORY_HEADER_SIZE);
+    site_remove(header->site, header->size);
+    atomic_fetch_sub_explicit(&live_bytes, header->size, memory_order_relaxed);
+    atomic_fetch_add_explicit(&frees, 1, memory_order_relaxed);
+    free((u8*)memory - header->offset);
+}
+
+static void* heap_alloc(void* context, u64 size, u64 alignment,
+                        const char* tag, const char* file, u32 line)
+{
+    (void)context;
+    return fc_memory_alloc(size, alignment, false, tag, file, line);
+}
+
+static void heap_free(void* context, void* memory, u64 size)
+{
+    (void)context;
+    (void)size;
+    fc_memory_free(memory);
+}
+
+FcAllocator fc_heap_allocator(void)
+{
+    return (FcAllocator){ .alloc = heap_alloc, .free = heap_free, .context = NULL };
+}
+
+static void end_phase(void)
+{
+    u64 engine = atomic_load_explicit(&allocations, memory_order_relaxed);
+    u64 bytes  = atomic_load_explicit(&bytes_allocated, memory_order_relaxed);
+    u64 total  = external != NULL
+        ? atomic_load_explicit(&external->allocations, memory_order_relaxed)
+        : engine;
+
+    // Engine allocations go through malloc, so the interposer counts them
+    // as well
+    u64 engine_count = engine - phase_start_allocations;
+    u64 total_count  = total - phase_start_external;
+    current_allocations[phase] += (u32)(total_count > engine_count ? total_count : engine_count);
+    current_bytes[phase]       += bytes - phase_start_bytes;
+
+    phase_start_allocations = engine;
+    phase_start_external    = total;
+    phase_start_bytes       = bytes;
+}
+
+void fc_memory_begin_phase(FcMemoryPhase next_phase)
+{
+    if (!initialized) {
+        memory_init();
+    }
+    end_phase();
+    phase = next_phase;
+}
+
+static void report_frame_and_abort(u32 total)
+{
+    FC_ENGINE_ERROR("Frame %u made %u allocations after reaching the steady state",
+                    (u32)frames, total);
+    for (u32 i = 0; i < FC_MEMORY_PHASE_COUNT; ++i) {
+        if (current_allocations[i] > 0) {
+            FC_ENGINE_ERROR("  %s: %u allocations, %u bytes from the engine",
+                            (char*)phase_names[i], current_allocations[i], (u32)current_bytes[i]);
+        }
+    }
+    for (u32 i = 0; i < frame_site_count; ++i) {
+        MemorySite* site = &sites[frame_sites[i]];
+        FC_ENGINE_ERROR("  %s:%u [%s] %u allocations", (char*)site->file, site->line,
+                        (char*)site->tag, site->frame_allocations);
+    }
+    if (!tracking) {
+        FC_ENGINE_ERROR("  Set FINCH_MEMORY_TRACKING=1 to see the call sites");
+    }
+    fc_log_flush();
+    abort();
+}
+
+void fc_memory_end_frame(void)
+{
+    if (!initialized) {
+        memory_init();
+    }
+    end_phase();
+
+    u32 total = 0;
+    for (u32 i = 0; i < FC_MEMORY_PHASE_COUNT; ++i) {
+        total += current_allocations[i];
+    }
+    frames += 1;
+    if (total > 0) {
+        frames_with_allocations += 1;
+        if (assert_after_frames > 0 && frames > assert_after_frames && !frame_allowed) {
+            report_frame_and_abort(total);
+        }
+    }
+
+    memcpy(last_allocations, current_allocations, sizeof(last_allocations));
+    memcpy(last_bytes, current_bytes, sizeof(last_bytes));
+    memset(current_allocations, 0, sizeof(current_allocations));
+    memset(current_bytes, 0, sizeof(current_bytes));
+    frame_allowed = false;
+    phase = FC_MEMORY_PHASE_EVENTS;
+
+    if (tracking) {
+        while (atomic_flag_test_and_set_explicit(&sites_lock, memory_order_acquire)) {}
+        for (u32 i = 0; i < frame_site_count; ++i) {
+            sites[frame_sites[i]].frame_allocations = 0;
+        }
+        frame_site_count = 0;
+        atomic_flag_clear_explicit(&sites_lock, memory_order_release);
+    }
+}
+
+void fc_memory_assert_steady_state(u64 after_frames)
+{
+    if (!initialized) {
+        memory_init();
+    }
+    assert_after_frames = after_frames > 0 ? frames + after_frames : 0;
+}
+
+void fc_memory_allow_frame(void)
+{
+    frame_allowed = true;
+}
+
+void fc_memory_get_stats(FcMemoryStats* stats)
+{
+    if (!initialized) {
+        memory_init();
+    }
+    *stats = (FcMemoryStats){
+        .allocations             = atomic_load(&allocations),
+        .frees                   = atomic_load(&frees),
+        .live_bytes              = atomic_load(&live_bytes),
+        .peak_bytes              = atomic_load(&peak_bytes),
+        .external_counted        = external != NULL,
+        .frames                  = frames,
+        .frames_with_allocations = frames_with_allocations
+    };
+    if (external != NULL) {
+        u64 total = atomic_load(&external->allocations);
+        stats->external_allocations = total > stats->allocations ? total - stats->allocations : 0;
+    }
+    memcpy(stats->frame_allocations, last_allocations, sizeof(last_allocations));
+    memcpy(stats->frame_bytes, last_bytes, sizeof(last_bytes));
+}
+
+void fc_memory_report(void)
+{
+    if (!initialized) {
+        memory_init();
+    }
+    if (!tracking) {
+        return;
+    }
+
+    FcMemoryStats stats;
+    fc_memory_get_stats(&stats);
+    FC_ENGINE_INFO("Memory: %u allocations, %u frees, %u KiB live, %u KiB peak, "
+                   "%u of %u frames allocated",
+                   (u32)stats.allocations, (u32)stats.frees,
+                   (u32)(stats.live_bytes / 1024), (u32)(stats.peak_bytes / 1024),
+                   (u32)stats.frames_with_allocations, (u32)stats.frames);
+    if (stats.external_counted) {
+        FC_ENGINE_INFO("Memory: %u allocations outside the engine allocator",
+                       (u32)stats.external_allocations);
+    }
+
+    // Most allocations first
+    u32 order[MEMORY_MAX_SITES];
+    u32 count = 0;
+    while (atomic_flag_test_and_set_explicit(&sites_lock, memory_order_acquire)) {}
+    for (u32 i = 0; i < MEMORY_MAX_SITES; ++i) {
+        if (sites[i].file == NULL) {
+            continue;
+        }
+        u32 j = count++;
+        while (j > 0 && sites[order[j - 1]].allocations < sites[i].allocations) {
+            order[j] = order[j - 1];
+            j -= 1;
+        }
+        order[j] = i;
+    }
+    MemorySite copy[MEMORY_MAX_SITES];
+    for (u32 i = 0; i < count; ++i) {
+        copy[i] = sites[order[i]];
+    }
+    atomic_flag_clear_explicit(&sites_lock, memory_order_release);
+
+    // Logged outside the lock, the logger allocates its sinks
+    for (u32 i = 0; i < count; ++i) {
+        FC_ENGINE_INFO("  %s:%u [%s] %u allocations, %u bytes live, %u bytes peak",
+                       (char*)copy[i].file, copy[i].line, (char*)copy[i].tag,
+                       (u32)copy[i].allocations, (u32)copy[i].live_bytes,
+                       (u32)copy[i].peak_bytes);
+    }
+}
@@ -0,0 +1,124 @@
+#include "finch/core/module.h"
+#include "finch/log/log.h"
+#include "finch/platform/platform.h"
+#include "finch/utils/string.h"
+
+#include <stddef.h>
+
+// Entry points of a statically linked application. Declared weak so that
+// the engine can also be started by an executable that links no
+// application and loads it as a module instead.
+#pragma weak fc_application_init
+#pragma weak fc_application_update
+#pragma weak fc_application_deinit
+
+static b32 module_open(FcApplicationModule* module)
+{
+    // Load a private copy so the linker can overwrite the original while it
+    // is mapped, and so the dynamic loader does not hand back the cached
+    // handle of the previous version.
+    static u32 live_copies = 0;
+    char live_path[1024];
+    string_format(live_path, sizeof(live_path), "%s.live-%u",
+                  module->path, live_copies++);
+    if (!platform_copy_file(module->path, live_path)) {
+        FC_ENGINE_ERROR("Could not copy application module '%s'", module->path);
+        return false;
+    }
+
+    void* handle = platform_load_library(live_path);
+    platform_delete_file(live_path);
+    if (handle == NULL) {
+        return false;
+    }
+
+    FcApplicationInitFn init = (FcApplicationInitFn)
+        platform_get_library_symbol(handle, "fc_application_init");
+    FcApplicationUpdateFn update = (FcApplicationUpdateFn)
+        platform_get_library_symbol(handle, "fc_application_update");
+    FcApplicationDeinitFn deinit = (FcApplicationDeinitFn)
+        platform_get_library_symbol(handle, "fc_application_deinit");
+    if (init == NULL || update == NULL || deinit == NULL) {
+        FC_ENGINE_ERROR("Application module '%s' is missing entry points",
+                        module->path);
+        platform_unload_library(handle);
+        return false;
+    }
+
+    if (module->handle != NULL) {
+        platform_unload_library(module->handle);
+    }
+    module->handle = handle;
+    module->init   = init;
+    module->update = update;
+    module->deinit = deinit;
+    return true;
+}
+
+b32 fc_module_load(FcApplicationModule* module, const char* path)
+{
+    *module = (FcApplicationModule){0};
+
+    if (path == NULL) {
+        if (fc_application_init == NULL) {
+            FC_ENGINE_ERROR("No application is linked and no application "
+                            "module was given");
+            return false;
+        }
+        module->init   = fc_application_init;
+        module->update = fc_application_update;
+        module->deinit = fc_application_deinit;
+        return true;
+    }
+
+    module->path = path;
+    module->last_write_time = platform_get_file_write_time(path);
+    if (!module_open(module)) {
+        return false;
+    }
+
+    FC_ENGINE_INFO("Loaded application module '%s'", path);
+    return true;
+}
+
+b32 fc_module_reload_if_changed(FcApplicationModule* module, f64 delta_time)
+{
+    if (module->path == NULL) {
+        return false;
+    }
+
+    module->time_since_check += delta_time;
+    if (module->time_since_check < FC_MODULE_RELOAD_CHECK_INTERVAL) {
+        return false;
+    }
+    module->time_since_check = 0.0;
+
+    s64 write_time = platform_get_file_write_time(module->path);
+    if (write_time <= 0 || write_time == module->last_write_time) {
+        return false;
+    }
+
+    f64 start_time = platform_get_epoch_time();
+    if (!module_open(module)) {
+        // Most likely caught the file mid-write, try again on next check
+        return false;
+    }
+    module->last_write_time = write_time;
+    module->reload_count += 1;
+
+    module->last_reload_ms   = (platform_get_epoch_time() - start_time) * 1000.0;
+    module->total_reload_ms += module->last_reload_ms;
+    FC_ENGINE_INFO("Reloaded application module '%s' in %f ms "
+                   "(reload #%u, average %f ms)",
+                   module->path, module->last_reload_ms, module->reload_count,
+                   module->total_reload_ms / module->reload_count);
+    return true;
+}
+
+void fc_module_unload(FcApplicationModule* module)
+{
+    if (module->handle != NULL) {
+        platform_unload_library(module->handle);
+    }
+    *module = (FcApplicationModule){0};
+}
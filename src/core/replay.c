@@ -0,0 +1,337 @@
+#include "finch/core/replay.h"
+#include "finch/log/log.h"
+#include "finch/platform/platform.h"
+#include "finch/utils/string.h"
+
+#include <stdlib.h>
+
+#define REPLAY_FRAME_INPUT_CHANGED 0x1
+#define REPLAY_FRAME_SIZE_CHANGED  0x2
+
+#define KEY_BITSET_SIZE ((FC_KEY_COUNT + 7) / 8)
+
+typedef struct _ReplayHeader {
+    u32 magic;
+    u32 version;
+    u16 key_count;
+    u16 button_count;
+    u32 width_px;
+    u32 height_px;
+} ReplayHeader;
+
+static b32 write_bytes(FcReplay* replay, const void* data, u64 size)
+{
+    return fwrite(data, 1, size, replay->file) == size;
+}
+
+static b32 read_bytes(FcReplay* replay, void* data, u64 size)
+{
+    return fread(data, 1, size, replay->file) == size;
+}
+
+static b32 input_states_equal(InputState* a, InputState* b)
+{
+    for (u32 i = 0; i < FC_BUTTON_COUNT; ++i) {
+        if (a->button_is_down[i] != b->button_is_down[i]) return false;
+    }
+    for (u32 i = 0; i < FC_KEY_COUNT; ++i) {
+        if (a->key_is_down[i] != b->key_is_down[i]) return false;
+    }
+    return a->mouse_x == b->mouse_x && a->mouse_y == b->mouse_y &&
+           a->mouse_dx == b->mouse_dx && a->mouse_dy == b->mouse_dy;
+}
+
+static void write_input_state(FcReplay* replay, InputState* input_state)
+{
+    u8 buttons = 0;
+    for (u32 i = 0; i < FC_BUTTON_COUNT; ++i) {
+        buttons |= (input_state->button_is_down[i] ? 1 : 0) << i;
+    }
+    u8 keys[KEY_BITSET_SIZE] = {0};
+    for (u32 i = 0; i < FC_KEY_COUNT; ++i) {
+        keys[i / 8] |= (input_state->key_is_down[i] ? 1 : 0) << (i % 8);
+    }
+
+    write_bytes(replay, &buttons, sizeof(buttons));
+    write_bytes(replay, keys, sizeof(keys));
+    write_bytes(replay, &input_state->mouse_x,  sizeof(input_state->mouse_x));
+    write_bytes(replay, &input_state->mouse_y,  sizeof(input_state->mouse_y));
+    write_bytes(replay, &input_state->mouse_dx, sizeof(input_state->mouse_dx));
+    write_bytes(replay, &input_state->mouse_dy, sizeof(input_state->mouse_dy));
+}
+
+static b32 read_input_state(FcReplay* replay, InputState* input_state)
+{
+    u8 buttons;
+    u8 keys[KEY_BITSET_SIZE];
+    if (!read_bytes(replay, &buttons, sizeof(buttons)) ||
+        !read_bytes(replay, keys, sizeof(keys)) ||
+        !read_bytes(replay, &input_state->mouse_x,  sizeof(input_state->mouse_x)) ||
+        !read_bytes(replay, &input_state->mouse_y,  sizeof(input_state->mouse_y)) ||
+        !read_bytes(replay, &input_state->mouse_dx, sizeof(input_state->mouse_dx)) ||
+        !read_bytes(replay, &input_state->mouse_dy, sizeof(input_state->mouse_dy))) {
+        return false;
+    }
+
+    for (u32 i = 0; i < FC_BUTTON_COUNT; ++i) {
+        input_state->button_is_down[i] = (buttons >> i) & 1;
+    }
+    for (u32 i = 0; i < FC_KEY_COUNT; ++i) {
+        input_state->key_is_down[i] = (keys[i / 8] >> (i % 8)) & 1;
+    }
+    return true;
+}
+
+static void write_event(FcReplay* replay, FcEvent* event)
+{
+    u8 fields[5] = {
+        (u8)event->type, (u8)event->button, (u8)event->key,
+        (u8)event->scroll_wheel_vertical_direction,
+        (u8)event->scroll_wheel_horizontal_direction
+    };
+    write_bytes(replay, fields, sizeof(fields));
+    write_bytes(replay, &event->mouse_x, sizeof(event->mouse_x));
+    write_bytes(replay, &event->mouse_y, sizeof(event->mouse_y));
+}
+
+static b32 read_event(FcReplay* replay, FcEvent* event)
+{
+    u8 fields[5];
+    if (!read_bytes(replay, fields, sizeof(fields)) ||
+        !read_bytes(replay, &event->mouse_x, sizeof(event->mouse_x)) ||
+        !read_bytes(replay, &event->mouse_y, sizeof(event->mouse_y))) {
+        return false;
+    }
+
+    event->type   = (FcEventType)fields[0];
+    event->button = (FcButton)fields[1];
+    event->key    = (FcKey)fields[2];
+    event->scroll_wheel_vertical_direction   = (s8)fields[3];
+    event->scroll_wheel_horizontal_direction = (s8)fields[4];
+    return true;
+}
+
+void fc_replay_init(FcReplay* replay, ApplicationState* application_state)
+{
+    *replay = (FcReplay){0};
+
+    char* record_path = getenv("FINCH_RECORD");
+    char* replay_path = getenv("FINCH_REPLAY");
+
+    if (replay_path != NULL) {
+        replay->file = fopen(replay_path, "rb");
+        if (replay->file == NULL) {
+            FC_ENGINE_ERROR("Could not open recording '%s'", replay_path);
+            exit(EXIT_FAILURE);
+        }
+
+        ReplayHeader header;
+        if (!read_bytes(replay, &header, sizeof(header)) ||
+            header.magic != FC_REPLAY_MAGIC || header.version != FC_REPLAY_VERSION ||
+            header.key_count != FC_KEY_COUNT || header.button_count != FC_BUTTON_COUNT) {
+            FC_ENGINE_ERROR("'%s' is not a compatible recording", replay_path);
+            exit(EXIT_FAILURE);
+        }
+
+        char* fixed_delta_time = getenv("FINCH_REPLAY_DT");
+        if (fixed_delta_time != NULL) {
+            replay->fixed_delta_time = atof(fixed_delta_time);
+        }
+        char* fast = getenv("FINCH_REPLAY_FAST");
+        replay->as_fast_as_possible = fast != NULL && fast[0] == '1';
+
+        char* timings_path = getenv("FINCH_REPLAY_TIMINGS");
+        if (timings_path != NULL) {
+            replay->timings = fopen(timings_path, "w");
+            if (replay->timings == NULL) {
+                FC_ENGINE_ERROR("Could not open '%s' for writing", timings_path);
+                exit(EXIT_FAILURE);
+            }
+            fprintf(replay->timings, "frame,frame_ms,update_ms,present_ms\n");
+        }
+
+        replay->mode = FC_REPLAY_MODE_PLAYBACK;
+        FC_ENGINE_INFO("Playing back recording '%s' (%ux%u)",
+                       replay_path, header.width_px, header.height_px);
+    }
+
+    else if (record_path != NULL) {
+        replay->file = fopen(record_path, "wb");
+        if (replay->file == NULL) {
+            FC_ENGINE_ERROR("Could not open '%s' for recording", record_path);
+            exit(EXIT_FAILURE);
+        }
+
+        ReplayHeader header = {
+            .magic        = FC_REPLAY_MAGIC,
+            .version      = FC_REPLAY_VERSION,
+            .key_count    = FC_KEY_COUNT,
+            .button_count = FC_BUTTON_COUNT,
+            .width_px     = application_state->width_px,
+            .height_px    = application_state->height_px
+        };
+        write_bytes(replay, &header, sizeof(header));
+
+        replay->mode = FC_REPLAY_MODE_RECORD;
+        FC_ENGINE_INFO("Recording session to '%s'", record_path);
+    }
+}
+
+void fc_replay_record_frame(FcReplay* replay, ApplicationState* application_state,
+                            f64 delta_time)
+{
+    InputState* input_state = &application_state->input_state;
+
+    u8 flags = 0;
+    if (replay->frame_count == 0 ||
+        !input_states_equal(input_state, &replay->previous_input_state)) {
+        flags |= REPLAY_FRAME_INPUT_CHANGED;
+    }
+    if (application_state->width_px  != replay->width_px ||
+        application_state->height_px != replay->height_px) {
+        flags |= REPLAY_FRAME_SIZE_CHANGED;
+        replay->width_px  = application_state->width_px;
+        replay->height_px = application_state->height_px;
+    }
+    u16 event_count = (u16)application_state->unhandled_events;
+
+    write_bytes(replay, &flags, sizeof(flags));
+    write_bytes(replay, &event_count, sizeof(event_count));
+    write_bytes(replay, &delta_time, sizeof(delta_time));
+    if (flags & REPLAY_FRAME_SIZE_CHANGED) {
+        write_bytes(replay, &replay->width_px,  sizeof(replay->width_px));
+        write_bytes(replay, &replay->height_px, sizeof(replay->height_px));
+    }
+    if (flags & REPLAY_FRAME_INPUT_CHANGED) {
+        write_input_state(replay, input_state);
+    }
+    for (u32 i = 0; i < event_count; ++i) {
+        write_event(replay, &application_state->events[i]);
+    }
+
+    replay->previous_input_state = *input_state;
+    replay->frame_count += 1;
+}
+
+b32 fc_replay_playback_frame(FcReplay* replay, ApplicationState* application_state,
+                             f64* delta_time)
+{
+    u8  flags;
+    u16 event_count;
+    f64 recorded_delta_time;
+    if (!read_bytes(replay, &flags, sizeof(flags)) ||
+        !read_bytes(replay, &event_count, sizeof(event_count)) ||
+        !read_bytes(replay, &recorded_delta_time, sizeof(recorded_delta_time))) {
+        return false;
+    }
+
+    if (flags & REPLAY_FRAME_SIZE_CHANGED) {
+        if (!read_bytes(replay, &replay->width_px,  sizeof(replay->width_px)) ||
+            !read_bytes(replay, &replay->height_px, sizeof(replay->height_px))) {
+            return false;
+        }
+    }
+    if (flags & REPLAY_FRAME_INPUT_CHANGED) {
+        if (!read_input_state(replay, &replay->previous_input_state)) {
+            return false;
+        }
+    }
+
+    // The window is still live, so the pixelbuffer can differ in size from
+    // the recorded one, which makes the output incomparable
+    if ((application_state->width_px  != replay->width_px ||
+         application_state->height_px != replay->height_px) &&
+        !replay->size_mismatch_reported) {
+        FC_ENGINE_WARN("Pixelbuffer is %ux%u but was %ux%u when recorded",
+                       application_state->width_px, application_state->height_px,
+                       replay->width_px, replay->height_px);
+        replay->size_mismatch_reported = true;
+    }
+    application_state->input_state = replay->previous_input_state;
+
+    application_state->unhandled_events = 0;
+    for (u32 i = 0; i < event_count; ++i) {
+        FcEvent event = {0};
+        if (!read_event(replay, &event)) {
+            return false;
+        }
+        if (application_state->unhandled_events < MAX_EVENTS) {
+            application_state->events[application_state->unhandled_events++] = event;
+        }
+    }
+
+    // Pace playback to the recorded frame times unless asked not to
+    if (!replay->as_fast_as_possible && replay->frame_count > 0) {
+        f64 elapsed = platform_get_epoch_time() - replay->frame_start_time;
+        if (elapsed < recorded_delta_time) {
+            platform_sleep(recorded_delta_time - elapsed);
+        }
+    }
+    replay->frame_start_time = platform_get_epoch_time();
+
+    *delta_time = replay->fixed_delta_time > 0.0
+        ? replay->fixed_delta_time
+        : recorded_delta_time;
+    replay->frame_count += 1;
+    return true;
+}
+
+void fc_replay_frame_timings(FcReplay* replay, f64 update_ms, f64 present_ms)
+{
+    if (replay->mode != FC_REPLAY_MODE_PLAYBACK) {
+        return;
+    }
+
+    replay->total_update_ms  += update_ms;
+    replay->total_present_ms += present_ms;
+    if (update_ms  > replay->max_update_ms)  replay->max_update_ms  = update_ms;
+    if (present_ms > replay->max_present_ms) replay->max_present_ms = present_ms;
+
+    if (replay->timings != NULL) {
+        f64 frame_ms = (platform_get_epoch_time() - replay->frame_start_time) * 1000.0;
+        fprintf(replay->timings, "%u,%.6f,%.6f,%.6f\n",
+                replay->frame_count - 1, frame_ms, update_ms, present_ms);
+    }
+}
+
+u64 fc_pixelbuffer_checksum(ApplicationState* application_state)
+{
+    // 64-bit FNV-1a over the pixels
+    u64 hash = 0xcbf29ce484222325ull;
+    u64 pixel_count = (u64)application_state->width_px * application_state->height_px;
+    for (u64 i = 0; i < pixel_count; ++i) {
+        hash ^= application_state->pixelbuffer[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+void fc_replay_deinit(FcReplay* replay, ApplicationState* application_state)
+{
+    if (replay->mode == FC_REPLAY_MODE_PLAYBACK && replay->frame_count > 0) {
+        char checksum[32];
+        u64_to_string_null_terminated(fc_pixelbuffer_checksum(application_state),
+                                      checksum, sizeof(checksum), 16);
+        FC_ENGINE_INFO("Replayed %u frames: update avg %f ms (max %f ms), "
+                       "present avg %f ms (max %f ms)",
+                       replay->frame_count,
+                       replay->total_update_ms / replay->frame_count,
+                       replay->max_update_ms,
+                       replay->total_present_ms / replay->frame_count,
+                       replay->max_present_ms);
+        FC_ENGINE_INFO("Final pixelbuffer %ux%u, checksum %s",
+                       application_state->width_px, application_state->height_px,
+                       checksum);
+    }
+    else if (replay->mode == FC_REPLAY_MODE_RECORD) {
+        FC_ENGINE_INFO("Recorded %u frames", replay->frame_count);
+    }
+
+    if (replay->file != NULL) {
+        fclose(replay->file);
+    }
+    if (replay->timings != NULL) {
+        fclose(replay->timings);
+    }
+    *replay = (FcReplay){0};
+}
@@ -0,0 +1,102 @@
+#include "finch/core/stats.h"
+
+#include <math.h>
+
+#define HISTOGRAM_BUCKETS_PER_DOUBLING 4
+
+void fc_histogram_add(FcHistogram* histogram, f64 ms)
+{
+    f64 us = ms * 1000.0;
+    u32 bucket = 0;
+    if (us >= 1.0) {
+        bucket = (u32)(log2(us) * HISTOGRAM_BUCKETS_PER_DOUBLING);
+        if (bucket >= FC_HISTOGRAM_BUCKETS) {
+            bucket = FC_HISTOGRAM_BUCKETS - 1;
+        }
+    }
+
+    histogram->counts[bucket] += 1;
+    histogram->count    += 1;
+    histogram->total_ms += ms;
+    if (ms > histogram->max_ms) {
+        histogram->max_ms = ms;
+    }
+}
+
+f64 fc_histogram_percentile(const FcHistogram* histogram, f64 percentile)
+{
+    if (histogram->count == 0) {
+        return 0.0;
+    }
+
+    u64 rank = (u64)ceil(percentile / 100.0 * histogram->count);
+    rank = rank > 0 ? rank : 1;
+    u64 seen = 0;
+    for (u32 bucket = 0; bucket < FC_HISTOGRAM_BUCKETS; ++bucket) {
+        seen += histogram->counts[bucket];
+        if (seen >= rank) {
+            f64 upper_ms = exp2((f64)(bucket + 1) / HISTOGRAM_BUCKETS_PER_DOUBLING) / 1000.0;
+            return upper_ms < histogram->max_ms ? upper_ms : histogram->max_ms;
+        }
+    }
+    return histogram->max_ms;
+}
+
+b32 fc_event_is_input(const FcEvent* event)
+{
+    switch (event->type) {
+        case FC_EVENT_TYPE_BUTTON_PRESSED:
+        case FC_EVENT_TYPE_BUTTON_RELEASED:
+        case FC_EVENT_TYPE_KEY_PRESSED:
+        case FC_EVENT_TYPE_KEY_RELEASED:
+        case FC_EVENT_TYPE_WHEEL_SCROLLED:
+        case FC_EVENT_TYPE_MOUSE_MOVED: {
+            return true;
+        }
+        default: {
+            return false;
+        }
+    }
+}
+
+void fc_frame_stats_record(FcFrameStats* stats, const FcEvent* events, u32 event_count,
+                           f64 update_start_time, f64 present_start_time,
+                           f64 present_end_time, b32 presented)
+{
+    stats->frame_index   += 1;
+    stats->presented      = presented;
+    stats->update_ms      = (present_start_time - update_start_time) * 1000.0;
+    stats->present_ms     = (present_end_time - present_start_time) * 1000.0;
+    stats->input_events   = 0;
+    stats->max_queue_ms   = 0.0;
+    stats->max_latency_ms = 0.0;
+
+    if (!presented) {
+        return;
+    }
+
+    FcLatencyStats* latency = &stats->latency;
+    for (u32 i = 0; i < event_count; ++i) {
+        const FcEvent* event = &events[i];
+        // Played back events were never read from the server
+        if (!fc_event_is_input(event) || event->arrival_time == 0.0) {
+            continue;
+        }
+
+        f64 queue_ms = (update_start_time - event->arrival_time) * 1000.0;
+        f64 total_ms = (present_end_time - event->arrival_time) * 1000.0;
+        fc_histogram_add(&latency->queue,   queue_ms);
+        fc_histogram_add(&latency->update,  stats->update_ms);
+        fc_histogram_add(&latency->present, stats->present_ms);
+        fc_histogram_add(&latency->total,   total_ms);
+
+        u32 delivery_ms = (u32)(u64)(event->arrival_time * 1000.0) - event->server_time_ms;
+        if (event->server_time_ms != 0 && delivery_ms < 1000) {
+            fc_histogram_add(&latency->delivery, delivery_ms);
+        }
+
+        stats->input_events += 1;
+        if (queue_ms > stats->max_queue_ms)   stats->max_queue_ms   = queue_ms;
+        if (total_ms > stats->max_latency_ms) stats->max_latency_ms = total_ms;
+    }
+}
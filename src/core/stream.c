@@ -0,0 +1,323 @@
+#include "finch/core/stream.h"
+#include "finch/core/memory.h"
+#include "finch/platform/platform.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STREAM_COMPLETION_BATCH 64
+
+typedef struct _StreamReadState {
+    s32   file;
+    u8*   dest;
+    u64   offset;
+    u64   size;
+    u64   submitted;        // Bytes put in flight so far
+    u64   completed;        // Bytes read by completed chunks
+    u32   chunks_in_flight;
+    s32   priority;
+    FcStreamStatus status;  // Failed or canceled reads are reported once nothing is in flight
+    b32   queued;           // Has chunks left to put in flight
+    FcStreamDoneFn done;
+    void* data;
+} StreamReadState;
+
+static b32    initialized;
+static void*  reader;
+static u32    max_chunks_in_flight;
+static u32    chunks_in_flight;
+static FcPool reads;
+
+// Reads with chunks left, highest priority first and in the order they
+// were queued within a priority
+static FcStreamRead* queue;
+static u32           queue_count;
+
+// Reads that finished without a completion to report them, such as reads
+// canceled before any chunk went out
+static FcStreamRead* finished;
+static u32           finished_count;
+
+static FcStreamStats stats;
+
+static u64 read_tag(FcStreamRead read)
+{
+    return ((u64)read.index << 32) | read.generation;
+}
+
+static FcStreamRead tag_read(u64 tag)
+{
+    return (FcStreamRead){ (u32)(tag >> 32), (u32)tag };
+}
+
+static void queue_insert(FcStreamRead read, s32 priority)
+{
+    u32 position = queue_count;
+    while (position > 0 && FC_POOL_GET(&reads, StreamReadState, queue[position - 1])->priority < priority) {
+        queue[position] = queue[position - 1];
+        position -= 1;
+    }
+    queue[position] = read;
+    queue_count += 1;
+    FC_POOL_GET(&reads, StreamReadState, read)->queued = true;
+}
+
+static void queue_remove(FcStreamRead read)
+{
+    u32 position = 0;
+    while (position < queue_count &&
+           (queue[position].index != read.index || queue[position].generation != read.generation)) {
+        position += 1;
+    }
+    if (position == queue_count) {
+        return;
+    }
+    memmove(queue + position, queue + position + 1, (queue_count - position - 1) * sizeof(FcStreamRead));
+    queue_count -= 1;
+    FC_POOL_GET(&reads, StreamReadState, read)->queued = false;
+}
+
+b32 fc_stream_init(u32 count)
+{
+    if (initialized) {
+        return true;
+    }
+    if (count == 0) {
+        const char* env = getenv("FINCH_STREAM_IN_FLIGHT");
+        count = env != NULL && atoi(env) > 0 ? (u32)atoi(env) : 8;
+    }
+
+    queue = (FcStreamRead*)FC_ALLOC(FC_STREAM_MAX_READS * sizeof(FcStreamRead), "stream");
+    finished = (FcStreamRead*)FC_ALLOC(FC_STREAM_MAX_READS * sizeof(FcStreamRead), "stream");
+    b32 pool_ready = FC_POOL_INIT(&reads, StreamReadState, FC_STREAM_MAX_READS, NULL);
+    reader = platform_file_reader_open(count);
+    if (queue == NULL || finished == NULL || !pool_ready || reader == NULL) {
+        FC_ENGINE_ERROR("Could not start streaming");
+        platform_file_reader_close(reader);
+        fc_pool_free(&reads);
+        FC_FREE(queue);
+        FC_FREE(finished);
+        return false;
+    }
+
+    max_chunks_in_flight = count;
+    chunks_in_flight = 0;
+    queue_count = 0;
+    finished_count = 0;
+    stats = (FcStreamStats){0};
+    initialized = true;
+    return true;
+}
+
+void fc_stream_deinit(void)
+{
+    if (!initialized) {
+        return;
+    }
+    for (u32 i = 0; i < reads.capacity; ++i) {
+        if (reads.generations[i] & 1) {
+            platform_file_reader_cancel(reader, read_tag((FcStreamRead){ i, reads.generations[i] }));
+        }
+    }
+    platform_file_reader_submit(reader);
+    platform_file_reader_close(reader);
+    for (u32 i = 0; i < reads.capacity; ++i) {
+        if (reads.generations[i] & 1) {
+            StreamReadState* read = FC_POOL_GET(&reads, StreamReadState,
+                                                ((FcStreamRead){ i, reads.generations[i] }));
+            platform_file_close(read->file);
+        }
+    }
+    fc_pool_free(&reads);
+    FC_FREE(queue);
+    FC_FREE(finished);
+    reader = NULL;
+    initialized = false;
+}
+
+FcStreamRead fc_stream_read(const char* path, u64 offset, u64 size, void* dest,
+                            s32 priority, FcStreamDoneFn done, void* data)
+{
+    if (!fc_stream_init(0)) {
+        return (FcStreamRead){0};
+    }
+
+    u64 file_size = 0;
+    s32 file = platform_file_open_read(path, &file_size);
+    if (file < 0 || offset > file_size || size > file_size - offset) {
+        FC_ENGINE_ERROR("Cannot stream %u bytes at %u of '%s'",
+                        (u32)size, (u32)offset, (char*)path);
+        platform_file_close(file);
+        return (FcStreamRead){0};
+    }
+
+    FcStreamRead handle = fc_pool_acquire(&reads);
+    if (!fc_pool_handle_is_valid(handle)) {
+        FC_ENGINE_WARN_PER_SECOND(1, "More than %u reads queued", FC_STREAM_MAX_READS);
+        platform_file_close(file);
+        return (FcStreamRead){0};
+    }
+    *FC_POOL_GET(&reads, StreamReadState, handle) = (StreamReadState){
+        .file     = file,
+        .dest     = (u8*)dest,
+        .offset   = offset,
+        .size     = size,
+        .priority = priority,
+        .status   = FC_STREAM_STATUS_PENDING,
+        .done     = done,
+        .data     = data
+    };
+    if (size > 0) {
+        queue_insert(handle, priority);
+    } else {
+        finished[finished_count++] = handle;
+    }
+    return handle;
+}
+
+b32 fc_stream_cancel(FcStreamRead handle)
+{
+    StreamReadState* read = initialized ? FC_POOL_GET(&reads, StreamReadState, handle) : NULL;
+    if (read == NULL || read->status != FC_STREAM_STATUS_PENDING) {
+        return false;
+    }
+    read->status = FC_STREAM_STATUS_CANCELED;
+    if (read->chunks_in_flight > 0) {
+        platform_file_reader_cancel(reader, read_tag(handle));
+    } else if (read->queued) {
+        finished[finished_count++] = handle;
+    }
+    // Otherwise it is empty and already waits to be reported
+    if (read->queued) {
+        queue_remove(handle);
+    }
+    return true;
+}
+
+b32 fc_stream_set_priority(FcStreamRead handle, s32 priority)
+{
+    StreamReadState* read = initialized ? FC_POOL_GET(&reads, StreamReadState, handle) : NULL;
+    if (read == NULL) {
+        return false;
+    }
+    read->priority = priority;
+    if (read->queued) {
+        queue_remove(handle);
+        queue_insert(handle, priority);
+    }
+    return true;
+}
+
+FcStreamStatus fc_stream_get_status(FcStreamRead handle)
+{
+    StreamReadState* read = initialized ? FC_POOL_GET(&reads, StreamReadState, handle) : NULL;
+    return read != NULL ? FC_STREAM_STATUS_PENDING : FC_STREAM_STATUS_NONE;
+}
+
+static void report(FcStreamRead handle)
+{
+    StreamReadState* read = FC_POOL_GET(&reads, StreamReadState, handle);
+    FcStreamStatus status = read->status;
+    if (status == FC_STREAM_STATUS_PENDING) {
+        status = read->completed == read->size ? FC_STREAM_STATUS_DONE : FC_STREAM_STATUS_FAILED;
+    }
+    switch (status) {
+        case FC_STREAM_STATUS_DONE:     stats.reads_done     += 1; break;
+        case FC_STREAM_STATUS_CANCELED: stats.reads_canceled += 1; break;
+        default:                        stats.reads_failed   += 1; break;
+    }
+
+    // Released first, so the callback may queue reads in its place
+    FcStreamDoneFn done = read->done;
+    void* data = read->data;
+    platform_file_close(read->file);
+    fc_pool_release(&reads, handle);
+    if (done != NULL) {
+        done(handle, status, data);
+    }
+}
+
+static void complete_chunk(const FcStreamCompletion* completion)
+{
+    chunks_in_flight -= 1;
+    FcStreamRead handle = tag_read(completion->tag);
+    StreamReadState* read = FC_POOL_GET(&reads, StreamReadState, handle);
+    if (read == NULL) {
+        return;
+    }
+    read->chunks_in_flight -= 1;
+
+    if (completion->result >= 0) {
+        read->completed += (u64)completion->result;
+        stats.bytes_read += (u64)completion->result;
+    } else if (read->status == FC_STREAM_STATUS_PENDING) {
+        FC_ENGINE_ERROR("Streaming read failed: %s", (char*)strerror((int)-completion->result));
+        read->status = FC_STREAM_STATUS_FAILED;
+        if (read->queued) {
+            queue_remove(handle);
+        }
+    }
+
+    // A read left the queue once all of it went out, or when it stopped
+    if (read->chunks_in_flight == 0 && !read->queued) {
+        report(handle);
+    }
+}
+
+void fc_stream_update(void)
+{
+    if (!initialized) {
+        return;
+    }
+    f64 start_time = platform_get_epoch_time();
+
+    FcStreamCompletion completions[STREAM_COMPLETION_BATCH];
+    u32 count;
+    do {
+        count = platform_file_reader_poll(reader, completions, STREAM_COMPLETION_BATCH);
+        for (u32 i = 0; i < count; ++i) {
+            complete_chunk(&completions[i]);
+        }
+    } while (count == STREAM_COMPLETION_BATCH);
+
+    // Reports may queue more, which wait for the next update
+    u32 finished_now = finished_count;
+    for (u32 i = 0; i < finished_now; ++i) {
+        report(finished[i]);
+    }
+    finished_count -= finished_now;
+    memmove(finished, finished + finished_now, finished_count * sizeof(FcStreamRead));
+
+    while (chunks_in_flight < max_chunks_in_flight && queue_count > 0) {
+        FcStreamRead handle = queue[0];
+        StreamReadState* read = FC_POOL_GET(&reads, StreamReadState, handle);
+        u64 remaining = read->size - read->submitted;
+        u64 chunk = remaining < FC_STREAM_CHUNK_SIZE ? remaining : FC_STREAM_CHUNK_SIZE;
+        if (!platform_file_reader_read(reader, read->file, read->dest + read->submitted, chunk,
+                                       read->offset + read->submitted, read_tag(handle))) {
+            break;
+        }
+        read->submitted += chunk;
+        read->chunks_in_flight += 1;
+        chunks_in_flight += 1;
+        if (read->submitted == read->size) {
+            queue_remove(handle);
+        }
+    }
+    platform_file_reader_submit(reader);
+
+    stats.chunks_in_flight = chunks_in_flight;
+    stats.reads_queued = reads.count;
+    stats.last_update_ms = (platform_get_epoch_time() - start_time) * 1000.0;
+    if (stats.last_update_ms > stats.max_update_ms) {
+        stats.max_update_ms = stats.last_update_ms;
+    }
+}
+
+void fc_stream_get_stats(FcStreamStats* out)
+{
+    *out = stats;
+}
@@ -0,0 +1,99 @@
+#include "finch/core/trace.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+#include "finch/platform/platform.h"
+
+#include <stdlib.h>
+
+static const char* event_names[FC_EVENT_TYPE_COUNT] = {
+    [FC_EVENT_TYPE_BUTTON_PRESSED]  = "button_pressed",
+    [FC_EVENT_TYPE_BUTTON_RELEASED] = "button_released",
+    [FC_EVENT_TYPE_KEY_PRESSED]     = "key_pressed",
+    [FC_EVENT_TYPE_KEY_RELEASED]    = "key_released",
+    [FC_EVENT_TYPE_WHEEL_SCROLLED]  = "wheel_scrolled",
+    [FC_EVENT_TYPE_MOUSE_MOVED]     = "mouse_moved",
+};
+
+// Trace timestamps are in microseconds since the trace started
+static f64 trace_us(FcTrace* trace, f64 time)
+{
+    return (time - trace->start_time) * 1000000.0;
+}
+
+static void trace_span(FcTrace* trace, const char* name, u32 thread, f64 start, f64 end)
+{
+    fprintf(trace->file,
+            ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            name, thread, trace_us(trace, start), (end - start) * 1000000.0);
+}
+
+void fc_trace_init(FcTrace* trace)
+{
+    trace->file = NULL;
+    trace->start_time = platform_get_epoch_time();
+
+    char* path = getenv("FINCH_TRACE");
+    if (path == NULL) {
+        return;
+    }
+    trace->file = fopen(path, "w");
+    if (trace->file == NULL) {
+        FC_ENGINE_ERROR("Could not open trace file `%s`", path);
+        return;
+    }
+
+    fprintf(trace->file,
+            "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"frames\"}},\n"
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"input\"}}");
+    FC_ENGINE_INFO("Writing trace to `%s`", path);
+}
+
+void fc_trace_frame(FcTrace* trace, const FcFrameStats* stats,
+                    const FcEvent* events, u32 event_count,
+                    f64 update_start_time, f64 present_end_time)
+{
+    if (trace->file == NULL) {
+        return;
+    }
+
+    f64 present_start_time = update_start_time + stats->update_ms / 1000.0;
+    trace_span(trace, "update", 1, update_start_time, present_start_time);
+    if (!stats->presented) {
+        return;
+    }
+    trace_span(trace, "present", 1, present_start_time, present_end_time);
+
+    for (u32 i = 0; i < event_count; ++i) {
+        const FcEvent* event = &events[i];
+        if (!fc_event_is_input(event) || event->arrival_time == 0.0) {
+            continue;
+        }
+        fprintf(trace->file,
+                ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%.3f,\"dur\":%.3f,"
+                "\"args\":{\"frame\":%llu,\"server_time_ms\":%u,\"queue_ms\":%.3f,"
+                "\"update_ms\":%.3f,\"present_ms\":%.3f}}",
+                event_names[event->type], trace_us(trace, event->arrival_time),
+                (present_end_time - event->arrival_time) * 1000000.0,
+                (unsigned long long)stats->frame_index, event->server_time_ms,
+                (update_start_time - event->arrival_time) * 1000.0,
+                stats->update_ms, stats->present_ms);
+    }
+
+    if (stats->input_events > 0) {
+        fprintf(trace->file,
+                ",\n{\"name\":\"input_latency_ms\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,"
+                "\"args\":{\"max\":%.3f}}",
+                trace_us(trace, present_end_time), stats->max_latency_ms);
+    }
+}
+
+void fc_trace_deinit(FcTrace* trace)
+{
+    if (trace->file == NULL) {
+        return;
+    }
+    fprintf(trace->file, "\n]}\n");
+    fclose(trace->file);
+    trace->file = NULL;
+}
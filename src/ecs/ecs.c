@@ -0,0 +1,364 @@
+#include "finch/ecs/ecs.h"
+#include "finch/core/jobs.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+
+#include <string.h>
+
+#define ENTITY_END UINT32_MAX
+
+// Field arrays start on a cache line so systems can use aligned loads
+#define FIELD_ALIGNMENT 64
+
+static void* allocate(FcWorld* world, u64 size, const char* tag)
+{
+    void* memory = FC_ALLOCATOR_ALLOC(&world->allocator, size, FIELD_ALIGNMENT, tag);
+    if (memory == NULL) {
+        FC_ENGINE_ERROR("Failed to allocate %u bytes for %s", (u32)size, (char*)tag);
+    }
+    return memory;
+}
+
+static void release(FcWorld* world, void* memory, u64 size)
+{
+    if (memory != NULL) {
+        FC_ALLOCATOR_FREE(&world->allocator, memory, size);
+    }
+}
+
+b32 fc_world_init(FcWorld* world, u32 max_entities, const FcAllocator* allocator)
+{
+    *world = (FcWorld){
+        .capacity = max_entities,
+        .allocator = allocator != NULL ? *allocator : fc_heap_allocator()
+    };
+    world->generations = allocate(world, (u64)max_entities * sizeof(u32), "ecs_entities");
+    world->next_free = allocate(world, (u64)max_entities * sizeof(u32), "ecs_entities");
+    if (world->generations == NULL || world->next_free == NULL) {
+        fc_world_free(world);
+        return false;
+    }
+    memset(world->generations, 0, (u64)max_entities * sizeof(u32));
+    for (u32 i = 0; i < max_entities; ++i) {
+        world->next_free[i] = i + 1 < max_entities ? i + 1 : ENTITY_END;
+    }
+    world->free_head = max_entities > 0 ? 0 : ENTITY_END;
+    return true;
+}
+
+static void free_component_set(FcWorld* world, FcComponentSet* set)
+{
+    u32 capacity = set->desc.capacity;
+    release(world, set->sparse, (u64)world->capacity * sizeof(u32));
+    release(world, set->entities, (u64)capacity * sizeof(u32));
+    for (u32 i = 0; i < set->desc.field_count; ++i) {
+        release(world, set->fields[i], (u64)capacity * set->desc.field_sizes[i]);
+    }
+}
+
+void fc_world_free(FcWorld* world)
+{
+    for (u32 i = 0; i < world->component_count; ++i) {
+        free_component_set(world, &world->components[i]);
+    }
+    release(world, world->generations, (u64)world->capacity * sizeof(u32));
+    release(world, world->next_free, (u64)world->capacity * sizeof(u32));
+    FcAllocator allocator = world->allocator;
+    *world = (FcWorld){ .allocator = allocator, .free_head = ENTITY_END };
+}
+
+FcComponent fc_world_register_component(FcWorld* world, const FcComponentDesc* desc)
+{
+    if (world->component_count == FC_ECS_MAX_COMPONENTS ||
+        desc->field_count == 0 || desc->field_count > FC_ECS_MAX_FIELDS) {
+        FC_ENGINE_ERROR("Cannot register component %s", (char*)desc->name);
+        return FC_ECS_INVALID;
+    }
+
+    FcComponentSet* set = &world->components[world->component_count];
+    *set = (FcComponentSet){ .desc = *desc, .group = FC_ECS_INVALID };
+    if (set->desc.capacity == 0 || set->desc.capacity > world->capacity) {
+        set->desc.capacity = world->capacity;
+    }
+    u32 capacity = set->desc.capacity;
+
+    set->sparse = allocate(world, (u64)world->capacity * sizeof(u32), "ecs_sparse");
+    set->entities = allocate(world, (u64)capacity * sizeof(u32), "ecs_dense");
+    b32 allocated = set->sparse != NULL && set->entities != NULL;
+    for (u32 i = 0; i < desc->field_count; ++i) {
+        set->fields[i] = allocate(world, (u64)capacity * desc->field_sizes[i], "ecs_fields");
+        allocated = allocated && set->fields[i] != NULL;
+    }
+    if (!allocated) {
+        free_component_set(world, set);
+        return FC_ECS_INVALID;
+    }
+    memset(set->sparse, 0xFF, (u64)world->capacity * sizeof(u32));
+    return world->component_count++;
+}
+
+static inline b32 set_contains(const FcComponentSet* set, u32 entity_index)
+{
+    return set->sparse[entity_index] != FC_ECS_INVALID;
+}
+
+// Exchanges two dense entries, fields included
+static void swap_dense(FcComponentSet* set, u32 a, u32 b)
+{
+    if (a == b) {
+        return;
+    }
+    u32 entity_a = set->entities[a];
+    u32 entity_b = set->entities[b];
+    set->entities[a] = entity_b;
+    set->entities[b] = entity_a;
+    set->sparse[entity_a] = b;
+    set->sparse[entity_b] = a;
+
+    for (u32 i = 0; i < set->desc.field_count; ++i) {
+        u32 size = set->desc.field_sizes[i];
+        u8* field_a = set->fields[i] + (u64)a * size;
+        u8* field_b = set->fields[i] + (u64)b * size;
+        u8 temp[256];
+        while (size > 0) {
+            u32 chunk = size < sizeof(temp) ? size : sizeof(temp);
+            memcpy(temp, field_a, chunk);
+            memcpy(field_a, field_b, chunk);
+            memcpy(field_b, temp, chunk);
+            field_a += chunk;
+            field_b += chunk;
+            size -= chunk;
+        }
+    }
+}
+
+static b32 group_has_all(const FcWorld* world, const FcEcsGroup* group, u32 entity_index)
+{
+    for (u32 i = 0; i < group->component_count; ++i) {
+        if (!set_contains(&world->components[group->components[i]], entity_index)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static b32 group_contains(const FcWorld* world, const FcEcsGroup* group, u32 entity_index)
+{
+    const FcComponentSet* first = &world->components[group->components[0]];
+    return set_contains(first, entity_index) && first->sparse[entity_index] < group->count;
+}
+
+static void group_enter(FcWorld* world, FcEcsGroup* group, u32 entity_index)
+{
+    for (u32 i = 0; i < group->component_count; ++i) {
+        FcComponentSet* set = &world->components[group->components[i]];
+        swap_dense(set, set->sparse[entity_index], group->count);
+    }
+    group->count += 1;
+}
+
+static void group_leave(FcWorld* world, FcEcsGroup* group, u32 entity_index)
+{
+    group->count -= 1;
+    for (u32 i = 0; i < group->component_count; ++i) {
+        FcComponentSet* set = &world->components[group->components[i]];
+        swap_dense(set, set->sparse[entity_index], group->count);
+    }
+}
+
+FcGroup fc_world_create_group(FcWorld* world, const FcComponent* components, u32 count)
+{
+    if (world->group_count == FC_ECS_MAX_GROUPS ||
+        count == 0 || count > FC_ECS_MAX_GROUP_COMPONENTS) {
+        FC_ENGINE_ERROR("Cannot create a group of %u components", count);
+        return FC_ECS_INVALID;
+    }
+    for (u32 i = 0; i < count; ++i) {
+        b32 repeated = false;
+        for (u32 j = 0; j < i; ++j) {
+            repeated = repeated || components[j] == components[i];
+        }
+        if (components[i] >= world->component_count || repeated ||
+            world->components[components[i]].group != FC_ECS_INVALID) {
+            FC_ENGINE_ERROR("Component %u is unknown or already in a group", components[i]);
+            return FC_ECS_INVALID;
+        }
+    }
+
+    FcGroup id = world->group_count++;
+    FcEcsGroup* group = &world->groups[id];
+    *group = (FcEcsGroup){ .component_count = count };
+    for (u32 i = 0; i < count; ++i) {
+        group->components[i] = components[i];
+        world->components[components[i]].group = id;
+    }
+
+    const FcComponentSet* first = &world->components[components[0]];
+    for (u32 i = 0; i < first->count; ++i) {
+        u32 entity_index = first->entities[i];
+        if (group_has_all(world, group, entity_index)) {
+            group_enter(world, group, entity_index);
+        }
+    }
+    return id;
+}
+
+FcEntity fc_entity_create(FcWorld* world)
+{
+    u32 index = world->free_head;
+    if (index == ENTITY_END) {
+        FC_ENGINE_ERROR("World is full (%u entities)", world->capacity);
+        return (FcEntity){0};
+    }
+    world->free_head = world->next_free[index];
+    world->count += 1;
+    return (FcEntity){ .index = index, .generation = ++world->generations[index] };
+}
+
+b32 fc_entity_is_alive(const FcWorld* world, FcEntity entity)
+{
+    return entity.index < world->capacity &&
+        (entity.generation & 1) != 0 &&
+        world->generations[entity.index] == entity.generation;
+}
+
+b32 fc_entity_destroy(FcWorld* world, FcEntity entity)
+{
+    if (!fc_entity_is_alive(world, entity)) {
+        return false;
+    }
+    for (u32 i = 0; i < world->component_count; ++i) {
+        fc_entity_remove(world, entity, i);
+    }
+    world->generations[entity.index] += 1;
+    world->next_free[entity.index] = world->free_head;
+    world->free_head = entity.index;
+    world->count -= 1;
+    return true;
+}
+
+b32 fc_entity_add(FcWorld* world, FcEntity entity, FcComponent component)
+{
+    if (!fc_entity_is_alive(world, entity) || component >= world->component_count) {
+        return false;
+    }
+    FcComponentSet* set = &world->components[component];
+    if (set_contains(set, entity.index)) {
+        return true;
+    }
+    if (set->count == set->desc.capacity) {
+        FC_ENGINE_ERROR("Component %s is full (%u entities)",
+                        (char*)set->desc.name, set->desc.capacity);
+        return false;
+    }
+
+    u32 dense = set->count++;
+    set->entities[dense] = entity.index;
+    set->sparse[entity.index] = dense;
+    for (u32 i = 0; i < set->desc.field_count; ++i) {
+        memset(set->fields[i] + (u64)dense * set->desc.field_sizes[i], 0,
+               set->desc.field_sizes[i]);
+    }
+
+    if (set->group != FC_ECS_INVALID) {
+        FcEcsGroup* group = &world->groups[set->group];
+        if (group_has_all(world, group, entity.index)) {
+            group_enter(world, group, entity.index);
+        }
+    }
+    return true;
+}
+
+b32 fc_entity_remove(FcWorld* world, FcEntity entity, FcComponent component)
+{
+    if (!fc_entity_is_alive(world, entity) || component >= world->component_count) {
+        return false;
+    }
+    FcComponentSet* set = &world->components[component];
+    if (!set_contains(set, entity.index)) {
+        return false;
+    }
+
+    // Leaving the group first moves the entity behind it, where the swap
+    // with the last entry cannot disturb the group
+    if (set->group != FC_ECS_INVALID) {
+        FcEcsGroup* group = &world->groups[set->group];
+        if (group_contains(world, group, entity.index)) {
+            group_leave(world, group, entity.index);
+        }
+    }
+    swap_dense(set, set->sparse[entity.index], set->count - 1);
+    set->count -= 1;
+    set->sparse[entity.index] = FC_ECS_INVALID;
+    return true;
+}
+
+b32 fc_entity_has(const FcWorld* world, FcEntity entity, FcComponent component)
+{
+    return fc_entity_is_alive(world, entity) && component < world->component_count &&
+        set_contains(&world->components[component], entity.index);
+}
+
+void* fc_entity_get_field(const FcWorld* world, FcEntity entity,
+                          FcComponent component, u32 field)
+{
+    if (!fc_entity_has(world, entity, component)) {
+        return NULL;
+    }
+    const FcComponentSet* set = &world->components[component];
+    if (field >= set->desc.field_count) {
+        return NULL;
+    }
+    return set->fields[field] + (u64)set->sparse[entity.index] * set->desc.field_sizes[field];
+}
+
+u32 fc_group_count(const FcWorld* world, FcGroup group)
+{
+    return group < world->group_count ? world->groups[group].count : 0;
+}
+
+typedef struct _SystemRun {
+    FcWorld*   world;
+    FcEcsGroup* group;
+    FcSystemFn system;
+    void*      data;
+} SystemRun;
+
+static void run_range(void* data, u32 begin, u32 end)
+{
+    SystemRun* run = (SystemRun*)data;
+    FcEcsBatch batch;
+    batch.count = end - begin;
+    batch.offset = begin;
+
+    // Within a group every set has the same entity at the same index
+    const FcComponentSet* first = &run->world->components[run->group->components[0]];
+    batch.entities = first->entities + begin;
+    for (u32 c = 0; c < run->group->component_count; ++c) {
+        const FcComponentSet* set = &run->world->components[run->group->components[c]];
+        for (u32 f = 0; f < set->desc.field_count; ++f) {
+            batch.fields[c][f] = set->fields[f] + (u64)begin * set->desc.field_sizes[f];
+        }
+    }
+    run->system(&batch, run->data);
+}
+
+void fc_world_run(FcWorld* world, FcGroup group, FcSystemFn system, void* data,
+                  u32 batch_size, b32 parallel)
+{
+    if (group >= world->group_count || world->groups[group].count == 0) {
+        return;
+    }
+    SystemRun run = { world, &world->groups[group], system, data };
+    u32 count = run.group->count;
+    batch_size = batch_size != 0 ? batch_size : count;
+
+    if (parallel) {
+        fc_jobs_parallel_for(count, batch_size, run_range, &run);
+        return;
+    }
+    for (u32 begin = 0; begin < count; begin += batch_size) {
+        u32 end = begin + batch_size < count ? begin + batch_size : count;
+        run_range(&run, begin, end);
+    }
+}
@@ -1,42 +1,410 @@
 #include "finch/log/log.h"
+#include "finch/core/memory.h"
+#include "finch/log/pattern.h"
 #include "finch/core/core.h"
 #include "finch/platform/platform.h"
 #include "finch/utils/string.h"
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
 #include <time.h>
 
-static char* levels[] = {"OFF", "TRACE", "INFO", "WARN", "ERROR"};
+#define LOG_DEFAULT_BUFFER_SIZE    (64 * 1024)
+#define LOG_DEFAULT_FLUSH_INTERVAL 1.0
+#define LOG_DEFAULT_MAX_FILES      4
+#define LOG_REPEAT_SUMMARY_INTERVAL 1.0
+
+typedef struct _LogSink {
+    FcLogSinkConfig config;
+    FcLogPattern    pattern;
+    char  path[512];
+    char* buffer;
+    u32   used;
+    f64   oldest_line_time;
+    void* file;
+} LogSink;
+
+// The last line written, to recognize repeats of it
+typedef struct _LogRepeat {
+    char*      name;
+    FcLogLevel level;
+    char*      file;
+    u32        line;
+    u64        message_hash;
+    u32        count;      // Repeats not yet summarized
+    f64        first_time; // Of the first of them
+} LogRepeat;
+
+static LogSink   sinks[FC_LOG_MAX_SINKS];
+static u32       sink_count;
+static b32       initialized;
+static LogRepeat last_line;
+static b32       suppress_repeats = true;
+
+// Lines can come from any thread, e.g. the audio mixer. Flushes write,
+// sync and rotate files while holding it, so waiters sleep instead of
+// spinning; it is statically initialized as lines may precede any setup.
+static pthread_mutex_t sinks_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void lock_sinks(void)
+{
+    pthread_mutex_lock(&sinks_lock);
+}
+
+static void unlock_sinks(void)
+{
+    pthread_mutex_unlock(&sinks_lock);
+}
+
+static void sink_open_file(LogSink* sink)
+{
+    sink->file = platform_log_file_open(sink->path, sink->config.sync == FC_LOG_SYNC_DIRECT);
+    if (sink->file == NULL) {
+        // The logger cannot log about itself
+        platform_write_to_stderr("Could not open log file ");
+        platform_write_to_stderr(sink->path);
+        platform_write_to_stderr("\n");
+    }
+}
+
+static void sink_rotate(LogSink* sink)
+{
+    platform_log_file_close(sink->file);
+
+    char from[sizeof(sink->path) + 16];
+    char to[sizeof(sink->path) + 16];
+    for (u32 i = sink->config.max_files; i > 1; --i) {
+        string_format(from, sizeof(from), "%s.%u", sink->path, i - 1);
+        string_format(to,   sizeof(to),   "%s.%u", sink->path, i);
+        platform_rename_file(from, to);
+    }
+    string_format(to, sizeof(to), "%s.1", sink->path);
+    platform_rename_file(sink->path, to);
+
+    sink_open_file(sink);
+}
+
+static void sink_write(LogSink* sink, const char* data, u64 size)
+{
+    if (sink->config.type == FC_LOG_SINK_STDOUT) {
+        platform_write_bytes_to_stdout(data, size);
+        return;
+    }
+    if (sink->file == NULL) {
+        return;
+    }
+
+    platform_log_file_write(sink->file, data, size);
+    if (sink->config.sync == FC_LOG_SYNC_DATA) {
+        platform_log_file_sync(sink->file);
+    }
+}
+
+static void sink_flush(LogSink* sink)
+{
+    if (sink->used > 0) {
+        sink_write(sink, sink->buffer, sink->used);
+        sink->used = 0;
+    }
+}
+
+static void sink_append(LogSink* sink, const char* data, u64 size)
+{
+    // Files are rotated between lines, never splitting one
+    if (sink->file != NULL && sink->config.max_file_size > 0) {
+        u64 file_size = platform_log_file_size(sink->file) + sink->used;
+        if (file_size > 0 && file_size + size > sink->config.max_file_size) {
+            sink_flush(sink);
+            sink_rotate(sink);
+        }
+    }
+    if (sink->used + size > sink->config.buffer_size) {
+        sink_flush(sink);
+    }
+    if (size > sink->config.buffer_size) {
+        sink_write(sink, data, size);
+        return;
+    }
+    memcpy(sink->buffer + sink->used, data, size);
+    sink->used += (u32)size;
+}
+
+static b32 add_sink(const FcLogSinkConfig* config)
+{
+    if (sink_count == FC_LOG_MAX_SINKS) {
+        return false;
+    }
+
+    LogSink* sink = &sinks[sink_count];
+    *sink = (LogSink){ .config = *config };
+    if (sink->config.buffer_size == 0) {
+        sink->config.buffer_size = LOG_DEFAULT_BUFFER_SIZE;
+    }
+    if (sink->config.max_files == 0) {
+        sink->config.max_files = LOG_DEFAULT_MAX_FILES;
+    }
+
+    b32 colors = false;
+    if (config->type == FC_LOG_SINK_STDOUT) {
+        b32 terminal = platform_stdout_is_terminal();
+        colors = terminal && platform_terminal_supports_colors();
+        if (sink->config.flush_interval == 0.0) {
+            // Interactive output is not held back
+            sink->config.flush_interval = terminal ? -1.0 : LOG_DEFAULT_FLUSH_INTERVAL;
+        }
+    } else {
+        if (config->path == NULL) {
+            return false;
+        }
+        string_format(sink->path, sizeof(sink->path), "%s", (char*)config->path);
+        sink->config.path = sink->path;
+        if (sink->config.flush_interval == 0.0) {
+            sink->config.flush_interval = LOG_DEFAULT_FLUSH_INTERVAL;
+        }
+    }
+
+    const char* pattern = config->pattern != NULL ? config->pattern : FC_LOG_DEFAULT_PATTERN;
+    if (!fc_log_pattern_compile(&sink->pattern, pattern, colors)) {
+        return false;
+    }
+    sink->config.pattern = NULL;
+
+    if (config->type == FC_LOG_SINK_FILE) {
+        sink_open_file(sink);
+        if (sink->file == NULL) {
+            return false;
+        }
+    }
+
+    sink->buffer = (char*)FC_ALLOC(sink->config.buffer_size, "log sink");
+    if (sink->buffer == NULL) {
+        platform_write_to_stderr("Could not allocate a log sink buffer\n");
+        if (sink->file != NULL) {
+            platform_log_file_close(sink->file);
+        }
+        return false;
+    }
+    sink_count += 1;
+    return true;
+}
+
+// Renders a line into every sink, with the lock held
+static void write_line(char* name, FcLogLevel level, char* file, u32 line, char* msg,
+                       f64 now, s64 second)
+{
+    char buf[2048];
+    for (u32 i = 0; i < sink_count; ++i) {
+        LogSink* sink = &sinks[i];
+        if (level < sink->config.min_level) {
+            continue;
+        }
+
+        if (sink->used == 0) {
+            sink->oldest_line_time = now;
+        }
+        u32 length = fc_log_pattern_render(&sink->pattern, buf, sizeof(buf), second,
+                                           name, level, file, line, msg);
+        sink_append(sink, buf, length);
+
+        if (sink->config.flush_interval < 0.0 || level >= FC_LOG_LEVEL_ERROR ||
+            now - sink->oldest_line_time >= sink->config.flush_interval) {
+            sink_flush(sink);
+        }
+    }
+}
+
+static void write_repeat_summary(f64 now)
+{
+    if (last_line.count == 0) {
+        return;
+    }
+    char msg[64];
+    string_format(msg, sizeof(msg), "Previous line repeated %u times", last_line.count);
+    last_line.count = 0;
+    write_line(last_line.name, last_line.level, last_line.file, last_line.line, msg,
+               now, (s64)time(NULL));
+}
+
+static void remove_sinks(void)
+{
+    for (u32 i = 0; i < sink_count; ++i) {
+        sink_flush(&sinks[i]);
+        if (sinks[i].file != NULL) {
+            platform_log_file_close(sinks[i].file);
+        }
+        FC_FREE(sinks[i].buffer);
+    }
+    sink_count = 0;
+}
+
+static void flush_at_exit(void)
+{
+    lock_sinks();
+    write_repeat_summary(platform_get_epoch_time());
+    for (u32 i = 0; i < sink_count; ++i) {
+        sink_flush(&sinks[i]);
+    }
+    unlock_sinks();
+}
+
+static void initialize(void)
+{
+    initialized = true;
+    atexit(flush_at_exit);
+
+    FcLogPattern test;
+    char* pattern = getenv("FINCH_LOG_PATTERN");
+    if (pattern != NULL && !fc_log_pattern_compile(&test, pattern, false)) {
+        platform_write_to_stderr("Invalid FINCH_LOG_PATTERN, using the default\n");
+        pattern = NULL;
+    }
+
+    FcLogSinkConfig stdout_config = { .type = FC_LOG_SINK_STDOUT, .pattern = pattern };
+    add_sink(&stdout_config);
+
+    char* path = getenv("FINCH_LOG_FILE");
+    if (path != NULL) {
+        FcLogSinkConfig file_config = {
+            .type          = FC_LOG_SINK_FILE,
+            .pattern       = pattern,
+            .path          = path,
+            .max_file_size = 16 * 1024 * 1024
+        };
+        add_sink(&file_config);
+    }
+}
+
+b32 fc_log_add_sink(const FcLogSinkConfig* config)
+{
+    lock_sinks();
+    if (!initialized) {
+        initialize();
+    }
+    b32 added = add_sink(config);
+    unlock_sinks();
+    return added;
+}
+
+void fc_log_remove_sinks(void)
+{
+    lock_sinks();
+    initialized = true;
+    remove_sinks();
+    unlock_sinks();
+}
+
+void fc_log_flush(void)
+{
+    lock_sinks();
+    write_repeat_summary(platform_get_epoch_time());
+    for (u32 i = 0; i < sink_count; ++i) {
+        sink_flush(&sinks[i]);
+    }
+    unlock_sinks();
+}
+
+void fc_log_update(void)
+{
+    f64 now = platform_get_epoch_time();
+    lock_sinks();
+    if (last_line.count > 0 && now - last_line.first_time >= LOG_REPEAT_SUMMARY_INTERVAL) {
+        write_repeat_summary(now);
+    }
+    for (u32 i = 0; i < sink_count; ++i) {
+        LogSink* sink = &sinks[i];
+        if (sink->used > 0 && now - sink->oldest_line_time >= sink->config.flush_interval) {
+            sink_flush(sink);
+        }
+    }
+    unlock_sinks();
+}
+
+void fc_log_set_suppress_repeats(b32 suppress)
+{
+    lock_sinks();
+    write_repeat_summary(platform_get_epoch_time());
+    suppress_repeats = suppress;
+    last_line = (LogRepeat){0};
+    unlock_sinks();
+}
+
+b32 fc_log_rate_allow(FcLogRateLimit* limit, f64 per_second)
+{
+    f64 now   = platform_get_coarse_time();
+    f64 burst = per_second > 1.0 ? per_second : 1.0;
+    if (limit->last_time == 0.0) {
+        limit->tokens = burst;
+    } else {
+        limit->tokens += (now - limit->last_time) * per_second;
+        limit->tokens  = limit->tokens < burst ? limit->tokens : burst;
+    }
+    limit->last_time = now;
+
+    if (limit->tokens >= 1.0) {
+        limit->tokens -= 1.0;
+        return true;
+    }
+    limit->suppressed += 1;
+    return false;
+}
+
+void fc_logger_log_limited(char* name, FcLogLevel level, char* file, u32 line,
+                           char* msg, FcLogRateLimit* limit)
+{
+    if (limit->suppressed == 0) {
+        fc_logger_log(name, level, file, line, msg);
+        return;
+    }
+
+    char buf[1024 + 64];
+    string_format(buf, sizeof(buf), "%s (%u lines suppressed)", msg, limit->suppressed);
+    limit->suppressed = 0;
+    fc_logger_log(name, level, file, line, buf);
+}
+
+// FNV-1a
+static u64 hash_message(const char* msg)
+{
+    u64 hash = 0xcbf29ce484222325ull;
+    for (; *msg != '\0'; ++msg) {
+        hash = (hash ^ (u8)*msg) * 0x100000001b3ull;
+    }
+    return hash;
+}
 
 void fc_logger_log(char* name, FcLogLevel level,
                    char* file, u32 line, char* msg)
 {
-    FcTerminalColor terminal_colors[] = {
-        FC_TERM_COLOR_WHITE,
-        FC_TERM_COLOR_WHITE,
-        FC_TERM_COLOR_GREEN,
-        FC_TERM_COLOR_ORANGE,
-        FC_TERM_COLOR_RED
-    };
-    platform_set_terminal_color(terminal_colors[level]);
-    
-    char buf[1024] = {0};
-                
-    time_t     now;
-    struct tm  ts;
-    time(&now);
-    
-    ts = *localtime(&now);
-    strftime(buf, sizeof(buf), "%T", &ts);    
-    u32 buf_len = string_length_null_terminated(buf);
-    
-    buf_len = buf_len + string_format(buf + buf_len, sizeof(buf) - buf_len,
-                            " (%s:%u) %s (%s) ", file, line, name, levels[level]);
-    string_copy(buf + buf_len, msg);
-    
-    platform_write_to_stdout(buf);
-    platform_write_to_stdout("\n");
-    
-    platform_set_terminal_color(FC_TERM_COLOR_WHITE);
+    f64 now          = platform_get_epoch_time();
+    s64 second       = (s64)time(NULL);
+    u64 message_hash = hash_message(msg);
+
+    lock_sinks();
+    if (!initialized) {
+        initialize();
+    }
+
+    if (suppress_repeats) {
+        if (last_line.file == file && last_line.line == line && last_line.level == level &&
+            last_line.message_hash == message_hash) {
+            if (last_line.count++ == 0) {
+                last_line.first_time = now;
+            }
+            unlock_sinks();
+            return;
+        }
+        write_repeat_summary(now);
+        last_line = (LogRepeat){
+            .name         = name,
+            .level        = level,
+            .file         = file,
+            .line         = line,
+            .message_hash = message_hash
+        };
+    }
+
+    write_line(name, level, file, line, msg, now, second);
+    unlock_sinks();
 }
@@ -0,0 +1,258 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "finch/log/pattern.h"
+#include "finch/platform/platform.h"
+#include "finch/utils/string.h"
+
+#include <string.h>
+#include <time.h>
+
+static const char* level_names[] = {"OFF", "TRACE", "INFO", "WARN", "ERROR"};
+
+static const FcTerminalColor level_colors[] = {
+    FC_TERM_COLOR_WHITE,
+    FC_TERM_COLOR_WHITE,
+    FC_TERM_COLOR_GREEN,
+    FC_TERM_COLOR_ORANGE,
+    FC_TERM_COLOR_RED
+};
+
+// strftime conversions accepted after %T; the E and O modifiers and the
+// glibc-less %+ are not
+static const char* time_conversions = "aAbBcCdDeFGghHIjklmMnpPrRsStTuUVwWxXyYzZ";
+
+static b32 parse_color(char c, FcTerminalColor* color)
+{
+    switch (c) {
+        case 'k': *color = FC_TERM_COLOR_BLACK;      return true;
+        case 'r': *color = FC_TERM_COLOR_RED;        return true;
+        case 'g': *color = FC_TERM_COLOR_GREEN;      return true;
+        case 'o': *color = FC_TERM_COLOR_ORANGE;     return true;
+        case 'b': *color = FC_TERM_COLOR_BLUE;       return true;
+        case 'p': *color = FC_TERM_COLOR_PURPLE;     return true;
+        case 'c': *color = FC_TERM_COLOR_CYAN;       return true;
+        case 'l': *color = FC_TERM_COLOR_LIGHT_GRAY; return true;
+        case 'n': *color = FC_TERM_COLOR_WHITE;      return true;
+        default:  return false;
+    }
+}
+
+static FcLogOp* last_op(FcLogPattern* pattern)
+{
+    return pattern->op_count > 0 ? &pattern->ops[pattern->op_count - 1] : NULL;
+}
+
+static FcLogOp* push_op(FcLogPattern* pattern, FcLogOpType type)
+{
+    if (pattern->op_count == FC_LOG_PATTERN_MAX_OPS) {
+        return NULL;
+    }
+    FcLogOp* op = &pattern->ops[pattern->op_count++];
+    *op = (FcLogOp){ .type = type };
+    return op;
+}
+
+// Appends to the strftime format of the time op `op`, if there is room
+static b32 append_time_format(FcLogPattern* pattern, FcLogOp* op, char a, char b)
+{
+    FcLogTimeField* field = &pattern->times[op->offset];
+    u32 length = op->length;
+    if (length + 3 > sizeof(field->format)) {
+        return false;
+    }
+    field->format[length++] = a;
+    if (b != '\0') {
+        field->format[length++] = b;
+    }
+    field->format[length] = '\0';
+    op->length = (u16)length;
+    return true;
+}
+
+static b32 push_literal(FcLogPattern* pattern, char c)
+{
+    // Text following a time is formatted (and cached) along with it
+    FcLogOp* op = last_op(pattern);
+    if (op != NULL && op->type == FC_LOG_OP_TIME &&
+        append_time_format(pattern, op, c, c == '%' ? '%' : '\0')) {
+        return true;
+    }
+
+    if (pattern->text_used == FC_LOG_PATTERN_MAX_TEXT) {
+        return false;
+    }
+    if (op == NULL || op->type != FC_LOG_OP_LITERAL) {
+        op = push_op(pattern, FC_LOG_OP_LITERAL);
+        if (op == NULL) {
+            return false;
+        }
+        op->offset = (u16)pattern->text_used;
+    }
+    pattern->text[pattern->text_used++] = c;
+    op->length += 1;
+    return true;
+}
+
+static b32 push_time(FcLogPattern* pattern, char conversion)
+{
+    FcLogOp* op = last_op(pattern);
+    if (op != NULL && op->type == FC_LOG_OP_TIME &&
+        append_time_format(pattern, op, '%', conversion)) {
+        return true;
+    }
+
+    if (pattern->time_count == FC_LOG_PATTERN_MAX_TIMES) {
+        return false;
+    }
+    op = push_op(pattern, FC_LOG_OP_TIME);
+    if (op == NULL) {
+        return false;
+    }
+    op->offset = (u16)pattern->time_count++;
+    pattern->times[op->offset] = (FcLogTimeField){ .second = -1 };
+    return append_time_format(pattern, op, '%', conversion);
+}
+
+b32 fc_log_pattern_compile(FcLogPattern* pattern, const char* source, b32 colors)
+{
+    *pattern = (FcLogPattern){0};
+
+    for (const char* c = source; *c != '\0'; ++c) {
+        if (*c != '%') {
+            if (!push_literal(pattern, *c)) {
+                return false;
+            }
+            continue;
+        }
+
+        char group = c[1];
+        if (group == '%') {
+            if (!push_literal(pattern, '%')) {
+                return false;
+            }
+            c += 1;
+            continue;
+        }
+        char spec = group != '\0' ? c[2] : '\0';
+        if (spec == '\0') {
+            return false;
+        }
+        c += 2;
+
+        FcLogOp* op = NULL;
+        FcTerminalColor color;
+        if (group == 'G' && spec == 'l') {
+            op = push_op(pattern, FC_LOG_OP_LEVEL);
+        } else if (group == 'G' && spec == 'm') {
+            op = push_op(pattern, FC_LOG_OP_MESSAGE);
+        } else if (group == 'G' && spec == 'n') {
+            op = push_op(pattern, FC_LOG_OP_NAME);
+        } else if (group == 'F' && spec == 'n') {
+            op = push_op(pattern, FC_LOG_OP_FILE);
+        } else if (group == 'F' && spec == 'l') {
+            op = push_op(pattern, FC_LOG_OP_LINE);
+        } else if (group == 'C' && spec == 'L') {
+            if (!colors) {
+                continue;
+            }
+            op = push_op(pattern, FC_LOG_OP_LEVEL_COLOR);
+        } else if (group == 'C' && parse_color(spec, &color)) {
+            if (!colors) {
+                continue;
+            }
+            op = push_op(pattern, FC_LOG_OP_COLOR);
+            if (op != NULL) {
+                op->color = color;
+            }
+        } else if (group == 'T' && strchr(time_conversions, spec) != NULL) {
+            if (!push_time(pattern, spec)) {
+                return false;
+            }
+            continue;
+        } else {
+            return false;
+        }
+
+        if (op == NULL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void append(char* dest, u32* length, u32 max_size, const char* str, u32 str_length)
+{
+    u32 room = max_size - 1 - *length;
+    str_length = str_length < room ? str_length : room;
+    memcpy(dest + *length, str, str_length);
+    *length += str_length;
+}
+
+static void append_string(char* dest, u32* length, u32 max_size, const char* str)
+{
+    append(dest, length, max_size, str, (u32)strlen(str));
+}
+
+static void update_time_field(FcLogTimeField* field, s64 second)
+{
+    time_t seconds = (time_t)second;
+    struct tm local_time;
+    localtime_r(&seconds, &local_time);
+    field->length = (u32)strftime(field->text, sizeof(field->text), field->format, &local_time);
+    field->second = second;
+}
+
+u32 fc_log_pattern_render(FcLogPattern* pattern, char* dest, u32 max_size, s64 second,
+                          const char* name, FcLogLevel level,
+                          const char* file, u32 line, const char* msg)
+{
+    u32 length = 0;
+    for (u32 i = 0; i < pattern->op_count; ++i) {
+        FcLogOp* op = &pattern->ops[i];
+        switch (op->type) {
+            case FC_LOG_OP_LITERAL: {
+                append(dest, &length, max_size, pattern->text + op->offset, op->length);
+            } break;
+            case FC_LOG_OP_TIME: {
+                FcLogTimeField* field = &pattern->times[op->offset];
+                if (field->second != second) {
+                    update_time_field(field, second);
+                }
+                append(dest, &length, max_size, field->text, field->length);
+            } break;
+            case FC_LOG_OP_LEVEL: {
+                append_string(dest, &length, max_size, level_names[level]);
+            } break;
+            case FC_LOG_OP_LEVEL_COLOR: {
+                append_string(dest, &length, max_size,
+                              platform_get_terminal_color_code(level_colors[level]));
+            } break;
+            case FC_LOG_OP_COLOR: {
+                append_string(dest, &length, max_size,
+                              platform_get_terminal_color_code(op->color));
+            } break;
+            case FC_LOG_OP_MESSAGE: {
+                append_string(dest, &length, max_size, msg);
+            } break;
+            case FC_LOG_OP_NAME: {
+                append_string(dest, &length, max_size, name);
+            } break;
+            case FC_LOG_OP_FILE: {
+                append_string(dest, &length, max_size, file);
+            } break;
+            case FC_LOG_OP_LINE: {
+                char digits[16];
+                u32 digit_count = u64_to_string_null_terminated(line, digits, sizeof(digits), 10);
+                append(dest, &length, max_size, digits, digit_count);
+            } break;
+        }
+    }
+
+    // The newline survives truncation
+    if (length == max_size - 1) {
+        length -= 1;
+    }
+    dest[length++] = '\n';
+    dest[length] = '\0';
+    return length;
+}
@@ -0,0 +1,124 @@
+#include "finch/platform/cpu.h"
+#include "finch/log/log.h"
+#include "finch/utils/string.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+static const char* feature_names[FC_CPU_FEATURE_COUNT] = {
+    "sse2", "sse4.1", "avx2", "avx512", "bmi2"
+};
+
+static u32 cpu_features = 0;
+
+static u32 detect_features(void)
+{
+    u32 features = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return 0;
+    }
+
+    if (edx & bit_SSE2)   features |= FC_CPU_FEATURE_SSE2;
+    if (ecx & bit_SSE4_1) features |= FC_CPU_FEATURE_SSE41;
+
+    // AVX state must be enabled by the OS, not just supported by the CPU
+    b32 os_saves_ymm = false;
+    b32 os_saves_zmm = false;
+    if ((ecx & bit_OSXSAVE) && (ecx & bit_AVX)) {
+        u32 xcr0_low, xcr0_high;
+        __asm__ volatile ("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+        os_saves_ymm = (xcr0_low & 0x06) == 0x06;
+        os_saves_zmm = (xcr0_low & 0xE6) == 0xE6;
+    }
+
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        if ((ebx & bit_AVX2) && os_saves_ymm) {
+            features |= FC_CPU_FEATURE_AVX2;
+        }
+        if ((ebx & bit_AVX512F) && (ebx & bit_AVX512BW) && os_saves_zmm) {
+            features |= FC_CPU_FEATURE_AVX512;
+        }
+        if (ebx & bit_BMI2) {
+            features |= FC_CPU_FEATURE_BMI2;
+        }
+    }
+#endif
+
+    return features;
+}
+
+static u32 parse_feature_list(const char* list)
+{
+    u32 features = 0;
+    while (*list) {
+        u32 length = 0;
+        while (list[length] && list[length] != ',') {
+            length += 1;
+        }
+
+        b32 found = length == 4 && strncmp(list, "none", 4) == 0;
+        for (u32 i = 0; i < FC_CPU_FEATURE_COUNT; ++i) {
+            if (strlen(feature_names[i]) == length &&
+                strncmp(list, feature_names[i], length) == 0) {
+                features |= 1u << i;
+                found = true;
+            }
+        }
+        if (!found) {
+            FC_ENGINE_WARN("Unknown CPU feature in FINCH_CPU_FEATURES: '%s'", list);
+        }
+
+        list += length;
+        if (*list == ',') {
+            list += 1;
+        }
+    }
+    return features;
+}
+
+void platform_cpu_init(void)
+{
+    u32 detected = detect_features();
+    cpu_features = detected;
+
+    const char* override = getenv("FINCH_CPU_FEATURES");
+    if (override != NULL) {
+        u32 requested = parse_feature_list(override);
+        if (requested & ~detected) {
+            FC_ENGINE_WARN("Ignoring CPU features not supported by this host");
+        }
+        cpu_features = requested & detected;
+    }
+
+    char buf[128] = {0};
+    u32 length = 0;
+    for (u32 i = 0; i < FC_CPU_FEATURE_COUNT; ++i) {
+        if (cpu_features & (1u << i)) {
+            length += string_format(buf + length, sizeof(buf) - length,
+                                    " %s", feature_names[i]);
+        }
+    }
+    FC_ENGINE_TRACE("CPU features:%s", length > 0 ? buf : " none");
+}
+
+u32 platform_get_cpu_features(void)
+{
+    return cpu_features;
+}
+
+const char* platform_get_cpu_feature_name(FcCpuFeature feature)
+{
+    for (u32 i = 0; i < FC_CPU_FEATURE_COUNT; ++i) {
+        if (feature == (FcCpuFeature)(1u << i)) {
+            return feature_names[i];
+        }
+    }
+    return "unknown";
+}
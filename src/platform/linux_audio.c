@@ -0,0 +1,234 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include "finch/core/core.h"
+#include "finch/core/memory.h"
+#include "finch/utils/string.h"
+#include "finch/audio/audio.h"
+#include "finch/log/log.h"
+#include "finch/platform/platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// libasound is loaded at runtime so that neither its headers nor the
+// library are needed to build, only declarations of the few functions used
+#define ALSA_STREAM_PLAYBACK       0
+#define ALSA_FORMAT_FLOAT_LE       14
+#define ALSA_ACCESS_RW_INTERLEAVED 3
+
+typedef struct _AlsaApi {
+    void* library;
+    int   (*pcm_open)(void** pcm, const char* name, int stream, int mode);
+    int   (*pcm_set_params)(void* pcm, int format, int access, unsigned int channels,
+                            unsigned int rate, int soft_resample, unsigned int latency_us);
+    long  (*pcm_writei)(void* pcm, const void* buffer, unsigned long size);
+    int   (*pcm_recover)(void* pcm, int err, int silent);
+    int   (*pcm_close)(void* pcm);
+    const char* (*strerror)(int errnum);
+} AlsaApi;
+
+typedef struct _LinuxAudioSink {
+    FcAudioSinkType type;
+    u32 sample_rate;
+    u32 frames_per_buffer;
+
+    // Device
+    AlsaApi alsa;
+    void*   pcm;
+
+    // File and null sinks consume one buffer per buffer duration
+    f64 next_deadline;
+    int fd;
+    u64 bytes_written;
+} LinuxAudioSink;
+
+static b32 alsa_load(AlsaApi* alsa)
+{
+    alsa->library = dlopen("libasound.so.2", RTLD_NOW | RTLD_LOCAL);
+    if (alsa->library == NULL) {
+        return false;
+    }
+
+    *(void**)&alsa->pcm_open       = dlsym(alsa->library, "snd_pcm_open");
+    *(void**)&alsa->pcm_set_params = dlsym(alsa->library, "snd_pcm_set_params");
+    *(void**)&alsa->pcm_writei     = dlsym(alsa->library, "snd_pcm_writei");
+    *(void**)&alsa->pcm_recover    = dlsym(alsa->library, "snd_pcm_recover");
+    *(void**)&alsa->pcm_close      = dlsym(alsa->library, "snd_pcm_close");
+    *(void**)&alsa->strerror       = dlsym(alsa->library, "snd_strerror");
+    if (!alsa->pcm_open || !alsa->pcm_set_params || !alsa->pcm_writei ||
+        !alsa->pcm_recover || !alsa->pcm_close || !alsa->strerror) {
+        dlclose(alsa->library);
+        alsa->library = NULL;
+        return false;
+    }
+    return true;
+}
+
+static b32 alsa_open(LinuxAudioSink* sink)
+{
+    if (!alsa_load(&sink->alsa)) {
+        FC_ENGINE_WARN("Could not load libasound.so.2, using the null audio sink");
+        return false;
+    }
+
+    int error = sink->alsa.pcm_open(&sink->pcm, "default", ALSA_STREAM_PLAYBACK, 0);
+    if (error < 0) {
+        FC_ENGINE_WARN("Could not open audio device: %s, using the null audio sink",
+                       sink->alsa.strerror(error));
+        dlclose(sink->alsa.library);
+        return false;
+    }
+
+    // Two buffers of latency: one playing while the next is mixed
+    u32 latency_us = (u32)(2ull * sink->frames_per_buffer * 1000000ull / sink->sample_rate);
+    error = sink->alsa.pcm_set_params(sink->pcm, ALSA_FORMAT_FLOAT_LE, ALSA_ACCESS_RW_INTERLEAVED,
+                                      FC_AUDIO_CHANNELS, sink->sample_rate, 1, latency_us);
+    if (error < 0) {
+        FC_ENGINE_WARN("Could not configure audio device: %s, using the null audio sink",
+                       sink->alsa.strerror(error));
+        sink->alsa.pcm_close(sink->pcm);
+        dlclose(sink->alsa.library);
+        return false;
+    }
+    return true;
+}
+
+static b32 alsa_write(LinuxAudioSink* sink, const f32* frames, u32 frame_count)
+{
+    b32 underrun = false;
+    while (frame_count > 0) {
+        long written = sink->alsa.pcm_writei(sink->pcm, frames, frame_count);
+        if (written < 0) {
+            if (written == -EPIPE) {
+                underrun = true;
+            }
+            if (sink->alsa.pcm_recover(sink->pcm, (int)written, 1) < 0) {
+                FC_ENGINE_ERROR("Audio device failed: %s", sink->alsa.strerror((int)written));
+                return false;
+            }
+            continue;
+        }
+        frames      += written * FC_AUDIO_CHANNELS;
+        frame_count -= (u32)written;
+    }
+    return !underrun;
+}
+
+// Canonical 44 byte header of a WAV file with IEEE float samples, the sizes
+// are patched in when the file is closed
+static void wav_write_header(LinuxAudioSink* sink)
+{
+    u32 data_size   = (u32)sink->bytes_written;
+    u32 riff_size   = 36 + data_size;
+    u16 format      = 3;
+    u16 channels    = FC_AUDIO_CHANNELS;
+    u32 byte_rate   = sink->sample_rate * FC_AUDIO_CHANNELS * sizeof(f32);
+    u16 block_align = FC_AUDIO_CHANNELS * sizeof(f32);
+    u16 bits        = 32;
+    u32 fmt_size    = 16;
+
+    u8 header[44];
+    memcpy(header + 0,  "RIFF", 4);
+    memcpy(header + 4,  &riff_size, 4);
+    memcpy(header + 8,  "WAVEfmt ", 8);
+    memcpy(header + 16, &fmt_size, 4);
+    memcpy(header + 20, &format, 2);
+    memcpy(header + 22, &channels, 2);
+    memcpy(header + 24, &sink->sample_rate, 4);
+    memcpy(header + 28, &byte_rate, 4);
+    memcpy(header + 32, &block_align, 2);
+    memcpy(header + 34, &bits, 2);
+    memcpy(header + 36, "data", 4);
+    memcpy(header + 40, &data_size, 4);
+
+    if (pwrite(sink->fd, header, sizeof(header), 0) != sizeof(header)) {
+        FC_ENGINE_ERROR("Could not write WAV header: %s", strerror(errno));
+    }
+}
+
+// Stands in for a device: blocks until the previous buffer would have been
+// played, and reports an underrun when the buffer arrives too late
+static b32 paced_write(LinuxAudioSink* sink)
+{
+    f64 buffer_duration = (f64)sink->frames_per_buffer / sink->sample_rate;
+    f64 now = platform_get_epoch_time();
+
+    if (sink->next_deadline == 0.0) {
+        sink->next_deadline = now;
+    }
+    if (now > sink->next_deadline + buffer_duration) {
+        sink->next_deadline = now + buffer_duration;
+        return false;
+    }
+    if (now < sink->next_deadline) {
+        platform_sleep(sink->next_deadline - now);
+    }
+    sink->next_deadline += buffer_duration;
+    return true;
+}
+
+void* platform_audio_open(const FcAudioConfig* config)
+{
+    LinuxAudioSink* sink = (LinuxAudioSink*)FC_ALLOC_ZEROED(sizeof(LinuxAudioSink), "audio sink");
+    sink->type              = config->sink;
+    sink->sample_rate       = config->sample_rate;
+    sink->frames_per_buffer = config->frames_per_buffer;
+    sink->fd                = -1;
+
+    if (sink->type == FC_AUDIO_SINK_DEVICE && !alsa_open(sink)) {
+        sink->type = FC_AUDIO_SINK_NULL;
+    }
+
+    if (sink->type == FC_AUDIO_SINK_FILE) {
+        const char* path = config->file_path != NULL ? config->file_path : "finch_audio.wav";
+        sink->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (sink->fd < 0) {
+            FC_ENGINE_ERROR("Could not open audio file `%s`: %s", path, strerror(errno));
+            FC_FREE(sink);
+            return NULL;
+        }
+        wav_write_header(sink);
+        FC_ENGINE_INFO("Writing audio to `%s`", path);
+    }
+
+    return sink;
+}
+
+b32 platform_audio_write(void* sink_handle, const f32* frames, u32 frame_count)
+{
+    LinuxAudioSink* sink = (LinuxAudioSink*)sink_handle;
+    switch (sink->type) {
+        case FC_AUDIO_SINK_DEVICE: {
+            return alsa_write(sink, frames, frame_count);
+        }
+        case FC_AUDIO_SINK_FILE: {
+            u64 size = (u64)frame_count * FC_AUDIO_CHANNELS * sizeof(f32);
+            if (pwrite(sink->fd, frames, size, 44 + sink->bytes_written) == (ssize_t)size) {
+                sink->bytes_written += size;
+            }
+            return paced_write(sink);
+        }
+        default: {
+            return paced_write(sink);
+        }
+    }
+}
+
+void platform_audio_close(void* sink_handle)
+{
+    LinuxAudioSink* sink = (LinuxAudioSink*)sink_handle;
+    if (sink->type == FC_AUDIO_SINK_DEVICE) {
+        sink->alsa.pcm_close(sink->pcm);
+        dlclose(sink->alsa.library);
+    }
+    if (sink->fd >= 0) {
+        wav_write_header(sink);
+        close(sink->fd);
+    }
+    FC_FREE(sink);
+}
@@ -1,20 +1,59 @@
-#define _POSIX_C_SOURCE 199309L
+// Xlib window backend, the default. Building with FINCH_PLATFORM=xcb uses
+// linux_xcb.c instead.
+#ifndef FINCH_PLATFORM_XCB
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
 
 #include <X11/Xlib.h>
+#include <X11/Xlibint.h>
 #include <X11/Xutil.h>
 #include <X11/Xos.h>
+#include <X11/extensions/XShm.h>
+#include <X11/extensions/Xge.h>
+#include <X11/extensions/presentproto.h>
 
 #include "finch/core/core.h"
+#include "finch/core/memory.h"
 #include "finch/utils/string.h"
 #include "finch/core/events.h"
 #include "finch/application/application.h"
 
 #include "finch/log/log.h"
+#include "finch/platform/cpu.h"
+#include "finch/platform/platform.h"
+#include "finch/render/kernels.h"
+#include "finch/render/raster.h"
+#include "linux_window.h"
 
 #include <stdlib.h>
 #include <errno.h>
+#include <poll.h>
+#include <sys/shm.h>
+
+#define X11_PRESENT_BUFFER_COUNT 3
+
+typedef struct _X11PresentBuffer {
+    XShmSegmentInfo shm;
+    Pixmap pixmap;
+    u32    width, height;
+    b32    busy; // Presented and not idle yet
+} X11PresentBuffer;
+
+typedef struct _X11Present {
+    b32 enabled;
+    int opcode;
+    XID event_id;
+    X11PresentBuffer buffers[X11_PRESENT_BUFFER_COUNT];
 
-static s32 terminal_supports_colors = -1;
+    u32 serial;           // Of the last present
+    u32 completed_serial; // Of the last CompleteNotify
+    u64 target_msc;
+    u64 last_msc, last_ust;
+    f64 request_time;
+
+    FcPresentStats stats;
+} X11Present;
 
 typedef struct _X11State {
     Display *display;
@@ -23,7 +62,17 @@ typedef struct _X11State {
     GC       gc;
     Atom     wm_delete_window;
 
-    WindowAttributes window_attributes;
+    Visual* visual;
+    int     depth;
+    int     bits_per_pixel;
+
+    // XImage describing the frame for XPutImage, kept while the data it
+    // points to and the frame size stay the same
+    XImage* image;
+
+    X11Present present;
+
+    LinuxWindow linux_window;
 } X11State;
 
 static void x11_init(X11State* x11_state)
@@ -38,12 +87,12 @@ static void x11_init(X11State* x11_state)
     x11_state->window = XCreateSimpleWindow(x11_state->display,
                                             XDefaultRootWindow(x11_state->display),
                                             0, 0,
-                                            x11_state->window_attributes.width,
-                                            x11_state->window_attributes.height,
+                                            x11_state->linux_window.attributes.width,
+                                            x11_state->linux_window.attributes.height,
                                             0, 0,
                                             WhitePixel(x11_state->display, x11_state->screen));
 
-    XStoreName(x11_state->display, x11_state->window, x11_state->window_attributes.title);
+    XStoreName(x11_state->display, x11_state->window, x11_state->linux_window.attributes.title);
     x11_state->gc = XCreateGC(x11_state->display, x11_state->window, 0, NULL);
 
     x11_state->wm_delete_window = XInternAtom(x11_state->display,
@@ -59,50 +108,426 @@ static void x11_init(X11State* x11_state)
     XMapWindow(x11_state->display, x11_state->window);
 }
 
-static void x11_deinit(X11State* x11_state)
+// Finds the window's visual and the bits per pixel of its depth
+static void x11_query_pixel_format(X11State* x11_state)
 {
-    XFreeGC(x11_state->display, x11_state->gc);
-	XDestroyWindow(x11_state->display, x11_state->window);
-    XCloseDisplay(x11_state->display);
+    x11_state->visual = DefaultVisual(x11_state->display, x11_state->screen);
+    x11_state->depth  = DefaultDepth(x11_state->display, x11_state->screen);
+    if (x11_state->visual->class != TrueColor && x11_state->visual->class != DirectColor) {
+        FC_ENGINE_ERROR("Unsupported visual class %d, need TrueColor",
+                        x11_state->visual->class);
+        exit(EXIT_FAILURE);
+    }
+
+    x11_state->bits_per_pixel = 0;
+    int format_count;
+    XPixmapFormatValues* formats = XListPixmapFormats(x11_state->display, &format_count);
+    for (int i = 0; i < format_count; ++i) {
+        if (formats[i].depth == x11_state->depth) {
+            x11_state->bits_per_pixel = formats[i].bits_per_pixel;
+        }
+    }
+    XFree(formats);
+
+    linux_window_set_native_format(&x11_state->linux_window,
+                                   (u32)x11_state->visual->red_mask,
+                                   (u32)x11_state->visual->green_mask,
+                                   (u32)x11_state->visual->blue_mask,
+                                   (u32)x11_state->depth, (u32)x11_state->bits_per_pixel,
+                                   ImageByteOrder(x11_state->display) == LSBFirst);
 }
 
-static void x11_put_pixelbuffer_on_screen(X11State* x11_state, ApplicationState* application_state)
+//
+// X Present path: frames are copied into shm-backed pixmaps and presented
+// at vblank with PresentPixmap. CompleteNotify paces the main loop to the
+// display, IdleNotify hands pixmaps back for reuse. The extension has no
+// Xlib binding here, so requests are encoded from the protocol headers.
+//
+
+#define X11_PRESENT_COMPLETE_TIMEOUT 0.5 // Seconds before giving up on Present
+
+static b32 x11_error_trapped;
+
+static int x11_trap_error(Display* display, XErrorEvent* error)
 {
-    XWindowAttributes window_attributes;
-    XGetWindowAttributes(x11_state->display, x11_state->window, &window_attributes);
-    
-    XImage* img = XCreateImage(x11_state->display,
-                               window_attributes.visual, window_attributes.depth,
-                               ZPixmap, 0, (char*)application_state->pixelbuffer,
-                               application_state->width_px, application_state->height_px,
-                               32, application_state->width_px * sizeof(application_state->pixelbuffer[0]));
+    (void)display;
+    (void)error;
+    x11_error_trapped = true;
+    return 0;
+}
 
-    XPutImage(x11_state->display, x11_state->window,
-              x11_state->gc, img,
-              0, 0,
-              0, 0,
-              application_state->width_px,
-              application_state->height_px);
+static Bool x11_present_is_event(Display* display, XEvent* event, XPointer arg)
+{
+    (void)display;
+    X11State* x11_state = (X11State*)arg;
+    return event->type == GenericEvent &&
+           event->xcookie.extension == x11_state->present.opcode;
+}
+
+// Keeps the raw wire event, which is parsed with the protocol structs
+static Bool x11_present_wire_to_cookie(Display* display, XGenericEventCookie* cookie,
+                                       xEvent* wire)
+{
+    xGenericEvent* generic = (xGenericEvent*)wire;
+    u64 size = sizeof(xEvent) + (u64)generic->length * 4;
+
+    cookie->type       = generic->type & 0x7F;
+    cookie->serial     = _XSetLastRequestRead(display, (xGenericReply*)wire);
+    cookie->send_event = (generic->type & 0x80) != 0;
+    cookie->display    = display;
+    cookie->extension  = generic->extension;
+    cookie->evtype     = generic->evtype;
+    // Freed by Xlib, so not from the engine allocator
+    cookie->data       = malloc(size);
+    if (cookie->data == NULL) {
+        return False;
+    }
+    memcpy(cookie->data, wire, size);
+    return True;
+}
+
+static void x11_present_handle_event(X11State* x11_state, XGenericEventCookie* cookie)
+{
+    X11Present* present = &x11_state->present;
+    if (!XGetEventData(x11_state->display, cookie)) {
+        return;
+    }
+
+    switch (cookie->evtype) {
+        case PresentCompleteNotify: {
+            xPresentCompleteNotify* complete = (xPresentCompleteNotify*)cookie->data;
+            if (complete->kind != PresentCompleteKindPixmap) {
+                break;
+            }
+            FcPresentStats* stats = &present->stats;
+            switch (complete->mode) {
+                case PresentCompleteModeFlip: stats->flips   += 1; break;
+                case PresentCompleteModeSkip: stats->skipped += 1; break;
+                default:                      stats->copies  += 1; break;
+            }
+            if (present->target_msc != 0 && complete->msc > present->target_msc) {
+                stats->missed += 1;
+            }
+
+            // Vblank interval from the server's clock (UST is in microseconds)
+            if (present->last_msc != 0 && complete->msc > present->last_msc) {
+                f64 refresh_ms = (f64)(complete->ust - present->last_ust) /
+                                 (f64)(complete->msc - present->last_msc) / 1000.0;
+                stats->refresh_ms = stats->refresh_ms == 0.0
+                    ? refresh_ms
+                    : stats->refresh_ms * 0.9 + refresh_ms * 0.1;
+            }
+            present->last_msc = complete->msc;
+            present->last_ust = complete->ust;
+
+            stats->completed += 1;
+            stats->last_complete_ms = (platform_get_epoch_time() - present->request_time) * 1000.0;
+            if (stats->last_complete_ms > stats->max_complete_ms) {
+                stats->max_complete_ms = stats->last_complete_ms;
+            }
+            present->completed_serial = complete->serial;
+        } break;
+        case PresentIdleNotify: {
+            xPresentIdleNotify* idle = (xPresentIdleNotify*)cookie->data;
+            for (u32 i = 0; i < X11_PRESENT_BUFFER_COUNT; ++i) {
+                if (present->buffers[i].pixmap == idle->pixmap) {
+                    present->buffers[i].busy = false;
+                }
+            }
+        } break;
+    }
+    XFreeEventData(x11_state->display, cookie);
 }
 
-static void game_initialize_pixelbuffer(ApplicationState* application_state) {
-    if (application_state->pixelbuffer != NULL) {
-        free(application_state->pixelbuffer);
+static void x11_present_deinit(X11State* x11_state);
+
+// Handles one Present event, waiting for it if none is queued. Falls back
+// to XPutImage if the server stops answering.
+static b32 x11_present_wait_event(X11State* x11_state)
+{
+    f64 deadline = platform_get_epoch_time() + X11_PRESENT_COMPLETE_TIMEOUT;
+    for (;;) {
+        XEvent event;
+        if (XCheckIfEvent(x11_state->display, &event, x11_present_is_event, (XPointer)x11_state)) {
+            x11_present_handle_event(x11_state, &event.xcookie);
+            return true;
+        }
+
+        f64 remaining = deadline - platform_get_epoch_time();
+        if (remaining <= 0.0) {
+            FC_ENGINE_WARN("X Present stopped responding, falling back to XPutImage");
+            x11_present_deinit(x11_state);
+            return false;
+        }
+        XFlush(x11_state->display);
+        struct pollfd connection = {
+            .fd     = ConnectionNumber(x11_state->display),
+            .events = POLLIN
+        };
+        poll(&connection, 1, (int)(remaining * 1000.0) + 1);
     }
-    application_state->pixelbuffer = (u32*)malloc(application_state->width_px * application_state->height_px * sizeof(u32));
 }
 
-static void game_resize(ApplicationState* application_state, u32 new_width, u32 new_height)
+static void x11_present_destroy_buffer(X11State* x11_state, X11PresentBuffer* buffer)
 {
-    application_state->width_px  = new_width;
-    application_state->height_px = new_height;
-    game_initialize_pixelbuffer(application_state);
+    if (buffer->pixmap != None) {
+        XFreePixmap(x11_state->display, buffer->pixmap);
+        XShmDetach(x11_state->display, &buffer->shm);
+        XSync(x11_state->display, False);
+        shmdt(buffer->shm.shmaddr);
+    }
+    memset(buffer, 0, sizeof(X11PresentBuffer));
 }
 
-static void x11_resize_window(X11State* x11_state, u32 new_width, u32 new_height)
+static b32 x11_present_create_buffer(X11State* x11_state, X11PresentBuffer* buffer,
+                                     u32 width, u32 height)
 {
-    x11_state->window_attributes.width  = new_width;
-    x11_state->window_attributes.height = new_height;
+    u64 size = (u64)width * height * (x11_state->bits_per_pixel / 8);
+    buffer->shm.shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+    if (buffer->shm.shmid < 0) {
+        FC_ENGINE_WARN("Could not create shared memory segment: %s", strerror(errno));
+        return false;
+    }
+    buffer->shm.shmaddr = (char*)shmat(buffer->shm.shmid, NULL, 0);
+    // Removed once both sides have detached
+    shmctl(buffer->shm.shmid, IPC_RMID, NULL);
+    if (buffer->shm.shmaddr == (char*)-1) {
+        FC_ENGINE_WARN("Could not attach shared memory segment: %s", strerror(errno));
+        return false;
+    }
+    buffer->shm.readOnly = False;
+
+    // Attaching fails on remote displays, which only shows as an X error
+    int (*previous_handler)(Display*, XErrorEvent*) = XSetErrorHandler(x11_trap_error);
+    x11_error_trapped = false;
+    XShmAttach(x11_state->display, &buffer->shm);
+    XSync(x11_state->display, False);
+    b32 attached = !x11_error_trapped;
+    if (attached) {
+        buffer->pixmap = XShmCreatePixmap(x11_state->display, x11_state->window,
+                                          buffer->shm.shmaddr, &buffer->shm,
+                                          width, height, x11_state->depth);
+        XSync(x11_state->display, False);
+    }
+    XSetErrorHandler(previous_handler);
+    if (x11_error_trapped) {
+        if (attached) {
+            XShmDetach(x11_state->display, &buffer->shm);
+            XSync(x11_state->display, False);
+        }
+        shmdt(buffer->shm.shmaddr);
+        memset(buffer, 0, sizeof(X11PresentBuffer));
+        return false;
+    }
+
+    buffer->width  = width;
+    buffer->height = height;
+    return true;
+}
+
+// Waits for the previous present to complete, then returns an idle buffer
+// of the given size
+static X11PresentBuffer* x11_present_acquire(X11State* x11_state, u32 width, u32 height)
+{
+    X11Present* present = &x11_state->present;
+    f64 wait_start_time = platform_get_epoch_time();
+    while (present->enabled && present->completed_serial != present->serial) {
+        x11_present_wait_event(x11_state);
+    }
+
+    while (present->enabled) {
+        for (u32 i = 0; i < X11_PRESENT_BUFFER_COUNT; ++i) {
+            X11PresentBuffer* buffer = &present->buffers[i];
+            if (buffer->busy) {
+                continue;
+            }
+            if (buffer->pixmap != None && (buffer->width != width || buffer->height != height)) {
+                x11_present_destroy_buffer(x11_state, buffer);
+            }
+            if (buffer->pixmap == None &&
+                !x11_present_create_buffer(x11_state, buffer, width, height)) {
+                FC_ENGINE_WARN("Could not create a shared memory pixmap, "
+                               "falling back to XPutImage");
+                x11_present_deinit(x11_state);
+                return NULL;
+            }
+            present->stats.last_wait_ms = (platform_get_epoch_time() - wait_start_time) * 1000.0;
+            return buffer;
+        }
+        x11_present_wait_event(x11_state);
+    }
+    return NULL;
+}
+
+// Presents at the vblank after the previous present completed
+static void x11_present_pixmap(X11State* x11_state, X11PresentBuffer* buffer)
+{
+    X11Present* present = &x11_state->present;
+    Display* dpy = x11_state->display;
+
+    present->serial    += 1;
+    present->target_msc = present->last_msc != 0 ? present->last_msc + 1 : 0;
+    buffer->busy        = true;
+
+    LockDisplay(dpy);
+    xPresentPixmapReq* req = (xPresentPixmapReq*)_XGetRequest(dpy, X_PresentPixmap,
+                                                              sz_xPresentPixmapReq);
+    req->reqType        = present->opcode;
+    req->presentReqType = X_PresentPixmap;
+    req->window         = x11_state->window;
+    req->pixmap         = buffer->pixmap;
+    req->serial         = present->serial;
+    req->valid          = None;
+    req->update         = None;
+    req->x_off          = 0;
+    req->y_off          = 0;
+    req->target_crtc    = None;
+    req->wait_fence     = None;
+    req->idle_fence     = None;
+    req->options        = PresentOptionNone;
+    req->target_msc     = present->target_msc;
+    req->divisor        = 0;
+    req->remainder      = 0;
+    UnlockDisplay(dpy);
+    SyncHandle();
+
+    present->request_time = platform_get_epoch_time();
+    present->stats.presented += 1;
+    XFlush(dpy);
+}
+
+static void x11_present_init(X11State* x11_state)
+{
+    X11Present* present = &x11_state->present;
+    Display* dpy = x11_state->display;
+    memset(present, 0, sizeof(X11Present));
+
+    char* setting = getenv("FINCH_PRESENT");
+    if (setting != NULL && strcmp(setting, "0") == 0) {
+        return;
+    }
+
+    int major, minor, first_event, first_error;
+    Bool shared_pixmaps = False;
+    if (!XShmQueryVersion(dpy, &major, &minor, &shared_pixmaps) || !shared_pixmaps ||
+        XShmPixmapFormat(dpy) != ZPixmap) {
+        FC_ENGINE_INFO("No MIT-SHM pixmaps, presenting with XPutImage");
+        return;
+    }
+    if (!XQueryExtension(dpy, PRESENT_NAME, &present->opcode, &first_event, &first_error) ||
+        !XGEQueryVersion(dpy, &major, &minor)) {
+        FC_ENGINE_INFO("No X Present extension, presenting with XPutImage");
+        return;
+    }
+
+    LockDisplay(dpy);
+    xPresentQueryVersionReq* version_req = (xPresentQueryVersionReq*)
+        _XGetRequest(dpy, X_PresentQueryVersion, sizeof(xPresentQueryVersionReq));
+    version_req->reqType        = present->opcode;
+    version_req->presentReqType = X_PresentQueryVersion;
+    version_req->majorVersion   = PRESENT_MAJOR;
+    version_req->minorVersion   = PRESENT_MINOR;
+    xPresentQueryVersionReply version_reply;
+    Status status = _XReply(dpy, (xReply*)&version_reply, 0, xTrue);
+    UnlockDisplay(dpy);
+    SyncHandle();
+    if (!status) {
+        FC_ENGINE_INFO("X Present did not answer, presenting with XPutImage");
+        return;
+    }
+
+    XESetWireToEventCookie(dpy, present->opcode, x11_present_wire_to_cookie);
+
+    present->event_id = XAllocID(dpy);
+    LockDisplay(dpy);
+    xPresentSelectInputReq* select_req = (xPresentSelectInputReq*)
+        _XGetRequest(dpy, X_PresentSelectInput, sizeof(xPresentSelectInputReq));
+    select_req->reqType        = present->opcode;
+    select_req->presentReqType = X_PresentSelectInput;
+    select_req->eid            = present->event_id;
+    select_req->window         = x11_state->window;
+    select_req->eventMask      = PresentCompleteNotifyMask | PresentIdleNotifyMask;
+    UnlockDisplay(dpy);
+    SyncHandle();
+
+    present->enabled     = true;
+    present->stats.vsync = true;
+    FC_ENGINE_INFO("Presenting with X Present %u.%u from shared memory pixmaps",
+                   version_reply.majorVersion, version_reply.minorVersion);
+}
+
+static void x11_present_deinit(X11State* x11_state)
+{
+    X11Present* present = &x11_state->present;
+    for (u32 i = 0; i < X11_PRESENT_BUFFER_COUNT; ++i) {
+        x11_present_destroy_buffer(x11_state, &present->buffers[i]);
+    }
+    present->enabled     = false;
+    present->stats.vsync = false;
+}
+
+static void x11_destroy_image(X11State* x11_state)
+{
+    if (x11_state->image != NULL) {
+        // The data belongs to the engine, not the image
+        x11_state->image->data = NULL;
+        XDestroyImage(x11_state->image);
+        x11_state->image = NULL;
+    }
+}
+
+static void x11_deinit(X11State* x11_state)
+{
+    x11_present_deinit(x11_state);
+    x11_destroy_image(x11_state);
+    linux_window_deinit(&x11_state->linux_window);
+    XFreeGC(x11_state->display, x11_state->gc);
+	XDestroyWindow(x11_state->display, x11_state->window);
+    XCloseDisplay(x11_state->display);
+}
+
+static void x11_put_pixelbuffer_on_screen(X11State* x11_state, ApplicationState* application_state)
+{
+    u32 width, height;
+    const u32* pixels = linux_window_scale_pixelbuffer(&x11_state->linux_window,
+                                                       application_state, &width, &height);
+    x11_state->present.stats.last_wait_ms = 0.0;
+
+    // Frames are converted or copied straight into the shared memory of a
+    // present buffer, otherwise they are put with XPutImage from the
+    // pixelbuffer or the converted staging copy
+    X11PresentBuffer* buffer = x11_state->present.enabled
+        ? x11_present_acquire(x11_state, width, height)
+        : NULL;
+    char* data = (char*)linux_window_convert(&x11_state->linux_window, application_state,
+                                             pixels, (u64)width * height,
+                                             buffer != NULL ? buffer->shm.shmaddr : NULL);
+
+    if (buffer != NULL) {
+        x11_present_pixmap(x11_state, buffer);
+        return;
+    }
+    
+    XImage* image = x11_state->image;
+    if (image == NULL || image->data != data ||
+        (u32)image->width != width || (u32)image->height != height) {
+        x11_destroy_image(x11_state);
+        image = XCreateImage(x11_state->display,
+                             x11_state->visual, x11_state->depth,
+                             ZPixmap, 0, data,
+                             width, height,
+                             x11_state->bits_per_pixel,
+                             width * (x11_state->bits_per_pixel / 8));
+        x11_state->image = image;
+    }
+
+    XPutImage(x11_state->display, x11_state->window,
+              x11_state->gc, image,
+              0, 0,
+              0, 0,
+              width,
+              height);
+    x11_state->present.stats.presented += 1;
 }
 
 static void x11_handle_events(X11State* x11_state, ApplicationState* application_state)
@@ -115,123 +540,19 @@ static void x11_handle_events(X11State* x11_state, ApplicationState* application
         
         XEvent e = {0};
         XNextEvent(x11_state->display, &e);
+        finch_event.arrival_time = platform_get_epoch_time();
         
         switch (e.type) {
             case KeyPress: {
-                finch_event.type = FC_EVENT_TYPE_KEY_PRESSED;
                 KeySym key = XLookupKeysym(&e.xkey, 0);
-                FcKey finch_key = FC_KEY_NONE;
-                
-                // Character key
-                if (key >= 'a' && key <= 'z') {
-                    finch_key = (FcKey)(key - 'a' + FC_KEY_A);
-                }
-
-                // Numeric key
-                else if (key >= '0' && key <= '9') {
-                    finch_key = (FcKey)(key - '0' + FC_KEY_0);
-                }
-
-                // Special keys
-                else {
-                    switch (key) {
-                        case 32: {
-                            finch_key = FC_KEY_SPACE;
-                        } break;
-                        case 65507: {
-                            finch_key = FC_KEY_LEFT_CTRL;
-                        } break;
-                        case 65508: {
-                            finch_key = FC_KEY_RIGHT_CTRL;
-                        } break;
-                        case 65505: {
-                            finch_key = FC_KEY_LEFT_SHIFT;
-                        } break;
-                        case 65506: {
-                            finch_key = FC_KEY_RIGHT_SHIFT;
-                        } break;
-                        case 65513: {
-                            finch_key = FC_KEY_LEFT_ALT;
-                        } break;
-                        case 65027: {
-                            finch_key = FC_KEY_RIGHT_ALT;
-                        } break;
-                        case 65289: {
-                            finch_key = FC_KEY_TAB;
-                        } break;
-                        case 65307: {
-                            finch_key = FC_KEY_ESC;
-                        } break;
-                        case 65293: {
-                            finch_key = FC_KEY_ENTER;
-                        } break;
-                        case 65288: {
-                            finch_key = FC_KEY_BACKSPACE;
-                        } break;
-                        case 65509: {
-                            finch_key = FC_KEY_CAPS_LOCK;
-                        } break;                            
-                        case 65362: {
-                            finch_key = FC_KEY_UP;
-                        } break;
-                        case 65364: {
-                            finch_key = FC_KEY_DOWN;
-                        } break;
-                        case 65361: {
-                            finch_key = FC_KEY_LEFT;
-                        } break;
-                        case 65363: {
-                            finch_key = FC_KEY_RIGHT;
-                        } break;
-                        case 65470: {
-                            finch_key = FC_KEY_F1;
-                        } break;
-                        case 65471: {
-                            finch_key = FC_KEY_F2;
-                        } break;
-                        case 65472: {
-                            finch_key = FC_KEY_F3;
-                        } break;
-                        case 65473: {
-                            finch_key = FC_KEY_F4;
-                        } break;
-                        case 65474: {
-                            finch_key = FC_KEY_F5;
-                        } break;
-                        case 65475: {
-                            finch_key = FC_KEY_F6;
-                        } break;
-                        case 65476: {
-                            finch_key = FC_KEY_F7;
-                        } break;
-                        case 65477: {
-                            finch_key = FC_KEY_F8;
-                        } break;
-                        case 65478: {
-                            finch_key = FC_KEY_F9;
-                        } break;
-                        case 65479: {
-                            finch_key = FC_KEY_F10;
-                        } break;
-                        case 65480: {
-                            finch_key = FC_KEY_F11;
-                        } break;
-                        case 65481: {
-                            finch_key = FC_KEY_F12;
-                        } break;
-                        default: {
-                            // Unhandled key
-                            FC_ENGINE_WARN("Unhandled key press event (Key: %d)",
-                                           key);
-                            finch_event.type = FC_EVENT_TYPE_NONE;
-                            finch_key = FC_KEY_NONE;
-                        }
-                    }
+                FcKey finch_key = linux_translate_keysym((u32)key);
+                if (finch_key == FC_KEY_NONE) {
+                    FC_ENGINE_WARN("Unhandled key press event (Key: %u)", (u32)key);
+                    break;
                 }
-                
+                finch_event.type = FC_EVENT_TYPE_KEY_PRESSED;
                 finch_event.key = finch_key;
                 application_state->input_state.key_is_down[finch_key] = true;
-                
             } break;
             case KeyRelease: {
 
@@ -247,168 +568,24 @@ static void x11_handle_events(X11State* x11_state, ApplicationState* application
                         break;
                     }
                 }
-     
-                finch_event.type = FC_EVENT_TYPE_KEY_RELEASED;
-                KeySym key = XLookupKeysym(&e.xkey, 0);
-                FcKey finch_key = FC_KEY_NONE;
-
-                // Character key
-                if (key >= 'a' && key <= 'z') {
-                    finch_key = (FcKey)(key - 'a' + FC_KEY_A);
-                }
 
-                // Numeric key
-                else if (key >= '0' && key <= '9') {
-                    finch_key = (FcKey)(key - '0' + FC_KEY_0);
-                }
-
-                else {
-                    // Special keys
-                    switch (key) {
-                        case 32: {
-                            finch_key = FC_KEY_SPACE;
-                        } break;
-                        case 65507: {
-                            finch_key = FC_KEY_LEFT_CTRL;
-                        } break;
-                        case 65508: {
-                            finch_key = FC_KEY_RIGHT_CTRL;
-                        } break;
-                        case 65505: {
-                            finch_key = FC_KEY_LEFT_SHIFT;
-                        } break;
-                        case 65506: {
-                            finch_key = FC_KEY_RIGHT_SHIFT;
-                        } break;
-                        case 65513: {
-                            finch_key = FC_KEY_LEFT_ALT;
-                        } break;
-                        case 65027: {
-                            finch_key = FC_KEY_RIGHT_ALT;
-                        } break;
-                        case 65289: {
-                            finch_key = FC_KEY_TAB;
-                        } break;
-                        case 65307: {
-                            finch_key = FC_KEY_ESC;
-                        } break;
-                        case 65293: {
-                            finch_key = FC_KEY_ENTER;
-                        } break;
-                        default: {
-                            finch_event.type = FC_EVENT_TYPE_NONE;
-                            finch_key = FC_KEY_NONE;
-                        }
-                    }
+                FcKey finch_key = linux_translate_keysym((u32)XLookupKeysym(&e.xkey, 0));
+                if (finch_key == FC_KEY_NONE) {
+                    break;
                 }
-                
+                finch_event.type = FC_EVENT_TYPE_KEY_RELEASED;
                 finch_event.key = finch_key;
                 application_state->input_state.key_is_down[finch_key] = false;
-                
-            } break;
-            case ButtonPress: {
-                u32 button = e.xbutton.button;
-                FcButton finch_button = FC_BUTTON_NONE;
-                
-                if (button >= 1 && button <= 3) {
-                    finch_event.type = FC_EVENT_TYPE_BUTTON_PRESSED;
-                }
-                
-                else if (button >= 4 && button <= 7) {
-                    finch_event.type = FC_EVENT_TYPE_WHEEL_SCROLLED;
-                }
-                
-                finch_event.mouse_x = e.xbutton.x;                
-                finch_event.mouse_y = e.xbutton.y;
-                
-                switch (button) {
-                    case 1: {
-                        // Left mouse button
-                        finch_button = FC_BUTTON_LEFT;
-                    } break;
-                    case 2: {
-                        // Middle mouse button
-                        finch_button = FC_BUTTON_MIDDLE;
-                    } break;
-                    case 3: {
-                        // Right mouse button
-                        finch_button = FC_BUTTON_RIGHT;
-                    } break;
-                    case 4: {
-                        // Mouse scroll up
-                        finch_event.scroll_wheel_vertical_direction = 1;
-                    } break;
-                    case 5: {
-                        // Mouse scroll down
-                        finch_event.scroll_wheel_vertical_direction = -1;
-                    } break;
-                    case 6: {
-                        // Mouse scroll left
-                        finch_event.scroll_wheel_horizontal_direction = -1;
-                    } break;
-                    case 7: {
-                        // Mouse scroll right
-                        finch_event.scroll_wheel_horizontal_direction = 1;
-                    } break;
-                    default: {
-                        // Unhandled button
-                        finch_event.type = FC_EVENT_TYPE_NONE;
-                        finch_button = FC_BUTTON_NONE;
-                    }
-                }
-
-                finch_event.button = finch_button;
-                application_state->input_state.button_is_down[finch_button] = true;
-                
             } break;
+            case ButtonPress:
             case ButtonRelease: {
-                u32 button = e.xbutton.button;
-
-                // Ignore release events from scrollwheels
-                if (button < 1 || button > 3) {
-                    break;
-                }
-                
-                finch_event.type = FC_EVENT_TYPE_BUTTON_RELEASED;
-                FcButton finch_button = FC_BUTTON_NONE;
-                
-                finch_event.mouse_x = e.xbutton.x;
-                finch_event.mouse_y = e.xbutton.y;
-                
-                switch (button) {
-                    case 1: {
-                        // Left mouse button
-                        finch_button = FC_BUTTON_LEFT;
-                    } break;
-                    case 2: {
-                        // Middlbe mouse button
-                        finch_button = FC_BUTTON_MIDDLE;
-                    } break;
-                    case 3: {
-                        // Right mouse button
-                        finch_button = FC_BUTTON_RIGHT;
-                    } break;
-                }
-
-                finch_event.button = finch_button;
-                application_state->input_state.button_is_down[finch_button] = false;
-                
+                linux_window_handle_button(&x11_state->linux_window, application_state,
+                                           e.xbutton.button, e.xbutton.x, e.xbutton.y,
+                                           e.type == ButtonPress, &finch_event);
             } break;
             case MotionNotify: {
-                finch_event.type = FC_EVENT_TYPE_MOUSE_MOVED;
-                
-                finch_event.mouse_x = e.xbutton.x;
-                application_state->input_state.mouse_dx +=
-                    (e.xbutton.x - application_state->input_state.mouse_x);
-                
-                application_state->input_state.mouse_x = e.xmotion.x;
-                
-                finch_event.mouse_y = e.xbutton.y;
-                application_state->input_state.mouse_dy +=
-                    (e.xbutton.y - application_state->input_state.mouse_y);
-                
-                application_state->input_state.mouse_y = e.xmotion.y;
-                
+                linux_window_handle_motion(&x11_state->linux_window, application_state,
+                                           e.xmotion.x, e.xmotion.y, &finch_event);
             } break;
             case ClientMessage: {
                 if ((Atom)e.xclient.data.l[0] == x11_state->wm_delete_window) {
@@ -416,19 +593,38 @@ static void x11_handle_events(X11State* x11_state, ApplicationState* application
                 }
             } break;
             case Expose: {
-                x11_put_pixelbuffer_on_screen(x11_state, application_state);
+                // Only the last of a series, which together cover the
+                // damage. The main loop presents, so the frame goes
+                // through the post chain.
+                if (e.xexpose.count == 0) {
+                    application_state->present_requested = true;
+                }
+            } break;
+            case GenericEvent: {
+                if (x11_present_is_event(x11_state->display, &e, (XPointer)x11_state)) {
+                    x11_present_handle_event(x11_state, &e.xcookie);
+                }
             } break;
             case ConfigureNotify: {
-                XConfigureEvent xce = e.xconfigure;
-
-                // Checking if window has been resized
-                if ((u32)xce.width != x11_state->window_attributes.width ||
-                    (u32)xce.height != x11_state->window_attributes.height) {
-                    x11_resize_window(x11_state, (u32)xce.width, (u32)xce.height);
-                    game_resize(application_state,
-                                x11_state->window_attributes.width,
-                                x11_state->window_attributes.height);
-                } 
+                if (linux_window_resize(&x11_state->linux_window, application_state,
+                                        (u32)e.xconfigure.width, (u32)e.xconfigure.height)) {
+                    finch_event.type = FC_EVENT_TYPE_WINDOW_RESIZED;
+                }
+            } break;
+        }
+
+        // Input events carry the server time they were generated at
+        switch (e.type) {
+            case KeyPress:
+            case KeyRelease: {
+                finch_event.server_time_ms = (u32)e.xkey.time;
+            } break;
+            case ButtonPress:
+            case ButtonRelease: {
+                finch_event.server_time_ms = (u32)e.xbutton.time;
+            } break;
+            case MotionNotify: {
+                finch_event.server_time_ms = (u32)e.xmotion.time;
             } break;
         }
 
@@ -440,147 +636,89 @@ static void x11_handle_events(X11State* x11_state, ApplicationState* application
     }
 }
 
-static f64 clock_now(void)
-{
-    struct timespec now;
-    if (clock_gettime(CLOCK_MONOTONIC, &now) < 0) {
-        FC_ENGINE_ERROR("Could not get current monotonic time: %s",
-                strerror(errno));
-        exit(EXIT_FAILURE);
-    }
-    return (f64)(now.tv_sec + (now.tv_nsec / 1000) * 0.000001);
-}
-
 static X11State x11_state;
 
 void platform_init(ApplicationState* application_state)
 {
-    char* game_name = application_state->name != NULL
-        ? application_state->name
-        : "Finch Application";
-    u32 game_width = application_state->width_px > 0
-        ? application_state->width_px
-        : 1280;
-    u32 game_height = application_state->height_px > 0
-        ? application_state->height_px
-        : 720;
-    WindowAttributes window_attributes = {
-        .title  = game_name,
-        .width  = game_width,
-        .height = game_height
-    };
+    platform_cpu_init();
+    fc_render_select_kernels(platform_get_cpu_features());
+    fc_raster_select_kernels(platform_get_cpu_features());
+    string_select_kernels(platform_get_cpu_features());
 
-    x11_state.window_attributes = window_attributes;
+    linux_window_init(&x11_state.linux_window, application_state);
     x11_init(&x11_state);
-    
-    game_resize(application_state,
-                x11_state.window_attributes.width,
-                x11_state.window_attributes.height);    
+    x11_query_pixel_format(&x11_state);
+    linux_window_negotiate_pixel_format(&x11_state.linux_window, application_state);
+    x11_present_init(&x11_state);
+    linux_window_update_pixelbuffer(&x11_state.linux_window, application_state);
 }
 
 void platform_deinit(ApplicationState* application_state)
 {
     x11_deinit(&x11_state);
-    if (application_state->pixelbuffer) {
-        free(application_state->pixelbuffer);
-    }
-}
-
-void platform_poll_events(ApplicationState* application_state)
-{
-    x11_handle_events(&x11_state, application_state);
-}
-
-void platform_put_pixelbuffer_on_screen(ApplicationState* application_state)
-{
-    x11_put_pixelbuffer_on_screen(&x11_state, application_state);
+    FC_FREE(application_state->pixelbuffer);
 }
 
-WindowAttributes* platform_get_window_attributes(void)
+void platform_update_render_scale(ApplicationState* application_state)
 {
-    return &x11_state.window_attributes;
+    linux_window_update_pixelbuffer(&x11_state.linux_window, application_state);
 }
 
-f64 platform_get_epoch_time(void)
+void platform_poll_events(ApplicationState* application_state)
 {
-    return clock_now();
+    x11_handle_events(&x11_state, application_state);
 }
 
-void platform_set_window_title(const char* title)
+b32 platform_wait_for_events(f64 timeout_seconds)
 {
-    XStoreName(x11_state.display, x11_state.window, title);
-}
+    // XPending flushes queued requests and reads what has already arrived
+    if (XPending(x11_state.display) > 0) {
+        return true;
+    }
 
-void platform_write_to_stdout(char* str)
-{
-    write(STDOUT_FILENO, str, string_length_null_terminated(str));
+    struct pollfd connection = {
+        .fd     = ConnectionNumber(x11_state.display),
+        .events = POLLIN
+    };
+    int timeout_ms = timeout_seconds < 0.0 ? -1 : (int)(timeout_seconds * 1000.0 + 0.999);
+    int ready;
+    do {
+        ready = poll(&connection, 1, timeout_ms);
+    } while (ready < 0 && errno == EINTR);
+    return ready > 0;
 }
 
-void platform_write_to_stderr(char* str)
+void platform_put_pixelbuffer_on_screen(ApplicationState* application_state)
 {
-    write(STDERR_FILENO, str, string_length_null_terminated(str));
+    x11_put_pixelbuffer_on_screen(&x11_state, application_state);
 }
 
-b32 platform_terminal_supports_colors()
+void platform_sync_present(void)
 {
-    int fd[2];
-    if (pipe(fd) < 0) {
-        return false;
-    };
-
-    pid_t pid = fork();
-    if (pid < 0) {
-        return false;
+    // A Present has reached the screen once it completed, XPutImage once
+    // the server processed it
+    X11Present* present = &x11_state.present;
+    while (present->enabled && present->completed_serial != present->serial) {
+        x11_present_wait_event(&x11_state);
     }
-    
-    if (pid == 0) {
-        // Child
-        close(fd[0]);
-        if (dup2(fd[1], STDOUT_FILENO) < 0) {
-            return false;
-        }
-        close(fd[1]);
-        if (execl("/bin/tput", "/bin/tput", "colors", NULL) < 0) {
-            return false;
-        }
+    if (!present->enabled) {
+        XSync(x11_state.display, False);
     }
-
-    close(fd[1]);
-    char buf[100];
-    while (read(fd[0], buf, sizeof(buf)) != 0) {};
-    return (atoi(buf) == 256);
 }
 
-b32 platform_stdout_is_terminal()
+void platform_get_present_stats(FcPresentStats* stats)
 {
-    return isatty(STDOUT_FILENO) == 1;
+    *stats = x11_state.present.stats;
 }
 
-b32 platform_stderr_is_terminal()
+WindowAttributes* platform_get_window_attributes(void)
 {
-    return isatty(STDERR_FILENO) == 1;
+    return &x11_state.linux_window.attributes;
 }
 
-void platform_set_terminal_color(FcTerminalColor color) {
-    if (terminal_supports_colors == -1) {
-        terminal_supports_colors =
-            platform_stdout_is_terminal() && platform_terminal_supports_colors();
-    }
-
-    if (terminal_supports_colors) {
-        switch (color) {
-            case FC_TERM_COLOR_WHITE: {
-                platform_write_to_stdout("\033[0m");
-            } break;
-            case FC_TERM_COLOR_GREEN: {
-                platform_write_to_stdout("\033[32m");
-            } break;
-            case FC_TERM_COLOR_ORANGE: {
-                platform_write_to_stdout("\033[33m");
-            } break;
-            case FC_TERM_COLOR_RED: {
-                platform_write_to_stdout("\033[31m");
-            } break;
-        }
-    }
+void platform_set_window_title(const char* title)
+{
+    XStoreName(x11_state.display, x11_state.window, title);
 }
+
+#endif // FINCH_PLATFORM_XCB
@@ -0,0 +1,164 @@
+#define _GNU_SOURCE
+
+#include "finch/core/core.h"
+#include "finch/core/memory.h"
+#include "finch/platform/platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Files opened for direct I/O are written in whole blocks from an aligned
+// buffer, bypassing the page cache. The partial block at the end of the
+// file is kept in the buffer and also written through a second, buffered
+// descriptor, so the file is complete after every write; the block is
+// rewritten with direct I/O once it fills up.
+#define LOG_FILE_BLOCK_SIZE  4096
+#define LOG_FILE_DIRECT_SIZE (64 * 1024)
+
+typedef struct _LinuxLogFile {
+    int fd;
+    int direct_fd; // -1 unless direct I/O is used
+    u64 size;
+
+    u8* block_buffer;
+    u64 block_used;   // Bytes of the partial block at block_offset
+    u64 block_offset; // Aligned offset of the first byte in block_buffer
+} LinuxLogFile;
+
+static b32 write_all(int fd, const u8* data, u64 size, u64 offset, b32 positioned)
+{
+    while (size > 0) {
+        ssize_t written = positioned
+            ? pwrite(fd, data, size, (off_t)offset)
+            : write(fd, data, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        data   += written;
+        size   -= (u64)written;
+        offset += (u64)written;
+    }
+    return true;
+}
+
+static b32 log_file_open_direct(LinuxLogFile* file, const char* path)
+{
+    file->direct_fd = open(path, O_WRONLY | O_DIRECT);
+    if (file->direct_fd < 0) {
+        return false;
+    }
+    file->block_buffer = (u8*)FC_ALLOC_ALIGNED(LOG_FILE_DIRECT_SIZE, LOG_FILE_BLOCK_SIZE, "log file");
+
+    // Pick up the partial block at the end of an existing file
+    file->block_offset = file->size - file->size % LOG_FILE_BLOCK_SIZE;
+    file->block_used   = file->size - file->block_offset;
+    if (file->block_used > 0 &&
+        pread(file->fd, file->block_buffer, file->block_used,
+              (off_t)file->block_offset) != (ssize_t)file->block_used) {
+        FC_FREE(file->block_buffer);
+        close(file->direct_fd);
+        file->direct_fd = -1;
+        return false;
+    }
+
+    // The tail block is rewritten in place, which appending would not do
+    fcntl(file->fd, F_SETFL, fcntl(file->fd, F_GETFL) & ~O_APPEND);
+    return true;
+}
+
+void* platform_log_file_open(const char* path, b32 direct_io)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    LinuxLogFile* file = (LinuxLogFile*)FC_ALLOC_ZEROED(sizeof(LinuxLogFile), "log file");
+    file->fd        = fd;
+    file->direct_fd = -1;
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0) {
+        file->size = (u64)file_stat.st_size;
+    }
+
+    // Not every file system supports direct I/O (e.g. tmpfs), in which case
+    // the file is written through the page cache
+    if (direct_io && !log_file_open_direct(file, path)) {
+        file->block_buffer = NULL;
+    }
+    return file;
+}
+
+u64 platform_log_file_size(void* file_handle)
+{
+    return ((LinuxLogFile*)file_handle)->size;
+}
+
+static b32 log_file_write_direct(LinuxLogFile* file, const u8* data, u64 size)
+{
+    while (size > 0) {
+        u64 chunk = LOG_FILE_DIRECT_SIZE - file->block_used;
+        chunk = chunk < size ? chunk : size;
+        memcpy(file->block_buffer + file->block_used, data, chunk);
+        file->block_used += chunk;
+        data += chunk;
+        size -= chunk;
+
+        u64 whole = file->block_used - file->block_used % LOG_FILE_BLOCK_SIZE;
+        if (whole > 0) {
+            if (!write_all(file->direct_fd, file->block_buffer, whole,
+                           file->block_offset, true)) {
+                return false;
+            }
+            memmove(file->block_buffer, file->block_buffer + whole, file->block_used - whole);
+            file->block_used   -= whole;
+            file->block_offset += whole;
+        }
+    }
+
+    return file->block_used == 0 ||
+           write_all(file->fd, file->block_buffer, file->block_used, file->block_offset, true);
+}
+
+b32 platform_log_file_write(void* file_handle, const void* data, u64 size)
+{
+    LinuxLogFile* file = (LinuxLogFile*)file_handle;
+    b32 success = file->direct_fd >= 0
+        ? log_file_write_direct(file, (const u8*)data, size)
+        : write_all(file->fd, (const u8*)data, size, 0, false);
+    if (success) {
+        file->size += size;
+    }
+    return success;
+}
+
+void platform_log_file_sync(void* file_handle)
+{
+    LinuxLogFile* file = (LinuxLogFile*)file_handle;
+    fdatasync(file->fd);
+}
+
+void platform_log_file_close(void* file_handle)
+{
+    LinuxLogFile* file = (LinuxLogFile*)file_handle;
+    if (file->direct_fd >= 0) {
+        close(file->direct_fd);
+        FC_FREE(file->block_buffer);
+    }
+    close(file->fd);
+    FC_FREE(file);
+}
+
+b32 platform_rename_file(const char* source, const char* destination)
+{
+    return rename(source, destination) == 0;
+}
@@ -0,0 +1,486 @@
+#define _GNU_SOURCE
+
+#include "finch/core/core.h"
+#include "finch/core/memory.h"
+#include "finch/core/stream.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+#include "finch/platform/platform.h"
+
+#include <linux/io_uring.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+// Reads go to the kernel through an io_uring when it has one, with every
+// read flagged to run in the kernel's workers, so a read served from the
+// page cache is not copied on the submitting thread either. Otherwise a
+// few threads run pread. Either way the main thread only queues reads and
+// collects completions, and at most queue_depth reads are outstanding.
+#define READER_THREAD_COUNT 4
+#define READER_CANCEL_TAG   UINT64_MAX // Completions of cancel requests
+
+typedef struct _IoUring {
+    int fd;
+    u32 entries;
+    void* sq_ring;
+    u64   sq_ring_size;
+    void* cq_ring;
+    u64   cq_ring_size;
+    struct io_uring_sqe* sqes;
+    u64   sqes_size;
+
+    // Shared with the kernel
+    u32* sq_head;
+    u32* sq_tail;
+    u32* sq_array;
+    u32  sq_mask;
+    u32* cq_head;
+    u32* cq_tail;
+    u32  cq_mask;
+    struct io_uring_cqe* cqes;
+
+    u32 to_submit;
+} IoUring;
+
+typedef struct _ThreadRead {
+    s32   file;
+    void* dest;
+    u64   size;
+    u64   offset;
+    u64   tag;
+} ThreadRead;
+
+typedef struct _ReaderThreads {
+    pthread_mutex_t lock;
+    void* reads_queued; // Posted for every queued read and at close
+    void* threads[READER_THREAD_COUNT];
+    b32   shutting_down;
+
+    // Rings of queue_depth entries, under the lock
+    ThreadRead*         queue;
+    u32                 queue_head;
+    u32                 queue_count;
+    FcStreamCompletion* completions;
+    u32                 completion_head;
+    u32                 completion_count;
+} ReaderThreads;
+
+typedef struct _LinuxFileReader {
+    u32 queue_depth;
+    u32 in_flight;    // Queued and not yet polled, cancel requests included
+    b32 uring_enabled;
+    IoUring       uring;
+    ReaderThreads threads;
+} LinuxFileReader;
+
+s32 platform_file_open_read(const char* path, u64* size)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        return -1;
+    }
+    *size = (u64)file_stat.st_size;
+    return fd;
+}
+
+void platform_file_close(s32 file)
+{
+    if (file >= 0) {
+        close(file);
+    }
+}
+
+//
+// io_uring, set up without liburing
+//
+
+static b32 uring_init(IoUring* uring, u32 entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    uring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (uring->fd < 0) {
+        return false;
+    }
+    // IORING_OP_READ came with the same kernel
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+        close(uring->fd);
+        return false;
+    }
+
+    uring->entries      = params.sq_entries;
+    uring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+    uring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    b32 single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        uring->sq_ring_size = uring->sq_ring_size > uring->cq_ring_size
+            ? uring->sq_ring_size : uring->cq_ring_size;
+        uring->cq_ring_size = uring->sq_ring_size;
+    }
+
+    uring->sq_ring = mmap(NULL, uring->sq_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING);
+    uring->cq_ring = single_mmap
+        ? uring->sq_ring
+        : mmap(NULL, uring->cq_ring_size, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_CQ_RING);
+    uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    uring->sqes = (struct io_uring_sqe*)mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_POPULATE, uring->fd,
+                                             IORING_OFF_SQES);
+    if (uring->sq_ring == MAP_FAILED || uring->cq_ring == MAP_FAILED ||
+        uring->sqes == MAP_FAILED) {
+        if (uring->sq_ring != MAP_FAILED) {
+            munmap(uring->sq_ring, uring->sq_ring_size);
+        }
+        if (!single_mmap && uring->cq_ring != MAP_FAILED) {
+            munmap(uring->cq_ring, uring->cq_ring_size);
+        }
+        if (uring->sqes != MAP_FAILED) {
+            munmap(uring->sqes, uring->sqes_size);
+        }
+        close(uring->fd);
+        return false;
+    }
+
+    u8* sq = (u8*)uring->sq_ring;
+    u8* cq = (u8*)uring->cq_ring;
+    uring->sq_head  = (u32*)(sq + params.sq_off.head);
+    uring->sq_tail  = (u32*)(sq + params.sq_off.tail);
+    uring->sq_array = (u32*)(sq + params.sq_off.array);
+    uring->sq_mask  = *(u32*)(sq + params.sq_off.ring_mask);
+    uring->cq_head  = (u32*)(cq + params.cq_off.head);
+    uring->cq_tail  = (u32*)(cq + params.cq_off.tail);
+    uring->cq_mask  = *(u32*)(cq + params.cq_off.ring_mask);
+    uring->cqes     = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    uring->to_submit = 0;
+    return true;
+}
+
+static void uring_deinit(IoUring* uring)
+{
+    munmap(uring->sqes, uring->sqes_size);
+    if (uring->cq_ring != uring->sq_ring) {
+        munmap(uring->cq_ring, uring->cq_ring_size);
+    }
+    munmap(uring->sq_ring, uring->sq_ring_size);
+    close(uring->fd);
+}
+
+// NULL when the submission queue is full
+static struct io_uring_sqe* uring_get_sqe(IoUring* uring)
+{
+    u32 tail = *uring->sq_tail;
+    u32 head = __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+    if (tail - head == uring->entries) {
+        return NULL;
+    }
+    u32 index = tail & uring->sq_mask;
+    struct io_uring_sqe* sqe = &uring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    uring->sq_array[index] = index;
+    return sqe;
+}
+
+static void uring_queue_sqe(IoUring* uring)
+{
+    __atomic_store_n(uring->sq_tail, *uring->sq_tail + 1, __ATOMIC_RELEASE);
+    uring->to_submit += 1;
+}
+
+static void uring_submit(IoUring* uring)
+{
+    while (uring->to_submit > 0) {
+        long submitted = syscall(__NR_io_uring_enter, uring->fd, uring->to_submit, 0, 0, NULL, 0);
+        if (submitted < 0 && errno == EINTR) {
+            continue;
+        }
+        if (submitted <= 0) {
+            // Out of kernel resources, the rest goes with the next submit
+            if (errno != EAGAIN && errno != EBUSY) {
+                FC_ENGINE_WARN_PER_SECOND(1, "io_uring_enter failed: %s", strerror(errno));
+            }
+            return;
+        }
+        uring->to_submit -= (u32)submitted;
+    }
+}
+
+static u32 uring_poll(LinuxFileReader* reader, FcStreamCompletion* completions, u32 max_count)
+{
+    IoUring* uring = &reader->uring;
+    u32 head = *uring->cq_head;
+    u32 tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+    u32 count = 0;
+    while (head != tail && count < max_count) {
+        const struct io_uring_cqe* cqe = &uring->cqes[head & uring->cq_mask];
+        if (cqe->user_data != READER_CANCEL_TAG) {
+            completions[count++] = (FcStreamCompletion){ cqe->user_data, cqe->res };
+        }
+        head += 1;
+        reader->in_flight -= 1;
+    }
+    __atomic_store_n(uring->cq_head, head, __ATOMIC_RELEASE);
+    return count;
+}
+
+//
+// Thread fallback
+//
+
+static s64 read_all(s32 file, u8* dest, u64 size, u64 offset)
+{
+    u64 total = 0;
+    while (total < size) {
+        ssize_t result = pread(file, dest + total, size - total, (off_t)(offset + total));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0) {
+            return -errno;
+        }
+        if (result == 0) {
+            break;
+        }
+        total += (u64)result;
+    }
+    return (s64)total;
+}
+
+static void reader_thread_main(void* data)
+{
+    LinuxFileReader* reader = (LinuxFileReader*)data;
+    ReaderThreads* threads = &reader->threads;
+    for (;;) {
+        platform_semaphore_wait(threads->reads_queued);
+        pthread_mutex_lock(&threads->lock);
+        if (threads->queue_count == 0) {
+            b32 shutting_down = threads->shutting_down;
+            pthread_mutex_unlock(&threads->lock);
+            // Canceled reads leave their post behind
+            if (shutting_down) {
+                return;
+            }
+            continue;
+        }
+        ThreadRead read = threads->queue[threads->queue_head];
+        threads->queue_head = (threads->queue_head + 1) % reader->queue_depth;
+        threads->queue_count -= 1;
+        pthread_mutex_unlock(&threads->lock);
+
+        s64 result = read_all(read.file, (u8*)read.dest, read.size, read.offset);
+
+        pthread_mutex_lock(&threads->lock);
+        u32 index = (threads->completion_head + threads->completion_count) % reader->queue_depth;
+        threads->completions[index] = (FcStreamCompletion){ read.tag, result };
+        threads->completion_count += 1;
+        pthread_mutex_unlock(&threads->lock);
+    }
+}
+
+static b32 threads_init(LinuxFileReader* reader)
+{
+    ReaderThreads* threads = &reader->threads;
+    threads->queue = (ThreadRead*)FC_ALLOC(reader->queue_depth * sizeof(ThreadRead), "file reader");
+    threads->completions = (FcStreamCompletion*)FC_ALLOC(reader->queue_depth * sizeof(FcStreamCompletion),
+                                                         "file reader");
+    threads->reads_queued = platform_create_semaphore(0);
+    if (threads->queue == NULL || threads->completions == NULL || threads->reads_queued == NULL) {
+        return false;
+    }
+    pthread_mutex_init(&threads->lock, NULL);
+    for (u32 i = 0; i < READER_THREAD_COUNT; ++i) {
+        threads->threads[i] = platform_create_thread(reader_thread_main, reader);
+    }
+    return true;
+}
+
+static void threads_deinit(LinuxFileReader* reader)
+{
+    ReaderThreads* threads = &reader->threads;
+    if (threads->reads_queued != NULL) {
+        pthread_mutex_lock(&threads->lock);
+        threads->shutting_down = true;
+        pthread_mutex_unlock(&threads->lock);
+        platform_semaphore_post(threads->reads_queued, READER_THREAD_COUNT);
+        for (u32 i = 0; i < READER_THREAD_COUNT; ++i) {
+            if (threads->threads[i] != NULL) {
+                platform_join_thread(threads->threads[i]);
+            }
+        }
+        pthread_mutex_destroy(&threads->lock);
+        platform_destroy_semaphore(threads->reads_queued);
+    }
+    FC_FREE(threads->queue);
+    FC_FREE(threads->completions);
+}
+
+//
+// Reader
+//
+
+void* platform_file_reader_open(u32 queue_depth)
+{
+    LinuxFileReader* reader = (LinuxFileReader*)FC_ALLOC_ZEROED(sizeof(LinuxFileReader), "file reader");
+    if (reader == NULL) {
+        return NULL;
+    }
+    reader->queue_depth = queue_depth;
+
+    // Room for a cancel request behind every read
+    const char* setting = getenv("FINCH_IO_URING");
+    b32 allowed = setting == NULL || strcmp(setting, "0") != 0;
+    reader->uring_enabled = allowed && uring_init(&reader->uring, queue_depth * 2);
+    if (reader->uring_enabled) {
+        FC_ENGINE_INFO("Streaming files with io_uring");
+        return reader;
+    }
+
+    if (!threads_init(reader)) {
+        FC_ENGINE_ERROR("Could not start the file reader threads");
+        threads_deinit(reader);
+        FC_FREE(reader);
+        return NULL;
+    }
+    FC_ENGINE_INFO("Streaming files with %u pread threads", READER_THREAD_COUNT);
+    return reader;
+}
+
+b32 platform_file_reader_read(void* handle, s32 file, void* dest, u64 size, u64 offset, u64 tag)
+{
+    LinuxFileReader* reader = (LinuxFileReader*)handle;
+    if (reader->in_flight >= reader->queue_depth) {
+        return false;
+    }
+
+    if (reader->uring_enabled) {
+        struct io_uring_sqe* sqe = uring_get_sqe(&reader->uring);
+        if (sqe == NULL) {
+            return false;
+        }
+        sqe->opcode    = IORING_OP_READ;
+        sqe->flags     = IOSQE_ASYNC;
+        sqe->fd        = file;
+        sqe->addr      = (u64)(uintptr_t)dest;
+        sqe->len       = (u32)size;
+        sqe->off       = offset;
+        sqe->user_data = tag;
+        uring_queue_sqe(&reader->uring);
+    } else {
+        ReaderThreads* threads = &reader->threads;
+        pthread_mutex_lock(&threads->lock);
+        u32 index = (threads->queue_head + threads->queue_count) % reader->queue_depth;
+        threads->queue[index] = (ThreadRead){ file, dest, size, offset, tag };
+        threads->queue_count += 1;
+        pthread_mutex_unlock(&threads->lock);
+        platform_semaphore_post(threads->reads_queued, 1);
+    }
+    reader->in_flight += 1;
+    return true;
+}
+
+void platform_file_reader_submit(void* handle)
+{
+    LinuxFileReader* reader = (LinuxFileReader*)handle;
+    if (reader->uring_enabled) {
+        uring_submit(&reader->uring);
+    }
+}
+
+u32 platform_file_reader_poll(void* handle, FcStreamCompletion* completions, u32 max_count)
+{
+    LinuxFileReader* reader = (LinuxFileReader*)handle;
+    if (reader->uring_enabled) {
+        return uring_poll(reader, completions, max_count);
+    }
+
+    ReaderThreads* threads = &reader->threads;
+    pthread_mutex_lock(&threads->lock);
+    u32 count = 0;
+    while (threads->completion_count > 0 && count < max_count) {
+        completions[count++] = threads->completions[threads->completion_head];
+        threads->completion_head = (threads->completion_head + 1) % reader->queue_depth;
+        threads->completion_count -= 1;
+    }
+    pthread_mutex_unlock(&threads->lock);
+    reader->in_flight -= count;
+    return count;
+}
+
+void platform_file_reader_cancel(void* handle, u64 tag)
+{
+    LinuxFileReader* reader = (LinuxFileReader*)handle;
+    if (reader->uring_enabled) {
+        // Reads already running complete as usual
+        struct io_uring_sqe* sqe = uring_get_sqe(&reader->uring);
+        if (sqe == NULL) {
+            return;
+        }
+        sqe->opcode       = IORING_OP_ASYNC_CANCEL;
+        sqe->addr         = tag;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_ALL;
+        sqe->user_data    = READER_CANCEL_TAG;
+        uring_queue_sqe(&reader->uring);
+        reader->in_flight += 1;
+        return;
+    }
+
+    // Only reads no thread took yet can be canceled
+    ReaderThreads* threads = &reader->threads;
+    pthread_mutex_lock(&threads->lock);
+    u32 kept = 0;
+    for (u32 i = 0; i < threads->queue_count; ++i) {
+        ThreadRead read = threads->queue[(threads->queue_head + i) % reader->queue_depth];
+        if (read.tag != tag) {
+            threads->queue[(threads->queue_head + kept++) % reader->queue_depth] = read;
+            continue;
+        }
+        u32 completion = (threads->completion_head + threads->completion_count) % reader->queue_depth;
+        threads->completions[completion] = (FcStreamCompletion){ tag, -ECANCELED };
+        threads->completion_count += 1;
+    }
+    threads->queue_count = kept;
+    pthread_mutex_unlock(&threads->lock);
+}
+
+void platform_file_reader_close(void* handle)
+{
+    LinuxFileReader* reader = (LinuxFileReader*)handle;
+    if (reader == NULL) {
+        return;
+    }
+    if (reader->uring_enabled) {
+        // The kernel writes into the caller's memory until reads complete.
+        // Entries the submit left queued are submitted by the wait, or it
+        // would wait for completions that can never come.
+        IoUring* uring = &reader->uring;
+        uring_submit(uring);
+        FcStreamCompletion completions[64];
+        while (reader->in_flight > 0) {
+            if (uring_poll(reader, completions, 64) == 0) {
+                long submitted = syscall(__NR_io_uring_enter, uring->fd, uring->to_submit, 1,
+                                         IORING_ENTER_GETEVENTS, NULL, 0);
+                if (submitted > 0) {
+                    uring->to_submit -= (u32)submitted;
+                }
+            }
+        }
+        uring_deinit(&reader->uring);
+    } else {
+        threads_deinit(reader);
+    }
+    FC_FREE(reader);
+}
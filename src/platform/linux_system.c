@@ -0,0 +1,335 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include "finch/core/core.h"
+#include "finch/core/memory.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+#include "finch/platform/platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static s32 terminal_supports_colors = -1;
+
+static f64 clock_now(void)
+{
+    struct timespec now;
+    if (clock_gettime(CLOCK_MONOTONIC, &now) < 0) {
+        FC_ENGINE_ERROR("Could not get current monotonic time: %s",
+                strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    return (f64)(now.tv_sec + (now.tv_nsec / 1000) * 0.000001);
+}
+
+f64 platform_get_epoch_time(void)
+{
+    return clock_now();
+}
+
+f64 platform_get_coarse_time(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    return (f64)now.tv_sec + (f64)now.tv_nsec * 1e-9;
+}
+
+void platform_sleep(f64 seconds)
+{
+    struct timespec duration = {
+        .tv_sec  = (time_t)seconds,
+        .tv_nsec = (long)((seconds - (time_t)seconds) * 1000000000.0)
+    };
+    while (nanosleep(&duration, &duration) < 0 && errno == EINTR) {}
+}
+
+void platform_write_to_stdout(char* str)
+{
+    write(STDOUT_FILENO, str, string_length_null_terminated(str));
+}
+
+void platform_write_bytes_to_stdout(const char* data, u64 size)
+{
+    while (size > 0) {
+        ssize_t written = write(STDOUT_FILENO, data, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return;
+        }
+        data += written;
+        size -= (u64)written;
+    }
+}
+
+void platform_write_to_stderr(char* str)
+{
+    write(STDERR_FILENO, str, string_length_null_terminated(str));
+}
+
+b32 platform_terminal_supports_colors()
+{
+    int fd[2];
+    if (pipe(fd) < 0) {
+        return false;
+    };
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    
+    if (pid == 0) {
+        // Child
+        close(fd[0]);
+        if (dup2(fd[1], STDOUT_FILENO) < 0) {
+            return false;
+        }
+        close(fd[1]);
+        if (execl("/bin/tput", "/bin/tput", "colors", NULL) < 0) {
+            return false;
+        }
+    }
+
+    close(fd[1]);
+    char buf[100];
+    while (read(fd[0], buf, sizeof(buf)) != 0) {};
+    return (atoi(buf) == 256);
+}
+
+b32 platform_stdout_is_terminal()
+{
+    return isatty(STDOUT_FILENO) == 1;
+}
+
+b32 platform_stderr_is_terminal()
+{
+    return isatty(STDERR_FILENO) == 1;
+}
+
+const char* platform_get_terminal_color_code(FcTerminalColor color)
+{
+    switch (color) {
+        case FC_TERM_COLOR_BLACK:      return "\033[30m";
+        case FC_TERM_COLOR_RED:        return "\033[31m";
+        case FC_TERM_COLOR_GREEN:      return "\033[32m";
+        case FC_TERM_COLOR_ORANGE:     return "\033[33m";
+        case FC_TERM_COLOR_BLUE:       return "\033[34m";
+        case FC_TERM_COLOR_PURPLE:     return "\033[35m";
+        case FC_TERM_COLOR_CYAN:       return "\033[36m";
+        case FC_TERM_COLOR_LIGHT_GRAY: return "\033[37m";
+        default:                       return "\033[0m";
+    }
+}
+
+void platform_set_terminal_color(FcTerminalColor color) {
+    if (terminal_supports_colors == -1) {
+        terminal_supports_colors =
+            platform_stdout_is_terminal() && platform_terminal_supports_colors();
+    }
+
+    if (terminal_supports_colors) {
+        platform_write_to_stdout((char*)platform_get_terminal_color_code(color));
+    }
+}
+
+void* platform_allocate_memory(u64 size)
+{
+    // Anonymous mappings are zeroed and only committed once touched
+    void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (memory == MAP_FAILED) {
+        FC_ENGINE_ERROR("Could not map %u bytes of memory: %s",
+                        (u32)size, strerror(errno));
+        return NULL;
+    }
+    return memory;
+}
+
+void platform_free_memory(void* memory, u64 size)
+{
+    if (memory != NULL) {
+        munmap(memory, size);
+    }
+}
+
+void* platform_load_library(const char* path)
+{
+    void* library = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (library == NULL) {
+        FC_ENGINE_ERROR("Could not load library '%s': %s", path, dlerror());
+    }
+    return library;
+}
+
+void* platform_get_library_symbol(void* library, const char* name)
+{
+    return dlsym(library, name);
+}
+
+void platform_unload_library(void* library)
+{
+    dlclose(library);
+}
+
+s64 platform_get_file_write_time(const char* path)
+{
+    struct stat st;
+    if (stat(path, &st) < 0) {
+        return 0;
+    }
+    return (s64)st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec;
+}
+
+b32 platform_copy_file(const char* source, const char* destination)
+{
+    int in = open(source, O_RDONLY);
+    if (in < 0) {
+        return false;
+    }
+    int out = open(destination, O_WRONLY | O_CREAT | O_TRUNC, 0755);
+    if (out < 0) {
+        close(in);
+        return false;
+    }
+
+    b32 success = true;
+    char buf[64 * 1024];
+    ssize_t bytes_read;
+    while ((bytes_read = read(in, buf, sizeof(buf))) > 0) {
+        if (write(out, buf, bytes_read) != bytes_read) {
+            success = false;
+            break;
+        }
+    }
+    if (bytes_read < 0) {
+        success = false;
+    }
+
+    close(in);
+    close(out);
+    return success;
+}
+
+b32 platform_delete_file(const char* path)
+{
+    return unlink(path) == 0;
+}
+
+const void* platform_map_file(const char* path, u64* size)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+
+    // The mapping keeps the file referenced after the descriptor is closed
+    void* data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+
+    *size = (u64)file_stat.st_size;
+    return data;
+}
+
+void platform_unmap_file(const void* data, u64 size)
+{
+    munmap((void*)data, size);
+}
+
+typedef struct _LinuxThread {
+    pthread_t handle;
+    void    (*proc)(void*);
+    void*     data;
+} LinuxThread;
+
+static void* thread_start(void* data)
+{
+    LinuxThread* thread = (LinuxThread*)data;
+    thread->proc(thread->data);
+    return NULL;
+}
+
+void* platform_create_thread(void (*proc)(void*), void* data)
+{
+    LinuxThread* thread = (LinuxThread*)FC_ALLOC(sizeof(LinuxThread), "thread");
+    thread->proc = proc;
+    thread->data = data;
+    int error = pthread_create(&thread->handle, NULL, thread_start, thread);
+    if (error != 0) {
+        FC_ENGINE_ERROR("Could not create thread: %s", strerror(error));
+        FC_FREE(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+void platform_join_thread(void* thread)
+{
+    pthread_join(((LinuxThread*)thread)->handle, NULL);
+    FC_FREE(thread);
+}
+
+f64 platform_get_thread_cpu_time(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (f64)now.tv_sec + now.tv_nsec * 0.000000001;
+}
+
+u32 platform_get_cpu_count(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (u32)count : 1;
+}
+
+void* platform_create_semaphore(u32 initial_count)
+{
+    sem_t* semaphore = (sem_t*)FC_ALLOC(sizeof(sem_t), "semaphore");
+    if (semaphore == NULL || sem_init(semaphore, 0, initial_count) != 0) {
+        FC_ENGINE_ERROR("Could not create semaphore: %s", strerror(errno));
+        FC_FREE(semaphore);
+        return NULL;
+    }
+    return semaphore;
+}
+
+void platform_semaphore_wait(void* semaphore)
+{
+    while (sem_wait((sem_t*)semaphore) != 0 && errno == EINTR) {
+    }
+}
+
+void platform_semaphore_post(void* semaphore, u32 count)
+{
+    for (u32 i = 0; i < count; ++i) {
+        sem_post((sem_t*)semaphore);
+    }
+}
+
+void platform_destroy_semaphore(void* semaphore)
+{
+    if (semaphore != NULL) {
+        sem_destroy((sem_t*)semaphore);
+        FC_FREE(semaphore);
+    }
+}
@@ -0,0 +1,349 @@
+#include "linux_window.h"
+
+#include "finch/core/memory.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+
+#include <stdlib.h>
+
+void linux_window_init(LinuxWindow* window, const ApplicationState* application_state)
+{
+    *window = (LinuxWindow){0};
+    window->attributes = (WindowAttributes){
+        .title  = application_state->name != NULL
+            ? application_state->name
+            : "Finch Application",
+        .width  = application_state->width_px > 0 ? application_state->width_px : 1280,
+        .height = application_state->height_px > 0 ? application_state->height_px : 720
+    };
+}
+
+void linux_window_deinit(LinuxWindow* window)
+{
+    FC_FREE(window->staging);
+    window->staging = NULL;
+    window->staging_size = 0;
+    FC_FREE(window->scaled);
+    window->scaled = NULL;
+    window->scaled_size = 0;
+    fc_upscaler_free(&window->upscaler);
+}
+
+//
+// Pixel format
+//
+
+void linux_window_set_native_format(LinuxWindow* window, u32 red_mask, u32 green_mask,
+                                    u32 blue_mask, u32 depth, u32 bits_per_pixel,
+                                    b32 server_is_lsb_first)
+{
+    if (bits_per_pixel != 32 && bits_per_pixel != 16) {
+        FC_ENGINE_ERROR("Unsupported visual with %u bits per pixel", bits_per_pixel);
+        exit(EXIT_FAILURE);
+    }
+
+    b32 host_is_lsb_first = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+    window->swap_bytes = server_is_lsb_first != host_is_lsb_first;
+
+    u32 alpha_mask = 0;
+    if (bits_per_pixel == 32) {
+        if (window->swap_bytes) {
+            red_mask   = __builtin_bswap32(red_mask);
+            green_mask = __builtin_bswap32(green_mask);
+            blue_mask  = __builtin_bswap32(blue_mask);
+        }
+        alpha_mask = ~(red_mask | green_mask | blue_mask);
+    }
+
+    FcPixelFormat* format = &window->native_pixel_format;
+    format->red_mask    = red_mask;
+    format->green_mask  = green_mask;
+    format->blue_mask   = blue_mask;
+    format->alpha_mask  = depth == 32 ? alpha_mask : 0;
+    format->red_shift   = __builtin_ctz(red_mask);
+    format->green_shift = __builtin_ctz(green_mask);
+    format->blue_shift  = __builtin_ctz(blue_mask);
+    // Padding byte when there is no alpha channel
+    format->alpha_shift = alpha_mask != 0 ? __builtin_ctz(alpha_mask) : 0;
+    format->bits_per_pixel = (u8)bits_per_pixel;
+    format->depth          = (u8)depth;
+}
+
+void linux_window_negotiate_pixel_format(LinuxWindow* window, ApplicationState* application_state)
+{
+    FcPixelFormat* native = &window->native_pixel_format;
+    application_state->native_pixel_format = *native;
+
+    if (application_state->pixel_format.bits_per_pixel == 0) {
+        application_state->pixel_format = native->bits_per_pixel == 32
+            ? *native
+            : FC_PIXEL_FORMAT_BGRA8;
+    }
+    if (application_state->pixel_format.bits_per_pixel != 32) {
+        FC_ENGINE_ERROR("Pixelbuffer formats must have 32 bits per pixel");
+        exit(EXIT_FAILURE);
+    }
+
+    window->conversion = LINUX_CONVERSION_NONE;
+    if (native->bits_per_pixel == 16) {
+        window->conversion = LINUX_CONVERSION_TO_U16;
+    } else if (!fc_pixel_formats_equal(&application_state->pixel_format, native)) {
+        window->conversion = LINUX_CONVERSION_SWIZZLE;
+        window->swizzle = fc_pixel_format_swizzle(&application_state->pixel_format, native);
+    }
+
+    if (window->conversion != LINUX_CONVERSION_NONE) {
+        FC_ENGINE_INFO("Pixelbuffer format differs from the native %u-bit format, "
+                       "converting at every present", native->bits_per_pixel);
+    }
+}
+
+//
+// Size
+//
+
+static void initialize_pixelbuffer(ApplicationState* application_state)
+{
+    FC_FREE(application_state->pixelbuffer);
+    application_state->pixelbuffer = (u32*)FC_ALLOC((u64)application_state->width_px *
+                                                    application_state->height_px * sizeof(u32),
+                                                    "pixelbuffer");
+}
+
+void linux_window_update_pixelbuffer(LinuxWindow* window, ApplicationState* application_state)
+{
+    u32 new_width, new_height;
+    fc_render_scale_resolve(&application_state->render_scale,
+                            window->attributes.width, window->attributes.height,
+                            &new_width, &new_height);
+    if (application_state->pixelbuffer != NULL &&
+        application_state->width_px  == new_width &&
+        application_state->height_px == new_height) {
+        return;
+    }
+
+    application_state->width_px  = new_width;
+    application_state->height_px = new_height;
+    initialize_pixelbuffer(application_state);
+    fc_memory_allow_frame();
+}
+
+b32 linux_window_resize(LinuxWindow* window, ApplicationState* application_state,
+                        u32 width, u32 height)
+{
+    if (width == window->attributes.width && height == window->attributes.height) {
+        return false;
+    }
+    // Frame buffers are reallocated for the new size
+    fc_memory_allow_frame();
+    window->attributes.width  = width;
+    window->attributes.height = height;
+    linux_window_update_pixelbuffer(window, application_state);
+    return true;
+}
+
+//
+// Present
+//
+
+const u32* linux_window_scale_pixelbuffer(LinuxWindow* window,
+                                          ApplicationState* application_state,
+                                          u32* width, u32* height)
+{
+    u32 window_width  = window->attributes.width;
+    u32 window_height = window->attributes.height;
+    if (application_state->width_px  == window_width &&
+        application_state->height_px == window_height) {
+        *width  = window_width;
+        *height = window_height;
+        return application_state->pixelbuffer;
+    }
+
+    u64 size = (u64)window_width * window_height * sizeof(u32);
+    if (size > window->scaled_size) {
+        FC_FREE(window->scaled);
+        window->scaled = (u32*)FC_ALLOC(size, "scaled frame");
+        window->scaled_size = size;
+    }
+
+    u32 x, y, dest_width, dest_height;
+    fc_render_scale_destination(&application_state->render_scale,
+                                application_state->width_px, application_state->height_px,
+                                window_width, window_height,
+                                &x, &y, &dest_width, &dest_height);
+
+    // Clear the borders left by integer scaling
+    if (dest_width != window_width || dest_height != window_height) {
+        fc_fill_rect_u32(window->scaled, window_width, 0, 0, window_width, y, 0);
+        fc_fill_rect_u32(window->scaled, window_width, 0, y + dest_height,
+                         window_width, window_height - y - dest_height, 0);
+        fc_fill_rect_u32(window->scaled, window_width, 0, y, x, dest_height, 0);
+        fc_fill_rect_u32(window->scaled, window_width, x + dest_width, y,
+                         window_width - x - dest_width, dest_height, 0);
+    }
+
+    fc_upscaler_run(&window->upscaler, application_state->render_scale.filter,
+                    window->scaled + (u64)y * window_width + x, window_width,
+                    dest_width, dest_height,
+                    application_state->pixelbuffer,
+                    application_state->width_px, application_state->height_px);
+    *width  = window_width;
+    *height = window_height;
+    return window->scaled;
+}
+
+void* linux_window_convert(LinuxWindow* window, const ApplicationState* application_state,
+                           const u32* pixels, u64 pixel_count, void* dest)
+{
+    if (window->conversion == LINUX_CONVERSION_NONE) {
+        if (dest == NULL) {
+            return (void*)pixels;
+        }
+        fc_copy_u32((u32*)dest, pixels, pixel_count);
+        return dest;
+    }
+
+    if (dest == NULL) {
+        u64 size = pixel_count * (window->native_pixel_format.bits_per_pixel / 8);
+        if (size > window->staging_size) {
+            FC_FREE(window->staging);
+            window->staging = FC_ALLOC(size, "staging frame");
+            window->staging_size = size;
+        }
+        dest = window->staging;
+    }
+
+    switch (window->conversion) {
+        case LINUX_CONVERSION_SWIZZLE: {
+            fc_swizzle_u32((u32*)dest, pixels, pixel_count, window->swizzle);
+        } break;
+        case LINUX_CONVERSION_TO_U16: {
+            fc_convert_u32_to_u16((u16*)dest, pixels,
+                                  pixel_count, &application_state->pixel_format,
+                                  &window->native_pixel_format, window->swap_bytes);
+        } break;
+        default: {}
+    }
+    return dest;
+}
+
+//
+// Input
+//
+
+FcKey linux_translate_keysym(u32 keysym)
+{
+    // Only the first keysym of a keycode is looked at, which is uppercase
+    // in some layouts
+    if (keysym >= 'A' && keysym <= 'Z') {
+        keysym += 'a' - 'A';
+    }
+    if (keysym >= 'a' && keysym <= 'z') {
+        return (FcKey)(keysym - 'a' + FC_KEY_A);
+    }
+    if (keysym >= '0' && keysym <= '9') {
+        return (FcKey)(keysym - '0' + FC_KEY_0);
+    }
+    switch (keysym) {
+        case 32:    return FC_KEY_SPACE;
+        case 65507: return FC_KEY_LEFT_CTRL;
+        case 65508: return FC_KEY_RIGHT_CTRL;
+        case 65505: return FC_KEY_LEFT_SHIFT;
+        case 65506: return FC_KEY_RIGHT_SHIFT;
+        case 65513: return FC_KEY_LEFT_ALT;
+        case 65027: return FC_KEY_RIGHT_ALT;
+        case 65289: return FC_KEY_TAB;
+        case 65307: return FC_KEY_ESC;
+        case 65293: return FC_KEY_ENTER;
+        case 65288: return FC_KEY_BACKSPACE;
+        case 65509: return FC_KEY_CAPS_LOCK;
+        case 65362: return FC_KEY_UP;
+        case 65364: return FC_KEY_DOWN;
+        case 65361: return FC_KEY_LEFT;
+        case 65363: return FC_KEY_RIGHT;
+        case 65470: return FC_KEY_F1;
+        case 65471: return FC_KEY_F2;
+        case 65472: return FC_KEY_F3;
+        case 65473: return FC_KEY_F4;
+        case 65474: return FC_KEY_F5;
+        case 65475: return FC_KEY_F6;
+        case 65476: return FC_KEY_F7;
+        case 65477: return FC_KEY_F8;
+        case 65478: return FC_KEY_F9;
+        case 65479: return FC_KEY_F10;
+        case 65480: return FC_KEY_F11;
+        case 65481: return FC_KEY_F12;
+        default:    return FC_KEY_NONE;
+    }
+}
+
+// Maps a position in the window to the pixelbuffer
+static void map_mouse(LinuxWindow* window, ApplicationState* application_state,
+                      s32 window_x, s32 window_y, u32* x, u32* y)
+{
+    u32 window_width  = window->attributes.width;
+    u32 window_height = window->attributes.height;
+    if (application_state->width_px  == window_width &&
+        application_state->height_px == window_height) {
+        *x = (u32)window_x;
+        *y = (u32)window_y;
+        return;
+    }
+
+    u32 dest_x, dest_y, dest_width, dest_height;
+    fc_render_scale_destination(&application_state->render_scale,
+                                application_state->width_px, application_state->height_px,
+                                window_width, window_height,
+                                &dest_x, &dest_y, &dest_width, &dest_height);
+
+    s64 mapped_x = ((s64)window_x - dest_x) * application_state->width_px  / dest_width;
+    s64 mapped_y = ((s64)window_y - dest_y) * application_state->height_px / dest_height;
+    *x = (u32)(mapped_x < 0 ? 0 : mapped_x >= application_state->width_px
+               ? application_state->width_px - 1 : mapped_x);
+    *y = (u32)(mapped_y < 0 ? 0 : mapped_y >= application_state->height_px
+               ? application_state->height_px - 1 : mapped_y);
+}
+
+void linux_window_handle_button(LinuxWindow* window, ApplicationState* application_state,
+                                u32 button, s32 x, s32 y, b32 pressed, FcEvent* finch_event)
+{
+    // Scroll wheels only press
+    if (!pressed && (button < 1 || button > 3)) {
+        return;
+    }
+
+    map_mouse(window, application_state, x, y, &finch_event->mouse_x, &finch_event->mouse_y);
+
+    FcButton finch_button = FC_BUTTON_NONE;
+    switch (button) {
+        case 1: finch_button = FC_BUTTON_LEFT;   break;
+        case 2: finch_button = FC_BUTTON_MIDDLE; break;
+        case 3: finch_button = FC_BUTTON_RIGHT;  break;
+        case 4: finch_event->scroll_wheel_vertical_direction   =  1; break;
+        case 5: finch_event->scroll_wheel_vertical_direction   = -1; break;
+        case 6: finch_event->scroll_wheel_horizontal_direction = -1; break;
+        case 7: finch_event->scroll_wheel_horizontal_direction =  1; break;
+        default: return;
+    }
+
+    if (finch_button != FC_BUTTON_NONE) {
+        finch_event->type = pressed ? FC_EVENT_TYPE_BUTTON_PRESSED : FC_EVENT_TYPE_BUTTON_RELEASED;
+    } else {
+        finch_event->type = FC_EVENT_TYPE_WHEEL_SCROLLED;
+    }
+    finch_event->button = finch_button;
+    application_state->input_state.button_is_down[finch_button] = pressed;
+}
+
+void linux_window_handle_motion(LinuxWindow* window, ApplicationState* application_state,
+                                s32 x, s32 y, FcEvent* finch_event)
+{
+    finch_event->type = FC_EVENT_TYPE_MOUSE_MOVED;
+    map_mouse(window, application_state, x, y, &finch_event->mouse_x, &finch_event->mouse_y);
+
+    InputState* input = &application_state->input_state;
+    input->mouse_dx += (s32)finch_event->mouse_x - (s32)input->mouse_x;
+    input->mouse_x = finch_event->mouse_x;
+    input->mouse_dy += (s32)finch_event->mouse_y - (s32)input->mouse_y;
+    input->mouse_y = finch_event->mouse_y;
+}
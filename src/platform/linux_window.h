@@ -0,0 +1,81 @@
+#ifndef FINCH_PLATFORM_LINUX_WINDOW_H
+#define FINCH_PLATFORM_LINUX_WINDOW_H
+
+#include "finch/core/core.h"
+#include "finch/core/events.h"
+#include "finch/application/application.h"
+#include "finch/platform/platform.h"
+#include "finch/render/kernels.h"
+#include "finch/render/scale.h"
+
+// The part of the Linux window backends (linux_finch.c for Xlib,
+// linux_xcb.c for XCB) that does not depend on the window system: pixel
+// format negotiation and conversion, keysym translation, scaling the
+// pixelbuffer to the window, mapping the mouse back and resizing.
+
+typedef enum _LinuxConversion {
+    LINUX_CONVERSION_NONE = 0,
+    LINUX_CONVERSION_SWIZZLE,
+    LINUX_CONVERSION_TO_U16
+} LinuxConversion;
+
+typedef struct _LinuxWindow {
+    b32           swap_bytes;
+    FcPixelFormat native_pixel_format;
+
+    // Conversion from the application's pixel format at present
+    LinuxConversion conversion;
+    FcSwizzle       swizzle;
+    void*           staging;
+    u64             staging_size;
+
+    // Pixelbuffer upscaled to the window when rendering at a lower resolution
+    FcUpscaler upscaler;
+    u32*       scaled;
+    u64        scaled_size;
+
+    WindowAttributes attributes;
+} LinuxWindow;
+
+// Takes the title and size the application asked for, or the defaults
+void linux_window_init(LinuxWindow* window, const ApplicationState* application_state);
+void linux_window_deinit(LinuxWindow* window);
+
+// Describes the pixels of a TrueColor visual, as they must be laid out in
+// memory for the server's byte order. Exits on visuals with other than 16
+// or 32 bits per pixel.
+void linux_window_set_native_format(LinuxWindow* window, u32 red_mask, u32 green_mask,
+                                    u32 blue_mask, u32 depth, u32 bits_per_pixel,
+                                    b32 server_is_lsb_first);
+// Picks the pixelbuffer format, the native one unless the application set
+// one, and the conversion at present
+void linux_window_negotiate_pixel_format(LinuxWindow* window, ApplicationState* application_state);
+
+// Reallocates the pixelbuffer if the render scale resolves to another size
+// for the window
+void linux_window_update_pixelbuffer(LinuxWindow* window, ApplicationState* application_state);
+// Returns true if the size changed, after resizing the pixelbuffer
+b32  linux_window_resize(LinuxWindow* window, ApplicationState* application_state,
+                         u32 width, u32 height);
+
+// Returns the pixels to put in the window, scaled when the pixelbuffer is
+// another size, and sets width and height to their size
+const u32* linux_window_scale_pixelbuffer(LinuxWindow* window,
+                                          ApplicationState* application_state,
+                                          u32* width, u32* height);
+// Converts pixels to the native format into dest, or into a staging copy
+// when dest is NULL, and returns the converted pixels. Without conversion
+// the pixels are copied into dest, or returned as they are.
+void* linux_window_convert(LinuxWindow* window, const ApplicationState* application_state,
+                           const u32* pixels, u64 pixel_count, void* dest);
+
+// The first keysym of a keycode, or FC_KEY_NONE
+FcKey linux_translate_keysym(u32 keysym);
+
+// Fill in finch_event from a button or motion event at a window position
+void linux_window_handle_button(LinuxWindow* window, ApplicationState* application_state,
+                                u32 button, s32 x, s32 y, b32 pressed, FcEvent* finch_event);
+void linux_window_handle_motion(LinuxWindow* window, ApplicationState* application_state,
+                                s32 x, s32 y, FcEvent* finch_event);
+
+#endif // FINCH_PLATFORM_LINUX_WINDOW_H
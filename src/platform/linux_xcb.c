@@ -0,0 +1,739 @@
+// XCB window backend, used when building with FINCH_PLATFORM=xcb. It
+// implements the window half of platform.h like linux_finch.c, on top of
+// the same window-system independent parts in linux_window.c, without
+// waiting on the server in the main loop: replies are only collected
+// through their cookies once needed, events are handled in batches of what
+// one read returned, and frames are put from shared memory when possible.
+#ifdef FINCH_PLATFORM_XCB
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include <xcb/xcb.h>
+#include <xcb/xcbext.h>
+
+#include "finch/core/core.h"
+#include "finch/core/memory.h"
+#include "finch/utils/string.h"
+#include "finch/core/events.h"
+#include "finch/application/application.h"
+
+#include "finch/log/log.h"
+#include "finch/platform/cpu.h"
+#include "finch/platform/platform.h"
+#include "finch/render/kernels.h"
+#include "finch/render/raster.h"
+#include "linux_window.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/shm.h>
+#include <sys/uio.h>
+
+#define SHM_BUFFER_COUNT  2
+#define EVENT_BATCH_SIZE  256
+
+typedef struct _XcbShmBuffer {
+    u32  segment; // Server side id of the attachment
+    u8*  data;
+    u64  size;
+    // Request answered after the last put from this buffer, 0 once the
+    // reply was collected
+    unsigned int fence;
+} XcbShmBuffer;
+
+static xcb_extension_t shm_extension = { "MIT-SHM", 0 };
+
+typedef struct _XcbState {
+    xcb_connection_t* connection;
+    xcb_screen_t*     screen;
+    xcb_window_t      window;
+    xcb_gcontext_t    gc;
+    xcb_atom_t        wm_protocols;
+    xcb_atom_t        wm_delete_window;
+
+    xcb_visualtype_t* visual;
+    u8                depth;
+    u8                bits_per_pixel;
+
+    // Frames are put from MIT-SHM segments when the server can attach
+    // them, otherwise sent in PutImage requests of at most this many bytes
+    b32           shm_enabled;
+    XcbShmBuffer  shm_buffers[SHM_BUFFER_COUNT];
+    XcbShmBuffer* shm_last; // Put last
+    u64           max_request_size;
+
+    // Keycode to key, rebuilt from the server's keyboard mapping
+    FcKey keys[256];
+    xcb_get_keyboard_mapping_cookie_t keyboard_mapping;
+    b32   keyboard_mapping_pending;
+
+    // Read while waiting for events and handled with the next batch
+    xcb_generic_event_t* pending_event;
+
+    FcPresentStats stats;
+
+    LinuxWindow linux_window;
+} XcbState;
+
+static xcb_intern_atom_cookie_t intern_atom(xcb_connection_t* connection, const char* name)
+{
+    return xcb_intern_atom(connection, 0, (u16)strlen(name), name);
+}
+
+static xcb_atom_t intern_atom_reply(xcb_connection_t* connection, xcb_intern_atom_cookie_t cookie)
+{
+    xcb_intern_atom_reply_t* reply = xcb_intern_atom_reply(connection, cookie, NULL);
+    xcb_atom_t atom = reply != NULL ? reply->atom : XCB_ATOM_NONE;
+    free(reply);
+    return atom;
+}
+
+//
+// Keyboard
+//
+
+static void keyboard_request_mapping(XcbState* state)
+{
+    if (state->keyboard_mapping_pending) {
+        xcb_discard_reply(state->connection, state->keyboard_mapping.sequence);
+    }
+    const xcb_setup_t* setup = xcb_get_setup(state->connection);
+    state->keyboard_mapping = xcb_get_keyboard_mapping(state->connection, setup->min_keycode,
+                                                       setup->max_keycode - setup->min_keycode + 1);
+    state->keyboard_mapping_pending = true;
+}
+
+static void keyboard_apply_mapping(XcbState* state, xcb_get_keyboard_mapping_reply_t* reply)
+{
+    state->keyboard_mapping_pending = false;
+    if (reply == NULL || reply->keysyms_per_keycode == 0) {
+        FC_ENGINE_WARN("Could not get the keyboard mapping");
+        free(reply);
+        return;
+    }
+
+    memset(state->keys, 0, sizeof(state->keys));
+    const xcb_keysym_t* keysyms = xcb_get_keyboard_mapping_keysyms(reply);
+    u32 keycode_count = (u32)xcb_get_keyboard_mapping_keysyms_length(reply) /
+                        reply->keysyms_per_keycode;
+    u32 min_keycode = xcb_get_setup(state->connection)->min_keycode;
+    for (u32 i = 0; i < keycode_count && min_keycode + i < 256; ++i) {
+        state->keys[min_keycode + i] = linux_translate_keysym(keysyms[i * reply->keysyms_per_keycode]);
+    }
+    // Allocated by XCB, so not from the engine allocator
+    free(reply);
+}
+
+// Applies a requested mapping if its reply was already read, without
+// waiting for it
+static void keyboard_poll_mapping(XcbState* state)
+{
+    if (!state->keyboard_mapping_pending) {
+        return;
+    }
+    void* reply = NULL;
+    xcb_generic_error_t* error = NULL;
+    if (xcb_poll_for_reply(state->connection, state->keyboard_mapping.sequence, &reply, &error)) {
+        free(error);
+        keyboard_apply_mapping(state, (xcb_get_keyboard_mapping_reply_t*)reply);
+    }
+}
+
+//
+// Window
+//
+
+static void window_init(XcbState* state)
+{
+    int screen_number;
+    xcb_connection_t* connection = xcb_connect(NULL, &screen_number);
+    if (xcb_connection_has_error(connection)) {
+        FC_ENGINE_ERROR("Could not open default display.");
+        exit(EXIT_FAILURE);
+    }
+    state->connection = connection;
+
+    xcb_screen_iterator_t screens = xcb_setup_roots_iterator(xcb_get_setup(connection));
+    for (int i = 0; i < screen_number; ++i) {
+        xcb_screen_next(&screens);
+    }
+    state->screen = screens.data;
+
+    // Everything the setup needs from the server is requested before any
+    // reply is waited for, so it costs a single round trip
+    xcb_prefetch_extension_data(connection, &shm_extension);
+    xcb_prefetch_maximum_request_length(connection);
+    xcb_intern_atom_cookie_t protocols_cookie = intern_atom(connection, "WM_PROTOCOLS");
+    xcb_intern_atom_cookie_t delete_cookie = intern_atom(connection, "WM_DELETE_WINDOW");
+    keyboard_request_mapping(state);
+
+    state->window = xcb_generate_id(connection);
+    u32 values[] = {
+        state->screen->white_pixel,
+        XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE |
+        XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE |
+        XCB_EVENT_MASK_POINTER_MOTION |
+        XCB_EVENT_MASK_STRUCTURE_NOTIFY | XCB_EVENT_MASK_EXPOSURE
+    };
+    xcb_create_window(connection, XCB_COPY_FROM_PARENT, state->window, state->screen->root,
+                      0, 0,
+                      (u16)state->linux_window.attributes.width,
+                      (u16)state->linux_window.attributes.height,
+                      0, XCB_WINDOW_CLASS_INPUT_OUTPUT, state->screen->root_visual,
+                      XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK, values);
+    xcb_change_property(connection, XCB_PROP_MODE_REPLACE, state->window,
+                        XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8,
+                        (u32)strlen(state->linux_window.attributes.title),
+                        state->linux_window.attributes.title);
+    state->gc = xcb_generate_id(connection);
+    xcb_create_gc(connection, state->gc, state->window, 0, NULL);
+
+    state->wm_protocols = intern_atom_reply(connection, protocols_cookie);
+    state->wm_delete_window = intern_atom_reply(connection, delete_cookie);
+    xcb_change_property(connection, XCB_PROP_MODE_REPLACE, state->window,
+                        state->wm_protocols, XCB_ATOM_ATOM, 32, 1, &state->wm_delete_window);
+    xcb_map_window(connection, state->window);
+
+    keyboard_apply_mapping(state, xcb_get_keyboard_mapping_reply(connection,
+                                                                 state->keyboard_mapping, NULL));
+    state->max_request_size = (u64)xcb_get_maximum_request_length(connection) * 4;
+    xcb_flush(connection);
+}
+
+// Finds the window's visual and the bits per pixel of its depth
+static void window_query_pixel_format(XcbState* state)
+{
+    const xcb_setup_t* setup = xcb_get_setup(state->connection);
+    xcb_screen_t* screen = state->screen;
+    state->depth = screen->root_depth;
+
+    state->visual = NULL;
+    xcb_depth_iterator_t depths = xcb_screen_allowed_depths_iterator(screen);
+    for (; depths.rem > 0 && state->visual == NULL; xcb_depth_next(&depths)) {
+        xcb_visualtype_iterator_t visuals = xcb_depth_visuals_iterator(depths.data);
+        for (; visuals.rem > 0; xcb_visualtype_next(&visuals)) {
+            if (visuals.data->visual_id == screen->root_visual) {
+                state->visual = visuals.data;
+                break;
+            }
+        }
+    }
+    if (state->visual == NULL ||
+        (state->visual->_class != XCB_VISUAL_CLASS_TRUE_COLOR &&
+         state->visual->_class != XCB_VISUAL_CLASS_DIRECT_COLOR)) {
+        FC_ENGINE_ERROR("Unsupported visual class %d, need TrueColor",
+                        state->visual != NULL ? state->visual->_class : -1);
+        exit(EXIT_FAILURE);
+    }
+
+    state->bits_per_pixel = 0;
+    const xcb_format_t* formats = xcb_setup_pixmap_formats(setup);
+    for (int i = 0; i < xcb_setup_pixmap_formats_length(setup); ++i) {
+        if (formats[i].depth == state->depth) {
+            state->bits_per_pixel = formats[i].bits_per_pixel;
+        }
+    }
+    linux_window_set_native_format(&state->linux_window, state->visual->red_mask,
+                                   state->visual->green_mask, state->visual->blue_mask,
+                                   state->depth, state->bits_per_pixel,
+                                   setup->image_byte_order == XCB_IMAGE_ORDER_LSB_FIRST);
+}
+
+//
+// MIT-SHM: frames are converted or copied into one of two shared memory
+// segments and put from there, so the pixels never go through the socket.
+// The extension has no XCB binding here, so requests are encoded from the
+// protocol. A request with a reply fences each put: replies arrive in
+// order, so once it is in the server has finished reading the segment.
+//
+
+#define SHM_ATTACH    1
+#define SHM_DETACH    2
+#define SHM_PUT_IMAGE 3
+
+typedef struct _ShmAttachRequest {
+    u8  major_opcode;
+    u8  minor_opcode;
+    u16 length;
+    u32 segment;
+    u32 shmid;
+    u8  read_only;
+    u8  pad[3];
+} ShmAttachRequest;
+
+typedef struct _ShmDetachRequest {
+    u8  major_opcode;
+    u8  minor_opcode;
+    u16 length;
+    u32 segment;
+} ShmDetachRequest;
+
+typedef struct _ShmPutImageRequest {
+    u8  major_opcode;
+    u8  minor_opcode;
+    u16 length;
+    u32 drawable;
+    u32 gc;
+    u16 total_width, total_height;
+    u16 src_x, src_y;
+    u16 src_width, src_height;
+    s16 dst_x, dst_y;
+    u8  depth;
+    u8  format;
+    u8  send_event;
+    u8  pad;
+    u32 segment;
+    u32 offset;
+} ShmPutImageRequest;
+
+// XCB fills in the opcodes and the length
+static unsigned int shm_send(XcbState* state, u8 minor_opcode, void* request, u64 size,
+                             b32 checked)
+{
+    struct iovec parts[4];
+    parts[2].iov_base = request;
+    parts[2].iov_len  = size;
+    parts[3].iov_base = NULL;
+    parts[3].iov_len  = 0;
+    xcb_protocol_request_t protocol = {
+        .count  = 2,
+        .ext    = &shm_extension,
+        .opcode = minor_opcode,
+        .isvoid = 1
+    };
+    return xcb_send_request(state->connection, checked ? XCB_REQUEST_CHECKED : 0,
+                            parts + 2, &protocol);
+}
+
+static void shm_wait_idle(XcbState* state, XcbShmBuffer* buffer)
+{
+    if (buffer->fence != 0) {
+        xcb_get_input_focus_cookie_t fence = { buffer->fence };
+        free(xcb_get_input_focus_reply(state->connection, fence, NULL));
+        buffer->fence = 0;
+    }
+}
+
+static void shm_destroy_buffer(XcbState* state, XcbShmBuffer* buffer)
+{
+    if (buffer->data != NULL) {
+        shm_wait_idle(state, buffer);
+        ShmDetachRequest request = { .segment = buffer->segment };
+        shm_send(state, SHM_DETACH, &request, sizeof(request), false);
+        shmdt(buffer->data);
+    }
+    if (state->shm_last == buffer) {
+        state->shm_last = NULL;
+    }
+    memset(buffer, 0, sizeof(XcbShmBuffer));
+}
+
+static b32 shm_create_buffer(XcbState* state, XcbShmBuffer* buffer, u64 size)
+{
+    int shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+    if (shmid < 0) {
+        FC_ENGINE_WARN("Could not create shared memory segment: %s", strerror(errno));
+        return false;
+    }
+    void* data = shmat(shmid, NULL, 0);
+    // Removed once both sides have detached
+    shmctl(shmid, IPC_RMID, NULL);
+    if (data == (void*)-1) {
+        FC_ENGINE_WARN("Could not attach shared memory segment: %s", strerror(errno));
+        return false;
+    }
+
+    // Attaching fails on remote displays. This is the only request waited
+    // for, and only when the window size changed.
+    u32 segment = xcb_generate_id(state->connection);
+    ShmAttachRequest request = { .segment = segment, .shmid = (u32)shmid, .read_only = 1 };
+    xcb_void_cookie_t cookie = { shm_send(state, SHM_ATTACH, &request, sizeof(request), true) };
+    xcb_generic_error_t* error = xcb_request_check(state->connection, cookie);
+    if (error != NULL) {
+        free(error);
+        shmdt(data);
+        return false;
+    }
+
+    buffer->segment = segment;
+    buffer->data    = (u8*)data;
+    buffer->size    = size;
+    return true;
+}
+
+static void shm_deinit(XcbState* state)
+{
+    for (u32 i = 0; i < SHM_BUFFER_COUNT; ++i) {
+        shm_destroy_buffer(state, &state->shm_buffers[i]);
+    }
+    state->shm_enabled = false;
+}
+
+// Returns the buffer put longest ago once the server is done with it
+static XcbShmBuffer* shm_acquire(XcbState* state, u64 size)
+{
+    XcbShmBuffer* buffer = &state->shm_buffers[0];
+    if (state->shm_last == buffer) {
+        buffer = &state->shm_buffers[1];
+    }
+    f64 wait_start_time = platform_get_epoch_time();
+    shm_wait_idle(state, buffer);
+    state->stats.last_wait_ms = (platform_get_epoch_time() - wait_start_time) * 1000.0;
+
+    if (buffer->data != NULL && buffer->size != size) {
+        shm_destroy_buffer(state, buffer);
+    }
+    if (buffer->data == NULL && !shm_create_buffer(state, buffer, size)) {
+        FC_ENGINE_WARN("Could not attach a shared memory segment, falling back to PutImage");
+        shm_deinit(state);
+        return NULL;
+    }
+    return buffer;
+}
+
+static void shm_put(XcbState* state, XcbShmBuffer* buffer, u32 width, u32 height)
+{
+    ShmPutImageRequest request = {
+        .drawable     = state->window,
+        .gc           = state->gc,
+        .total_width  = (u16)width,
+        .total_height = (u16)height,
+        .src_width    = (u16)width,
+        .src_height   = (u16)height,
+        .depth        = state->depth,
+        .format       = XCB_IMAGE_FORMAT_Z_PIXMAP,
+        .segment      = buffer->segment
+    };
+    shm_send(state, SHM_PUT_IMAGE, &request, sizeof(request), false);
+    buffer->fence = xcb_get_input_focus(state->connection).sequence;
+    state->shm_last = buffer;
+}
+
+static void shm_init(XcbState* state)
+{
+    char* setting = getenv("FINCH_PRESENT");
+    if (setting != NULL && strcmp(setting, "0") == 0) {
+        return;
+    }
+    const xcb_query_extension_reply_t* extension =
+        xcb_get_extension_data(state->connection, &shm_extension);
+    if (extension == NULL || !extension->present) {
+        FC_ENGINE_INFO("No MIT-SHM, presenting with PutImage");
+        return;
+    }
+    state->shm_enabled = true;
+    FC_ENGINE_INFO("Presenting with MIT-SHM PutImage");
+}
+
+//
+// Present
+//
+
+static void window_deinit(XcbState* state)
+{
+    shm_deinit(state);
+    linux_window_deinit(&state->linux_window);
+    free(state->pending_event);
+    state->pending_event = NULL;
+    if (state->keyboard_mapping_pending) {
+        xcb_discard_reply(state->connection, state->keyboard_mapping.sequence);
+    }
+    xcb_free_gc(state->connection, state->gc);
+    xcb_destroy_window(state->connection, state->window);
+    xcb_disconnect(state->connection);
+}
+
+// Frames larger than the maximum request size are sent in bands of rows
+static void put_image(XcbState* state, const u8* data, u32 width, u32 height)
+{
+    u32 stride = width * (state->bits_per_pixel / 8);
+    // PutImage header, with the extended length of BIG-REQUESTS
+    u64 header_size = sizeof(xcb_put_image_request_t) + 4;
+    u32 rows = (u32)((state->max_request_size - header_size) / stride);
+    rows = rows > 0 ? rows : 1;
+
+    for (u32 y = 0; y < height; y += rows) {
+        u32 band = height - y < rows ? height - y : rows;
+        xcb_put_image(state->connection, XCB_IMAGE_FORMAT_Z_PIXMAP, state->window, state->gc,
+                      (u16)width, (u16)band, 0, (s16)y, 0, state->depth,
+                      band * stride, data + (u64)y * stride);
+    }
+}
+
+static void put_pixelbuffer_on_screen(XcbState* state, ApplicationState* application_state)
+{
+    u32 width, height;
+    const u32* pixels = linux_window_scale_pixelbuffer(&state->linux_window, application_state,
+                                                       &width, &height);
+    state->stats.last_wait_ms = 0.0;
+
+    // Frames are converted or copied straight into a shared memory segment,
+    // otherwise sent from the pixelbuffer or the converted staging copy
+    u64 pixel_count = (u64)width * height;
+    u64 size = pixel_count * (state->bits_per_pixel / 8);
+    XcbShmBuffer* buffer = state->shm_enabled ? shm_acquire(state, size) : NULL;
+    const u8* data = (const u8*)linux_window_convert(&state->linux_window, application_state,
+                                                     pixels, pixel_count,
+                                                     buffer != NULL ? buffer->data : NULL);
+
+    if (buffer != NULL) {
+        shm_put(state, buffer, width, height);
+    } else {
+        put_image(state, data, width, height);
+    }
+    state->stats.presented += 1;
+    xcb_flush(state->connection);
+}
+
+//
+// Events
+//
+
+static u8 event_type(const xcb_generic_event_t* event)
+{
+    return event->response_type & 0x7F;
+}
+
+// Key repeats arrive as a release followed by a press with the same time
+static b32 is_key_repeat(const xcb_generic_event_t* release, const xcb_generic_event_t* next)
+{
+    if (next == NULL || event_type(next) != XCB_KEY_PRESS) {
+        return false;
+    }
+    const xcb_key_release_event_t* released = (const xcb_key_release_event_t*)release;
+    const xcb_key_press_event_t* pressed = (const xcb_key_press_event_t*)next;
+    return pressed->time == released->time && pressed->detail == released->detail;
+}
+
+static void handle_event(XcbState* state, ApplicationState* application_state,
+                         const xcb_generic_event_t* event, FcEvent* finch_event)
+{
+    switch (event_type(event)) {
+        case 0: {
+            const xcb_generic_error_t* error = (const xcb_generic_error_t*)event;
+            FC_ENGINE_WARN_PER_SECOND(1, "X error %u from request %u.%u",
+                                      error->error_code, error->major_code, error->minor_code);
+        } break;
+        case XCB_KEY_PRESS:
+        case XCB_KEY_RELEASE: {
+            const xcb_key_press_event_t* key_event = (const xcb_key_press_event_t*)event;
+            b32 pressed = event_type(event) == XCB_KEY_PRESS;
+            FcKey finch_key = state->keys[key_event->detail];
+            finch_event->server_time_ms = (u32)key_event->time;
+            if (finch_key == FC_KEY_NONE) {
+                if (pressed) {
+                    FC_ENGINE_WARN("Unhandled key press event (Keycode: %u)", key_event->detail);
+                }
+                break;
+            }
+            finch_event->type = pressed ? FC_EVENT_TYPE_KEY_PRESSED : FC_EVENT_TYPE_KEY_RELEASED;
+            finch_event->key = finch_key;
+            application_state->input_state.key_is_down[finch_key] = pressed;
+        } break;
+        case XCB_BUTTON_PRESS:
+        case XCB_BUTTON_RELEASE: {
+            const xcb_button_press_event_t* button = (const xcb_button_press_event_t*)event;
+            finch_event->server_time_ms = (u32)button->time;
+            linux_window_handle_button(&state->linux_window, application_state, button->detail,
+                                       button->event_x, button->event_y,
+                                       event_type(event) == XCB_BUTTON_PRESS, finch_event);
+        } break;
+        case XCB_MOTION_NOTIFY: {
+            const xcb_motion_notify_event_t* motion = (const xcb_motion_notify_event_t*)event;
+            finch_event->server_time_ms = (u32)motion->time;
+            linux_window_handle_motion(&state->linux_window, application_state,
+                                       motion->event_x, motion->event_y, finch_event);
+        } break;
+        case XCB_CLIENT_MESSAGE: {
+            const xcb_client_message_event_t* message = (const xcb_client_message_event_t*)event;
+            if (message->type == state->wm_protocols &&
+                message->data.data32[0] == state->wm_delete_window) {
+                application_state->running = false;
+            }
+        } break;
+        case XCB_EXPOSE: {
+            // Only the last of a series, which together cover the damage.
+            // The main loop presents, so the frame goes through the post
+            // chain.
+            if (((const xcb_expose_event_t*)event)->count == 0) {
+                application_state->present_requested = true;
+            }
+        } break;
+        case XCB_CONFIGURE_NOTIFY: {
+            const xcb_configure_notify_event_t* configure = (const xcb_configure_notify_event_t*)event;
+            if (linux_window_resize(&state->linux_window, application_state,
+                                    configure->width, configure->height)) {
+                finch_event->type = FC_EVENT_TYPE_WINDOW_RESIZED;
+            }
+        } break;
+        case XCB_MAPPING_NOTIFY: {
+            if (((const xcb_mapping_notify_event_t*)event)->request == XCB_MAPPING_KEYBOARD) {
+                keyboard_request_mapping(state);
+                xcb_flush(state->connection);
+            }
+        } break;
+    }
+}
+
+static void handle_events(XcbState* state, ApplicationState* application_state)
+{
+    application_state->unhandled_events = 0;
+    application_state->input_state.mouse_dx = 0;
+    application_state->input_state.mouse_dy = 0;
+    if (xcb_connection_has_error(state->connection)) {
+        FC_ENGINE_ERROR("Lost the connection to the X server");
+        application_state->running = false;
+        return;
+    }
+
+    // The connection is read once, after which the events it returned are
+    // handled in batches. Looking ahead for key repeats only needs to look
+    // at the batch.
+    xcb_generic_event_t* events[EVENT_BATCH_SIZE];
+    b32 read = false;
+    for (;;) {
+        u32 count = 0;
+        if (state->pending_event != NULL) {
+            events[count++] = state->pending_event;
+            state->pending_event = NULL;
+        }
+        while (count < EVENT_BATCH_SIZE) {
+            xcb_generic_event_t* event = read
+                ? xcb_poll_for_queued_event(state->connection)
+                : xcb_poll_for_event(state->connection);
+            read = true;
+            if (event == NULL) {
+                break;
+            }
+            events[count++] = event;
+        }
+        if (count == 0) {
+            break;
+        }
+
+        f64 arrival_time = platform_get_epoch_time();
+        for (u32 i = 0; i < count; ++i) {
+            if (event_type(events[i]) == XCB_KEY_RELEASE) {
+                // The press that may follow is in the next batch
+                if (i + 1 == count && count == EVENT_BATCH_SIZE) {
+                    state->pending_event = events[i];
+                    break;
+                }
+                if (is_key_repeat(events[i], i + 1 < count ? events[i + 1] : NULL)) {
+                    free(events[i]);
+                    free(events[i + 1]);
+                    i += 1;
+                    continue;
+                }
+            }
+
+            FcEvent finch_event = { .arrival_time = arrival_time };
+            handle_event(state, application_state, events[i], &finch_event);
+            free(events[i]);
+
+            // Add event to game's event buffer if it is a finch event
+            if (finch_event.type != FC_EVENT_TYPE_NONE &&
+                application_state->unhandled_events < MAX_EVENTS) {
+                application_state->events[application_state->unhandled_events++] = finch_event;
+            }
+        }
+        if (count < EVENT_BATCH_SIZE) {
+            break;
+        }
+    }
+
+    keyboard_poll_mapping(state);
+}
+
+static XcbState xcb_state;
+
+void platform_init(ApplicationState* application_state)
+{
+    platform_cpu_init();
+    fc_render_select_kernels(platform_get_cpu_features());
+    fc_raster_select_kernels(platform_get_cpu_features());
+    string_select_kernels(platform_get_cpu_features());
+
+    linux_window_init(&xcb_state.linux_window, application_state);
+    window_init(&xcb_state);
+    window_query_pixel_format(&xcb_state);
+    linux_window_negotiate_pixel_format(&xcb_state.linux_window, application_state);
+    shm_init(&xcb_state);
+    linux_window_update_pixelbuffer(&xcb_state.linux_window, application_state);
+}
+
+void platform_deinit(ApplicationState* application_state)
+{
+    window_deinit(&xcb_state);
+    FC_FREE(application_state->pixelbuffer);
+}
+
+void platform_update_render_scale(ApplicationState* application_state)
+{
+    linux_window_update_pixelbuffer(&xcb_state.linux_window, application_state);
+}
+
+void platform_poll_events(ApplicationState* application_state)
+{
+    handle_events(&xcb_state, application_state);
+}
+
+b32 platform_wait_for_events(f64 timeout_seconds)
+{
+    xcb_flush(xcb_state.connection);
+    if (xcb_state.pending_event == NULL) {
+        xcb_state.pending_event = xcb_poll_for_event(xcb_state.connection);
+    }
+    if (xcb_state.pending_event != NULL) {
+        return true;
+    }
+
+    struct pollfd connection = {
+        .fd     = xcb_get_file_descriptor(xcb_state.connection),
+        .events = POLLIN
+    };
+    int timeout_ms = timeout_seconds < 0.0 ? -1 : (int)(timeout_seconds * 1000.0 + 0.999);
+    int ready;
+    do {
+        ready = poll(&connection, 1, timeout_ms);
+    } while (ready < 0 && errno == EINTR);
+    return ready > 0;
+}
+
+void platform_put_pixelbuffer_on_screen(ApplicationState* application_state)
+{
+    put_pixelbuffer_on_screen(&xcb_state, application_state);
+}
+
+void platform_sync_present(void)
+{
+    // The fence of the last shared memory put, or a round trip after PutImage
+    if (xcb_state.shm_last != NULL) {
+        shm_wait_idle(&xcb_state, xcb_state.shm_last);
+    } else {
+        free(xcb_get_input_focus_reply(xcb_state.connection,
+                                       xcb_get_input_focus(xcb_state.connection), NULL));
+    }
+}
+
+void platform_get_present_stats(FcPresentStats* stats)
+{
+    *stats = xcb_state.stats;
+}
+
+WindowAttributes* platform_get_window_attributes(void)
+{
+    return &xcb_state.linux_window.attributes;
+}
+
+void platform_set_window_title(const char* title)
+{
+    xcb_change_property(xcb_state.connection, XCB_PROP_MODE_REPLACE, xcb_state.window,
+                        XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, (u32)strlen(title), title);
+    xcb_flush(xcb_state.connection);
+}
+
+#endif // FINCH_PLATFORM_XCB
@@ -0,0 +1,415 @@
+#include "finch/render/kernels.h"
+#include "finch/platform/cpu.h"
+#include "finch/log/log.h"
+#include "finch/utils/string.h"
+
+//
+// Generic variants
+//
+
+static void fill_u32_generic(u32* dest, u32 value, u64 count)
+{
+    for (u64 i = 0; i < count; ++i) {
+        dest[i] = value;
+    }
+}
+
+static void copy_u32_generic(u32* dest, const u32* src, u64 count)
+{
+    for (u64 i = 0; i < count; ++i) {
+        dest[i] = src[i];
+    }
+}
+
+static void swizzle_u32_generic(u32* dest, const u32* src, u64 count, FcSwizzle swizzle)
+{
+    u32 shift[4], keep[4], set = 0;
+    for (u32 i = 0; i < 4; ++i) {
+        u8 index = swizzle.index[i];
+        keep[i]  = index < 4 ? 0xFF : 0x00;
+        shift[i] = index < 4 ? index * 8 : 0;
+        if (index == FC_SWIZZLE_ONE) {
+            set |= 0xFFu << (i * 8);
+        }
+    }
+
+    for (u64 i = 0; i < count; ++i) {
+        u32 pixel = src[i];
+        dest[i] = ((((pixel >> shift[0]) & keep[0]) << 0)  |
+                   (((pixel >> shift[1]) & keep[1]) << 8)  |
+                   (((pixel >> shift[2]) & keep[2]) << 16) |
+                   (((pixel >> shift[3]) & keep[3]) << 24) | set);
+    }
+}
+
+static void scale_row_nearest_generic(u32* dest, const u32* src, const u32* x_table, u32 count)
+{
+    for (u32 i = 0; i < count; ++i) {
+        dest[i] = src[x_table[i]];
+    }
+}
+
+static void scale_row_bilinear_generic(u32* dest, const u32* src, const u32* x_table, u32 count)
+{
+    for (u32 i = 0; i < count; ++i) {
+        u32 index  = x_table[i] >> 16;
+        u32 weight = (x_table[i] >> 8) & 0xFF;
+        u32 a = src[index], b = src[index + 1];
+        u32 result = 0;
+        for (u32 shift = 0; shift < 32; shift += 8) {
+            u32 ca = (a >> shift) & 0xFF, cb = (b >> shift) & 0xFF;
+            result |= ((ca * (256 - weight) + cb * weight) >> 8) << shift;
+        }
+        dest[i] = result;
+    }
+}
+
+static void lerp_u32_generic(u32* dest, const u32* a, const u32* b, u32 weight, u64 count)
+{
+    for (u64 i = 0; i < count; ++i) {
+        u32 result = 0;
+        for (u32 shift = 0; shift < 32; shift += 8) {
+            u32 ca = (a[i] >> shift) & 0xFF, cb = (b[i] >> shift) & 0xFF;
+            result |= ((ca * (256 - weight) + cb * weight) >> 8) << shift;
+        }
+        dest[i] = result;
+    }
+}
+
+static void blend_mask_u32_generic(u32* dest, const u8* mask, u32 color, u64 count)
+{
+    for (u64 i = 0; i < count; ++i) {
+        // Coverage 255 maps to a weight of 256, so that it is exact
+        u32 weight = mask[i] + (mask[i] >> 7);
+        if (weight == 0) {
+            continue;
+        }
+        u32 result = 0;
+        for (u32 shift = 0; shift < 32; shift += 8) {
+            u32 cd = (dest[i] >> shift) & 0xFF, cc = (color >> shift) & 0xFF;
+            result |= ((cd * (256 - weight) + cc * weight) >> 8) << shift;
+        }
+        dest[i] = result;
+    }
+}
+
+static void blend_over_u32_generic(u32* dest, const u32* src, u32 alpha_shift, u64 count)
+{
+    for (u64 i = 0; i < count; ++i) {
+        u32 alpha = (src[i] >> alpha_shift) & 0xFF;
+        if (alpha == 0) {
+            continue;
+        }
+        if (alpha == 0xFF) {
+            dest[i] = src[i];
+            continue;
+        }
+        u32 weight = alpha + (alpha >> 7);
+        u32 result = 0;
+        for (u32 shift = 0; shift < 32; shift += 8) {
+            u32 cd = (dest[i] >> shift) & 0xFF, cs = (src[i] >> shift) & 0xFF;
+            result |= ((cd * (256 - weight) + cs * weight) >> 8) << shift;
+        }
+        dest[i] = result;
+    }
+}
+
+static u32 blur_pack(const u32 sums[4], u32 scale)
+{
+    u32 result = 0;
+    for (u32 c = 0; c < 4; ++c) {
+        result |= ((sums[c] * scale + 32768) >> 16) << (c * 8);
+    }
+    return result;
+}
+
+static void blur_row_u32(u32* dest, const u32* src, u32 count, u32 radius, u32 scale)
+{
+    u32 sums[4] = {0};
+    s32 last = (s32)count - 1;
+    for (s32 k = -(s32)radius; k <= (s32)radius; ++k) {
+        u32 pixel = src[k < 0 ? 0 : k > last ? last : k];
+        for (u32 c = 0; c < 4; ++c) {
+            sums[c] += (pixel >> (c * 8)) & 0xFF;
+        }
+    }
+    for (u32 x = 0; x < count; ++x) {
+        dest[x] = blur_pack(sums, scale);
+        s32 add = (s32)(x + radius + 1), sub = (s32)x - (s32)radius;
+        u32 added = src[add > last ? last : add], removed = src[sub < 0 ? 0 : sub];
+        for (u32 c = 0; c < 4; ++c) {
+            sums[c] += ((added >> (c * 8)) & 0xFF) - ((removed >> (c * 8)) & 0xFF);
+        }
+    }
+}
+
+static void blur_rows_u32_generic(u32* dest, u32 dest_stride, const u32* src, u32 src_stride,
+                                  u32 rows, u32 count, u32 radius, u32 scale)
+{
+    for (u32 y = 0; y < rows; ++y) {
+        blur_row_u32(dest + (u64)y * dest_stride, src + (u64)y * src_stride, count, radius, scale);
+    }
+}
+
+static void blur_column_u32_generic(u32* dest, u32* sums, const u32* add, const u32* sub,
+                                    u32 count, u32 scale)
+{
+    for (u32 i = 0; i < count; ++i) {
+        dest[i] = blur_pack(sums + i * 4, scale);
+        for (u32 c = 0; c < 4; ++c) {
+            sums[i * 4 + c] += ((add[i] >> (c * 8)) & 0xFF) - ((sub[i] >> (c * 8)) & 0xFF);
+        }
+    }
+}
+
+static void lut_1d_u32_generic(u32* dest, const u32* src, u64 count, const u32* tables)
+{
+    for (u64 i = 0; i < count; ++i) {
+        u32 pixel = src[i];
+        dest[i] = tables[pixel & 0xFF] | tables[256 + ((pixel >> 8) & 0xFF)] |
+                  tables[512 + ((pixel >> 16) & 0xFF)] | tables[768 + (pixel >> 24)];
+    }
+}
+
+// Weights go from 0 (all a) to 256 (all b), two channels per multiply,
+// rounded to nearest
+static u32 lerp_packed(u32 a, u32 b, u32 weight)
+{
+    u32 low  = ((a & 0x00FF00FF) * (256 - weight) + (b & 0x00FF00FF) * weight + 0x00800080) >> 8;
+    u32 high = ((a >> 8) & 0x00FF00FF) * (256 - weight) + ((b >> 8) & 0x00FF00FF) * weight + 0x00800080;
+    return (low & 0x00FF00FF) | (high & 0xFF00FF00);
+}
+
+static void lut_3d_u32_generic(u32* dest, const u32* src, u64 count, const FcLut3dTables* tables)
+{
+    const u32* lattice = tables->lattice;
+    u32 row = tables->size, slice = tables->size * tables->size;
+    for (u64 i = 0; i < count; ++i) {
+        u32 pixel = src[i];
+        u32 r = tables->axes[0][(pixel >> tables->shifts[0]) & 0xFF];
+        u32 g = tables->axes[1][(pixel >> tables->shifts[1]) & 0xFF];
+        u32 b = tables->axes[2][(pixel >> tables->shifts[2]) & 0xFF];
+        const u32* base = lattice + (r >> 9) + (g >> 9) + (b >> 9);
+        u32 wr = r & 0x1FF, wg = g & 0x1FF, wb = b & 0x1FF;
+        u32 c00 = lerp_packed(base[0], base[1], wr);
+        u32 c01 = lerp_packed(base[row], base[row + 1], wr);
+        u32 c10 = lerp_packed(base[slice], base[slice + 1], wr);
+        u32 c11 = lerp_packed(base[slice + row], base[slice + row + 1], wr);
+        u32 c0 = lerp_packed(c00, c01, wg);
+        u32 c1 = lerp_packed(c10, c11, wg);
+        dest[i] = (lerp_packed(c0, c1, wb) & ~tables->alpha_mask) | (pixel & tables->alpha_mask);
+    }
+}
+
+//
+// x86 variants, implemented in kernels_x86.c
+//
+
+#if defined(__x86_64__) || defined(__i386__)
+void fill_u32_sse2(u32* dest, u32 value, u64 count);
+void fill_u32_avx2(u32* dest, u32 value, u64 count);
+void fill_u32_avx512(u32* dest, u32 value, u64 count);
+void copy_u32_sse2(u32* dest, const u32* src, u64 count);
+void copy_u32_avx2(u32* dest, const u32* src, u64 count);
+void copy_u32_avx512(u32* dest, const u32* src, u64 count);
+void swizzle_u32_sse41(u32* dest, const u32* src, u64 count, FcSwizzle swizzle);
+void swizzle_u32_avx2(u32* dest, const u32* src, u64 count, FcSwizzle swizzle);
+void swizzle_u32_avx512(u32* dest, const u32* src, u64 count, FcSwizzle swizzle);
+void scale_row_nearest_avx2(u32* dest, const u32* src, const u32* x_table, u32 count);
+void scale_row_nearest_avx512(u32* dest, const u32* src, const u32* x_table, u32 count);
+void scale_row_bilinear_sse2(u32* dest, const u32* src, const u32* x_table, u32 count);
+void scale_row_bilinear_avx2(u32* dest, const u32* src, const u32* x_table, u32 count);
+void lerp_u32_sse2(u32* dest, const u32* a, const u32* b, u32 weight, u64 count);
+void lerp_u32_avx2(u32* dest, const u32* a, const u32* b, u32 weight, u64 count);
+void blend_mask_u32_sse2(u32* dest, const u8* mask, u32 color, u64 count);
+void blend_mask_u32_avx2(u32* dest, const u8* mask, u32 color, u64 count);
+void blend_over_u32_sse2(u32* dest, const u32* src, u32 alpha_shift, u64 count);
+void blend_over_u32_avx2(u32* dest, const u32* src, u32 alpha_shift, u64 count);
+void blur_rows_u32_sse41(u32* dest, u32 dest_stride, const u32* src, u32 src_stride,
+                         u32 rows, u32 count, u32 radius, u32 scale);
+void blur_rows_u32_avx2(u32* dest, u32 dest_stride, const u32* src, u32 src_stride,
+                        u32 rows, u32 count, u32 radius, u32 scale);
+void blur_column_u32_sse41(u32* dest, u32* sums, const u32* add, const u32* sub,
+                           u32 count, u32 scale);
+void blur_column_u32_avx2(u32* dest, u32* sums, const u32* add, const u32* sub,
+                          u32 count, u32 scale);
+void lut_1d_u32_avx2(u32* dest, const u32* src, u64 count, const u32* tables);
+void lut_3d_u32_avx2(u32* dest, const u32* src, u64 count, const FcLut3dTables* tables);
+#endif
+
+FcRenderKernels fc_render_kernels = {
+    .fill_u32    = fill_u32_generic,
+    .copy_u32    = copy_u32_generic,
+    .swizzle_u32 = swizzle_u32_generic,
+
+    .scale_row_nearest  = scale_row_nearest_generic,
+    .scale_row_bilinear = scale_row_bilinear_generic,
+    .lerp_u32           = lerp_u32_generic,
+
+    .blend_mask_u32 = blend_mask_u32_generic,
+    .blend_over_u32 = blend_over_u32_generic,
+
+    .blur_rows_u32   = blur_rows_u32_generic,
+    .blur_column_u32 = blur_column_u32_generic,
+    .lut_1d_u32      = lut_1d_u32_generic,
+    .lut_3d_u32      = lut_3d_u32_generic,
+
+    .fill_u32_variant    = "generic",
+    .copy_u32_variant    = "generic",
+    .swizzle_u32_variant = "generic",
+    .scale_variant       = "generic",
+    .blend_variant       = "generic",
+    .post_variant        = "generic",
+};
+
+void fc_render_select_kernels(u32 cpu_features)
+{
+    FcRenderKernels kernels = {
+        .fill_u32    = fill_u32_generic,
+        .copy_u32    = copy_u32_generic,
+        .swizzle_u32 = swizzle_u32_generic,
+
+        .scale_row_nearest  = scale_row_nearest_generic,
+        .scale_row_bilinear = scale_row_bilinear_generic,
+        .lerp_u32           = lerp_u32_generic,
+
+        .blend_mask_u32 = blend_mask_u32_generic,
+        .blend_over_u32 = blend_over_u32_generic,
+
+        .blur_rows_u32   = blur_rows_u32_generic,
+        .blur_column_u32 = blur_column_u32_generic,
+        .lut_1d_u32      = lut_1d_u32_generic,
+        .lut_3d_u32      = lut_3d_u32_generic,
+
+        .fill_u32_variant    = "generic",
+        .copy_u32_variant    = "generic",
+        .swizzle_u32_variant = "generic",
+        .scale_variant       = "generic",
+        .blend_variant       = "generic",
+        .post_variant        = "generic",
+    };
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (cpu_features & FC_CPU_FEATURE_SSE2) {
+        kernels.fill_u32 = fill_u32_sse2;
+        kernels.copy_u32 = copy_u32_sse2;
+        kernels.scale_row_bilinear = scale_row_bilinear_sse2;
+        kernels.lerp_u32           = lerp_u32_sse2;
+        kernels.blend_mask_u32     = blend_mask_u32_sse2;
+        kernels.blend_over_u32     = blend_over_u32_sse2;
+        kernels.fill_u32_variant = kernels.copy_u32_variant =
+            kernels.scale_variant = kernels.blend_variant = "sse2";
+    }
+    if (cpu_features & FC_CPU_FEATURE_SSE41) {
+        kernels.swizzle_u32 = swizzle_u32_sse41;
+        kernels.blur_rows_u32   = blur_rows_u32_sse41;
+        kernels.blur_column_u32 = blur_column_u32_sse41;
+        kernels.swizzle_u32_variant = kernels.post_variant = "sse4.1";
+    }
+    if (cpu_features & FC_CPU_FEATURE_AVX2) {
+        kernels.fill_u32    = fill_u32_avx2;
+        kernels.copy_u32    = copy_u32_avx2;
+        kernels.swizzle_u32 = swizzle_u32_avx2;
+        kernels.scale_row_nearest  = scale_row_nearest_avx2;
+        kernels.scale_row_bilinear = scale_row_bilinear_avx2;
+        kernels.lerp_u32           = lerp_u32_avx2;
+        kernels.blend_mask_u32     = blend_mask_u32_avx2;
+        kernels.blend_over_u32     = blend_over_u32_avx2;
+        kernels.blur_rows_u32      = blur_rows_u32_avx2;
+        kernels.blur_column_u32    = blur_column_u32_avx2;
+        kernels.lut_1d_u32         = lut_1d_u32_avx2;
+        kernels.lut_3d_u32         = lut_3d_u32_avx2;
+        kernels.fill_u32_variant = kernels.copy_u32_variant =
+            kernels.swizzle_u32_variant = kernels.scale_variant =
+            kernels.blend_variant = kernels.post_variant = "avx2";
+    }
+    if (cpu_features & FC_CPU_FEATURE_AVX512) {
+        kernels.fill_u32    = fill_u32_avx512;
+        kernels.copy_u32    = copy_u32_avx512;
+        kernels.swizzle_u32 = swizzle_u32_avx512;
+        kernels.scale_row_nearest = scale_row_nearest_avx512;
+        kernels.fill_u32_variant = kernels.copy_u32_variant =
+            kernels.swizzle_u32_variant = kernels.scale_variant = "avx512";
+    }
+#else
+    (void)cpu_features;
+#endif
+
+    fc_render_kernels = kernels;
+    FC_ENGINE_TRACE("Render kernels: fill=%s copy=%s swizzle=%s scale=%s blend=%s post=%s",
+                    kernels.fill_u32_variant, kernels.copy_u32_variant,
+                    kernels.swizzle_u32_variant, kernels.scale_variant,
+                    kernels.blend_variant, kernels.post_variant);
+}
+
+void fc_fill_rect_u32(u32* dest, u32 dest_stride,
+                      u32 x, u32 y, u32 width, u32 height, u32 value)
+{
+    u32* row = dest + x + (u64)y * dest_stride;
+    for (u32 j = 0; j < height; ++j) {
+        fc_render_kernels.fill_u32(row, value, width);
+        row += dest_stride;
+    }
+}
+
+void fc_blit_u32(u32* dest, u32 dest_stride,
+                 const u32* src, u32 src_stride, u32 width, u32 height)
+{
+    if (dest_stride == width && src_stride == width) {
+        fc_render_kernels.copy_u32(dest, src, (u64)width * height);
+        return;
+    }
+    for (u32 j = 0; j < height; ++j) {
+        fc_render_kernels.copy_u32(dest, src, width);
+        dest += dest_stride;
+        src  += src_stride;
+    }
+}
+
+b32 fc_pixel_formats_equal(const FcPixelFormat* a, const FcPixelFormat* b)
+{
+    return a->bits_per_pixel == b->bits_per_pixel &&
+           a->red_shift   == b->red_shift   &&
+           a->green_shift == b->green_shift &&
+           a->blue_shift  == b->blue_shift  &&
+           a->alpha_shift == b->alpha_shift;
+}
+
+FcSwizzle fc_pixel_format_swizzle(const FcPixelFormat* from, const FcPixelFormat* to)
+{
+    // Bytes of the destination no channel maps to (e.g. padding) are set
+    FcSwizzle swizzle = {{
+        FC_SWIZZLE_ONE, FC_SWIZZLE_ONE, FC_SWIZZLE_ONE, FC_SWIZZLE_ONE
+    }};
+    swizzle.index[to->red_shift   / 8] = from->red_shift   / 8;
+    swizzle.index[to->green_shift / 8] = from->green_shift / 8;
+    swizzle.index[to->blue_shift  / 8] = from->blue_shift  / 8;
+    swizzle.index[to->alpha_shift / 8] = from->alpha_shift / 8;
+    return swizzle;
+}
+
+static u32 convert_channel(u32 pixel, u8 from_shift, u32 to_mask)
+{
+    if (to_mask == 0) {
+        return 0;
+    }
+    u32 value = (pixel >> from_shift) & 0xFF;
+    u32 bits  = __builtin_popcount(to_mask);
+    u32 shift = __builtin_ctz(to_mask);
+    return bits >= 8
+        ? (value << (bits - 8) << shift) & to_mask
+        : (value >> (8 - bits) << shift) & to_mask;
+}
+
+void fc_convert_u32_to_u16(u16* dest, const u32* src, u64 count,
+                           const FcPixelFormat* from, const FcPixelFormat* to,
+                           b32 swap_bytes)
+{
+    for (u64 i = 0; i < count; ++i) {
+        u32 pixel = src[i];
+        u16 result = (u16)(convert_channel(pixel, from->red_shift,   to->red_mask)   |
+                           convert_channel(pixel, from->green_shift, to->green_mask) |
+                           convert_channel(pixel, from->blue_shift,  to->blue_mask));
+        dest[i] = swap_bytes ? (u16)((result >> 8) | (result << 8)) : result;
+    }
+}
@@ -0,0 +1,839 @@
+#include "finch/render/kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+#include <string.h>
+
+// Each variant is compiled for its own instruction set with the target
+// attribute and only ever called when the CPU supports it.
+#define TARGET_SSE2   __attribute__((target("sse2")))
+#define TARGET_SSE41  __attribute__((target("sse4.1")))
+#define TARGET_AVX2   __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+
+//
+// Fill
+//
+
+TARGET_SSE2 void fill_u32_sse2(u32* dest, u32 value, u64 count)
+{
+    __m128i v = _mm_set1_epi32((int)value);
+    u64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i*)(dest + i), v);
+    }
+    for (; i < count; ++i) {
+        dest[i] = value;
+    }
+}
+
+TARGET_AVX2 void fill_u32_avx2(u32* dest, u32 value, u64 count)
+{
+    __m256i v = _mm256_set1_epi32((int)value);
+    u64 i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm256_storeu_si256((__m256i*)(dest + i), v);
+        _mm256_storeu_si256((__m256i*)(dest + i + 8), v);
+    }
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256((__m256i*)(dest + i), v);
+    }
+    for (; i < count; ++i) {
+        dest[i] = value;
+    }
+}
+
+TARGET_AVX512 void fill_u32_avx512(u32* dest, u32 value, u64 count)
+{
+    __m512i v = _mm512_set1_epi32((int)value);
+    u64 i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm512_storeu_si512((void*)(dest + i), v);
+    }
+    if (i < count) {
+        __mmask16 tail = (__mmask16)((1u << (count - i)) - 1);
+        _mm512_mask_storeu_epi32((void*)(dest + i), tail, v);
+    }
+}
+
+//
+// Copy
+//
+
+TARGET_SSE2 void copy_u32_sse2(u32* dest, const u32* src, u64 count)
+{
+    u64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i*)(dest + i),
+                         _mm_loadu_si128((const __m128i*)(src + i)));
+    }
+    for (; i < count; ++i) {
+        dest[i] = src[i];
+    }
+}
+
+TARGET_AVX2 void copy_u32_avx2(u32* dest, const u32* src, u64 count)
+{
+    u64 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256((__m256i*)(dest + i),
+                            _mm256_loadu_si256((const __m256i*)(src + i)));
+    }
+    for (; i < count; ++i) {
+        dest[i] = src[i];
+    }
+}
+
+TARGET_AVX512 void copy_u32_avx512(u32* dest, const u32* src, u64 count)
+{
+    u64 i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm512_storeu_si512((void*)(dest + i),
+                            _mm512_loadu_si512((const void*)(src + i)));
+    }
+    if (i < count) {
+        __mmask16 tail = (__mmask16)((1u << (count - i)) - 1);
+        _mm512_mask_storeu_epi32((void*)(dest + i), tail,
+                                 _mm512_maskz_loadu_epi32(tail, (const void*)(src + i)));
+    }
+}
+
+//
+// Swizzle
+//
+
+// Builds the byte shuffle control (for four pixels) and the mask of bytes
+// that are forced to 0xFF
+static void swizzle_controls(FcSwizzle swizzle, u8 control[16], u8 set[16])
+{
+    for (u32 pixel = 0; pixel < 4; ++pixel) {
+        for (u32 i = 0; i < 4; ++i) {
+            u8 index = swizzle.index[i];
+            control[pixel * 4 + i] = index < 4 ? (u8)(pixel * 4 + index) : 0x80;
+            set[pixel * 4 + i]     = index == FC_SWIZZLE_ONE ? 0xFF : 0x00;
+        }
+    }
+}
+
+static void swizzle_tail(u32* dest, const u32* src, u64 count, FcSwizzle swizzle)
+{
+    for (u64 i = 0; i < count; ++i) {
+        u32 pixel = src[i], result = 0;
+        for (u32 b = 0; b < 4; ++b) {
+            u8 index = swizzle.index[b];
+            u32 byte = index < 4 ? (pixel >> (index * 8)) & 0xFF
+                : index == FC_SWIZZLE_ONE ? 0xFF : 0x00;
+            result |= byte << (b * 8);
+        }
+        dest[i] = result;
+    }
+}
+
+TARGET_SSE41 void swizzle_u32_sse41(u32* dest, const u32* src, u64 count, FcSwizzle swizzle)
+{
+    u8 control_bytes[16], set_bytes[16];
+    swizzle_controls(swizzle, control_bytes, set_bytes);
+    __m128i control = _mm_loadu_si128((const __m128i*)control_bytes);
+    __m128i set     = _mm_loadu_si128((const __m128i*)set_bytes);
+
+    u64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(src + i));
+        pixels = _mm_or_si128(_mm_shuffle_epi8(pixels, control), set);
+        _mm_storeu_si128((__m128i*)(dest + i), pixels);
+    }
+    swizzle_tail(dest + i, src + i, count - i, swizzle);
+}
+
+TARGET_AVX2 void swizzle_u32_avx2(u32* dest, const u32* src, u64 count, FcSwizzle swizzle)
+{
+    u8 control_bytes[16], set_bytes[16];
+    swizzle_controls(swizzle, control_bytes, set_bytes);
+    __m256i control = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)control_bytes));
+    __m256i set     = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set_bytes));
+
+    u64 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i pixels = _mm256_loadu_si256((const __m256i*)(src + i));
+        pixels = _mm256_or_si256(_mm256_shuffle_epi8(pixels, control), set);
+        _mm256_storeu_si256((__m256i*)(dest + i), pixels);
+    }
+    swizzle_tail(dest + i, src + i, count - i, swizzle);
+}
+
+TARGET_AVX512 void swizzle_u32_avx512(u32* dest, const u32* src, u64 count, FcSwizzle swizzle)
+{
+    u8 control_bytes[16], set_bytes[16];
+    swizzle_controls(swizzle, control_bytes, set_bytes);
+    __m512i control = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)control_bytes));
+    __m512i set     = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)set_bytes));
+
+    u64 i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i pixels = _mm512_loadu_si512((const void*)(src + i));
+        pixels = _mm512_or_si512(_mm512_shuffle_epi8(pixels, control), set);
+        _mm512_storeu_si512((void*)(dest + i), pixels);
+    }
+    swizzle_tail(dest + i, src + i, count - i, swizzle);
+}
+
+//
+// Scaling
+//
+
+TARGET_AVX2 void scale_row_nearest_avx2(u32* dest, const u32* src, const u32* x_table, u32 count)
+{
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i indices = _mm256_loadu_si256((const __m256i*)(x_table + i));
+        _mm256_storeu_si256((__m256i*)(dest + i),
+                            _mm256_i32gather_epi32((const int*)src, indices, 4));
+    }
+    for (; i < count; ++i) {
+        dest[i] = src[x_table[i]];
+    }
+}
+
+TARGET_AVX512 void scale_row_nearest_avx512(u32* dest, const u32* src, const u32* x_table, u32 count)
+{
+    u32 i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i indices = _mm512_loadu_si512((const void*)(x_table + i));
+        _mm512_storeu_si512((void*)(dest + i),
+                            _mm512_i32gather_epi32(indices, (const void*)src, 4));
+    }
+    for (; i < count; ++i) {
+        dest[i] = src[x_table[i]];
+    }
+}
+
+// Two neighbouring pixels are widened to 16 bits per channel and weighted
+// in one register, then the halves are summed
+TARGET_SSE2 void scale_row_bilinear_sse2(u32* dest, const u32* src, const u32* x_table, u32 count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    const __m128i one  = _mm_set1_epi16(256);
+
+    u32 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        u32 i0 = x_table[i] >> 16,     i1 = x_table[i + 1] >> 16;
+        u32 i2 = x_table[i + 2] >> 16, i3 = x_table[i + 3] >> 16;
+        __m128i left  = _mm_set_epi32((int)src[i3], (int)src[i2], (int)src[i1], (int)src[i0]);
+        __m128i right = _mm_set_epi32((int)src[i3 + 1], (int)src[i2 + 1],
+                                      (int)src[i1 + 1], (int)src[i0 + 1]);
+
+        // Weight of each pixel repeated for its four channels
+        __m128i weight = _mm_and_si128(_mm_srli_epi32(
+            _mm_loadu_si128((const __m128i*)(x_table + i)), 8), mask);
+        weight = _mm_or_si128(weight, _mm_slli_epi32(weight, 16));
+        __m128i weight_lo = _mm_unpacklo_epi32(weight, weight);
+        __m128i weight_hi = _mm_unpackhi_epi32(weight, weight);
+
+        __m128i lo = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_unpacklo_epi8(left, zero), _mm_sub_epi16(one, weight_lo)),
+            _mm_mullo_epi16(_mm_unpacklo_epi8(right, zero), weight_lo));
+        __m128i hi = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_unpackhi_epi8(left, zero), _mm_sub_epi16(one, weight_hi)),
+            _mm_mullo_epi16(_mm_unpackhi_epi8(right, zero), weight_hi));
+        _mm_storeu_si128((__m128i*)(dest + i),
+                         _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+    }
+    for (; i < count; ++i) {
+        u32 index  = x_table[i] >> 16;
+        u32 weight = (x_table[i] >> 8) & 0xFF;
+        u32 result = 0;
+        for (u32 shift = 0; shift < 32; shift += 8) {
+            u32 left = (src[index] >> shift) & 0xFF, right = (src[index + 1] >> shift) & 0xFF;
+            result |= ((left * (256 - weight) + right * weight) >> 8) << shift;
+        }
+        dest[i] = result;
+    }
+}
+
+TARGET_SSE2 void lerp_u32_sse2(u32* dest, const u32* a, const u32* b, u32 weight, u64 count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i wa = _mm_set1_epi16((short)(256 - weight));
+    const __m128i wb = _mm_set1_epi16((short)weight);
+
+    u64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i pa = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i pb = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pa, zero), wa),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(pb, zero), wb));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pa, zero), wa),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(pb, zero), wb));
+        _mm_storeu_si128((__m128i*)(dest + i),
+                         _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+    }
+    for (; i < count; ++i) {
+        u32 result = 0;
+        for (u32 shift = 0; shift < 32; shift += 8) {
+            u32 ca = (a[i] >> shift) & 0xFF, cb = (b[i] >> shift) & 0xFF;
+            result |= ((ca * (256 - weight) + cb * weight) >> 8) << shift;
+        }
+        dest[i] = result;
+    }
+}
+
+TARGET_AVX2 void lerp_u32_avx2(u32* dest, const u32* a, const u32* b, u32 weight, u64 count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i wa = _mm256_set1_epi16((short)(256 - weight));
+    const __m256i wb = _mm256_set1_epi16((short)weight);
+
+    u64 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i pa = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i pb = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(pa, zero), wa),
+                                      _mm256_mullo_epi16(_mm256_unpacklo_epi8(pb, zero), wb));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(pa, zero), wa),
+                                      _mm256_mullo_epi16(_mm256_unpackhi_epi8(pb, zero), wb));
+        _mm256_storeu_si256((__m256i*)(dest + i),
+                            _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8)));
+    }
+    lerp_u32_sse2(dest + i, a + i, b + i, weight, count - i);
+}
+
+TARGET_AVX2 void scale_row_bilinear_avx2(u32* dest, const u32* src, const u32* x_table, u32 count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    const __m256i one  = _mm256_set1_epi16(256);
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i position = _mm256_loadu_si256((const __m256i*)(x_table + i));
+        __m256i index = _mm256_srli_epi32(position, 16);
+        __m256i left  = _mm256_i32gather_epi32((const int*)src, index, 4);
+        __m256i right = _mm256_i32gather_epi32((const int*)(src + 1), index, 4);
+
+        __m256i weight = _mm256_and_si256(_mm256_srli_epi32(position, 8), mask);
+        weight = _mm256_or_si256(weight, _mm256_slli_epi32(weight, 16));
+        __m256i weight_lo = _mm256_unpacklo_epi32(weight, weight);
+        __m256i weight_hi = _mm256_unpackhi_epi32(weight, weight);
+
+        __m256i lo = _mm256_add_epi16(
+            _mm256_mullo_epi16(_mm256_unpacklo_epi8(left, zero), _mm256_sub_epi16(one, weight_lo)),
+            _mm256_mullo_epi16(_mm256_unpacklo_epi8(right, zero), weight_lo));
+        __m256i hi = _mm256_add_epi16(
+            _mm256_mullo_epi16(_mm256_unpackhi_epi8(left, zero), _mm256_sub_epi16(one, weight_hi)),
+            _mm256_mullo_epi16(_mm256_unpackhi_epi8(right, zero), weight_hi));
+        _mm256_storeu_si256((__m256i*)(dest + i),
+                            _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8)));
+    }
+    scale_row_bilinear_sse2(dest + i, src, x_table + i, count - i);
+}
+
+//
+// Coverage blending
+//
+
+TARGET_SSE2 void blend_mask_u32_sse2(u32* dest, const u8* mask, u32 color, u64 count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one  = _mm_set1_epi16(256);
+    const __m128i solid = _mm_set1_epi32((int)color);
+    const __m128i color16 = _mm_unpacklo_epi8(solid, zero);
+
+    u64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        u32 coverage;
+        memcpy(&coverage, mask + i, sizeof(coverage));
+        if (coverage == 0) {
+            continue;
+        }
+        if (coverage == 0xFFFFFFFF) {
+            _mm_storeu_si128((__m128i*)(dest + i), solid);
+            continue;
+        }
+
+        // Coverage of each pixel widened to its four channels, 255 -> 256
+        __m128i weight = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)coverage), zero), zero);
+        weight = _mm_add_epi32(weight, _mm_srli_epi32(weight, 7));
+        weight = _mm_or_si128(weight, _mm_slli_epi32(weight, 16));
+        __m128i weight_lo = _mm_unpacklo_epi32(weight, weight);
+        __m128i weight_hi = _mm_unpackhi_epi32(weight, weight);
+
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(dest + i));
+        __m128i lo = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), _mm_sub_epi16(one, weight_lo)),
+            _mm_mullo_epi16(color16, weight_lo));
+        __m128i hi = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), _mm_sub_epi16(one, weight_hi)),
+            _mm_mullo_epi16(color16, weight_hi));
+        _mm_storeu_si128((__m128i*)(dest + i),
+                         _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+    }
+    for (; i < count; ++i) {
+        u32 weight = mask[i] + (mask[i] >> 7);
+        if (weight == 0) {
+            continue;
+        }
+        u32 result = 0;
+        for (u32 shift = 0; shift < 32; shift += 8) {
+            u32 cd = (dest[i] >> shift) & 0xFF, cc = (color >> shift) & 0xFF;
+            result |= ((cd * (256 - weight) + cc * weight) >> 8) << shift;
+        }
+        dest[i] = result;
+    }
+}
+
+TARGET_AVX2 void blend_mask_u32_avx2(u32* dest, const u8* mask, u32 color, u64 count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one  = _mm256_set1_epi16(256);
+    const __m256i solid = _mm256_set1_epi32((int)color);
+    const __m256i color16 = _mm256_unpacklo_epi8(solid, zero);
+
+    u64 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        u64 coverage;
+        memcpy(&coverage, mask + i, sizeof(coverage));
+        if (coverage == 0) {
+            continue;
+        }
+        if (coverage == ~0ull) {
+            _mm256_storeu_si256((__m256i*)(dest + i), solid);
+            continue;
+        }
+
+        __m256i weight = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128((s64)coverage));
+        weight = _mm256_add_epi32(weight, _mm256_srli_epi32(weight, 7));
+        weight = _mm256_or_si256(weight, _mm256_slli_epi32(weight, 16));
+        __m256i weight_lo = _mm256_unpacklo_epi32(weight, weight);
+        __m256i weight_hi = _mm256_unpackhi_epi32(weight, weight);
+
+        __m256i pixels = _mm256_loadu_si256((const __m256i*)(dest + i));
+        __m256i lo = _mm256_add_epi16(
+            _mm256_mullo_epi16(_mm256_unpacklo_epi8(pixels, zero), _mm256_sub_epi16(one, weight_lo)),
+            _mm256_mullo_epi16(color16, weight_lo));
+        __m256i hi = _mm256_add_epi16(
+            _mm256_mullo_epi16(_mm256_unpackhi_epi8(pixels, zero), _mm256_sub_epi16(one, weight_hi)),
+            _mm256_mullo_epi16(color16, weight_hi));
+        _mm256_storeu_si256((__m256i*)(dest + i),
+                            _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8)));
+    }
+    blend_mask_u32_sse2(dest + i, mask + i, color, count - i);
+}
+
+//
+// Blend over
+//
+
+TARGET_SSE2 void blend_over_u32_sse2(u32* dest, const u32* src, u32 alpha_shift, u64 count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one  = _mm_set1_epi16(256);
+    const __m128i alpha_mask = _mm_set1_epi32((int)(0xFFu << alpha_shift));
+    const __m128i shift = _mm_cvtsi32_si128((int)alpha_shift);
+
+    u64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i alpha = _mm_and_si128(pixels, alpha_mask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xFFFF) {
+            continue;
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alpha_mask)) == 0xFFFF) {
+            _mm_storeu_si128((__m128i*)(dest + i), pixels);
+            continue;
+        }
+
+        // Alpha of each pixel widened to its four channels, 255 -> 256
+        __m128i weight = _mm_srl_epi32(alpha, shift);
+        weight = _mm_add_epi32(weight, _mm_srli_epi32(weight, 7));
+        weight = _mm_or_si128(weight, _mm_slli_epi32(weight, 16));
+        __m128i weight_lo = _mm_unpacklo_epi32(weight, weight);
+        __m128i weight_hi = _mm_unpackhi_epi32(weight, weight);
+
+        __m128i below = _mm_loadu_si128((const __m128i*)(dest + i));
+        __m128i lo = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_unpacklo_epi8(below, zero), _mm_sub_epi16(one, weight_lo)),
+            _mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), weight_lo));
+        __m128i hi = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_unpackhi_epi8(below, zero), _mm_sub_epi16(one, weight_hi)),
+            _mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), weight_hi));
+        _mm_storeu_si128((__m128i*)(dest + i),
+                         _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+    }
+    for (; i < count; ++i) {
+        u32 alpha = (src[i] >> alpha_shift) & 0xFF;
+        if (alpha == 0) {
+            continue;
+        }
+        if (alpha == 0xFF) {
+            dest[i] = src[i];
+            continue;
+        }
+        u32 weight = alpha + (alpha >> 7);
+        u32 result = 0;
+        for (u32 channel = 0; channel < 32; channel += 8) {
+            u32 cd = (dest[i] >> channel) & 0xFF, cs = (src[i] >> channel) & 0xFF;
+            result |= ((cd * (256 - weight) + cs * weight) >> 8) << channel;
+        }
+        dest[i] = result;
+    }
+}
+
+TARGET_AVX2 void blend_over_u32_avx2(u32* dest, const u32* src, u32 alpha_shift, u64 count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one  = _mm256_set1_epi16(256);
+    const __m256i alpha_mask = _mm256_set1_epi32((int)(0xFFu << alpha_shift));
+    const __m128i shift = _mm_cvtsi32_si128((int)alpha_shift);
+
+    u64 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i pixels = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i alpha = _mm256_and_si256(pixels, alpha_mask);
+        if (_mm256_testz_si256(alpha, alpha)) {
+            continue;
+        }
+        if ((u32)_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, alpha_mask)) == 0xFFFFFFFF) {
+            _mm256_storeu_si256((__m256i*)(dest + i), pixels);
+            continue;
+        }
+
+        __m256i weight = _mm256_srl_epi32(alpha, shift);
+        weight = _mm256_add_epi32(weight, _mm256_srli_epi32(weight, 7));
+        weight = _mm256_or_si256(weight, _mm256_slli_epi32(weight, 16));
+        __m256i weight_lo = _mm256_unpacklo_epi32(weight, weight);
+        __m256i weight_hi = _mm256_unpackhi_epi32(weight, weight);
+
+        __m256i below = _mm256_loadu_si256((const __m256i*)(dest + i));
+        __m256i lo = _mm256_add_epi16(
+            _mm256_mullo_epi16(_mm256_unpacklo_epi8(below, zero), _mm256_sub_epi16(one, weight_lo)),
+            _mm256_mullo_epi16(_mm256_unpacklo_epi8(pixels, zero), weight_lo));
+        __m256i hi = _mm256_add_epi16(
+            _mm256_mullo_epi16(_mm256_unpackhi_epi8(below, zero), _mm256_sub_epi16(one, weight_hi)),
+            _mm256_mullo_epi16(_mm256_unpackhi_epi8(pixels, zero), weight_hi));
+        _mm256_storeu_si256((__m256i*)(dest + i),
+                            _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8)));
+    }
+    blend_over_u32_sse2(dest + i, src + i, alpha_shift, count - i);
+}
+
+//
+// Blur
+//
+
+TARGET_SSE41 static inline __m128i blur_expand_sse41(u32 pixel)
+{
+    return _mm_cvtepu8_epi32(_mm_cvtsi32_si128((int)pixel));
+}
+
+TARGET_SSE41 static inline __m128i blur_scale_sse41(__m128i sums, __m128i scale)
+{
+    return _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(sums, scale), _mm_set1_epi32(32768)), 16);
+}
+
+// The row kernels blur four rows at a time. A 4x4 transpose turns four
+// pixels of each row into four registers that each hold one pixel of every
+// row, whose bytes widen to 16-bit window sums: a window is at most 255
+// pixels, so a sum is at most 65025. A short group repeats its last row.
+TARGET_SSE41 static inline void blur_transpose_sse41(__m128i v[4])
+{
+    __m128i t0 = _mm_unpacklo_epi32(v[0], v[1]), t1 = _mm_unpacklo_epi32(v[2], v[3]);
+    __m128i t2 = _mm_unpackhi_epi32(v[0], v[1]), t3 = _mm_unpackhi_epi32(v[2], v[3]);
+    v[0] = _mm_unpacklo_epi64(t0, t1);
+    v[1] = _mm_unpackhi_epi64(t0, t1);
+    v[2] = _mm_unpacklo_epi64(t2, t3);
+    v[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+TARGET_SSE41 static inline __m128i blur_gather_sse41(const u32* const rows[4], s32 x, s32 last)
+{
+    x = x < 0 ? 0 : x > last ? last : x;
+    return _mm_setr_epi32((int)rows[0][x], (int)rows[1][x], (int)rows[2][x], (int)rows[3][x]);
+}
+
+// Pixels x to x + 3 of the four rows, one register per pixel, with the
+// edge pixels repeated outside the row
+TARGET_SSE41 static inline void blur_load_sse41(__m128i v[4], const u32* const rows[4], s32 x, s32 last)
+{
+    if (x >= 0 && x + 3 <= last) {
+        for (u32 k = 0; k < 4; ++k) {
+            v[k] = _mm_loadu_si128((const __m128i*)(rows[k] + x));
+        }
+        blur_transpose_sse41(v);
+    } else {
+        for (u32 k = 0; k < 4; ++k) {
+            v[k] = blur_gather_sse41(rows, x + (s32)k, last);
+        }
+    }
+}
+
+// Transposes the results for pixels x to x + 3 back into the rows
+TARGET_SSE41 static inline void blur_store_sse41(u32* const rows[4], s32 x, s32 last, __m128i v[4])
+{
+    blur_transpose_sse41(v);
+    for (u32 k = 0; k < 4; ++k) {
+        if (x + 3 <= last) {
+            _mm_storeu_si128((__m128i*)(rows[k] + x), v[k]);
+        } else {
+            u32 pixels[4];
+            _mm_storeu_si128((__m128i*)pixels, v[k]);
+            memcpy(rows[k] + x, pixels, (u64)(last - x + 1) * sizeof(u32));
+        }
+    }
+}
+
+// (sums * scale + 32768) >> 16 in 16 bits: the high half of the product,
+// plus one when the low half reaches 32768
+TARGET_SSE41 static inline __m128i blur_scale_u16_sse41(__m128i sums, __m128i scale)
+{
+    return _mm_add_epi16(_mm_mulhi_epu16(sums, scale), _mm_srli_epi16(_mm_mullo_epi16(sums, scale), 15));
+}
+
+TARGET_SSE41 static inline void blur_group_rows(const u32* src_rows[4], u32* dest_rows[4],
+                                                const u32* src, u32 src_stride, u32* dest,
+                                                u32 dest_stride, u32 y, u32 rows)
+{
+    for (u32 k = 0; k < 4; ++k) {
+        u32 row = y + k < rows ? y + k : rows - 1;
+        src_rows[k] = src + (u64)row * src_stride;
+        dest_rows[k] = dest + (u64)row * dest_stride;
+    }
+}
+
+TARGET_SSE41 static inline void blur_copy_rows(u32* dest, u32 dest_stride, const u32* src,
+                                               u32 src_stride, u32 rows, u32 count)
+{
+    for (u32 y = 0; y < rows; ++y) {
+        memcpy(dest + (u64)y * dest_stride, src + (u64)y * src_stride, (u64)count * sizeof(u32));
+    }
+}
+
+TARGET_SSE41 void blur_rows_u32_sse41(u32* dest, u32 dest_stride, const u32* src, u32 src_stride,
+                                      u32 rows, u32 count, u32 radius, u32 scale)
+{
+    // A window of one pixel scales by 65536, which does not fit 16 bits
+    if (radius == 0) {
+        blur_copy_rows(dest, dest_stride, src, src_stride, rows, count);
+        return;
+    }
+    // Two rows' sums per register
+    __m128i scale_v = _mm_set1_epi16((short)scale);
+    s32 last = (s32)count - 1, r = (s32)radius;
+    for (u32 y = 0; y < rows; y += 4) {
+        const u32* src_rows[4];
+        u32* dest_rows[4];
+        blur_group_rows(src_rows, dest_rows, src, src_stride, dest, dest_stride, y, rows);
+
+        __m128i low = _mm_setzero_si128(), high = _mm_setzero_si128();
+        for (s32 k = -r; k <= r; ++k) {
+            __m128i pixels = blur_gather_sse41(src_rows, k, last);
+            low  = _mm_add_epi16(low, _mm_cvtepu8_epi16(pixels));
+            high = _mm_add_epi16(high, _mm_cvtepu8_epi16(_mm_srli_si128(pixels, 8)));
+        }
+        for (s32 x = 0; x <= last; x += 4) {
+            __m128i added[4], removed[4], results[4];
+            blur_load_sse41(added, src_rows, x + r + 1, last);
+            blur_load_sse41(removed, src_rows, x - r, last);
+            for (u32 k = 0; k < 4; ++k) {
+                results[k] = _mm_packus_epi16(blur_scale_u16_sse41(low, scale_v),
+                                              blur_scale_u16_sse41(high, scale_v));
+                low  = _mm_add_epi16(low, _mm_sub_epi16(_mm_cvtepu8_epi16(added[k]),
+                                                        _mm_cvtepu8_epi16(removed[k])));
+                high = _mm_add_epi16(high, _mm_sub_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(added[k], 8)),
+                                                         _mm_cvtepu8_epi16(_mm_srli_si128(removed[k], 8))));
+            }
+            blur_store_sse41(dest_rows, x, last, results);
+        }
+    }
+}
+
+TARGET_AVX2 void blur_rows_u32_avx2(u32* dest, u32 dest_stride, const u32* src, u32 src_stride,
+                                    u32 rows, u32 count, u32 radius, u32 scale)
+{
+    if (radius == 0) {
+        blur_copy_rows(dest, dest_stride, src, src_stride, rows, count);
+        return;
+    }
+    // All four rows' sums in one register; packing leaves rows 0-1 in the
+    // low half and rows 2-3 in the high half, which the permute joins
+    __m256i scale_v = _mm256_set1_epi16((short)scale);
+    s32 last = (s32)count - 1, r = (s32)radius;
+    for (u32 y = 0; y < rows; y += 4) {
+        const u32* src_rows[4];
+        u32* dest_rows[4];
+        blur_group_rows(src_rows, dest_rows, src, src_stride, dest, dest_stride, y, rows);
+
+        __m256i sums = _mm256_setzero_si256();
+        for (s32 k = -r; k <= r; ++k) {
+            sums = _mm256_add_epi16(sums, _mm256_cvtepu8_epi16(blur_gather_sse41(src_rows, k, last)));
+        }
+        for (s32 x = 0; x <= last; x += 4) {
+            __m128i added[4], removed[4], results[4];
+            blur_load_sse41(added, src_rows, x + r + 1, last);
+            blur_load_sse41(removed, src_rows, x - r, last);
+            for (u32 k = 0; k < 4; ++k) {
+                __m256i scaled = _mm256_add_epi16(_mm256_mulhi_epu16(sums, scale_v),
+                                                  _mm256_srli_epi16(_mm256_mullo_epi16(sums, scale_v), 15));
+                scaled = _mm256_packus_epi16(scaled, scaled);
+                results[k] = _mm256_castsi256_si128(_mm256_permute4x64_epi64(scaled, 0x08));
+                sums = _mm256_add_epi16(sums, _mm256_sub_epi16(_mm256_cvtepu8_epi16(added[k]),
+                                                               _mm256_cvtepu8_epi16(removed[k])));
+            }
+            blur_store_sse41(dest_rows, x, last, results);
+        }
+    }
+}
+
+TARGET_SSE41 void blur_column_u32_sse41(u32* dest, u32* sums, const u32* add, const u32* sub,
+                                        u32 count, u32 scale)
+{
+    __m128i scale_v = _mm_set1_epi32((int)scale);
+    u32 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i added   = _mm_loadu_si128((const __m128i*)(add + i));
+        __m128i removed = _mm_loadu_si128((const __m128i*)(sub + i));
+        __m128i results[4];
+        for (u32 k = 0; k < 4; ++k) {
+            __m128i* sum = (__m128i*)(sums + (i + k) * 4);
+            __m128i value = _mm_loadu_si128(sum);
+            results[k] = blur_scale_sse41(value, scale_v);
+            value = _mm_add_epi32(value, _mm_sub_epi32(_mm_cvtepu8_epi32(added),
+                                                       _mm_cvtepu8_epi32(removed)));
+            _mm_storeu_si128(sum, value);
+            added   = _mm_srli_si128(added, 4);
+            removed = _mm_srli_si128(removed, 4);
+        }
+        __m128i packed = _mm_packus_epi16(_mm_packus_epi32(results[0], results[1]),
+                                          _mm_packus_epi32(results[2], results[3]));
+        _mm_storeu_si128((__m128i*)(dest + i), packed);
+    }
+    for (; i < count; ++i) {
+        __m128i* sum = (__m128i*)(sums + i * 4);
+        __m128i value = _mm_loadu_si128(sum);
+        __m128i result = blur_scale_sse41(value, scale_v);
+        result = _mm_packus_epi16(_mm_packus_epi32(result, result), result);
+        dest[i] = (u32)_mm_cvtsi128_si32(result);
+        _mm_storeu_si128(sum, _mm_add_epi32(value, _mm_sub_epi32(blur_expand_sse41(add[i]),
+                                                                 blur_expand_sse41(sub[i]))));
+    }
+}
+
+TARGET_AVX2 void blur_column_u32_avx2(u32* dest, u32* sums, const u32* add, const u32* sub,
+                                      u32 count, u32 scale)
+{
+    // Two pixels' sums per register; packing interleaves the pixels across
+    // the two halves, which the final permute undoes
+    __m256i scale_v = _mm256_set1_epi32((int)scale);
+    __m256i half = _mm256_set1_epi32(32768);
+    __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i results[4];
+        for (u32 k = 0; k < 4; ++k) {
+            __m256i* sum = (__m256i*)(sums + (i + k * 2) * 4);
+            __m256i value = _mm256_loadu_si256(sum);
+            results[k] = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(value, scale_v), half), 16);
+            __m256i added   = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(add + i + k * 2)));
+            __m256i removed = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(sub + i + k * 2)));
+            _mm256_storeu_si256(sum, _mm256_add_epi32(value, _mm256_sub_epi32(added, removed)));
+        }
+        __m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(results[0], results[1]),
+                                             _mm256_packus_epi32(results[2], results[3]));
+        _mm256_storeu_si256((__m256i*)(dest + i), _mm256_permutevar8x32_epi32(packed, order));
+    }
+    blur_column_u32_sse41(dest + i, sums + i * 4, add + i, sub + i, count - i, scale);
+}
+
+//
+// Lookup tables
+//
+
+TARGET_AVX2 void lut_1d_u32_avx2(u32* dest, const u32* src, u64 count, const u32* tables)
+{
+    __m256i byte = _mm256_set1_epi32(0xFF);
+    u64 i = 0;
+    for (; i < count; i += 8) {
+        // The tail is loaded and stored masked
+        u64 left = count - i < 8 ? count - i : 8;
+        __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32((int)left),
+                                          _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256i pixels = _mm256_maskload_epi32((const int*)(src + i), mask);
+        __m256i result = _mm256_i32gather_epi32((const int*)tables, _mm256_and_si256(pixels, byte), 4);
+        result = _mm256_or_si256(result, _mm256_i32gather_epi32(
+            (const int*)(tables + 256), _mm256_and_si256(_mm256_srli_epi32(pixels, 8), byte), 4));
+        result = _mm256_or_si256(result, _mm256_i32gather_epi32(
+            (const int*)(tables + 512), _mm256_and_si256(_mm256_srli_epi32(pixels, 16), byte), 4));
+        result = _mm256_or_si256(result, _mm256_i32gather_epi32(
+            (const int*)(tables + 768), _mm256_srli_epi32(pixels, 24), 4));
+        _mm256_maskstore_epi32((int*)(dest + i), mask, result);
+    }
+}
+
+// Same as the generic lerp, with each channel in a 16-bit lane
+TARGET_AVX2 static inline __m256i lerp_packed_avx2(__m256i a, __m256i b, __m256i weight)
+{
+    __m256i even = _mm256_set1_epi32(0x00FF00FF);
+    __m256i inverse = _mm256_sub_epi16(_mm256_set1_epi16(256), weight);
+    __m256i round = _mm256_set1_epi16(128);
+    __m256i low = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_and_si256(a, even), inverse),
+                                   _mm256_mullo_epi16(_mm256_and_si256(b, even), weight));
+    __m256i high = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi32(a, 8), even), inverse),
+        _mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi32(b, 8), even), weight));
+    low = _mm256_add_epi16(low, round);
+    high = _mm256_add_epi16(high, round);
+    return _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(low, 8), even),
+                           _mm256_andnot_si256(even, high));
+}
+
+TARGET_AVX2 void lut_3d_u32_avx2(u32* dest, const u32* src, u64 count, const FcLut3dTables* tables)
+{
+    const int* lattice = (const int*)tables->lattice;
+    __m256i byte = _mm256_set1_epi32(0xFF);
+    __m256i weight_mask = _mm256_set1_epi32(0x1FF);
+    __m256i row = _mm256_set1_epi32((int)tables->size);
+    __m256i slice = _mm256_set1_epi32((int)(tables->size * tables->size));
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i alpha = _mm256_set1_epi32((int)tables->alpha_mask);
+    u64 i = 0;
+    for (; i < count; i += 8) {
+        u64 left = count - i < 8 ? count - i : 8;
+        __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32((int)left),
+                                          _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256i pixels = _mm256_maskload_epi32((const int*)(src + i), mask);
+
+        __m256i axis[3], weight[3];
+        __m256i base = _mm256_setzero_si256();
+        for (u32 c = 0; c < 3; ++c) {
+            __m256i value = _mm256_and_si256(_mm256_srl_epi32(pixels, _mm_cvtsi32_si128(tables->shifts[c])), byte);
+            axis[c] = _mm256_i32gather_epi32((const int*)tables->axes[c], value, 4);
+            base = _mm256_add_epi32(base, _mm256_srli_epi32(axis[c], 9));
+            weight[c] = _mm256_and_si256(axis[c], weight_mask);
+            weight[c] = _mm256_or_si256(weight[c], _mm256_slli_epi32(weight[c], 16));
+        }
+
+        __m256i base_row = _mm256_add_epi32(base, row);
+        __m256i base_slice = _mm256_add_epi32(base, slice);
+        __m256i base_both = _mm256_add_epi32(base_slice, row);
+        __m256i c00 = lerp_packed_avx2(_mm256_i32gather_epi32(lattice, base, 4),
+                                       _mm256_i32gather_epi32(lattice, _mm256_add_epi32(base, one), 4),
+                                       weight[0]);
+        __m256i c01 = lerp_packed_avx2(_mm256_i32gather_epi32(lattice, base_row, 4),
+                                       _mm256_i32gather_epi32(lattice, _mm256_add_epi32(base_row, one), 4),
+                                       weight[0]);
+        __m256i c10 = lerp_packed_avx2(_mm256_i32gather_epi32(lattice, base_slice, 4),
+                                       _mm256_i32gather_epi32(lattice, _mm256_add_epi32(base_slice, one), 4),
+                                       weight[0]);
+        __m256i c11 = lerp_packed_avx2(_mm256_i32gather_epi32(lattice, base_both, 4),
+                                       _mm256_i32gather_epi32(lattice, _mm256_add_epi32(base_both, one), 4),
+                                       weight[0]);
+        __m256i c0 = lerp_packed_avx2(c00, c01, weight[1]);
+        __m256i c1 = lerp_packed_avx2(c10, c11, weight[1]);
+        __m256i result = lerp_packed_avx2(c0, c1, weight[2]);
+        result = _mm256_or_si256(_mm256_andnot_si256(alpha, result), _mm256_and_si256(pixels, alpha));
+        _mm256_maskstore_epi32((int*)(dest + i), mask, result);
+    }
+}
+
+#endif
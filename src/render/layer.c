@@ -0,0 +1,274 @@
+#include "finch/render/layer.h"
+#include "finch/render/kernels.h"
+#include "finch/core/memory.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+
+static s32 min_s32(s32 a, s32 b) { return a < b ? a : b; }
+static s32 max_s32(s32 a, s32 b) { return a > b ? a : b; }
+
+static b32 rect_is_empty(FcRect rect)
+{
+    return rect.width <= 0 || rect.height <= 0;
+}
+
+static FcRect rect_intersect(FcRect a, FcRect b)
+{
+    s32 x0 = max_s32(a.x, b.x), y0 = max_s32(a.y, b.y);
+    s32 x1 = min_s32(a.x + a.width, b.x + b.width);
+    s32 y1 = min_s32(a.y + a.height, b.y + b.height);
+    return (FcRect){ x0, y0, x1 - x0, y1 - y0 };
+}
+
+static FcRect rect_union(FcRect a, FcRect b)
+{
+    s32 x0 = min_s32(a.x, b.x), y0 = min_s32(a.y, b.y);
+    s32 x1 = max_s32(a.x + a.width, b.x + b.width);
+    s32 y1 = max_s32(a.y + a.height, b.y + b.height);
+    return (FcRect){ x0, y0, x1 - x0, y1 - y0 };
+}
+
+static b32 rect_contains(FcRect outer, FcRect inner)
+{
+    return inner.x >= outer.x && inner.y >= outer.y &&
+        inner.x + inner.width <= outer.x + outer.width &&
+        inner.y + inner.height <= outer.y + outer.height;
+}
+
+static FcRect layer_screen_rect(const FcLayer* layer)
+{
+    return (FcRect){ layer->x, layer->y, (s32)layer->width, (s32)layer->height };
+}
+
+void fc_compositor_init(FcCompositor* compositor, const FcPixelFormat* format, u32 clear_color)
+{
+    *compositor = (FcCompositor){
+        .alpha_shift = format->alpha_mask != 0 ? format->alpha_shift : 24,
+        .clear_color = clear_color
+    };
+}
+
+void fc_compositor_free(FcCompositor* compositor)
+{
+    for (u32 i = 0; i < FC_COMPOSITOR_MAX_LAYERS; ++i) {
+        if (compositor->layers[i].in_use) {
+            FC_FREE(compositor->layers[i].pixels);
+        }
+    }
+    *compositor = (FcCompositor){0};
+}
+
+FcLayer* fc_compositor_add_layer(FcCompositor* compositor, const FcLayerDesc* desc)
+{
+    FcLayer* layer = NULL;
+    for (u32 i = 0; i < FC_COMPOSITOR_MAX_LAYERS && layer == NULL; ++i) {
+        if (!compositor->layers[i].in_use) {
+            layer = &compositor->layers[i];
+        }
+    }
+    if (layer == NULL || desc->width == 0 || desc->height == 0) {
+        FC_ENGINE_ERROR("Cannot add a %ux%u layer", desc->width, desc->height);
+        return NULL;
+    }
+
+    u32* pixels = (u32*)FC_ALLOC_ZEROED((u64)desc->width * desc->height * sizeof(u32), "layer");
+    if (pixels == NULL) {
+        return NULL;
+    }
+    *layer = (FcLayer){
+        .pixels = pixels,
+        .width  = desc->width,
+        .height = desc->height,
+        .x      = desc->x,
+        .y      = desc->y,
+        .z      = desc->z,
+        .blend  = desc->blend,
+        .visible = true,
+        .draw   = desc->draw,
+        .data   = desc->data,
+        .in_use = true
+    };
+    fc_layer_invalidate(layer, NULL);
+
+    // Above every layer with the same or a lower z
+    u32 position = compositor->layer_count;
+    while (position > 0 && compositor->order[position - 1]->z > layer->z) {
+        compositor->order[position] = compositor->order[position - 1];
+        position -= 1;
+    }
+    compositor->order[position] = layer;
+    compositor->layer_count += 1;
+    return layer;
+}
+
+void fc_compositor_remove_layer(FcCompositor* compositor, FcLayer* layer)
+{
+    if (layer->visible) {
+        FcRect rect = layer_screen_rect(layer);
+        fc_compositor_damage(compositor, &rect);
+    }
+
+    u32 position = 0;
+    while (position < compositor->layer_count && compositor->order[position] != layer) {
+        position += 1;
+    }
+    for (; position + 1 < compositor->layer_count; ++position) {
+        compositor->order[position] = compositor->order[position + 1];
+    }
+    compositor->layer_count -= 1;
+
+    FC_FREE(layer->pixels);
+    *layer = (FcLayer){0};
+}
+
+void fc_compositor_move_layer(FcCompositor* compositor, FcLayer* layer, s32 x, s32 y)
+{
+    if (layer->x == x && layer->y == y) {
+        return;
+    }
+    FcRect before = layer_screen_rect(layer);
+    layer->x = x;
+    layer->y = y;
+    if (layer->visible) {
+        FcRect after = layer_screen_rect(layer);
+        fc_compositor_damage(compositor, &before);
+        fc_compositor_damage(compositor, &after);
+    }
+}
+
+void fc_compositor_set_layer_visible(FcCompositor* compositor, FcLayer* layer, b32 visible)
+{
+    if (layer->visible != visible) {
+        layer->visible = visible;
+        FcRect rect = layer_screen_rect(layer);
+        fc_compositor_damage(compositor, &rect);
+    }
+}
+
+void fc_layer_invalidate(FcLayer* layer, const FcRect* region)
+{
+    FcRect all = { 0, 0, (s32)layer->width, (s32)layer->height };
+    FcRect rect = region != NULL ? rect_intersect(*region, all) : all;
+    if (rect_is_empty(rect)) {
+        return;
+    }
+    layer->dirty_region = layer->dirty ? rect_union(layer->dirty_region, rect) : rect;
+    layer->dirty = true;
+}
+
+void fc_compositor_damage(FcCompositor* compositor, const FcRect* region)
+{
+    // The size is only known at render, where damage is clipped
+    FcRect rect = region != NULL ? *region : (FcRect){ 0, 0, INT32_MAX / 2, INT32_MAX / 2 };
+    if (rect_is_empty(rect)) {
+        return;
+    }
+
+    // Overlapping regions are merged, which at worst rebuilds some pixels
+    // twice as cheaply as keeping them apart
+    for (u32 i = 0; i < compositor->damage_count; ++i) {
+        if (!rect_is_empty(rect_intersect(compositor->damage[i], rect))) {
+            compositor->damage[i] = rect_union(compositor->damage[i], rect);
+            return;
+        }
+    }
+    if (compositor->damage_count == FC_COMPOSITOR_MAX_DAMAGE) {
+        for (u32 i = 1; i < compositor->damage_count; ++i) {
+            rect = rect_union(rect, compositor->damage[i]);
+        }
+        compositor->damage[0] = rect_union(compositor->damage[0], rect);
+        compositor->damage_count = 1;
+        return;
+    }
+    compositor->damage[compositor->damage_count++] = rect;
+}
+
+static void composite_region(FcCompositor* compositor, u32* pixels, u32 stride, FcRect region)
+{
+    // Nothing below the topmost opaque layer covering the region shows
+    u32 first = 0;
+    b32 covered = false;
+    for (u32 i = compositor->layer_count; i > 0; --i) {
+        const FcLayer* layer = compositor->order[i - 1];
+        if (layer->visible && layer->blend == FC_LAYER_BLEND_OPAQUE &&
+            rect_contains(layer_screen_rect(layer), region)) {
+            first = i - 1;
+            covered = true;
+            break;
+        }
+    }
+    if (!covered) {
+        fc_fill_rect_u32(pixels, stride, (u32)region.x, (u32)region.y,
+                         (u32)region.width, (u32)region.height, compositor->clear_color);
+    }
+
+    for (u32 i = first; i < compositor->layer_count; ++i) {
+        const FcLayer* layer = compositor->order[i];
+        FcRect rect = rect_intersect(region, layer_screen_rect(layer));
+        if (!layer->visible || rect_is_empty(rect)) {
+            continue;
+        }
+        u32* dest = pixels + (u64)rect.y * stride + rect.x;
+        const u32* src = layer->pixels + (u64)(rect.y - layer->y) * layer->width + (rect.x - layer->x);
+        if (layer->blend == FC_LAYER_BLEND_OPAQUE) {
+            fc_blit_u32(dest, stride, src, layer->width, (u32)rect.width, (u32)rect.height);
+        } else {
+            for (s32 y = 0; y < rect.height; ++y) {
+                fc_blend_over_u32(dest, src, compositor->alpha_shift, (u64)rect.width);
+                dest += stride;
+                src += layer->width;
+            }
+        }
+        compositor->pixels_composited += (u64)rect.width * rect.height;
+    }
+}
+
+b32 fc_compositor_render(FcCompositor* compositor, u32* pixels, u32 width, u32 height)
+{
+    compositor->layers_drawn = 0;
+    compositor->pixels_composited = 0;
+
+    if (width != compositor->width || height != compositor->height) {
+        compositor->width = width;
+        compositor->height = height;
+        fc_compositor_damage(compositor, NULL);
+    }
+
+    for (u32 i = 0; i < compositor->layer_count; ++i) {
+        FcLayer* layer = compositor->order[i];
+        // Hidden layers are redrawn once they are shown
+        if (!layer->dirty || !layer->visible) {
+            continue;
+        }
+        if (layer->draw != NULL) {
+            layer->draw(layer, layer->dirty_region, layer->data);
+        }
+        layer->dirty = false;
+        compositor->layers_drawn += 1;
+
+        FcRect rect = layer->dirty_region;
+        rect.x += layer->x;
+        rect.y += layer->y;
+        fc_compositor_damage(compositor, &rect);
+    }
+
+    if (compositor->damage_count == 0) {
+        return false;
+    }
+    if (compositor->composite_all) {
+        compositor->damage[0] = (FcRect){ 0, 0, (s32)width, (s32)height };
+        compositor->damage_count = 1;
+    }
+
+    FcRect screen = { 0, 0, (s32)width, (s32)height };
+    b32 changed = false;
+    for (u32 i = 0; i < compositor->damage_count; ++i) {
+        FcRect region = rect_intersect(compositor->damage[i], screen);
+        if (!rect_is_empty(region)) {
+            composite_region(compositor, pixels, width, region);
+            changed = true;
+        }
+    }
+    compositor->damage_count = 0;
+    return changed;
+}
@@ -0,0 +1,557 @@
+#include "finch/render/post.h"
+#include "finch/core/jobs.h"
+#include "finch/core/memory.h"
+#include "finch/platform/platform.h"
+#include "finch/render/kernels.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Gaussian blurs are three box blurs, each pass sized so their variances
+// add up to sigma^2
+#define GAUSSIAN_BOXES 3
+
+typedef struct _BlurPass {
+    const u32* src;
+    u32* dest;
+    u32  src_stride, dest_stride;
+    u32  width, height;
+    u32  radius, scale;
+    u32* column_sums;
+} BlurPass;
+
+typedef struct _PointStep {
+    FcPostFilterType type;
+    const u32* tables;          // Tone
+    FcLut3dTables lut_3d;       // Colour grade
+} PointStep;
+
+typedef struct _PointPass {
+    const u32* src;
+    u32* dest;
+    u32  src_stride, dest_stride, width;
+    PointStep steps[FC_POST_MAX_FILTERS];
+    u32  step_count;
+} PointPass;
+
+//
+// Chain
+//
+
+void fc_post_chain_init(FcPostChain* chain, b32 parallel)
+{
+    memset(chain, 0, sizeof(FcPostChain));
+    chain->parallel = parallel;
+}
+
+void fc_post_chain_free(FcPostChain* chain)
+{
+    FC_FREE(chain->output);
+    FC_FREE(chain->scratch);
+    FC_FREE(chain->column_sums);
+    chain->output = NULL;
+    chain->scratch = NULL;
+    chain->column_sums = NULL;
+    chain->width = chain->height = 0;
+}
+
+static FcPostFilter* add_filter(FcPostChain* chain, FcPostFilterType type)
+{
+    if (chain->filter_count == FC_POST_MAX_FILTERS) {
+        FC_ENGINE_WARN("Post-processing chain is full");
+        return NULL;
+    }
+    FcPostFilter* filter = &chain->filters[chain->filter_count++];
+    memset(filter, 0, sizeof(FcPostFilter));
+    filter->type = type;
+    filter->enabled = true;
+    return filter;
+}
+
+FcPostFilter* fc_post_chain_add_box_blur(FcPostChain* chain, u32 radius)
+{
+    FcPostFilter* filter = add_filter(chain, FC_POST_FILTER_BOX_BLUR);
+    if (filter != NULL) {
+        filter->radius = radius;
+    }
+    return filter;
+}
+
+FcPostFilter* fc_post_chain_add_gaussian_blur(FcPostChain* chain, f32 sigma)
+{
+    FcPostFilter* filter = add_filter(chain, FC_POST_FILTER_GAUSSIAN_BLUR);
+    if (filter != NULL) {
+        filter->sigma = sigma;
+    }
+    return filter;
+}
+
+FcPostFilter* fc_post_chain_add_tone(FcPostChain* chain, FcToneLut* lut)
+{
+    FcPostFilter* filter = add_filter(chain, FC_POST_FILTER_TONE);
+    if (filter != NULL) {
+        filter->tone = lut;
+    }
+    return filter;
+}
+
+FcPostFilter* fc_post_chain_add_color_grade(FcPostChain* chain, FcColorLut* lut)
+{
+    FcPostFilter* filter = add_filter(chain, FC_POST_FILTER_COLOR_GRADE);
+    if (filter != NULL) {
+        filter->color = lut;
+    }
+    return filter;
+}
+
+static b32 allocate_buffers(FcPostChain* chain, u32 width, u32 height)
+{
+    fc_post_chain_free(chain);
+    u32 strips = (width + FC_POST_STRIP_WIDTH - 1) / FC_POST_STRIP_WIDTH;
+    chain->output = (u32*)FC_ALLOC_ALIGNED((u64)width * height * sizeof(u32), 64, "post");
+    chain->scratch = (u32*)FC_ALLOC_ALIGNED((u64)width * height * sizeof(u32), 64, "post");
+    chain->column_sums = (u32*)FC_ALLOC_ALIGNED((u64)strips * FC_POST_STRIP_WIDTH * 4 * sizeof(u32),
+                                                64, "post");
+    if (chain->output == NULL || chain->scratch == NULL || chain->column_sums == NULL) {
+        FC_ENGINE_ERROR("Could not allocate post-processing buffers for %ux%u pixels", width, height);
+        fc_post_chain_free(chain);
+        return false;
+    }
+    chain->width = width;
+    chain->height = height;
+    fc_memory_allow_frame();
+    return true;
+}
+
+//
+// Blur
+//
+
+static void blur_rows(void* data, u32 begin, u32 end)
+{
+    BlurPass* pass = (BlurPass*)data;
+    fc_render_kernels.blur_rows_u32(pass->dest + (u64)begin * pass->dest_stride, pass->dest_stride,
+                                    pass->src + (u64)begin * pass->src_stride, pass->src_stride,
+                                    end - begin, pass->width, pass->radius, pass->scale);
+}
+
+static void blur_columns(void* data, u32 begin, u32 end)
+{
+    static const u32 zeros[FC_POST_STRIP_WIDTH];
+    BlurPass* pass = (BlurPass*)data;
+    s32 radius = (s32)pass->radius, last = (s32)pass->height - 1;
+    u32 discard[FC_POST_STRIP_WIDTH];
+
+    for (u32 strip = begin; strip < end; ++strip) {
+        u32 x = strip * FC_POST_STRIP_WIDTH;
+        u32 count = pass->width - x < FC_POST_STRIP_WIDTH ? pass->width - x : FC_POST_STRIP_WIDTH;
+        u32* sums = pass->column_sums + (u64)x * 4;
+        const u32* src = pass->src + x;
+
+        // The window of the first row, its top edge repeated, is summed by
+        // the same kernel with nothing to remove
+        memset(sums, 0, count * 4 * sizeof(u32));
+        for (s32 k = -radius; k <= radius; ++k) {
+            s32 row = k < 0 ? 0 : k > last ? last : k;
+            fc_render_kernels.blur_column_u32(discard, sums, src + (u64)row * pass->src_stride,
+                                              zeros, count, pass->scale);
+        }
+        for (s32 y = 0; y <= last; ++y) {
+            s32 add = y + radius + 1, sub = y - radius;
+            fc_render_kernels.blur_column_u32(pass->dest + (u64)y * pass->dest_stride + x, sums,
+                                              src + (u64)(add > last ? last : add) * pass->src_stride,
+                                              src + (u64)(sub < 0 ? 0 : sub) * pass->src_stride,
+                                              count, pass->scale);
+        }
+    }
+}
+
+static void blur_pass(FcPostChain* chain, BlurPass* pass, b32 vertical)
+{
+    pass->radius = pass->radius > FC_POST_MAX_BLUR_RADIUS ? FC_POST_MAX_BLUR_RADIUS : pass->radius;
+    pass->scale = 65536 / (2 * pass->radius + 1);
+    pass->column_sums = chain->column_sums;
+    FcJobRangeFn fn = vertical ? blur_columns : blur_rows;
+    u32 count = vertical ? (pass->width + FC_POST_STRIP_WIDTH - 1) / FC_POST_STRIP_WIDTH : pass->height;
+    u32 batch = vertical ? 1 : FC_POST_BAND_ROWS;
+    if (chain->parallel) {
+        fc_jobs_parallel_for(count, batch, fn, pass);
+    } else {
+        fn(pass, 0, count);
+    }
+}
+
+// Box sizes from "Fast Almost-Gaussian Filtering" (Kovesi 2010): the
+// smaller odd size for the first boxes and the next one for the rest
+static void gaussian_radii(f32 sigma, u32 radii[GAUSSIAN_BOXES])
+{
+    f32 variance = sigma * sigma;
+    f32 ideal = sqrtf(12.0f * variance / GAUSSIAN_BOXES + 1.0f);
+    s32 lower = (s32)floorf(ideal);
+    if (lower % 2 == 0) {
+        lower--;
+    }
+    s32 smaller = (s32)roundf((12.0f * variance - GAUSSIAN_BOXES * lower * lower -
+                               4.0f * GAUSSIAN_BOXES * lower - 3.0f * GAUSSIAN_BOXES) /
+                              (-4.0f * lower - 4.0f));
+    for (s32 i = 0; i < GAUSSIAN_BOXES; ++i) {
+        radii[i] = (u32)((i < smaller ? lower : lower + 2) - 1) / 2;
+    }
+}
+
+static void box_blur(FcPostChain* chain, const u32* src, u32 src_stride, u32 radius)
+{
+    BlurPass pass = {
+        .src = src, .dest = chain->scratch, .src_stride = src_stride, .dest_stride = chain->width,
+        .width = chain->width, .height = chain->height, .radius = radius,
+    };
+    blur_pass(chain, &pass, false);
+    pass.src = chain->scratch;
+    pass.dest = chain->output;
+    pass.src_stride = chain->width;
+    pass.radius = radius;
+    blur_pass(chain, &pass, true);
+}
+
+static void gaussian_blur(FcPostChain* chain, const u32* src, u32 src_stride, f32 sigma)
+{
+    u32 radii[GAUSSIAN_BOXES];
+    gaussian_radii(sigma, radii);
+
+    // Passes alternate between scratch and the output, so three along the
+    // rows and three along the columns end in the output
+    for (u32 i = 0; i < 2 * GAUSSIAN_BOXES; ++i) {
+        b32 to_scratch = i % 2 == 0;
+        BlurPass pass = {
+            .src = i == 0 ? src : to_scratch ? chain->output : chain->scratch,
+            .dest = to_scratch ? chain->scratch : chain->output,
+            .src_stride = i == 0 ? src_stride : chain->width, .dest_stride = chain->width,
+            .width = chain->width, .height = chain->height, .radius = radii[i % GAUSSIAN_BOXES],
+        };
+        blur_pass(chain, &pass, i >= GAUSSIAN_BOXES);
+    }
+}
+
+//
+// Lookup tables
+//
+
+static void tone_lut_prepare(FcToneLut* lut, const FcPixelFormat* format)
+{
+    if (!lut->dirty && fc_pixel_formats_equal(&lut->format, format)) {
+        return;
+    }
+    // Alpha, or any byte no channel uses, is kept
+    for (u32 byte = 0; byte < 4; ++byte) {
+        u32 shift = byte * 8;
+        const u8* curve = shift == format->red_shift   ? lut->curves[0] :
+                          shift == format->green_shift ? lut->curves[1] :
+                          shift == format->blue_shift  ? lut->curves[2] : NULL;
+        for (u32 v = 0; v < 256; ++v) {
+            lut->tables[byte * 256 + v] = (u32)(curve != NULL ? curve[v] : v) << shift;
+        }
+    }
+    lut->format = *format;
+    lut->dirty = false;
+}
+
+static void color_lut_prepare(FcColorLut* lut, const FcPixelFormat* format)
+{
+    if (!lut->dirty && fc_pixel_formats_equal(&lut->format, format)) {
+        return;
+    }
+    u32 size = lut->size, count = size * size * size;
+    for (u32 i = 0; i < count; ++i) {
+        const u8* color = lut->colors + (u64)i * 3;
+        lut->lattice[i] = ((u32)color[0] << format->red_shift) |
+                          ((u32)color[1] << format->green_shift) |
+                          ((u32)color[2] << format->blue_shift);
+    }
+
+    // Values map onto the lattice linearly, 0 to the first point and 255 to
+    // the last, which is reached as the second to last with full weight
+    u32 strides[3] = { 1, size, size * size };
+    for (u32 v = 0; v < 256; ++v) {
+        u32 position = v * (size - 1);
+        u32 index = position / 255;
+        u32 weight = ((position % 255) * 256 + 127) / 255;
+        if (index >= size - 1) {
+            index = size - 2;
+            weight = 256;
+        }
+        for (u32 c = 0; c < 3; ++c) {
+            lut->axes[c][v] = ((index * strides[c]) << 9) | weight;
+        }
+    }
+    lut->format = *format;
+    lut->dirty = false;
+}
+
+static void apply_point_steps(void* data, u32 begin, u32 end)
+{
+    PointPass* pass = (PointPass*)data;
+    // Each row goes through every step while it is in cache, the first
+    // reading the source and the rest the output
+    for (u32 y = begin; y < end; ++y) {
+        u32* row = pass->dest + (u64)y * pass->dest_stride;
+        const u32* src = pass->src + (u64)y * pass->src_stride;
+        for (u32 i = 0; i < pass->step_count; ++i) {
+            const PointStep* step = &pass->steps[i];
+            if (step->type == FC_POST_FILTER_TONE) {
+                fc_render_kernels.lut_1d_u32(row, i == 0 ? src : row, pass->width, step->tables);
+            } else {
+                fc_render_kernels.lut_3d_u32(row, i == 0 ? src : row, pass->width, &step->lut_3d);
+            }
+        }
+    }
+}
+
+//
+// Running
+//
+
+const u32* fc_post_chain_run(FcPostChain* chain, const u32* pixels, u32 width, u32 height,
+                             u32 stride, const FcPixelFormat* format)
+{
+    if (width == 0 || height == 0) {
+        return pixels;
+    }
+    f64 start_time = platform_get_epoch_time();
+    if ((width != chain->width || height != chain->height) &&
+        !allocate_buffers(chain, width, height)) {
+        return NULL;
+    }
+
+    // The first pass reads the pixels and every pass writes the output, so
+    // the pixels stay as the application drew them
+    const u32* src = pixels;
+    u32 src_stride = stride;
+    PointPass point_pass = { .dest = chain->output, .dest_stride = width, .width = width };
+    for (u32 i = 0; i < chain->filter_count; ++i) {
+        FcPostFilter* filter = &chain->filters[i];
+        if (!filter->enabled) {
+            continue;
+        }
+        if (filter->type == FC_POST_FILTER_TONE || filter->type == FC_POST_FILTER_COLOR_GRADE) {
+            PointStep* step = &point_pass.steps[point_pass.step_count++];
+            step->type = filter->type;
+            if (filter->type == FC_POST_FILTER_TONE) {
+                tone_lut_prepare(filter->tone, format);
+                step->tables = filter->tone->tables;
+            } else {
+                FcColorLut* lut = filter->color;
+                color_lut_prepare(lut, format);
+                step->lut_3d = (FcLut3dTables){
+                    .lattice  = lut->lattice,
+                    .axes     = { lut->axes[0], lut->axes[1], lut->axes[2] },
+                    .shifts   = { format->red_shift, format->green_shift, format->blue_shift },
+                    .size     = lut->size,
+                    .alpha_mask = 0xFFu << format->alpha_shift,
+                };
+            }
+        }
+
+        // Steps gathered so far run together before the next blur or the end
+        FcPostFilter* next = NULL;
+        for (u32 j = i + 1; j < chain->filter_count && next == NULL; ++j) {
+            next = chain->filters[j].enabled ? &chain->filters[j] : NULL;
+        }
+        b32 next_is_point = next != NULL && (next->type == FC_POST_FILTER_TONE ||
+                                             next->type == FC_POST_FILTER_COLOR_GRADE);
+        if (point_pass.step_count > 0 && !next_is_point) {
+            point_pass.src = src;
+            point_pass.src_stride = src_stride;
+            if (chain->parallel) {
+                fc_jobs_parallel_for(height, FC_POST_BAND_ROWS, apply_point_steps, &point_pass);
+            } else {
+                apply_point_steps(&point_pass, 0, height);
+            }
+            point_pass.step_count = 0;
+            src = chain->output;
+            src_stride = width;
+        }
+
+        if (filter->type == FC_POST_FILTER_BOX_BLUR) {
+            box_blur(chain, src, src_stride, filter->radius);
+            src = chain->output;
+            src_stride = width;
+        } else if (filter->type == FC_POST_FILTER_GAUSSIAN_BLUR && filter->sigma > 0.0f) {
+            gaussian_blur(chain, src, src_stride, filter->sigma);
+            src = chain->output;
+            src_stride = width;
+        }
+    }
+
+    // Nothing enabled leaves the output stale, so the pixels are copied
+    if (src == pixels) {
+        for (u32 y = 0; y < height; ++y) {
+            fc_copy_u32(chain->output + (u64)y * width, pixels + (u64)y * stride, width);
+        }
+    }
+    chain->last_run_ms = (platform_get_epoch_time() - start_time) * 1000.0;
+    return chain->output;
+}
+
+//
+// LUTs
+//
+
+void fc_tone_lut_init(FcToneLut* lut, f32 exposure, f32 contrast, f32 gamma)
+{
+    memset(lut, 0, sizeof(FcToneLut));
+    f32 inverse_gamma = gamma > 0.0f ? 1.0f / gamma : 1.0f;
+    for (u32 v = 0; v < 256; ++v) {
+        f32 value = (f32)v / 255.0f * exposure;
+        value = (value - 0.5f) * contrast + 0.5f;
+        value = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+        u8 out = (u8)(powf(value, inverse_gamma) * 255.0f + 0.5f);
+        lut->curves[0][v] = lut->curves[1][v] = lut->curves[2][v] = out;
+    }
+    lut->dirty = true;
+}
+
+b32 fc_color_lut_init(FcColorLut* lut, u32 size)
+{
+    memset(lut, 0, sizeof(FcColorLut));
+    if (size < 2 || size > FC_COLOR_LUT_MAX_SIZE) {
+        FC_ENGINE_ERROR("Unsupported colour LUT size %u", size);
+        return false;
+    }
+    u64 count = (u64)size * size * size;
+    lut->colors = (u8*)FC_ALLOC(count * 3, "color lut");
+    lut->lattice = (u32*)FC_ALLOC_ALIGNED(count * sizeof(u32), 64, "color lut");
+    if (lut->colors == NULL || lut->lattice == NULL) {
+        FC_ENGINE_ERROR("Could not allocate a colour LUT of size %u", size);
+        fc_color_lut_free(lut);
+        return false;
+    }
+    lut->size = size;
+    for (u32 b = 0; b < size; ++b) {
+        for (u32 g = 0; g < size; ++g) {
+            for (u32 r = 0; r < size; ++r) {
+                u8* color = lut->colors + ((u64)(b * size + g) * size + r) * 3;
+                color[0] = (u8)((r * 255 + (size - 1) / 2) / (size - 1));
+                color[1] = (u8)((g * 255 + (size - 1) / 2) / (size - 1));
+                color[2] = (u8)((b * 255 + (size - 1) / 2) / (size - 1));
+            }
+        }
+    }
+    lut->dirty = true;
+    return true;
+}
+
+static u8 unit_to_byte(f32 value)
+{
+    value = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+    return (u8)(value * 255.0f + 0.5f);
+}
+
+void fc_color_lut_set(FcColorLut* lut, u32 r, u32 g, u32 b, f32 red, f32 green, f32 blue)
+{
+    u8* color = lut->colors + ((u64)(b * lut->size + g) * lut->size + r) * 3;
+    color[0] = unit_to_byte(red);
+    color[1] = unit_to_byte(green);
+    color[2] = unit_to_byte(blue);
+    lut->dirty = true;
+}
+
+static b32 parse_cube(FcColorLut* lut, char* text)
+{
+    u32 size = 0, count = 0, total = 0;
+    for (char* line = text; line != NULL;) {
+        char* newline = strchr(line, '\n');
+        if (newline != NULL) {
+            *newline = '\0';
+        }
+        char* next = newline != NULL ? newline + 1 : NULL;
+        while (*line == ' ' || *line == '\t') {
+            line++;
+        }
+        if (*line == '\0' || *line == '\r' || *line == '#' || strncmp(line, "TITLE", 5) == 0) {
+            line = next;
+            continue;
+        }
+        if (strncmp(line, "LUT_3D_SIZE", 11) == 0) {
+            if (size != 0 || !fc_color_lut_init(lut, (u32)strtoul(line + 11, NULL, 10))) {
+                return false;
+            }
+            size = lut->size;
+            total = size * size * size;
+            line = next;
+            continue;
+        }
+        if (strncmp(line, "DOMAIN_MIN", 10) == 0 || strncmp(line, "DOMAIN_MAX", 10) == 0) {
+            char* end = line + 10;
+            f32 expected = line[8] == 'I' ? 0.0f : 1.0f;
+            for (u32 c = 0; c < 3; ++c) {
+                if (strtof(end, &end) != expected) {
+                    return false;
+                }
+            }
+            line = next;
+            continue;
+        }
+
+        // Anything else must be a colour, after the size
+        char* end = line;
+        f32 rgb[3];
+        for (u32 c = 0; c < 3; ++c) {
+            char* start = end;
+            rgb[c] = strtof(start, &end);
+            if (end == start) {
+                return false;
+            }
+        }
+        if (count == total) {
+            return false;
+        }
+        u8* color = lut->colors + (u64)count++ * 3;
+        color[0] = unit_to_byte(rgb[0]);
+        color[1] = unit_to_byte(rgb[1]);
+        color[2] = unit_to_byte(rgb[2]);
+        line = next;
+    }
+    return size != 0 && count == total;
+}
+
+b32 fc_color_lut_load_cube(FcColorLut* lut, const char* path)
+{
+    memset(lut, 0, sizeof(FcColorLut));
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        FC_ENGINE_ERROR("Could not open colour LUT `%s`", (char*)path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* text = (char*)FC_ALLOC(size > 0 ? size + 1 : 1, "color lut file");
+    b32 read = size > 0 && fread(text, 1, size, file) == (u64)size;
+    fclose(file);
+
+    b32 success = false;
+    if (read) {
+        text[size] = '\0';
+        success = parse_cube(lut, text);
+    }
+    FC_FREE(text);
+    if (!success) {
+        FC_ENGINE_ERROR("`%s` is not a 3D LUT in the .cube format", (char*)path);
+        fc_color_lut_free(lut);
+    }
+    return success;
+}
+
+void fc_color_lut_free(FcColorLut* lut)
+{
+    FC_FREE(lut->colors);
+    FC_FREE(lut->lattice);
+    lut->colors = NULL;
+    lut->lattice = NULL;
+    lut->size = 0;
+}
@@ -0,0 +1,735 @@
+#include "finch/render/raster.h"
+#include "finch/core/jobs.h"
+#include "finch/core/memory.h"
+#include "finch/platform/cpu.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+
+#include <math.h>
+#include <string.h>
+
+#define SUBPIXEL_SCALE (1 << FC_RASTER_SUBPIXEL_BITS)
+#define SUBPIXEL_HALF  (SUBPIXEL_SCALE / 2)
+#define BLOCK_SPAN     ((FC_RASTER_BLOCK_SIZE - 1) * SUBPIXEL_SCALE)
+
+// A triangle clipped against all six planes becomes at most nine vertices
+#define CLIP_MAX_VERTICES 9
+
+#define DEPTH_FAR_16 0xFFFFu
+#define DEPTH_FAR_32 0x3F800000u // 1.0f
+
+typedef struct _ClipVertex {
+    f32 position[4];
+    f32 color[3];
+    f32 uv[2];
+} ClipVertex;
+
+//
+// Matrices
+//
+
+FcMat4 fc_mat4_identity(void)
+{
+    FcMat4 result = {0};
+    result.m[0] = result.m[5] = result.m[10] = result.m[15] = 1.0f;
+    return result;
+}
+
+FcMat4 fc_mat4_multiply(const FcMat4* a, const FcMat4* b)
+{
+    FcMat4 result;
+    for (u32 column = 0; column < 4; ++column) {
+        for (u32 row = 0; row < 4; ++row) {
+            f32 sum = 0.0f;
+            for (u32 k = 0; k < 4; ++k) {
+                sum += a->m[k * 4 + row] * b->m[column * 4 + k];
+            }
+            result.m[column * 4 + row] = sum;
+        }
+    }
+    return result;
+}
+
+FcMat4 fc_mat4_perspective(f32 fov_y_radians, f32 aspect, f32 near, f32 far)
+{
+    f32 f = 1.0f / tanf(fov_y_radians * 0.5f);
+    FcMat4 result = {0};
+    result.m[0]  = f / aspect;
+    result.m[5]  = f;
+    result.m[10] = (far + near) / (near - far);
+    result.m[11] = -1.0f;
+    result.m[14] = 2.0f * far * near / (near - far);
+    return result;
+}
+
+FcMat4 fc_mat4_translation(f32 x, f32 y, f32 z)
+{
+    FcMat4 result = fc_mat4_identity();
+    result.m[12] = x;
+    result.m[13] = y;
+    result.m[14] = z;
+    return result;
+}
+
+FcMat4 fc_mat4_rotation_x(f32 radians)
+{
+    f32 c = cosf(radians), s = sinf(radians);
+    FcMat4 result = fc_mat4_identity();
+    result.m[5] = c;  result.m[9]  = -s;
+    result.m[6] = s;  result.m[10] = c;
+    return result;
+}
+
+FcMat4 fc_mat4_rotation_y(f32 radians)
+{
+    f32 c = cosf(radians), s = sinf(radians);
+    FcMat4 result = fc_mat4_identity();
+    result.m[0] = c;  result.m[8]  = s;
+    result.m[2] = -s; result.m[10] = c;
+    return result;
+}
+
+//
+// Block kernel, generic variant
+//
+
+static u32 depth_encode(f32 z, FcRasterDepthFormat format)
+{
+    z = z < 0.0f ? 0.0f : z > 1.0f ? 1.0f : z;
+    if (format == FC_RASTER_DEPTH_16) {
+        return (u32)(z * 65535.0f + 0.5f);
+    }
+    u32 bits;
+    memcpy(&bits, &z, sizeof(bits));
+    return bits;
+}
+
+static u32 shade_channel(u32 texel, f32 factor)
+{
+    f32 value = (f32)texel * factor;
+    value = value < 0.0f ? 0.0f : value > 255.0f ? 255.0f : value;
+    return (u32)(value + 0.5f);
+}
+
+static u32 raster_block_generic(const FcRasterBlock* block, u32* block_depth)
+{
+    const FcRasterTriangle* triangle = block->triangle;
+    const FcRasterTexture* texture = triangle->texture;
+    f32 start_x = (f32)block->x + 0.5f - triangle->origin_x;
+    f32 start_y = (f32)block->y + 0.5f - triangle->origin_y;
+    f32 start[FC_RASTER_PLANE_COUNT];
+    for (u32 p = 0; p < FC_RASTER_PLANE_COUNT; ++p) {
+        start[p] = triangle->planes[p][0] + triangle->planes[p][1] * start_x +
+                   triangle->planes[p][2] * start_y;
+    }
+    b32 depth_16 = block->depth_format == FC_RASTER_DEPTH_16;
+    u32 written = 0;
+
+    for (u32 j = 0; j < block->rows; ++j) {
+        u32* pixels = block->pixels + (u64)j * block->pixel_stride;
+        u64 depth_row = (u64)j * block->depth_stride;
+        for (u32 i = 0; i < block->columns; ++i) {
+            b32 inside = true;
+            for (u32 e = 0; e < 3; ++e) {
+                if (block->partial_edges & (1u << e)) {
+                    s32 value = block->edges[e] +
+                                triangle->edge_a[e] * SUBPIXEL_SCALE * (s32)i +
+                                triangle->edge_b[e] * SUBPIXEL_SCALE * (s32)j;
+                    inside &= value >= 0;
+                }
+            }
+            if (!inside) {
+                continue;
+            }
+
+            f32 v[FC_RASTER_PLANE_COUNT];
+            for (u32 p = 0; p < FC_RASTER_PLANE_COUNT; ++p) {
+                v[p] = (start[p] + triangle->planes[p][2] * (f32)j) +
+                       triangle->planes[p][1] * (f32)i;
+            }
+            u32 depth = depth_encode(v[FC_RASTER_PLANE_Z], block->depth_format);
+            u32 stored = depth_16 ? ((u16*)block->depth)[depth_row + i]
+                                  : ((u32*)block->depth)[depth_row + i];
+            if (depth >= stored) {
+                continue;
+            }
+
+            f32 w = 1.0f / v[FC_RASTER_PLANE_INV_W];
+            u32 texel_r = 255, texel_g = 255, texel_b = 255;
+            if (texture != NULL) {
+                f32 u = v[FC_RASTER_PLANE_U] * w, t = v[FC_RASTER_PLANE_V] * w;
+                u32 tx = (u32)((u - floorf(u)) * (f32)texture->width) & (texture->width - 1);
+                u32 ty = (u32)((t - floorf(t)) * (f32)texture->height) & (texture->height - 1);
+                u32 texel = texture->pixels[ty * texture->width + tx];
+                texel_r = (texel >> block->red_shift) & 0xFF;
+                texel_g = (texel >> block->green_shift) & 0xFF;
+                texel_b = (texel >> block->blue_shift) & 0xFF;
+            }
+            pixels[i] = shade_channel(texel_r, v[FC_RASTER_PLANE_RED] * w) << block->red_shift |
+                        shade_channel(texel_g, v[FC_RASTER_PLANE_GREEN] * w) << block->green_shift |
+                        shade_channel(texel_b, v[FC_RASTER_PLANE_BLUE] * w) << block->blue_shift |
+                        0xFFu << block->alpha_shift;
+            if (depth_16) {
+                ((u16*)block->depth)[depth_row + i] = (u16)depth;
+            } else {
+                ((u32*)block->depth)[depth_row + i] = depth;
+            }
+            written += 1;
+        }
+    }
+
+    if (written > 0) {
+        u32 farthest = 0;
+        for (u32 j = 0; j < FC_RASTER_BLOCK_SIZE; ++j) {
+            for (u32 i = 0; i < FC_RASTER_BLOCK_SIZE; ++i) {
+                u64 index = (u64)j * block->depth_stride + i;
+                u32 depth = depth_16 ? ((u16*)block->depth)[index] : ((u32*)block->depth)[index];
+                farthest = depth > farthest ? depth : farthest;
+            }
+        }
+        *block_depth = farthest;
+    }
+    return written;
+}
+
+//
+// x86 variants, implemented in raster_x86.c
+//
+
+#if defined(__x86_64__) || defined(__i386__)
+u32 raster_block_avx2(const FcRasterBlock* block, u32* block_depth);
+#endif
+
+FcRasterKernels fc_raster_kernels = {
+    .block         = raster_block_generic,
+    .block_variant = "generic",
+};
+
+void fc_raster_select_kernels(u32 cpu_features)
+{
+    FcRasterKernels kernels = {
+        .block         = raster_block_generic,
+        .block_variant = "generic",
+    };
+#if defined(__x86_64__) || defined(__i386__)
+    if (cpu_features & FC_CPU_FEATURE_AVX2) {
+        kernels.block = raster_block_avx2;
+        kernels.block_variant = "avx2";
+    }
+#else
+    (void)cpu_features;
+#endif
+    fc_raster_kernels = kernels;
+    FC_ENGINE_TRACE("Raster kernels: block=%s", kernels.block_variant);
+}
+
+//
+// Frames
+//
+
+void fc_raster_init(FcRaster* raster, FcRasterDepthFormat depth_format)
+{
+    *raster = (FcRaster){0};
+    raster->depth_format = depth_format;
+    raster->cull_back_faces = true;
+    FC_ARRAY_INIT(&raster->triangles, FcRasterTriangle, NULL);
+    FC_ARRAY_INIT(&raster->active_tiles, u32, NULL);
+    FC_ARRAY_INIT(&raster->clip_vertices, ClipVertex, NULL);
+}
+
+static void free_buffers(FcRaster* raster)
+{
+    for (u32 i = 0; i < raster->tiles_x * raster->tiles_y; ++i) {
+        fc_array_free(&raster->bins[i].triangles);
+    }
+    FC_FREE(raster->bins);
+    FC_FREE(raster->depth);
+    FC_FREE(raster->block_depth);
+    raster->bins = NULL;
+    raster->depth = NULL;
+    raster->block_depth = NULL;
+    raster->tiles_x = raster->tiles_y = 0;
+    raster->allocated_width = raster->allocated_height = 0;
+}
+
+void fc_raster_free(FcRaster* raster)
+{
+    free_buffers(raster);
+    fc_array_free(&raster->triangles);
+    fc_array_free(&raster->active_tiles);
+    fc_array_free(&raster->clip_vertices);
+}
+
+static b32 allocate_buffers(FcRaster* raster, u32 width, u32 height)
+{
+    free_buffers(raster);
+    u32 blocks_x = (width + FC_RASTER_BLOCK_SIZE - 1) / FC_RASTER_BLOCK_SIZE;
+    u32 blocks_y = (height + FC_RASTER_BLOCK_SIZE - 1) / FC_RASTER_BLOCK_SIZE;
+    u32 tiles_x = (width + FC_RASTER_TILE_SIZE - 1) / FC_RASTER_TILE_SIZE;
+    u32 tiles_y = (height + FC_RASTER_TILE_SIZE - 1) / FC_RASTER_TILE_SIZE;
+    u32 depth_size = raster->depth_format == FC_RASTER_DEPTH_16 ? sizeof(u16) : sizeof(u32);
+    u64 depth_count = (u64)blocks_x * FC_RASTER_BLOCK_SIZE * blocks_y * FC_RASTER_BLOCK_SIZE;
+
+    raster->depth = FC_ALLOC_ALIGNED(depth_count * depth_size, 64, "raster");
+    raster->block_depth = (u32*)FC_ALLOC((u64)blocks_x * blocks_y * sizeof(u32), "raster");
+    raster->bins = (FcRasterBin*)FC_ALLOC_ZEROED((u64)tiles_x * tiles_y * sizeof(FcRasterBin),
+                                                 "raster");
+    if (raster->depth == NULL || raster->block_depth == NULL || raster->bins == NULL) {
+        FC_ENGINE_ERROR("Could not allocate a %ux%u depth buffer", width, height);
+        free_buffers(raster);
+        return false;
+    }
+    for (u32 i = 0; i < tiles_x * tiles_y; ++i) {
+        FC_ARRAY_INIT(&raster->bins[i].triangles, u32, NULL);
+    }
+    raster->depth_stride = blocks_x * FC_RASTER_BLOCK_SIZE;
+    raster->blocks_x = blocks_x;
+    raster->blocks_y = blocks_y;
+    raster->tiles_x = tiles_x;
+    raster->tiles_y = tiles_y;
+    raster->allocated_width = width;
+    raster->allocated_height = height;
+    fc_raster_clear_depth(raster);
+    return true;
+}
+
+b32 fc_raster_begin(FcRaster* raster, u32* pixels, u32 width, u32 height, u32 stride,
+                    const FcPixelFormat* format)
+{
+    if (width == 0 || height == 0 || width > FC_RASTER_MAX_SIZE || height > FC_RASTER_MAX_SIZE) {
+        FC_ENGINE_ERROR("Cannot rasterize to %ux%u pixels", width, height);
+        return false;
+    }
+    if ((width != raster->allocated_width || height != raster->allocated_height) &&
+        !allocate_buffers(raster, width, height)) {
+        return false;
+    }
+
+    raster->pixels = pixels;
+    raster->width = width;
+    raster->height = height;
+    raster->stride = stride;
+    raster->pixel_format = *format;
+    fc_array_clear(&raster->triangles);
+    for (u32 i = 0; i < raster->active_tiles.count; ++i) {
+        fc_array_clear(&raster->bins[FC_ARRAY_AT(&raster->active_tiles, u32, i)].triangles);
+    }
+    fc_array_clear(&raster->active_tiles);
+    raster->stats = (FcRasterStats){0};
+    return true;
+}
+
+void fc_raster_clear_depth(FcRaster* raster)
+{
+    u64 depth_count = (u64)raster->depth_stride * raster->blocks_y * FC_RASTER_BLOCK_SIZE;
+    u32 far = raster->depth_format == FC_RASTER_DEPTH_16 ? DEPTH_FAR_16 : DEPTH_FAR_32;
+    if (raster->depth_format == FC_RASTER_DEPTH_16) {
+        memset(raster->depth, 0xFF, depth_count * sizeof(u16));
+    } else {
+        for (u64 i = 0; i < depth_count; ++i) {
+            ((u32*)raster->depth)[i] = far;
+        }
+    }
+    for (u64 i = 0; i < (u64)raster->blocks_x * raster->blocks_y; ++i) {
+        raster->block_depth[i] = far;
+    }
+}
+
+//
+// Setup and binning
+//
+
+static s32 min3(s32 a, s32 b, s32 c)
+{
+    return a < b ? (a < c ? a : c) : (b < c ? b : c);
+}
+
+static s32 max3(s32 a, s32 b, s32 c)
+{
+    return a > b ? (a > c ? a : c) : (b > c ? b : c);
+}
+
+static void set_plane(f32 plane[3], f32 q0, f32 q1, f32 q2,
+                      f32 dx1, f32 dy1, f32 dx2, f32 dy2, f32 inv_area)
+{
+    plane[0] = q0;
+    plane[1] = ((q1 - q0) * dy2 - (q2 - q0) * dy1) * inv_area;
+    plane[2] = ((q2 - q0) * dx1 - (q1 - q0) * dx2) * inv_area;
+}
+
+static void bin_triangle(FcRaster* raster, const FcRasterTriangle* triangle)
+{
+    u32 index = raster->triangles.count;
+    FcRasterTriangle* stored = FC_ARRAY_PUSH(&raster->triangles, FcRasterTriangle);
+    if (stored == NULL) {
+        FC_ENGINE_WARN_PER_SECOND(1, "Dropped triangles, out of memory");
+        return;
+    }
+    *stored = *triangle;
+    raster->stats.triangles_binned += 1;
+
+    u32 tile_x0 = (u32)triangle->min_x / FC_RASTER_TILE_SIZE;
+    u32 tile_x1 = (u32)triangle->max_x / FC_RASTER_TILE_SIZE;
+    u32 tile_y0 = (u32)triangle->min_y / FC_RASTER_TILE_SIZE;
+    u32 tile_y1 = (u32)triangle->max_y / FC_RASTER_TILE_SIZE;
+    for (u32 tile_y = tile_y0; tile_y <= tile_y1; ++tile_y) {
+        for (u32 tile_x = tile_x0; tile_x <= tile_x1; ++tile_x) {
+            u32 tile = tile_y * raster->tiles_x + tile_x;
+            FcArray* bin = &raster->bins[tile].triangles;
+            if (bin->count == 0) {
+                u32* active = FC_ARRAY_PUSH(&raster->active_tiles, u32);
+                if (active == NULL) {
+                    continue;
+                }
+                *active = tile;
+            }
+            u32* slot = FC_ARRAY_PUSH(bin, u32);
+            if (slot != NULL) {
+                *slot = index;
+            }
+        }
+    }
+}
+
+static void setup_triangle(FcRaster* raster, const ClipVertex* a, const ClipVertex* b,
+                           const ClipVertex* c, const FcRasterTexture* texture)
+{
+    const ClipVertex* vertices[3] = { a, b, c };
+    s32 x[3], y[3];
+    f32 z[3], inv_w[3];
+    s32 max_x = (s32)raster->width * SUBPIXEL_SCALE;
+    s32 max_y = (s32)raster->height * SUBPIXEL_SCALE;
+    for (u32 i = 0; i < 3; ++i) {
+        const f32* position = vertices[i]->position;
+        inv_w[i] = 1.0f / position[3];
+        f32 sx = (position[0] * inv_w[i] * 0.5f + 0.5f) * (f32)raster->width;
+        f32 sy = (0.5f - position[1] * inv_w[i] * 0.5f) * (f32)raster->height;
+        x[i] = (s32)floorf(sx * SUBPIXEL_SCALE + 0.5f);
+        y[i] = (s32)floorf(sy * SUBPIXEL_SCALE + 0.5f);
+        // Clipping keeps vertices on screen, up to rounding
+        x[i] = x[i] < 0 ? 0 : x[i] > max_x ? max_x : x[i];
+        y[i] = y[i] < 0 ? 0 : y[i] > max_y ? max_y : y[i];
+        z[i] = position[2] * inv_w[i] * 0.5f + 0.5f;
+    }
+
+    // Counter clockwise in view is clockwise on screen, as y points down
+    s64 area = (s64)(x[1] - x[0]) * (y[2] - y[0]) - (s64)(x[2] - x[0]) * (y[1] - y[0]);
+    if (area == 0 || (area > 0 && raster->cull_back_faces)) {
+        raster->stats.triangles_culled += 1;
+        return;
+    }
+    if (area < 0) {
+        // Front face: turned around so that edge functions are positive inside
+        vertices[1] = c;
+        vertices[2] = b;
+        s32 swap_x = x[1], swap_y = y[1];
+        f32 swap_z = z[1], swap_w = inv_w[1];
+        x[1] = x[2]; y[1] = y[2]; z[1] = z[2]; inv_w[1] = inv_w[2];
+        x[2] = swap_x; y[2] = swap_y; z[2] = swap_z; inv_w[2] = swap_w;
+        area = -area;
+    }
+
+    FcRasterTriangle triangle;
+    // Pixels whose center is within the bounds
+    triangle.min_x = (min3(x[0], x[1], x[2]) + SUBPIXEL_HALF - 1) >> FC_RASTER_SUBPIXEL_BITS;
+    triangle.min_y = (min3(y[0], y[1], y[2]) + SUBPIXEL_HALF - 1) >> FC_RASTER_SUBPIXEL_BITS;
+    triangle.max_x = (max3(x[0], x[1], x[2]) - SUBPIXEL_HALF) >> FC_RASTER_SUBPIXEL_BITS;
+    triangle.max_y = (max3(y[0], y[1], y[2]) - SUBPIXEL_HALF) >> FC_RASTER_SUBPIXEL_BITS;
+    triangle.max_x = triangle.max_x < (s32)raster->width - 1 ? triangle.max_x : (s32)raster->width - 1;
+    triangle.max_y = triangle.max_y < (s32)raster->height - 1 ? triangle.max_y : (s32)raster->height - 1;
+    if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y) {
+        raster->stats.triangles_culled += 1;
+        return;
+    }
+
+    for (u32 i = 0; i < 3; ++i) {
+        u32 j = (i + 1) % 3;
+        s32 edge_a = y[i] - y[j];
+        s32 edge_b = x[j] - x[i];
+        s64 edge_c = -((s64)edge_a * x[i] + (s64)edge_b * y[i]);
+        // Top-left rule: pixel centers on an edge belong to the triangle
+        // only if it is a top or left edge
+        b32 top_left = edge_a > 0 || (edge_a == 0 && edge_b > 0);
+        triangle.edge_a[i] = edge_a;
+        triangle.edge_b[i] = edge_b;
+        triangle.edge_c[i] = top_left ? edge_c : edge_c - 1;
+    }
+
+    f32 x0 = (f32)x[0] / SUBPIXEL_SCALE, y0 = (f32)y[0] / SUBPIXEL_SCALE;
+    f32 dx1 = (f32)x[1] / SUBPIXEL_SCALE - x0, dy1 = (f32)y[1] / SUBPIXEL_SCALE - y0;
+    f32 dx2 = (f32)x[2] / SUBPIXEL_SCALE - x0, dy2 = (f32)y[2] / SUBPIXEL_SCALE - y0;
+    f32 inv_area = (f32)(SUBPIXEL_SCALE * SUBPIXEL_SCALE) / (f32)area;
+    triangle.origin_x = x0;
+    triangle.origin_y = y0;
+
+    f32 values[FC_RASTER_PLANE_COUNT][3];
+    for (u32 i = 0; i < 3; ++i) {
+        const ClipVertex* vertex = vertices[i];
+        values[FC_RASTER_PLANE_Z][i]     = z[i];
+        values[FC_RASTER_PLANE_INV_W][i] = inv_w[i];
+        values[FC_RASTER_PLANE_RED][i]   = vertex->color[0] * inv_w[i];
+        values[FC_RASTER_PLANE_GREEN][i] = vertex->color[1] * inv_w[i];
+        values[FC_RASTER_PLANE_BLUE][i]  = vertex->color[2] * inv_w[i];
+        values[FC_RASTER_PLANE_U][i]     = vertex->uv[0] * inv_w[i];
+        values[FC_RASTER_PLANE_V][i]     = vertex->uv[1] * inv_w[i];
+    }
+    for (u32 p = 0; p < FC_RASTER_PLANE_COUNT; ++p) {
+        set_plane(triangle.planes[p], values[p][0], values[p][1], values[p][2],
+                  dx1, dy1, dx2, dy2, inv_area);
+    }
+    f32 z_min = z[0] < z[1] ? z[0] : z[1];
+    triangle.z_min = z_min < z[2] ? z_min : z[2];
+    triangle.texture = texture;
+    bin_triangle(raster, &triangle);
+}
+
+// Distance inside each clip plane, -w <= x, y, z <= w
+static f32 clip_distance(const f32 position[4], u32 plane)
+{
+    f32 value = position[plane >> 1];
+    return (plane & 1) ? position[3] - value : position[3] + value;
+}
+
+static u32 clip_outcode(const f32 position[4])
+{
+    u32 outcode = 0;
+    for (u32 plane = 0; plane < 6; ++plane) {
+        outcode |= (clip_distance(position, plane) < 0.0f) << plane;
+    }
+    return outcode;
+}
+
+static void clip_lerp(ClipVertex* result, const ClipVertex* a, const ClipVertex* b, f32 t)
+{
+    for (u32 i = 0; i < 4; ++i) {
+        result->position[i] = a->position[i] + (b->position[i] - a->position[i]) * t;
+    }
+    for (u32 i = 0; i < 3; ++i) {
+        result->color[i] = a->color[i] + (b->color[i] - a->color[i]) * t;
+    }
+    for (u32 i = 0; i < 2; ++i) {
+        result->uv[i] = a->uv[i] + (b->uv[i] - a->uv[i]) * t;
+    }
+}
+
+// Sutherland-Hodgman against the planes in `outcodes`, then drawn as a fan
+static void clip_triangle(FcRaster* raster, const ClipVertex* a, const ClipVertex* b,
+                          const ClipVertex* c, u32 outcodes, const FcRasterTexture* texture)
+{
+    ClipVertex buffers[2][CLIP_MAX_VERTICES];
+    ClipVertex* input = buffers[0];
+    ClipVertex* output = buffers[1];
+    input[0] = *a;
+    input[1] = *b;
+    input[2] = *c;
+    u32 count = 3;
+
+    for (u32 plane = 0; plane < 6 && count >= 3; ++plane) {
+        if (!(outcodes & (1u << plane))) {
+            continue;
+        }
+        u32 output_count = 0;
+        for (u32 i = 0; i < count; ++i) {
+            const ClipVertex* current = &input[i];
+            const ClipVertex* next = &input[(i + 1) % count];
+            f32 d0 = clip_distance(current->position, plane);
+            f32 d1 = clip_distance(next->position, plane);
+            if (d0 >= 0.0f) {
+                output[output_count++] = *current;
+            }
+            if ((d0 >= 0.0f) != (d1 >= 0.0f)) {
+                clip_lerp(&output[output_count++], current, next, d0 / (d0 - d1));
+            }
+        }
+        ClipVertex* swap = input;
+        input = output;
+        output = swap;
+        count = output_count;
+    }
+
+    for (u32 i = 1; i + 1 < count; ++i) {
+        setup_triangle(raster, &input[0], &input[i], &input[i + 1], texture);
+    }
+}
+
+void fc_raster_draw(FcRaster* raster, const FcMat4* transform,
+                    const FcRasterVertex* vertices, u32 vertex_count,
+                    const u32* indices, u32 index_count, const FcRasterTexture* texture)
+{
+    if (raster->depth == NULL) {
+        return;
+    }
+    if (!fc_array_resize(&raster->clip_vertices, vertex_count)) {
+        FC_ENGINE_WARN_PER_SECOND(1, "Dropped a draw of %u vertices, out of memory", vertex_count);
+        return;
+    }
+
+    const f32* m = transform->m;
+    ClipVertex* clip = FC_ARRAY_DATA(&raster->clip_vertices, ClipVertex);
+    for (u32 i = 0; i < vertex_count; ++i) {
+        const f32* p = vertices[i].position;
+        for (u32 row = 0; row < 4; ++row) {
+            clip[i].position[row] = m[row] * p[0] + m[4 + row] * p[1] + m[8 + row] * p[2] + m[12 + row];
+        }
+        memcpy(clip[i].color, vertices[i].color, sizeof(clip[i].color));
+        memcpy(clip[i].uv, vertices[i].uv, sizeof(clip[i].uv));
+    }
+
+    for (u32 i = 0; i + 2 < index_count; i += 3) {
+        raster->stats.triangles_submitted += 1;
+        if (indices[i] >= vertex_count || indices[i + 1] >= vertex_count ||
+            indices[i + 2] >= vertex_count) {
+            FC_ENGINE_WARN_PER_SECOND(1, "Triangle index out of range");
+            raster->stats.triangles_culled += 1;
+            continue;
+        }
+        const ClipVertex* a = &clip[indices[i]];
+        const ClipVertex* b = &clip[indices[i + 1]];
+        const ClipVertex* c = &clip[indices[i + 2]];
+        u32 outcode_a = clip_outcode(a->position);
+        u32 outcode_b = clip_outcode(b->position);
+        u32 outcode_c = clip_outcode(c->position);
+        if (outcode_a & outcode_b & outcode_c) {
+            raster->stats.triangles_culled += 1;
+        } else if (outcode_a | outcode_b | outcode_c) {
+            raster->stats.triangles_clipped += 1;
+            clip_triangle(raster, a, b, c, outcode_a | outcode_b | outcode_c, texture);
+        } else {
+            setup_triangle(raster, a, b, c, texture);
+        }
+    }
+}
+
+//
+// Tiles
+//
+
+// Smallest depth a triangle can have in a block, in the depth buffer's
+// encoding and rounded towards the viewer
+static u32 block_nearest_depth(const FcRasterTriangle* triangle, s32 x, s32 y,
+                               FcRasterDepthFormat format)
+{
+    const f32* plane = triangle->planes[FC_RASTER_PLANE_Z];
+    f32 span = (f32)(FC_RASTER_BLOCK_SIZE - 1);
+    f32 z = plane[0] + plane[1] * ((f32)x + 0.5f - triangle->origin_x) +
+            plane[2] * ((f32)y + 0.5f - triangle->origin_y);
+    z += (plane[1] < 0.0f ? plane[1] * span : 0.0f) + (plane[2] < 0.0f ? plane[2] * span : 0.0f);
+    z = z > triangle->z_min ? z : triangle->z_min;
+    z -= 1.0f / 65536.0f;
+    if (z <= 0.0f) {
+        return 0;
+    }
+    if (format == FC_RASTER_DEPTH_16) {
+        return (u32)(z * 65535.0f);
+    }
+    u32 bits;
+    memcpy(&bits, &z, sizeof(bits));
+    return bits;
+}
+
+static void rasterize_tile(FcRaster* raster, u32 tile)
+{
+    FcRasterBin* bin = &raster->bins[tile];
+    const FcRasterTriangle* triangles = FC_ARRAY_DATA(&raster->triangles, FcRasterTriangle);
+    const u32* indices = FC_ARRAY_DATA(&bin->triangles, u32);
+    s32 tile_x0 = (s32)(tile % raster->tiles_x) * FC_RASTER_TILE_SIZE;
+    s32 tile_y0 = (s32)(tile / raster->tiles_x) * FC_RASTER_TILE_SIZE;
+    s32 tile_x1 = tile_x0 + FC_RASTER_TILE_SIZE - 1;
+    s32 tile_y1 = tile_y0 + FC_RASTER_TILE_SIZE - 1;
+    u32 depth_size = raster->depth_format == FC_RASTER_DEPTH_16 ? sizeof(u16) : sizeof(u32);
+
+    FcRasterBlock block = {
+        .pixel_stride = raster->stride,
+        .depth_stride = raster->depth_stride,
+        .depth_format = raster->depth_format,
+        .red_shift    = raster->pixel_format.red_shift,
+        .green_shift  = raster->pixel_format.green_shift,
+        .blue_shift   = raster->pixel_format.blue_shift,
+        .alpha_shift  = raster->pixel_format.alpha_shift,
+    };
+    u64 blocks_rasterized = 0, blocks_rejected = 0, pixels_written = 0;
+
+    for (u32 t = 0; t < bin->triangles.count; ++t) {
+        const FcRasterTriangle* triangle = &triangles[indices[t]];
+        block.triangle = triangle;
+        s32 x0 = triangle->min_x > tile_x0 ? triangle->min_x : tile_x0;
+        s32 y0 = triangle->min_y > tile_y0 ? triangle->min_y : tile_y0;
+        s32 x1 = triangle->max_x < tile_x1 ? triangle->max_x : tile_x1;
+        s32 y1 = triangle->max_y < tile_y1 ? triangle->max_y : tile_y1;
+        x0 &= ~(FC_RASTER_BLOCK_SIZE - 1);
+        y0 &= ~(FC_RASTER_BLOCK_SIZE - 1);
+
+        for (s32 y = y0; y <= y1; y += FC_RASTER_BLOCK_SIZE) {
+            for (s32 x = x0; x <= x1; x += FC_RASTER_BLOCK_SIZE) {
+                // Edge values over the block's pixel centers
+                s64 px = (s64)x * SUBPIXEL_SCALE + SUBPIXEL_HALF;
+                s64 py = (s64)y * SUBPIXEL_SCALE + SUBPIXEL_HALF;
+                b32 outside = false;
+                u32 partial = 0;
+                for (u32 e = 0; e < 3; ++e) {
+                    s64 a = triangle->edge_a[e], b = triangle->edge_b[e];
+                    s64 value = a * px + b * py + triangle->edge_c[e];
+                    s64 low = value + (a < 0 ? a * BLOCK_SPAN : 0) + (b < 0 ? b * BLOCK_SPAN : 0);
+                    s64 high = value + (a > 0 ? a * BLOCK_SPAN : 0) + (b > 0 ? b * BLOCK_SPAN : 0);
+                    outside |= high < 0;
+                    if (low < 0) {
+                        partial |= 1u << e;
+                        block.edges[e] = (s32)value;
+                    }
+                }
+                if (outside) {
+                    continue;
+                }
+
+                u32 block_index = (u32)(y / FC_RASTER_BLOCK_SIZE) * raster->blocks_x +
+                                  (u32)(x / FC_RASTER_BLOCK_SIZE);
+                u32* block_depth = &raster->block_depth[block_index];
+                if (block_nearest_depth(triangle, x, y, raster->depth_format) >= *block_depth) {
+                    blocks_rejected += 1;
+                    continue;
+                }
+
+                block.x = x;
+                block.y = y;
+                block.partial_edges = partial;
+                block.columns = (u32)raster->width - (u32)x < FC_RASTER_BLOCK_SIZE
+                    ? (u32)raster->width - (u32)x : FC_RASTER_BLOCK_SIZE;
+                block.rows = (u32)raster->height - (u32)y < FC_RASTER_BLOCK_SIZE
+                    ? (u32)raster->height - (u32)y : FC_RASTER_BLOCK_SIZE;
+                block.pixels = raster->pixels + (u64)y * raster->stride + (u32)x;
+                block.depth = (u8*)raster->depth +
+                              ((u64)y * raster->depth_stride + (u32)x) * depth_size;
+                pixels_written += fc_raster_kernels.block(&block, block_depth);
+                blocks_rasterized += 1;
+            }
+        }
+    }
+
+    bin->blocks_rasterized = blocks_rasterized;
+    bin->blocks_rejected = blocks_rejected;
+    bin->pixels_written = pixels_written;
+}
+
+static void rasterize_tiles(void* data, u32 begin, u32 end)
+{
+    FcRaster* raster = (FcRaster*)data;
+    for (u32 i = begin; i < end; ++i) {
+        rasterize_tile(raster, FC_ARRAY_AT(&raster->active_tiles, u32, i));
+    }
+}
+
+void fc_raster_end(FcRaster* raster, b32 parallel)
+{
+    u32 count = raster->active_tiles.count;
+    if (parallel) {
+        fc_jobs_parallel_for(count, 1, rasterize_tiles, raster);
+    } else {
+        rasterize_tiles(raster, 0, count);
+    }
+    for (u32 i = 0; i < count; ++i) {
+        const FcRasterBin* bin = &raster->bins[FC_ARRAY_AT(&raster->active_tiles, u32, i)];
+        raster->stats.blocks_rasterized += bin->blocks_rasterized;
+        raster->stats.blocks_rejected += bin->blocks_rejected;
+        raster->stats.pixels_written += bin->pixels_written;
+    }
+}
@@ -0,0 +1,151 @@
+#include "finch/render/raster.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+// Compiled for AVX2 with the target attribute and only ever called when the
+// CPU supports it, like the pixel kernels in kernels_x86.c. A row of the
+// block is one vector; every step matches the generic variant's order of
+// operations, so both write the same pixels.
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+TARGET_AVX2 static __m256i shade_channel_avx2(__m256 texel, __m256 factor)
+{
+    __m256 value = _mm256_mul_ps(texel, factor);
+    value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(255.0f));
+    return _mm256_cvttps_epi32(_mm256_add_ps(value, _mm256_set1_ps(0.5f)));
+}
+
+TARGET_AVX2 u32 raster_block_avx2(const FcRasterBlock* block, u32* block_depth)
+{
+    const FcRasterTriangle* triangle = block->triangle;
+    const FcRasterTexture* texture = triangle->texture;
+    f32 start_x = (f32)block->x + 0.5f - triangle->origin_x;
+    f32 start_y = (f32)block->y + 0.5f - triangle->origin_y;
+    f32 start[FC_RASTER_PLANE_COUNT];
+    __m256 step_x[FC_RASTER_PLANE_COUNT];
+    __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256 lane_f = _mm256_cvtepi32_ps(lane);
+    for (u32 p = 0; p < FC_RASTER_PLANE_COUNT; ++p) {
+        start[p] = triangle->planes[p][0] + triangle->planes[p][1] * start_x +
+                   triangle->planes[p][2] * start_y;
+        step_x[p] = _mm256_mul_ps(_mm256_set1_ps(triangle->planes[p][1]), lane_f);
+    }
+
+    __m256i edge_step[3];
+    for (u32 e = 0; e < 3; ++e) {
+        edge_step[e] = _mm256_mullo_epi32(_mm256_set1_epi32(triangle->edge_a[e] * (1 << FC_RASTER_SUBPIXEL_BITS)),
+                                          lane);
+    }
+    __m256i columns = _mm256_cmpgt_epi32(_mm256_set1_epi32((s32)block->columns), lane);
+
+    b32 depth_16 = block->depth_format == FC_RASTER_DEPTH_16;
+    __m128i red_shift   = _mm_cvtsi32_si128(block->red_shift);
+    __m128i green_shift = _mm_cvtsi32_si128(block->green_shift);
+    __m128i blue_shift  = _mm_cvtsi32_si128(block->blue_shift);
+    __m256i alpha = _mm256_set1_epi32((s32)(0xFFu << block->alpha_shift));
+    __m256i channel_mask = _mm256_set1_epi32(0xFF);
+    __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+    u32 written = 0;
+
+    for (u32 j = 0; j < block->rows; ++j) {
+        __m256i inside = columns;
+        for (u32 e = 0; e < 3; ++e) {
+            if (block->partial_edges & (1u << e)) {
+                s32 row = block->edges[e] + triangle->edge_b[e] * (1 << FC_RASTER_SUBPIXEL_BITS) * (s32)j;
+                __m256i value = _mm256_add_epi32(_mm256_set1_epi32(row), edge_step[e]);
+                inside = _mm256_and_si256(inside, _mm256_cmpgt_epi32(value, _mm256_set1_epi32(-1)));
+            }
+        }
+        if (_mm256_testz_si256(inside, inside)) {
+            continue;
+        }
+
+        __m256 v[FC_RASTER_PLANE_COUNT];
+        for (u32 p = 0; p < FC_RASTER_PLANE_COUNT; ++p) {
+            v[p] = _mm256_add_ps(_mm256_set1_ps(start[p] + triangle->planes[p][2] * (f32)j), step_x[p]);
+        }
+
+        __m256 z = _mm256_min_ps(_mm256_max_ps(v[FC_RASTER_PLANE_Z], zero), one);
+        __m256i depth, stored;
+        u16* depth_row_16 = (u16*)block->depth + (u64)j * block->depth_stride;
+        u32* depth_row_32 = (u32*)block->depth + (u64)j * block->depth_stride;
+        if (depth_16) {
+            depth = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(65535.0f)),
+                                                      _mm256_set1_ps(0.5f)));
+            stored = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)depth_row_16));
+        } else {
+            // Depths from 0 to 1 compare the same as their bits
+            depth = _mm256_castps_si256(z);
+            stored = _mm256_loadu_si256((const __m256i*)depth_row_32);
+        }
+        __m256i pass = _mm256_and_si256(inside, _mm256_cmpgt_epi32(stored, depth));
+        u32 pass_bits = (u32)_mm256_movemask_ps(_mm256_castsi256_ps(pass));
+        if (pass_bits == 0) {
+            continue;
+        }
+
+        __m256 w = _mm256_div_ps(one, v[FC_RASTER_PLANE_INV_W]);
+        __m256 texel_r = _mm256_set1_ps(255.0f), texel_g = texel_r, texel_b = texel_r;
+        if (texture != NULL) {
+            __m256 u = _mm256_mul_ps(v[FC_RASTER_PLANE_U], w);
+            __m256 t = _mm256_mul_ps(v[FC_RASTER_PLANE_V], w);
+            u = _mm256_mul_ps(_mm256_sub_ps(u, _mm256_floor_ps(u)), _mm256_set1_ps((f32)texture->width));
+            t = _mm256_mul_ps(_mm256_sub_ps(t, _mm256_floor_ps(t)), _mm256_set1_ps((f32)texture->height));
+            __m256i tx = _mm256_and_si256(_mm256_cvttps_epi32(u), _mm256_set1_epi32((s32)texture->width - 1));
+            __m256i ty = _mm256_and_si256(_mm256_cvttps_epi32(t), _mm256_set1_epi32((s32)texture->height - 1));
+            __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(ty, _mm256_set1_epi32((s32)texture->width)), tx);
+            __m256i texel = _mm256_i32gather_epi32((const int*)texture->pixels, index, 4);
+            texel_r = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(texel, red_shift), channel_mask));
+            texel_g = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(texel, green_shift), channel_mask));
+            texel_b = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(texel, blue_shift), channel_mask));
+        }
+        __m256i r = shade_channel_avx2(texel_r, _mm256_mul_ps(v[FC_RASTER_PLANE_RED], w));
+        __m256i g = shade_channel_avx2(texel_g, _mm256_mul_ps(v[FC_RASTER_PLANE_GREEN], w));
+        __m256i b = shade_channel_avx2(texel_b, _mm256_mul_ps(v[FC_RASTER_PLANE_BLUE], w));
+        __m256i color = _mm256_or_si256(_mm256_or_si256(_mm256_sll_epi32(r, red_shift),
+                                                        _mm256_sll_epi32(g, green_shift)),
+                                        _mm256_or_si256(_mm256_sll_epi32(b, blue_shift), alpha));
+        _mm256_maskstore_epi32((int*)(block->pixels + (u64)j * block->pixel_stride), pass, color);
+
+        // The depth buffer is padded to whole blocks, so full rows are stored
+        __m256i merged = _mm256_blendv_epi8(stored, depth, pass);
+        if (depth_16) {
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(merged, merged), 0x08);
+            _mm_storeu_si128((__m128i*)depth_row_16, _mm256_castsi256_si128(packed));
+        } else {
+            _mm256_storeu_si256((__m256i*)depth_row_32, merged);
+        }
+        written += (u32)__builtin_popcount(pass_bits);
+    }
+
+    if (written > 0) {
+        u32 farthest;
+        if (depth_16) {
+            __m128i max = _mm_setzero_si128();
+            for (u32 j = 0; j < FC_RASTER_BLOCK_SIZE; ++j) {
+                const u16* row = (const u16*)block->depth + (u64)j * block->depth_stride;
+                max = _mm_max_epu16(max, _mm_loadu_si128((const __m128i*)row));
+            }
+            max = _mm_max_epu16(max, _mm_srli_si128(max, 8));
+            max = _mm_max_epu16(max, _mm_srli_si128(max, 4));
+            max = _mm_max_epu16(max, _mm_srli_si128(max, 2));
+            farthest = (u32)_mm_extract_epi16(max, 0);
+        } else {
+            __m256i max = _mm256_setzero_si256();
+            for (u32 j = 0; j < FC_RASTER_BLOCK_SIZE; ++j) {
+                const u32* row = (const u32*)block->depth + (u64)j * block->depth_stride;
+                max = _mm256_max_epu32(max, _mm256_loadu_si256((const __m256i*)row));
+            }
+            __m128i half = _mm_max_epu32(_mm256_castsi256_si128(max), _mm256_extracti128_si256(max, 1));
+            half = _mm_max_epu32(half, _mm_srli_si128(half, 8));
+            half = _mm_max_epu32(half, _mm_srli_si128(half, 4));
+            farthest = (u32)_mm_cvtsi128_si32(half);
+        }
+        *block_depth = farthest;
+    }
+    return written;
+}
+
+#endif
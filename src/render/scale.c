@@ -0,0 +1,191 @@
+#include "finch/render/scale.h"
+#include "finch/core/memory.h"
+#include "finch/render/kernels.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+void fc_render_scale_resolve(FcRenderScale* render_scale,
+                             u32 window_width, u32 window_height,
+                             u32* width, u32* height)
+{
+    *width  = window_width;
+    *height = window_height;
+
+    switch (render_scale->mode) {
+        case FC_RENDER_SCALE_FIXED: {
+            if (render_scale->width_px > 0 && render_scale->height_px > 0) {
+                *width  = render_scale->width_px;
+                *height = render_scale->height_px;
+            }
+        } break;
+        case FC_RENDER_SCALE_FACTOR:
+        case FC_RENDER_SCALE_DYNAMIC: {
+            if (render_scale->factor <= 0.0f) {
+                render_scale->factor = render_scale->max_factor > 0.0f
+                    ? render_scale->max_factor
+                    : 1.0f;
+            }
+            *width  = (u32)(window_width  * render_scale->factor);
+            *height = (u32)(window_height * render_scale->factor);
+        } break;
+        default: {}
+    }
+
+    if (*width  == 0) *width  = 1;
+    if (*height == 0) *height = 1;
+}
+
+b32 fc_render_scale_update(FcRenderScale* render_scale, f64 frame_ms)
+{
+    if (render_scale->mode != FC_RENDER_SCALE_DYNAMIC ||
+        render_scale->frame_budget_ms <= 0.0) {
+        return false;
+    }
+
+    render_scale->average_frame_ms = render_scale->average_frame_ms > 0.0
+        ? render_scale->average_frame_ms * 0.9 + frame_ms * 0.1
+        : frame_ms;
+    if (++render_scale->frames_since_change < FC_RENDER_SCALE_SETTLE_FRAMES) {
+        return false;
+    }
+
+    f64 budget  = render_scale->frame_budget_ms;
+    f64 average = render_scale->average_frame_ms;
+    if (average <= budget && average >= budget * 0.7) {
+        return false;
+    }
+
+    // Frame cost grows with the pixel count, i.e. with the factor squared.
+    // Aim a little under budget and limit each step to avoid oscillating.
+    f64 step = sqrt(budget * 0.85 / average);
+    if (step < 0.75) step = 0.75;
+    if (step > 1.10) step = 1.10;
+
+    f32 min_factor = render_scale->min_factor > 0.0f ? render_scale->min_factor : 0.25f;
+    f32 max_factor = render_scale->max_factor > 0.0f ? render_scale->max_factor : 1.0f;
+    f32 factor = (f32)(render_scale->factor * step);
+    if (factor < min_factor) factor = min_factor;
+    if (factor > max_factor) factor = max_factor;
+
+    render_scale->frames_since_change = 0;
+    render_scale->average_frame_ms = 0.0;
+    if (fabsf(factor - render_scale->factor) < 0.01f) {
+        return false;
+    }
+    render_scale->factor = factor;
+    return true;
+}
+
+void fc_render_scale_destination(FcRenderScale* render_scale,
+                                 u32 width, u32 height,
+                                 u32 window_width, u32 window_height,
+                                 u32* x, u32* y, u32* dest_width, u32* dest_height)
+{
+    *x = 0;
+    *y = 0;
+    *dest_width  = window_width;
+    *dest_height = window_height;
+
+    if (render_scale->integer_scaling) {
+        u32 scale_x = window_width  / width;
+        u32 scale_y = window_height / height;
+        u32 scale = scale_x < scale_y ? scale_x : scale_y;
+        if (scale >= 1) {
+            *dest_width  = width  * scale;
+            *dest_height = height * scale;
+            *x = (window_width  - *dest_width)  / 2;
+            *y = (window_height - *dest_height) / 2;
+        }
+    }
+}
+
+static void build_tables(FcUpscaler* upscaler)
+{
+    u32 src_width  = upscaler->src_width,  src_height  = upscaler->src_height;
+    u32 dest_width = upscaler->dest_width, dest_height = upscaler->dest_height;
+
+    FC_FREE(upscaler->x_table);
+    FC_FREE(upscaler->y_table);
+    FC_FREE(upscaler->rows);
+    upscaler->x_table = (u32*)FC_ALLOC(dest_width  * sizeof(u32), "upscaler");
+    upscaler->y_table = (u32*)FC_ALLOC(dest_height * sizeof(u32), "upscaler");
+    upscaler->rows    = (u32*)FC_ALLOC((src_width + 1) * sizeof(u32), "upscaler");
+
+    if (upscaler->filter == FC_RENDER_SCALE_FILTER_NEAREST) {
+        // Sample at destination pixel centers, which makes whole-number
+        // scales repeat every source pixel exactly
+        for (u32 i = 0; i < dest_width; ++i) {
+            upscaler->x_table[i] = (u32)(((2ull * i + 1) * src_width) / (2ull * dest_width));
+        }
+        for (u32 j = 0; j < dest_height; ++j) {
+            upscaler->y_table[j] = (u32)(((2ull * j + 1) * src_height) / (2ull * dest_height));
+        }
+        return;
+    }
+
+    // 16.16 fixed point source positions, clamped to the last pixel
+    for (u32 i = 0; i < dest_width; ++i) {
+        s64 position = (s64)(((2ull * i + 1) * src_width << 16) / (2ull * dest_width)) - 32768;
+        s64 last = (s64)(src_width - 1) << 16;
+        upscaler->x_table[i] = (u32)(position < 0 ? 0 : position > last ? last : position);
+    }
+    for (u32 j = 0; j < dest_height; ++j) {
+        s64 position = (s64)(((2ull * j + 1) * src_height << 16) / (2ull * dest_height)) - 32768;
+        s64 last = (s64)(src_height - 1) << 16;
+        upscaler->y_table[j] = (u32)(position < 0 ? 0 : position > last ? last : position);
+    }
+}
+
+void fc_upscaler_run(FcUpscaler* upscaler, FcRenderScaleFilter filter,
+                     u32* dest, u32 dest_stride, u32 dest_width, u32 dest_height,
+                     const u32* src, u32 src_width, u32 src_height)
+{
+    if (upscaler->x_table == NULL || upscaler->filter != filter ||
+        upscaler->src_width  != src_width  || upscaler->src_height  != src_height ||
+        upscaler->dest_width != dest_width || upscaler->dest_height != dest_height) {
+        upscaler->src_width   = src_width;
+        upscaler->src_height  = src_height;
+        upscaler->dest_width  = dest_width;
+        upscaler->dest_height = dest_height;
+        upscaler->filter      = filter;
+        build_tables(upscaler);
+    }
+
+    u32* dest_row = dest;
+    u32 previous_y = ~0u;
+    for (u32 j = 0; j < dest_height; ++j, dest_row += dest_stride) {
+        u32 y = upscaler->y_table[j];
+
+        // Rows that sample the same source position are identical
+        if (y == previous_y) {
+            fc_copy_u32(dest_row, dest_row - dest_stride, dest_width);
+            continue;
+        }
+        previous_y = y;
+
+        if (filter == FC_RENDER_SCALE_FILTER_NEAREST) {
+            fc_render_kernels.scale_row_nearest(dest_row, src + (u64)y * src_width,
+                                                upscaler->x_table, dest_width);
+            continue;
+        }
+
+        u32 y0 = y >> 16;
+        u32 y1 = y0 + 1 < src_height ? y0 + 1 : y0;
+        u32 weight = (y >> 8) & 0xFF;
+        fc_render_kernels.lerp_u32(upscaler->rows,
+                                   src + (u64)y0 * src_width, src + (u64)y1 * src_width,
+                                   weight, src_width);
+        upscaler->rows[src_width] = upscaler->rows[src_width - 1];
+        fc_render_kernels.scale_row_bilinear(dest_row, upscaler->rows,
+                                             upscaler->x_table, dest_width);
+    }
+}
+
+void fc_upscaler_free(FcUpscaler* upscaler)
+{
+    FC_FREE(upscaler->x_table);
+    FC_FREE(upscaler->y_table);
+    FC_FREE(upscaler->rows);
+    *upscaler = (FcUpscaler){0};
+}
@@ -0,0 +1,336 @@
+#include "finch/render/text.h"
+#include "finch/core/memory.h"
+#include "finch/render/kernels.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Coverage of one row of a line of text is gathered from the atlas into a
+// buffer of this size and blended with a single kernel call
+#define TEXT_MAX_RUN 2048
+
+#define PSF1_MAGIC 0x0436
+#define PSF2_MAGIC 0x864ab572
+
+// Limits on fonts read from files and on the baked atlas
+#define FONT_MAX_GLYPH_SIZE 256              // Pixels in either direction, before scaling
+#define FONT_MAX_ATLAS_SIZE (64ull << 20)    // Bytes
+
+// Printable ASCII, one byte per row with the leftmost pixel in the high bit
+static const u8 default_font_bits[95][8] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, //  
+    { 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x20, 0x00 }, // !
+    { 0x50, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // "
+    { 0x50, 0x50, 0xf8, 0x50, 0xf8, 0x50, 0x50, 0x00 }, // #
+    { 0x20, 0x78, 0xa0, 0x70, 0x28, 0xf0, 0x20, 0x00 }, // $
+    { 0xc0, 0xc8, 0x10, 0x20, 0x40, 0x98, 0x18, 0x00 }, // %
+    { 0x60, 0x90, 0xa0, 0x40, 0xa8, 0x90, 0x68, 0x00 }, // &
+    { 0x20, 0x20, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00 }, // quote
+    { 0x10, 0x20, 0x40, 0x40, 0x40, 0x20, 0x10, 0x00 }, // (
+    { 0x40, 0x20, 0x10, 0x10, 0x10, 0x20, 0x40, 0x00 }, // )
+    { 0x00, 0x20, 0xa8, 0x70, 0xa8, 0x20, 0x00, 0x00 }, // *
+    { 0x00, 0x20, 0x20, 0xf8, 0x20, 0x20, 0x00, 0x00 }, // +
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x20, 0x40 }, // ,
+    { 0x00, 0x00, 0x00, 0xf8, 0x00, 0x00, 0x00, 0x00 }, // -
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x60, 0x00 }, // .
+    { 0x00, 0x08, 0x10, 0x20, 0x40, 0x80, 0x00, 0x00 }, // /
+    { 0x70, 0x88, 0x98, 0xa8, 0xc8, 0x88, 0x70, 0x00 }, // 0
+    { 0x20, 0x60, 0x20, 0x20, 0x20, 0x20, 0x70, 0x00 }, // 1
+    { 0x70, 0x88, 0x08, 0x10, 0x20, 0x40, 0xf8, 0x00 }, // 2
+    { 0xf8, 0x10, 0x20, 0x10, 0x08, 0x88, 0x70, 0x00 }, // 3
+    { 0x10, 0x30, 0x50, 0x90, 0xf8, 0x10, 0x10, 0x00 }, // 4
+    { 0xf8, 0x80, 0xf0, 0x08, 0x08, 0x88, 0x70, 0x00 }, // 5
+    { 0x30, 0x40, 0x80, 0xf0, 0x88, 0x88, 0x70, 0x00 }, // 6
+    { 0xf8, 0x08, 0x10, 0x20, 0x40, 0x40, 0x40, 0x00 }, // 7
+    { 0x70, 0x88, 0x88, 0x70, 0x88, 0x88, 0x70, 0x00 }, // 8
+    { 0x70, 0x88, 0x88, 0x78, 0x08, 0x10, 0x60, 0x00 }, // 9
+    { 0x00, 0x60, 0x60, 0x00, 0x60, 0x60, 0x00, 0x00 }, // :
+    { 0x00, 0x60, 0x60, 0x00, 0x60, 0x20, 0x40, 0x00 }, // ;
+    { 0x10, 0x20, 0x40, 0x80, 0x40, 0x20, 0x10, 0x00 }, // <
+    { 0x00, 0x00, 0xf8, 0x00, 0xf8, 0x00, 0x00, 0x00 }, // =
+    { 0x40, 0x20, 0x10, 0x08, 0x10, 0x20, 0x40, 0x00 }, // >
+    { 0x70, 0x88, 0x08, 0x10, 0x20, 0x00, 0x20, 0x00 }, // ?
+    { 0x70, 0x88, 0x08, 0x68, 0xa8, 0xa8, 0x70, 0x00 }, // @
+    { 0x70, 0x88, 0x88, 0xf8, 0x88, 0x88, 0x88, 0x00 }, // A
+    { 0xf0, 0x88, 0x88, 0xf0, 0x88, 0x88, 0xf0, 0x00 }, // B
+    { 0x70, 0x88, 0x80, 0x80, 0x80, 0x88, 0x70, 0x00 }, // C
+    { 0xe0, 0x90, 0x88, 0x88, 0x88, 0x90, 0xe0, 0x00 }, // D
+    { 0xf8, 0x80, 0x80, 0xf0, 0x80, 0x80, 0xf8, 0x00 }, // E
+    { 0xf8, 0x80, 0x80, 0xf0, 0x80, 0x80, 0x80, 0x00 }, // F
+    { 0x70, 0x88, 0x80, 0xb8, 0x88, 0x88, 0x78, 0x00 }, // G
+    { 0x88, 0x88, 0x88, 0xf8, 0x88, 0x88, 0x88, 0x00 }, // H
+    { 0x70, 0x20, 0x20, 0x20, 0x20, 0x20, 0x70, 0x00 }, // I
+    { 0x38, 0x10, 0x10, 0x10, 0x10, 0x90, 0x60, 0x00 }, // J
+    { 0x88, 0x90, 0xa0, 0xc0, 0xa0, 0x90, 0x88, 0x00 }, // K
+    { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0xf8, 0x00 }, // L
+    { 0x88, 0xd8, 0xa8, 0xa8, 0x88, 0x88, 0x88, 0x00 }, // M
+    { 0x88, 0x88, 0xc8, 0xa8, 0x98, 0x88, 0x88, 0x00 }, // N
+    { 0x70, 0x88, 0x88, 0x88, 0x88, 0x88, 0x70, 0x00 }, // O
+    { 0xf0, 0x88, 0x88, 0xf0, 0x80, 0x80, 0x80, 0x00 }, // P
+    { 0x70, 0x88, 0x88, 0x88, 0xa8, 0x90, 0x68, 0x00 }, // Q
+    { 0xf0, 0x88, 0x88, 0xf0, 0xa0, 0x90, 0x88, 0x00 }, // R
+    { 0x78, 0x80, 0x80, 0x70, 0x08, 0x08, 0xf0, 0x00 }, // S
+    { 0xf8, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00 }, // T
+    { 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x70, 0x00 }, // U
+    { 0x88, 0x88, 0x88, 0x88, 0x88, 0x50, 0x20, 0x00 }, // V
+    { 0x88, 0x88, 0x88, 0xa8, 0xa8, 0xa8, 0x50, 0x00 }, // W
+    { 0x88, 0x88, 0x50, 0x20, 0x50, 0x88, 0x88, 0x00 }, // X
+    { 0x88, 0x88, 0x88, 0x50, 0x20, 0x20, 0x20, 0x00 }, // Y
+    { 0xf8, 0x08, 0x10, 0x20, 0x40, 0x80, 0xf8, 0x00 }, // Z
+    { 0x70, 0x40, 0x40, 0x40, 0x40, 0x40, 0x70, 0x00 }, // [
+    { 0x00, 0x80, 0x40, 0x20, 0x10, 0x08, 0x00, 0x00 }, // backslash
+    { 0x70, 0x10, 0x10, 0x10, 0x10, 0x10, 0x70, 0x00 }, // ]
+    { 0x20, 0x50, 0x88, 0x00, 0x00, 0x00, 0x00, 0x00 }, // ^
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf8, 0x00 }, // _
+    { 0x40, 0x20, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00 }, // `
+    { 0x00, 0x00, 0x70, 0x08, 0x78, 0x88, 0x78, 0x00 }, // a
+    { 0x80, 0x80, 0xb0, 0xc8, 0x88, 0x88, 0xf0, 0x00 }, // b
+    { 0x00, 0x00, 0x70, 0x80, 0x80, 0x88, 0x70, 0x00 }, // c
+    { 0x08, 0x08, 0x68, 0x98, 0x88, 0x88, 0x78, 0x00 }, // d
+    { 0x00, 0x00, 0x70, 0x88, 0xf8, 0x80, 0x70, 0x00 }, // e
+    { 0x30, 0x48, 0x40, 0xe0, 0x40, 0x40, 0x40, 0x00 }, // f
+    { 0x00, 0x00, 0x78, 0x88, 0x88, 0x78, 0x08, 0x70 }, // g
+    { 0x80, 0x80, 0xb0, 0xc8, 0x88, 0x88, 0x88, 0x00 }, // h
+    { 0x20, 0x00, 0x60, 0x20, 0x20, 0x20, 0x70, 0x00 }, // i
+    { 0x10, 0x00, 0x30, 0x10, 0x10, 0x10, 0x90, 0x60 }, // j
+    { 0x80, 0x80, 0x90, 0xa0, 0xc0, 0xa0, 0x90, 0x00 }, // k
+    { 0x60, 0x20, 0x20, 0x20, 0x20, 0x20, 0x70, 0x00 }, // l
+    { 0x00, 0x00, 0xd0, 0xa8, 0xa8, 0x88, 0x88, 0x00 }, // m
+    { 0x00, 0x00, 0xb0, 0xc8, 0x88, 0x88, 0x88, 0x00 }, // n
+    { 0x00, 0x00, 0x70, 0x88, 0x88, 0x88, 0x70, 0x00 }, // o
+    { 0x00, 0x00, 0xf0, 0x88, 0x88, 0xf0, 0x80, 0x80 }, // p
+    { 0x00, 0x00, 0x78, 0x88, 0x88, 0x78, 0x08, 0x08 }, // q
+    { 0x00, 0x00, 0xb0, 0xc8, 0x80, 0x80, 0x80, 0x00 }, // r
+    { 0x00, 0x00, 0x78, 0x80, 0x70, 0x08, 0xf0, 0x00 }, // s
+    { 0x40, 0x40, 0xe0, 0x40, 0x40, 0x48, 0x30, 0x00 }, // t
+    { 0x00, 0x00, 0x88, 0x88, 0x88, 0x98, 0x68, 0x00 }, // u
+    { 0x00, 0x00, 0x88, 0x88, 0x88, 0x50, 0x20, 0x00 }, // v
+    { 0x00, 0x00, 0x88, 0x88, 0xa8, 0xa8, 0x50, 0x00 }, // w
+    { 0x00, 0x00, 0x88, 0x50, 0x20, 0x50, 0x88, 0x00 }, // x
+    { 0x00, 0x00, 0x88, 0x88, 0x88, 0x78, 0x08, 0x70 }, // y
+    { 0x00, 0x00, 0xf8, 0x10, 0x20, 0x40, 0xf8, 0x00 }, // z
+    { 0x10, 0x20, 0x20, 0x40, 0x20, 0x20, 0x10, 0x00 }, // {
+    { 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00 }, // |
+    { 0x40, 0x20, 0x20, 0x10, 0x20, 0x20, 0x40, 0x00 }, // }
+    { 0x00, 0x00, 0x40, 0xa8, 0x10, 0x00, 0x00, 0x00 }, // ~
+};
+
+static b32 font_bake(FcFont* font, const u8* bits, u32 bytes_per_glyph, u32 bytes_per_row,
+                     u32 bits_width, u32 bits_height, u32 cell_width, u32 cell_height,
+                     u32 first_char, u32 glyph_count, u32 scale)
+{
+    scale = scale > 0 ? scale : 1;
+    u64 glyph_width  = (u64)cell_width  * scale;
+    u64 glyph_height = (u64)cell_height * scale;
+    u64 glyph_size = glyph_width * glyph_height;
+    if (glyph_size > FONT_MAX_ATLAS_SIZE || (u64)glyph_count * glyph_size > FONT_MAX_ATLAS_SIZE) {
+        FC_ENGINE_ERROR("A font of %u %ux%u glyphs at scale %u is too large",
+                        glyph_count, cell_width, cell_height, scale);
+        return false;
+    }
+    u8* atlas = (u8*)FC_ALLOC_ZEROED(glyph_count * glyph_size, "font atlas");
+    if (atlas == NULL) {
+        FC_ENGINE_ERROR("Could not allocate a font atlas of %llu bytes",
+                        (unsigned long long)(glyph_count * glyph_size));
+        return false;
+    }
+    font->glyph_width  = (u32)glyph_width;
+    font->glyph_height = (u32)glyph_height;
+    font->first_char   = first_char;
+    font->glyph_count  = glyph_count;
+    font->atlas        = atlas;
+
+    for (u32 g = 0; g < glyph_count; ++g) {
+        const u8* glyph_bits = bits + (u64)g * bytes_per_glyph;
+        u8* glyph = font->atlas + g * glyph_size;
+        for (u64 y = 0; y < (u64)bits_height * scale; ++y) {
+            const u8* row = glyph_bits + (y / scale) * bytes_per_row;
+            for (u64 x = 0; x < (u64)bits_width * scale; ++x) {
+                u64 bit = x / scale;
+                if (row[bit / 8] & (0x80 >> (bit % 8))) {
+                    glyph[y * glyph_width + x] = 0xFF;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void fc_font_init_default(FcFont* font, u32 scale)
+{
+    if (!font_bake(font, &default_font_bits[0][0], 8, 1, 5, 8, 6, 9, ' ', 95, scale)) {
+        font_bake(font, &default_font_bits[0][0], 8, 1, 5, 8, 6, 9, ' ', 95, 1);
+    }
+}
+
+b32 fc_font_load_psf(FcFont* font, const char* path, u32 scale)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        FC_ENGINE_ERROR("Could not open font `%s`", (char*)path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    u8* data = (u8*)FC_ALLOC(size > 0 ? size : 1, "font file");
+    b32 read = size > 0 && data != NULL && fread(data, 1, size, file) == (u64)size;
+    fclose(file);
+
+    b32 success = false;
+    u32 header[8];
+    if (read && size >= 4 && (data[0] | (data[1] << 8)) == PSF1_MAGIC) {
+        u32 glyph_count = (data[2] & 0x01) ? 512 : 256;
+        u32 height = data[3];
+        if (height > 0 && (u64)size >= 4 + (u64)glyph_count * height) {
+            success = font_bake(font, data + 4, height, 1, 8, height, 8, height, 0, glyph_count, scale);
+        }
+    } else if (read && size >= (long)sizeof(header)) {
+        memcpy(header, data, sizeof(header));
+        u32 header_size = header[2], glyph_count = header[4], glyph_size = header[5];
+        u32 height = header[6], width = header[7];
+        u64 bytes_per_row = ((u64)width + 7) / 8;
+        if (header[0] == PSF2_MAGIC && glyph_count > 0 && width > 0 && width <= FONT_MAX_GLYPH_SIZE &&
+            height > 0 && height <= FONT_MAX_GLYPH_SIZE && glyph_size >= bytes_per_row * height &&
+            (u64)size >= (u64)header_size + (u64)glyph_count * glyph_size) {
+            success = font_bake(font, data + header_size, glyph_size, (u32)bytes_per_row,
+                                width, height, width, height, 0, glyph_count, scale);
+        }
+    }
+
+    FC_FREE(data);
+    if (!success) {
+        FC_ENGINE_ERROR("`%s` is not a PSF font", (char*)path);
+    }
+    return success;
+}
+
+void fc_font_free(FcFont* font)
+{
+    FC_FREE(font->atlas);
+    font->atlas = NULL;
+}
+
+static const u8* glyph_coverage(const FcFont* font, u8 c)
+{
+    u32 index = c - font->first_char;
+    if (c < font->first_char || index >= font->glyph_count) {
+        index = (u32)'?' - font->first_char;
+        if ('?' < font->first_char || index >= font->glyph_count) {
+            index = 0;
+        }
+    }
+    return font->atlas + (u64)index * font->glyph_width * font->glyph_height;
+}
+
+static void draw_line(const FcFont* font, u32* pixels, u32 width, u32 height,
+                      s32 x, s32 y, u32 color, const char* text, u32 length)
+{
+    s64 glyph_width  = font->glyph_width;
+    s64 glyph_height = font->glyph_height;
+
+    // Clip to the pixelbuffer
+    s64 x0 = x > 0 ? x : 0;
+    s64 x1 = (s64)x + length * glyph_width;
+    s64 y0 = y > 0 ? y : 0;
+    s64 y1 = (s64)y + glyph_height;
+    x1 = x1 < width  ? x1 : width;
+    y1 = y1 < height ? y1 : height;
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    u32 first_glyph = (u32)((x0 - x) / glyph_width);
+    u32 end_glyph   = (u32)((x1 - x + glyph_width - 1) / glyph_width);
+    // Glyphs wider than the buffer are blended one at a time straight from
+    // the atlas, where each of their rows is contiguous already
+    b32 wide = glyph_width > TEXT_MAX_RUN;
+    u32 glyphs_per_run = wide ? 1 : (u32)(TEXT_MAX_RUN / glyph_width);
+
+    u8 coverage[TEXT_MAX_RUN];
+    for (u32 run = first_glyph; run < end_glyph; run += glyphs_per_run) {
+        u32 run_end = run + glyphs_per_run < end_glyph ? run + glyphs_per_run : end_glyph;
+        s64 run_x0 = x + run * glyph_width;
+        s64 run_x1 = x + run_end * glyph_width;
+        s64 clip_x0 = run_x0 > x0 ? run_x0 : x0;
+        s64 clip_x1 = run_x1 < x1 ? run_x1 : x1;
+
+        for (s64 row = y0; row < y1; ++row) {
+            u64 glyph_row = (u64)(row - y) * glyph_width;
+            const u8* source = coverage;
+            if (wide) {
+                source = glyph_coverage(font, (u8)text[run]) + glyph_row;
+            } else {
+                u8* cursor = coverage;
+                for (u32 g = run; g < run_end; ++g) {
+                    memcpy(cursor, glyph_coverage(font, (u8)text[g]) + glyph_row, glyph_width);
+                    cursor += glyph_width;
+                }
+            }
+            fc_render_kernels.blend_mask_u32(pixels + row * width + clip_x0,
+                                             source + (clip_x0 - run_x0),
+                                             color, (u64)(clip_x1 - clip_x0));
+        }
+    }
+}
+
+u32 fc_text_draw(const FcFont* font, u32* pixels, u32 width, u32 height,
+                 s32 x, s32 y, u32 color, const char* text)
+{
+    u32 widest = 0;
+    for (;;) {
+        u32 length = 0;
+        while (text[length] != '\0' && text[length] != '\n') {
+            ++length;
+        }
+        draw_line(font, pixels, width, height, x, y, color, text, length);
+        if (length * font->glyph_width > widest) {
+            widest = length * font->glyph_width;
+        }
+
+        if (text[length] == '\0') {
+            break;
+        }
+        text += length + 1;
+        y += font->glyph_height;
+    }
+    return widest;
+}
+
+u32 fc_text_draw_format_v(const FcFont* font, u32* pixels, u32 width, u32 height,
+                          s32 x, s32 y, u32 color, const char* fmt, va_list args)
+{
+    char text[1024];
+    string_format_v(text, sizeof(text), fmt, args);
+    return fc_text_draw(font, pixels, width, height, x, y, color, text);
+}
+
+u32 fc_text_draw_format(const FcFont* font, u32* pixels, u32 width, u32 height,
+                        s32 x, s32 y, u32 color, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    u32 widest = fc_text_draw_format_v(font, pixels, width, height, x, y, color, fmt, args);
+    va_end(args);
+    return widest;
+}
+
+void fc_text_measure(const FcFont* font, const char* text, u32* width, u32* height)
+{
+    u32 widest = 0, lines = 1, length = 0;
+    for (; *text != '\0'; ++text) {
+        if (*text == '\n') {
+            ++lines;
+            length = 0;
+            continue;
+        }
+        if (++length * font->glyph_width > widest) {
+            widest = length * font->glyph_width;
+        }
+    }
+    *width  = widest;
+    *height = lines * font->glyph_height;
+}
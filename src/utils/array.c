@@ -0,0 +1,97 @@
+#include "finch/utils/array.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+
+#include <string.h>
+
+void fc_array_init(FcArray* array, u32 element_size, u32 element_alignment,
+                   const FcAllocator* allocator)
+{
+    *array = (FcArray){
+        .element_size = element_size,
+        .element_alignment = element_alignment,
+        .allocator = allocator != NULL ? *allocator : fc_heap_allocator()
+    };
+}
+
+void fc_array_free(FcArray* array)
+{
+    if (array->data != NULL) {
+        FC_ALLOCATOR_FREE(&array->allocator, array->data,
+                          (u64)array->capacity * array->element_size);
+    }
+    array->data = NULL;
+    array->count = 0;
+    array->capacity = 0;
+}
+
+b32 fc_array_reserve(FcArray* array, u32 capacity)
+{
+    if (capacity <= array->capacity) {
+        return true;
+    }
+
+    u64 size = (u64)capacity * array->element_size;
+    u8* data = FC_ALLOCATOR_ALLOC(&array->allocator, size, array->element_alignment, "array");
+    if (data == NULL) {
+        FC_ENGINE_ERROR("Failed to grow array to %u elements", capacity);
+        return false;
+    }
+    if (array->data != NULL) {
+        memcpy(data, array->data, (u64)array->count * array->element_size);
+        FC_ALLOCATOR_FREE(&array->allocator, array->data,
+                          (u64)array->capacity * array->element_size);
+    }
+    array->data = data;
+    array->capacity = capacity;
+    return true;
+}
+
+b32 fc_array_resize(FcArray* array, u32 count)
+{
+    if (count > array->capacity) {
+        u32 capacity = array->capacity != 0 ? array->capacity : 16;
+        while (capacity < count) {
+            capacity *= 2;
+        }
+        if (!fc_array_reserve(array, capacity)) {
+            return false;
+        }
+    }
+    if (count > array->count) {
+        memset(array->data + (u64)array->count * array->element_size, 0,
+               (u64)(count - array->count) * array->element_size);
+    }
+    array->count = count;
+    return true;
+}
+
+void fc_array_pop(FcArray* array)
+{
+    if (array->count > 0) {
+        array->count -= 1;
+    }
+}
+
+void fc_array_remove_swap(FcArray* array, u32 index)
+{
+    u32 last = array->count - 1;
+    if (index != last) {
+        memcpy(array->data + (u64)index * array->element_size,
+               array->data + (u64)last * array->element_size, array->element_size);
+    }
+    array->count = last;
+}
+
+void fc_array_remove_ordered(FcArray* array, u32 index)
+{
+    memmove(array->data + (u64)index * array->element_size,
+            array->data + (u64)(index + 1) * array->element_size,
+            (u64)(array->count - index - 1) * array->element_size);
+    array->count -= 1;
+}
+
+void fc_array_clear(FcArray* array)
+{
+    array->count = 0;
+}
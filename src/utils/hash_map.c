@@ -0,0 +1,344 @@
+#include "finch/utils/hash_map.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Control bytes: the high bit is set for free slots, clear for full ones,
+// which hold the low 7 bits of their hash
+#define CONTROL_EMPTY   0x80
+#define CONTROL_DELETED 0xFE
+
+#define MIN_CAPACITY FC_HASH_MAP_GROUP_WIDTH
+
+// Bit i of a mask is slot i of a group
+typedef u32 GroupMask;
+
+#if defined(__SSE2__)
+static inline GroupMask group_match(const u8* group, u8 value)
+{
+    __m128i control = _mm_load_si128((const __m128i*)group);
+    return (GroupMask)_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8((char)value)));
+}
+
+static inline GroupMask group_match_free(const u8* group)
+{
+    return (GroupMask)_mm_movemask_epi8(_mm_load_si128((const __m128i*)group));
+}
+#else
+static inline GroupMask group_match(const u8* group, u8 value)
+{
+    GroupMask mask = 0;
+    for (u32 i = 0; i < FC_HASH_MAP_GROUP_WIDTH; ++i) {
+        mask |= (GroupMask)(group[i] == value) << i;
+    }
+    return mask;
+}
+
+static inline GroupMask group_match_free(const u8* group)
+{
+    GroupMask mask = 0;
+    for (u32 i = 0; i < FC_HASH_MAP_GROUP_WIDTH; ++i) {
+        mask |= (GroupMask)(group[i] >> 7) << i;
+    }
+    return mask;
+}
+#endif
+
+static inline u32 lowest_bit(GroupMask mask)
+{
+    return (u32)__builtin_ctz(mask);
+}
+
+static inline u64 mix(u64 value)
+{
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDull;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+u64 fc_hash_bytes(const void* data, u64 size)
+{
+    const u8* bytes = (const u8*)data;
+    u64 hash = 0x9E3779B97F4A7C15ull ^ size;
+    while (size >= 8) {
+        u64 word;
+        memcpy(&word, bytes, 8);
+        hash = (hash ^ mix(word)) * 0x9E3779B97F4A7C15ull;
+        bytes += 8;
+        size -= 8;
+    }
+    if (size > 0) {
+        u64 word = 0;
+        memcpy(&word, bytes, size);
+        hash = (hash ^ mix(word)) * 0x9E3779B97F4A7C15ull;
+    }
+    return mix(hash);
+}
+
+static inline u64 hash_key(const FcHashMap* map, const void* key)
+{
+    if (map->hash != NULL) {
+        return map->hash(key, map->key_size);
+    }
+    // Integer keys skip the loop
+    if (map->key_size == 8) {
+        u64 word;
+        memcpy(&word, key, 8);
+        return mix(word);
+    }
+    if (map->key_size == 4) {
+        u32 word;
+        memcpy(&word, key, 4);
+        return mix(word);
+    }
+    return fc_hash_bytes(key, map->key_size);
+}
+
+static inline b32 keys_equal(const FcHashMap* map, const void* a, const void* b)
+{
+    if (map->equal != NULL) {
+        return map->equal(a, b, map->key_size);
+    }
+    return memcmp(a, b, map->key_size) == 0;
+}
+
+static inline u8* slot_at(const FcHashMap* map, u32 index)
+{
+    return map->slots + (u64)index * map->slot_size;
+}
+
+// The top bits pick the first group, the low 7 go into the control byte
+static inline u32 hash_group(u64 hash, u32 group_mask)
+{
+    return (u32)(hash >> 7) & group_mask;
+}
+
+static inline u8 hash_control(u64 hash)
+{
+    return (u8)(hash & 0x7F);
+}
+
+static u32 max_load(u32 capacity)
+{
+    return capacity - capacity / 8;
+}
+
+void fc_hash_map_init(FcHashMap* map, u32 key_size, u32 value_size,
+                      const FcAllocator* allocator)
+{
+    u32 value_offset = (key_size + 7) & ~7u;
+    *map = (FcHashMap){
+        .key_size = key_size,
+        .value_offset = value_offset,
+        .value_size = value_size,
+        .slot_size = (value_offset + value_size + 7) & ~7u,
+        .allocator = allocator != NULL ? *allocator : fc_heap_allocator()
+    };
+}
+
+static void free_storage(FcHashMap* map)
+{
+    if (map->control != NULL) {
+        FC_ALLOCATOR_FREE(&map->allocator, map->control,
+                          map->capacity + (u64)map->capacity * map->slot_size);
+    }
+}
+
+void fc_hash_map_free(FcHashMap* map)
+{
+    free_storage(map);
+    map->control = NULL;
+    map->slots = NULL;
+    map->capacity = 0;
+    map->count = 0;
+    map->growth_left = 0;
+}
+
+// First free slot on the probe sequence of `hash`. There always is one.
+static u32 find_free_slot(const FcHashMap* map, u64 hash)
+{
+    u32 group_mask = map->capacity / FC_HASH_MAP_GROUP_WIDTH - 1;
+    u32 group = hash_group(hash, group_mask);
+    for (u32 step = 1;; ++step) {
+        const u8* control = map->control + group * FC_HASH_MAP_GROUP_WIDTH;
+        GroupMask free_slots = group_match_free(control);
+        if (free_slots != 0) {
+            return group * FC_HASH_MAP_GROUP_WIDTH + lowest_bit(free_slots);
+        }
+        // Triangular steps visit every group of a power of two count
+        group = (group + step) & group_mask;
+    }
+}
+
+// Moves every entry into fresh storage of `capacity` slots, dropping
+// tombstones on the way
+static b32 rehash(FcHashMap* map, u32 capacity)
+{
+    u64 storage_size = capacity + (u64)capacity * map->slot_size;
+    u8* storage = FC_ALLOCATOR_ALLOC(&map->allocator, storage_size, 16, "hash_map");
+    if (storage == NULL) {
+        FC_ENGINE_ERROR("Failed to grow hash map to %u slots", capacity);
+        return false;
+    }
+
+    FcHashMap old = *map;
+    map->control = storage;
+    map->slots = storage + capacity;
+    map->capacity = capacity;
+    map->growth_left = max_load(capacity) - map->count;
+    memset(map->control, CONTROL_EMPTY, capacity);
+
+    for (u32 i = 0; i < old.capacity; ++i) {
+        if (old.control[i] & 0x80) {
+            continue;
+        }
+        const u8* slot = slot_at(&old, i);
+        u64 hash = hash_key(map, slot);
+        u32 index = find_free_slot(map, hash);
+        map->control[index] = hash_control(hash);
+        memcpy(slot_at(map, index), slot, map->slot_size);
+    }
+
+    free_storage(&old);
+    return true;
+}
+
+b32 fc_hash_map_reserve(FcHashMap* map, u32 count)
+{
+    u32 capacity = map->capacity != 0 ? map->capacity : MIN_CAPACITY;
+    while (max_load(capacity) < count) {
+        capacity *= 2;
+    }
+    if (capacity == map->capacity) {
+        return true;
+    }
+    return rehash(map, capacity);
+}
+
+static u32 find_index(const FcHashMap* map, const void* key, u64 hash)
+{
+    u32 group_mask = map->capacity / FC_HASH_MAP_GROUP_WIDTH - 1;
+    u32 group = hash_group(hash, group_mask);
+    u8 control_byte = hash_control(hash);
+
+    for (u32 step = 1; step <= group_mask + 1; ++step) {
+        const u8* control = map->control + group * FC_HASH_MAP_GROUP_WIDTH;
+        GroupMask matches = group_match(control, control_byte);
+        while (matches != 0) {
+            u32 index = group * FC_HASH_MAP_GROUP_WIDTH + lowest_bit(matches);
+            if (keys_equal(map, slot_at(map, index), key)) {
+                return index;
+            }
+            matches &= matches - 1;
+        }
+        // A key is never placed past a group with an empty slot
+        if (group_match(control, CONTROL_EMPTY) != 0) {
+            break;
+        }
+        group = (group + step) & group_mask;
+    }
+    return UINT32_MAX;
+}
+
+void* fc_hash_map_find(const FcHashMap* map, const void* key)
+{
+    if (map->count == 0) {
+        return NULL;
+    }
+    u32 index = find_index(map, key, hash_key(map, key));
+    return index != UINT32_MAX ? slot_at(map, index) + map->value_offset : NULL;
+}
+
+void* fc_hash_map_insert(FcHashMap* map, const void* key, b32* existed)
+{
+    u64 hash = hash_key(map, key);
+    if (map->count > 0) {
+        u32 index = find_index(map, key, hash);
+        if (index != UINT32_MAX) {
+            if (existed != NULL) {
+                *existed = true;
+            }
+            return slot_at(map, index) + map->value_offset;
+        }
+    }
+    if (existed != NULL) {
+        *existed = false;
+    }
+
+    u32 index = map->capacity != 0 ? find_free_slot(map, hash) : 0;
+    if (map->capacity == 0 ||
+        (map->growth_left == 0 && map->control[index] == CONTROL_EMPTY)) {
+        // Grow, unless tombstones are what fill the map
+        u32 capacity = map->capacity == 0 ? MIN_CAPACITY :
+            (map->count + 1 > map->capacity / 2 ? map->capacity * 2 : map->capacity);
+        if (!rehash(map, capacity)) {
+            return NULL;
+        }
+        index = find_free_slot(map, hash);
+    }
+
+    // Reusing a tombstone does not use up an empty slot
+    if (map->control[index] == CONTROL_EMPTY) {
+        map->growth_left -= 1;
+    }
+    map->control[index] = hash_control(hash);
+    map->count += 1;
+
+    u8* slot = slot_at(map, index);
+    memcpy(slot, key, map->key_size);
+    return slot + map->value_offset;
+}
+
+b32 fc_hash_map_remove(FcHashMap* map, const void* key)
+{
+    if (map->count == 0) {
+        return false;
+    }
+    u32 index = find_index(map, key, hash_key(map, key));
+    if (index == UINT32_MAX) {
+        return false;
+    }
+
+    // Probes stop at groups with an empty slot, so the slot can be empty
+    // again if its group already has one; otherwise probes must go on past it
+    const u8* group = map->control + (index & ~(u32)(FC_HASH_MAP_GROUP_WIDTH - 1));
+    if (group_match(group, CONTROL_EMPTY) != 0) {
+        map->control[index] = CONTROL_EMPTY;
+        map->growth_left += 1;
+    } else {
+        map->control[index] = CONTROL_DELETED;
+    }
+    map->count -= 1;
+    return true;
+}
+
+void fc_hash_map_clear(FcHashMap* map)
+{
+    if (map->capacity != 0) {
+        memset(map->control, CONTROL_EMPTY, map->capacity);
+        map->growth_left = max_load(map->capacity);
+    }
+    map->count = 0;
+}
+
+b32 fc_hash_map_next(const FcHashMap* map, u32* iterator, void** key, void** value)
+{
+    while (*iterator < map->capacity) {
+        u32 index = (*iterator)++;
+        if ((map->control[index] & 0x80) == 0) {
+            u8* slot = slot_at(map, index);
+            *key = slot;
+            *value = slot + map->value_offset;
+            return true;
+        }
+    }
+    return false;
+}
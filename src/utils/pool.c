@@ -0,0 +1,70 @@
+#include "finch/utils/pool.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+
+#include <string.h>
+
+static inline void set_next_free(FcPool* pool, u32 index, u32 next)
+{
+    memcpy(fc_pool_block_at(pool, index), &next, sizeof(next));
+}
+
+static void link_free_blocks(FcPool* pool)
+{
+    for (u32 i = 0; i < pool->capacity; ++i) {
+        set_next_free(pool, i, i + 1 < pool->capacity ? i + 1 : FC_POOL_END);
+    }
+    pool->free_head = pool->capacity > 0 ? 0 : FC_POOL_END;
+    pool->count = 0;
+}
+
+static u64 storage_size(u32 block_size, u32 capacity)
+{
+    return (u64)block_size * capacity + (u64)capacity * sizeof(u32);
+}
+
+b32 fc_pool_init(FcPool* pool, u32 block_size, u32 capacity, const FcAllocator* allocator)
+{
+    // Room for the free list link, and 16 byte alignment for every block
+    block_size = block_size < sizeof(u32) ? sizeof(u32) : block_size;
+    block_size = (block_size + 15) & ~15u;
+
+    *pool = (FcPool){
+        .block_size = block_size,
+        .capacity = capacity,
+        .allocator = allocator != NULL ? *allocator : fc_heap_allocator()
+    };
+
+    u8* storage = FC_ALLOCATOR_ALLOC(&pool->allocator, storage_size(block_size, capacity),
+                                     16, "pool");
+    if (storage == NULL) {
+        FC_ENGINE_ERROR("Failed to allocate a pool of %u blocks of %u bytes",
+                        capacity, block_size);
+        pool->capacity = 0;
+        pool->free_head = FC_POOL_END;
+        return false;
+    }
+    pool->blocks = storage;
+    pool->generations = (u32*)(storage + (u64)block_size * capacity);
+    memset(pool->generations, 0, (u64)capacity * sizeof(u32));
+    link_free_blocks(pool);
+    return true;
+}
+
+void fc_pool_free(FcPool* pool)
+{
+    if (pool->blocks != NULL) {
+        FC_ALLOCATOR_FREE(&pool->allocator, pool->blocks,
+                          storage_size(pool->block_size, pool->capacity));
+    }
+    *pool = (FcPool){ .free_head = FC_POOL_END };
+}
+
+void fc_pool_clear(FcPool* pool)
+{
+    // Bumping only live blocks keeps every generation even
+    for (u32 i = 0; i < pool->capacity; ++i) {
+        pool->generations[i] += pool->generations[i] & 1;
+    }
+    link_free_blocks(pool);
+}
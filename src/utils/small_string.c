@@ -0,0 +1,152 @@
+#include "finch/utils/small_string.h"
+#include "finch/utils/hash_map.h"
+#include "finch/utils/string.h"
+#include "finch/log/log.h"
+
+#include <string.h>
+
+static FcAllocator heap_allocator(const FcSmallString* string)
+{
+    return string->allocator != NULL ? *string->allocator : fc_heap_allocator();
+}
+
+static char* chars(FcSmallString* string)
+{
+    return string->on_heap ? string->heap.data : string->inline_chars;
+}
+
+static u32 capacity(const FcSmallString* string)
+{
+    return string->on_heap ? string->heap.capacity : FC_SMALL_STRING_INLINE_CAPACITY;
+}
+
+// Makes room for `length` characters, keeping the current ones
+static b32 reserve(FcSmallString* string, u32 length)
+{
+    if (length <= capacity(string)) {
+        return true;
+    }
+
+    u32 new_capacity = capacity(string);
+    while (new_capacity < length) {
+        new_capacity = new_capacity * 2 + 1;
+    }
+    FcAllocator allocator = heap_allocator(string);
+    char* data = FC_ALLOCATOR_ALLOC(&allocator, (u64)new_capacity + 1, 0, "small_string");
+    if (data == NULL) {
+        FC_ENGINE_ERROR("Failed to grow string to %u characters", length);
+        return false;
+    }
+    memcpy(data, chars(string), (u64)string->length + 1);
+    if (string->on_heap) {
+        FC_ALLOCATOR_FREE(&allocator, string->heap.data, (u64)string->heap.capacity + 1);
+    }
+    string->heap.data = data;
+    string->heap.capacity = new_capacity;
+    string->on_heap = true;
+    return true;
+}
+
+void fc_small_string_init(FcSmallString* string, const FcAllocator* allocator)
+{
+    *string = (FcSmallString){ .allocator = allocator };
+}
+
+void fc_small_string_free(FcSmallString* string)
+{
+    if (string->on_heap) {
+        FcAllocator allocator = heap_allocator(string);
+        FC_ALLOCATOR_FREE(&allocator, string->heap.data, (u64)string->heap.capacity + 1);
+    }
+    fc_small_string_init(string, string->allocator);
+}
+
+// Offset of str in the string's own characters, or -1 when it points
+// elsewhere, so it can be found again after reserve moves them
+static s64 own_offset(FcSmallString* string, const char* str)
+{
+    const char* start = chars(string);
+    return str >= start && str <= start + string->length ? str - start : -1;
+}
+
+b32 fc_small_string_set_n(FcSmallString* string, const char* str, u32 length)
+{
+    s64 offset = own_offset(string, str);
+    if (!reserve(string, length)) {
+        return false;
+    }
+    char* dest = chars(string);
+    memmove(dest, offset >= 0 ? dest + offset : str, length);
+    string->length = length;
+    dest[length] = '\0';
+    return true;
+}
+
+b32 fc_small_string_set(FcSmallString* string, const char* str)
+{
+    return fc_small_string_set_n(string, str, (u32)strlen(str));
+}
+
+b32 fc_small_string_append_n(FcSmallString* string, const char* str, u32 length)
+{
+    s64 offset = own_offset(string, str);
+    if (!reserve(string, string->length + length)) {
+        return false;
+    }
+    char* dest = chars(string);
+    memcpy(dest + string->length, offset >= 0 ? dest + offset : str, length);
+    string->length += length;
+    dest[string->length] = '\0';
+    return true;
+}
+
+b32 fc_small_string_append(FcSmallString* string, const char* str)
+{
+    return fc_small_string_append_n(string, str, (u32)strlen(str));
+}
+
+b32 fc_small_string_format_v(FcSmallString* string, const char* fmt, va_list args)
+{
+    char buffer[1024];
+    u32 length = string_format_v(buffer, sizeof(buffer), fmt, args);
+    return fc_small_string_set_n(string, buffer, length);
+}
+
+b32 fc_small_string_format(FcSmallString* string, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    b32 result = fc_small_string_format_v(string, fmt, args);
+    va_end(args);
+    return result;
+}
+
+void fc_small_string_clear(FcSmallString* string)
+{
+    string->length = 0;
+    chars(string)[0] = '\0';
+}
+
+b32 fc_small_string_equals(const FcSmallString* a, const FcSmallString* b)
+{
+    return a->length == b->length &&
+        memcmp(fc_small_string_cstr(a), fc_small_string_cstr(b), a->length) == 0;
+}
+
+b32 fc_small_string_equals_cstr(const FcSmallString* string, const char* str)
+{
+    return strcmp(fc_small_string_cstr(string), str) == 0;
+}
+
+u64 fc_small_string_hash_key(const void* key, u32 size)
+{
+    (void)size;
+    const FcSmallString* string = (const FcSmallString*)key;
+    return fc_hash_bytes(fc_small_string_cstr(string), string->length);
+}
+
+b32 fc_small_string_key_equal(const void* a, const void* b, u32 size)
+{
+    (void)size;
+    return fc_small_string_equals((const FcSmallString*)a, (const FcSmallString*)b);
+}
@@ -2,10 +2,15 @@
 #include "finch/utils/utils.h"
 #include "finch/log/log.h"
 #include "finch/platform/platform.h"
+#include "finch/platform/cpu.h"
 
 #include <stdlib.h>
 
-u32 string_length_null_terminated(char* str)
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+static u32 string_length_generic(char* str)
 {
     u32 length = 0;
     while (str && *str != '\0') {
@@ -15,6 +20,80 @@ u32 string_length_null_terminated(char* str)
     return length;
 }
 
+#if defined(__x86_64__) || defined(__i386__)
+// Scans aligned blocks, which never cross a page boundary, so reading past
+// the terminator is safe
+__attribute__((target("sse2")))
+static u32 string_length_sse2(char* str)
+{
+    if (str == NULL) {
+        return 0;
+    }
+    u32 misalignment = (u64)str & 15;
+    const __m128i* block = (const __m128i*)(str - misalignment);
+    const __m128i zero = _mm_setzero_si128();
+
+    u32 mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(block), zero))
+        >> misalignment;
+    if (mask != 0) {
+        return __builtin_ctz(mask);
+    }
+    for (;;) {
+        block += 1;
+        mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(block), zero));
+        if (mask != 0) {
+            return (u32)((const char*)block - str) + __builtin_ctz(mask);
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static u32 string_length_avx2(char* str)
+{
+    if (str == NULL) {
+        return 0;
+    }
+    u32 misalignment = (u64)str & 31;
+    const __m256i* block = (const __m256i*)(str - misalignment);
+    const __m256i zero = _mm256_setzero_si256();
+
+    u32 mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(block), zero))
+        >> misalignment;
+    if (mask != 0) {
+        return __builtin_ctz(mask);
+    }
+    for (;;) {
+        block += 1;
+        mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(block), zero));
+        if (mask != 0) {
+            return (u32)((const char*)block - str) + __builtin_ctz(mask);
+        }
+    }
+}
+#endif
+
+static u32 (*string_length_kernel)(char*) = string_length_generic;
+
+void string_select_kernels(u32 cpu_features)
+{
+    string_length_kernel = string_length_generic;
+#if defined(__x86_64__) || defined(__i386__)
+    if (cpu_features & FC_CPU_FEATURE_SSE2) {
+        string_length_kernel = string_length_sse2;
+    }
+    if (cpu_features & FC_CPU_FEATURE_AVX2) {
+        string_length_kernel = string_length_avx2;
+    }
+#else
+    (void)cpu_features;
+#endif
+}
+
+u32 string_length_null_terminated(char* str)
+{
+    return string_length_kernel(str);
+}
+
 void string_reverse(char* str, u32 length)
 {
     for (u32 i = 0; i < length / 2; ++i) {
@@ -108,48 +187,68 @@ char* string_copy(char* dest, char* src)
 }
 
 
-// TODO: Remove dependency on libc math
-#include "math.h"
+// Rounds to `num_decimals` (at most 9) decimals and writes
+// "nan"/"inf" for non-finite numbers
 char* f64_to_string_null_terminated(f64 number, char* buf, u32 buf_size, u32 num_decimals) {
-    char* s = buf + buf_size;
+    char digits[48];
+    char* s = digits + sizeof(digits);
     *--s = '\0';
-    s32 k = pow(10, num_decimals);
-    u16 decimals;
-    s32 units;
-    if (number < 0) {
-        decimals = (s32)(number * -k) % k;
-        units = (s32)(number * -1);
-    } else {
-        decimals = (s32)(number * k) % k;
-        units = (s32)number;
+
+    if (number != number) {
+        string_copy(buf, buf_size >= 4 ? "nan" : "");
+        return buf;
+    }
+    b32 negative = number < 0;
+    f64 magnitude = negative ? -number : number;
+    if (magnitude > 1.8e19) {
+        string_copy(buf, buf_size >= 5 ? (negative ? "-inf" : "inf") : "");
+        return buf;
+    }
+
+    num_decimals = num_decimals < 9 ? num_decimals : 9;
+    u64 k = 1;
+    for (u32 i = 0; i < num_decimals; ++i) {
+        k *= 10;
+    }
+    u64 units    = (u64)magnitude;
+    u64 decimals = (u64)((magnitude - (f64)units) * (f64)k + 0.5);
+    if (decimals >= k) {
+        decimals -= k;
+        units    += 1;
     }
 
     for (u32 i = 0; i < num_decimals; ++i) {
         *--s = (decimals % 10) + '0';
         decimals /= 10;
     }
-    *--s = '.';
+    if (num_decimals > 0) {
+        *--s = '.';
+    }
 
-    while (units > 0) {
+    do {
         *--s = (units % 10) + '0';
         units /= 10;
+    } while (units > 0);
+    if (negative) *--s = '-';
+
+    u32 length = (u32)(digits + sizeof(digits) - 1 - s);
+    if (length > buf_size - 1) {
+        length = buf_size - 1;
+    }
+    for (u32 i = 0; i < length; ++i) {
+        buf[i] = s[i];
     }
-    if (number < 0) *--s = '-';
+    buf[length] = '\0';
 
-    string_copy(buf, s);
-    
     return buf;
 }
 
 
-u32 string_format(char* dest, u32 max_size, const char* fmt, ...)
+u32 string_format_v(char* dest, u32 max_size, const char* fmt, va_list args)
 {
     char temp[1024] = {0};
     u32 i = 0, j = 0;
 
-    va_list args;
-    va_start(args, fmt);
-        
     while (fmt && fmt[i] && j < max_size - 1) {
 
         // If character is not a '%', treat no formatting is necessary
@@ -158,11 +257,16 @@ u32 string_format(char* dest, u32 max_size, const char* fmt, ...)
             continue;
         }
     
-        // Character is '%', formatting is necessary
+        // Character is '%', formatting is necessary. The log formats of
+        // src/log/README.md spell the same conversions with a V prefix.
         i += 1;
+        if (fmt[i] == 'V') {
+            i += 1;
+        }
         switch (fmt[i]) {
             case '%': {
-                dest[j++] = fmt[i++];
+                temp[0] = '%';
+                temp[1] = '\0';
             } break;
             case 'd': {
                 s64_to_string_null_terminated(va_arg(args, s32),
@@ -189,7 +293,12 @@ u32 string_format(char* dest, u32 max_size, const char* fmt, ...)
                 temp[1] = '\0';
             } break;
             case 's': {
-                string_copy(temp, va_arg(args, char*));
+                // Copied straight into dest, strings can be longer than temp
+                char* str = va_arg(args, char*);
+                while (str && *str != '\0' && j < max_size - 1) {
+                    dest[j++] = *str++;
+                }
+                temp[0] = '\0';
             } break;
             case 'p': {
                 temp[0] = '0';
@@ -197,6 +306,11 @@ u32 string_format(char* dest, u32 max_size, const char* fmt, ...)
                 u64_to_string_null_terminated(va_arg(args, u64),
                                               temp + 2, 1024, 16);
             } break;
+            case '\0': {
+                // A trailing '%' ends the format
+                i -= 1;
+                temp[0] = '\0';
+            } break;
             default: {
                 string_format(temp, 1024,
                               "Logger: Unrecognized format option: '%c'\n", fmt[i]);
@@ -206,13 +320,23 @@ u32 string_format(char* dest, u32 max_size, const char* fmt, ...)
             }
         }
         
-        string_copy(dest + j, temp);
-        j += string_length_null_terminated(temp);
+        // Truncated rather than written past the end of dest
+        for (u32 k = 0; temp[k] != '\0' && j < max_size - 1; ++k) {
+            dest[j++] = temp[k];
+        }
         i += 1;
     }
 
     dest[j] = '\0';
-    va_end(args);
 
     return j;
 }
+
+u32 string_format(char* dest, u32 max_size, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    u32 length = string_format_v(dest, max_size, fmt, args);
+    va_end(args);
+    return length;
+}
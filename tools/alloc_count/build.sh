@@ -0,0 +1,72 @@
+#! /usr/bin/sh
+
+source ../../scripts/color_support.sh
+
+CC=gcc
+CFLAGS="-Wall -Wextra -std=c11 -O2 -ggdb"
+
+INCLUDE_PATH="-I ../../include"
+SRC_PATH="src/"
+
+BUILD_PATH="build/"
+BIN_PATH=$BUILD_PATH"/bin/"
+LIB="libfinch_alloc_count.so"
+
+SRC=$(find $SRC_PATH -name '*.c' | sort -k 1nr | cut -f2-)
+OBJ=$(echo $SRC | sed "s|\.c|\.o|g" | sed "s|$SRC_PATH|$BUILD_PATH|g")
+
+clean()
+{
+    echo -e "${BOLD}${RED}Removing:${NORMAL} $BIN_PATH"
+    rm -rf $BIN_PATH
+    echo -e "${BOLD}${RED}Removing:${NORMAL} $BUILD_PATH"
+    rm -rf $BUILD_PATH
+}
+
+create_directories()
+{
+    echo -e "${BOLD}${GREEN}Creating:${NORMAL} $BUILD_PATH"
+    mkdir -p $BUILD_PATH
+    echo -e "${BOLD}${GREEN}Creating:${NORMAL} $BIN_PATH"
+    mkdir -p $BIN_PATH
+}
+
+compile_sources()
+{
+    # Compile C files
+    CNT=$(echo $SRC | wc -w)
+    for i in `seq 1 $CNT`; do
+        SRC_FILE=$(echo $SRC | cut -d\  -f$i)
+        OBJ_FILE=$(echo $OBJ | cut -d\  -f$i)
+        echo -e "${BOLD}${BLUE}Compiling:${NORMAL} $SRC_FILE -> $OBJ_FILE"
+        $CC $CFLAGS -c $INCLUDE_PATH -fpic $SRC_FILE -o $OBJ_FILE
+    done
+}
+
+link_library()
+{
+    # Not linked against libfinch, it is loaded before everything else
+    echo -e "${BOLD}${MAGENTA}Linking:${NORMAL} $OBJ -> $BIN_PATH/$LIB"
+    $CC $CFLAGS -shared -o $BIN_PATH/$LIB $OBJ
+}
+
+#
+# Main part of build script starts here
+#
+
+if test "$1" == '--clean'; then
+    echo -e "${BOLD}${STANDOUT}${RED}CLEANING PROJECT${NORMAL}"
+    clean | sed "s|^|    |g"
+    exit 0
+fi
+
+echo -e "${STANDOUT}${BOLD}${GREEN}CREATING DIRECTORIES${NORMAL}"
+create_directories | sed "s|^|    |g"
+echo ""
+
+echo -e "${STANDOUT}${BOLD}${BLUE}COMPILING SOURCES${NORMAL}"
+compile_sources | sed "s|^|    |g"
+echo ""
+
+echo -e "${STANDOUT}${BOLD}${MAGENTA}LINKING LIBRARY${NORMAL}"
+link_library | sed "s|^|    |g"
@@ -0,0 +1,72 @@
+#define _GNU_SOURCE
+
+#include "finch/core/memory.h"
+
+#include <stddef.h>
+#include <errno.h>
+
+// Preloaded with LD_PRELOAD to count every heap allocation of the process,
+// including those of libc and Xlib that bypass the engine allocator. The
+// engine finds the counters by name when it starts.
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* memory, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void  __libc_free(void* memory);
+
+FcExternalAllocCounters fc_external_alloc_counters;
+
+static void count(size_t size)
+{
+    atomic_fetch_add_explicit(&fc_external_alloc_counters.allocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&fc_external_alloc_counters.bytes, size, memory_order_relaxed);
+}
+
+void* malloc(size_t size)
+{
+    count(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count_, size_t size)
+{
+    count(count_ * size);
+    return __libc_calloc(count_, size);
+}
+
+void* realloc(void* memory, size_t size)
+{
+    count(size);
+    return __libc_realloc(memory, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    count(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    count(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** memory, size_t alignment, size_t size)
+{
+    count(size);
+    void* result = __libc_memalign(alignment, size);
+    if (result == NULL) {
+        return ENOMEM;
+    }
+    *memory = result;
+    return 0;
+}
+
+void free(void* memory)
+{
+    if (memory != NULL) {
+        atomic_fetch_add_explicit(&fc_external_alloc_counters.frees, 1, memory_order_relaxed);
+    }
+    __libc_free(memory);
+}
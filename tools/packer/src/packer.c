@@ -0,0 +1,133 @@
+#include "finch/core/core.h"
+#include "finch/asset/image.h"
+#include "finch/asset/pack.h"
+#include "finch/platform/cpu.h"
+#include "finch/render/kernels.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Builds an asset pack from image and data files. Images are converted to
+// the target pixel format now so that applications never convert them.
+
+static b32 has_extension(const char* path, const char* extension)
+{
+    u64 path_length      = strlen(path);
+    u64 extension_length = strlen(extension);
+    return path_length > extension_length &&
+           strcmp(path + path_length - extension_length, extension) == 0;
+}
+
+static b32 add_file(FcPackWriter* writer, const char* path, const char* name,
+                    const FcPixelFormat* format)
+{
+    b32 netpbm = has_extension(path, ".ppm") || has_extension(path, ".pam");
+    if (netpbm || has_extension(path, ".qoi")) {
+        FcImage image;
+        b32 loaded = netpbm
+            ? fc_image_load_netpbm(&image, path, format)
+            : fc_image_load_qoi(&image, path, format);
+        if (!loaded) {
+            return false;
+        }
+        fc_pack_writer_add_image(writer, name, &image);
+        printf("  image %-40s %ux%u\n", name, image.width, image.height);
+        fc_image_free(&image);
+        return true;
+    }
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Could not open '%s'\n", path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    void* data = malloc(size > 0 ? size : 1);
+    b32 read = size >= 0 && fread(data, 1, size, file) == (size_t)size;
+    fclose(file);
+    if (!read) {
+        fprintf(stderr, "Could not read '%s'\n", path);
+        free(data);
+        return false;
+    }
+    fc_pack_writer_add_blob(writer, name, data, (u64)size);
+    printf("  blob  %-40s %ld bytes\n", name, size);
+    free(data);
+    return true;
+}
+
+static void print_usage(const char* program)
+{
+    printf("Usage: %s [options] -o <output.pack> <files...>\n"
+           "  --format <bgra8|rgba8>  Pixel format of images (default bgra8,\n"
+           "                          the usual X11 TrueColor layout)\n"
+           "  --strip <prefix>        Removed from file paths to form entry names\n"
+           "Files ending in .ppm, .pam or .qoi are stored as images, others as is.\n",
+           program);
+}
+
+int main(int argc, char** argv)
+{
+    FcPixelFormat format = FC_PIXEL_FORMAT_BGRA8;
+    const char* output = NULL;
+    const char* strip  = "";
+    int first_file = argc;
+
+    for (int i = 1; i < argc; ++i) {
+        b32 has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--format") == 0 && has_value) {
+            const char* name = argv[++i];
+            if (strcmp(name, "bgra8") == 0) {
+                format = FC_PIXEL_FORMAT_BGRA8;
+            } else if (strcmp(name, "rgba8") == 0) {
+                format = FC_PIXEL_FORMAT_RGBA8;
+            } else {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--strip") == 0 && has_value) {
+            strip = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && has_value) {
+            output = argv[++i];
+        } else if (argv[i][0] == '-') {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        } else {
+            first_file = i;
+            break;
+        }
+    }
+    if (output == NULL || first_file == argc) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    platform_cpu_init();
+    fc_render_select_kernels(platform_get_cpu_features());
+
+    FcPackWriter writer;
+    if (!fc_pack_writer_begin(&writer, output, &format)) {
+        return EXIT_FAILURE;
+    }
+
+    b32 success = true;
+    u64 strip_length = strlen(strip);
+    for (int i = first_file; i < argc; ++i) {
+        const char* name = argv[i];
+        if (strncmp(name, strip, strip_length) == 0) {
+            name += strip_length;
+        }
+        success = add_file(&writer, argv[i], name, &format) && success;
+    }
+
+    if (!fc_pack_writer_finish(&writer) || !success) {
+        fprintf(stderr, "Failed to build '%s'\n", output);
+        remove(output);
+        return EXIT_FAILURE;
+    }
+    printf("Wrote %s with %d entries\n", output, argc - first_file);
+    return EXIT_SUCCESS;
+}